@@ -19,7 +19,7 @@ namespace Signalforge\Validation;
  * collection.
  *
  * Supported rule families (see phpinfo() for the full list):
- *  - Presence: required, nullable, filled, present
+ *  - Presence: required, nullable, filled, present, bail
  *  - Types: string, integer, numeric, boolean, array
  *  - String: min, max, between, regex, alpha, alpha_num, alpha_dash
  *  - Comparison: gt, gte, lt, lte, in, not_in, same, different, confirmed
@@ -49,10 +49,24 @@ final class Validator
      * The rules array is parsed once and cached on the instance, so calling
      * {@see validate()} multiple times is cheap.
      *
+     * Options:
+     *  - `optimize` (bool, default true): run the rule-chain optimizer. It
+     *    hoists a leading `nullable`, merges adjacent `min`/`max`, drops a
+     *    `string` rule made redundant by the rule after it and, on `bail`
+     *    fields, runs cheap rules before expensive ones. Pass false to run
+     *    every chain exactly as written.
+     *  - `bail` (bool, default false): stop every field at its first failure,
+     *    as if each chain contained the `bail` rule.
+     *  - `profile` (bool, default false): record how often each rule of a
+     *    bail field runs and fails and how long it takes, and periodically
+     *    reorder independent rules so the cheapest, most selective run first.
+     *    See {@see exportProfile()}.
+     *
      * @param array<string, string|array<int, string>> $rules Field => rule(s)
-     * @throws InvalidRuleException If a rule definition is malformed
+     * @param array{optimize?: bool, bail?: bool, profile?: bool} $options Validator options
+     * @throws InvalidRuleException If a rule definition or option is malformed
      */
-    public function __construct(array $rules) {}
+    public function __construct(array $rules, array $options = []) {}
 
     /**
      * Validate input data against the configured rules.
@@ -75,8 +89,40 @@ final class Validator
      *
      * @param array<string, mixed> $data Input data (not stored)
      * @param array<string, string|array<int, string>> $rules Field => rule(s)
+     * @param array{optimize?: bool, bail?: bool, profile?: bool} $options See {@see __construct()}
      * @return Validator
-     * @throws InvalidRuleException If a rule definition is malformed
+     * @throws InvalidRuleException If a rule definition or option is malformed
+     */
+    public static function make(array $data, array $rules, array $options = []): Validator {}
+
+    /**
+     * Export the rule statistics gathered with the `profile` option.
+     *
+     * Entries are listed per bail field in current execution order. Store
+     * the result and pass it to {@see importProfile()} on a fresh worker to
+     * start from a warm ordering.
+     *
+     * @return array<string, list<array{rule: string, slot: int, runs: int, fails: int, time: int}>>
+     */
+    public function exportProfile(): array {}
+
+    /**
+     * Load statistics produced by {@see exportProfile()} and reorder rules
+     * accordingly. Entries that no longer match the rules are ignored.
+     *
+     * @param array<string, list<array{rule: string, slot: int, runs: int, fails: int, time: int}>> $profile
+     * @throws InvalidRuleException If the profile is malformed
+     */
+    public function importProfile(array $profile): void {}
+
+    /**
+     * How runs found their fields so far. A run (the top-level data, or one
+     * value validated against a sub-schema) is data-driven when its data has
+     * several times fewer keys than there are fields: one pass over the keys
+     * marks the present ones, and fields under absent keys skip the lookup.
+     * Other runs look every field up.
+     *
+     * @return array{runs: int, rule_driven: int, data_driven: int, fields: int}
      */
-    public static function make(array $data, array $rules): Validator {}
+    public function stats(): array {}
 }
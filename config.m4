@@ -16,8 +16,12 @@ if test "$PHP_SIGNALFORGE_VALIDATION" != "no"; then
     src/validator.c \
     src/result.c \
     src/parser.c \
+    src/program.c \
+    src/optimizer.c \
+    src/profile.c \
     src/condition.c \
     src/wildcard.c \
+    src/path.c \
     src/rules/presence.c \
     src/rules/types.c \
     src/rules/string.c \
@@ -27,7 +31,10 @@ if test "$PHP_SIGNALFORGE_VALIDATION" != "no"; then
     src/rules/comparison.c \
     src/rules/regional.c \
     src/util/utf8.c \
-    src/util/memory.c,
+    src/util/analysis.c \
+    src/util/memory.c \
+    src/util/value_set.c \
+    src/util/enum_table.c,
     $ext_shared)
 
   PHP_ADD_BUILD_DIR($ext_builddir/src)
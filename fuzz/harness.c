@@ -48,16 +48,20 @@
  * and its pcre2 transitive. */
 typedef enum {
     RULE_REQUIRED, RULE_NULLABLE, RULE_FILLED, RULE_PRESENT,
+    RULE_REQUIRED_IF, RULE_REQUIRED_UNLESS, RULE_PROHIBITED_IF, RULE_EXCLUDE_IF,
+    RULE_REQUIRED_WITH, RULE_REQUIRED_WITH_ALL, RULE_REQUIRED_WITHOUT, RULE_REQUIRED_WITHOUT_ALL,
     RULE_STRING, RULE_INTEGER, RULE_NUMERIC, RULE_BOOLEAN, RULE_ARRAY,
     RULE_MIN, RULE_MAX, RULE_BETWEEN, RULE_REGEX, RULE_NOT_REGEX,
     RULE_ALPHA, RULE_ALPHA_NUM, RULE_ALPHA_DASH, RULE_LOWERCASE, RULE_UPPERCASE,
     RULE_STARTS_WITH, RULE_ENDS_WITH, RULE_CONTAINS,
-    RULE_GT, RULE_GTE, RULE_LT, RULE_LTE, RULE_DISTINCT,
+    RULE_GT, RULE_GTE, RULE_LT, RULE_LTE, RULE_DISTINCT, RULE_KEYS, RULE_STRICT,
+    RULE_UNIQUE, RULE_SORTED, RULE_SUM_MIN, RULE_SUM_MAX, RULE_COUNT_WHERE,
     RULE_EMAIL, RULE_URL, RULE_IP, RULE_UUID, RULE_JSON,
     RULE_DATE, RULE_DATE_FORMAT,
     RULE_AFTER, RULE_BEFORE, RULE_AFTER_OR_EQUAL, RULE_BEFORE_OR_EQUAL,
-    RULE_IN, RULE_NOT_IN, RULE_SAME, RULE_DIFFERENT, RULE_CONFIRMED,
-    RULE_OIB, RULE_PHONE, RULE_IBAN, RULE_VAT_EU, RULE_WHEN, RULE_UNKNOWN
+    RULE_IN, RULE_NOT_IN, RULE_ENUM, RULE_SAME, RULE_DIFFERENT, RULE_CONFIRMED,
+    RULE_OIB, RULE_PHONE, RULE_IBAN, RULE_VAT_EU, RULE_WHEN, RULE_VARIANT,
+    RULE_ANY_OF, RULE_ALL_OF, RULE_NONE_OF, RULE_SCHEMA, RULE_BAIL, RULE_SOMETIMES, RULE_UNKNOWN
 } sf_rule_type_t;
 
 #define RULE_NAME_MAX_LENGTH 1024
@@ -79,6 +83,15 @@ extern sf_rule_type_t sf_get_rule_type(const char *name, size_t len);
 typedef struct sf_condition_s sf_condition_t;
 sf_condition_t *sf_parse_condition(zval *z) { (void)z; return NULL; }
 void sf_free_condition(sf_condition_t *c)   { (void)c; }
+bool sf_condition_bind(sf_condition_t *c, const void *f) { (void)c; (void)f; return 1; }
+
+/* Field-reference path stubs (path.c interns its keys through the engine).
+ * The parsed rules are discarded without being resolved. */
+typedef struct sf_path_s sf_path_t;
+void sf_path_init(sf_path_t *p, const char *s, size_t n) { (void)p; (void)s; (void)n; }
+void sf_path_destroy(sf_path_t *p)                     { (void)p; }
+bool sf_path_bind(sf_path_t *p, const sf_path_t *f)    { (void)p; (void)f; return 1; }
+bool sf_path_is_relative(const sf_path_t *p)           { (void)p; return 0; }
 
 /* ==========================================================================
  * Byte-driven input decoder
@@ -86,18 +86,60 @@
  * Security limits - prevent resource exhaustion and DoS attacks
  */
 #define SF_MAX_CONDITION_PARSE_DEPTH   32     /* Maximum recursion depth for condition parsing */
-#define SF_MAX_CONDITION_EVAL_DEPTH    32     /* Maximum recursion depth for condition evaluation */
 #define SF_MAX_RULE_PARSE_DEPTH        32     /* Maximum recursion depth for rule parsing */
 #define SF_MAX_REGEX_PATTERN_LENGTH    8192   /* Maximum length of a regex pattern */
 #define SF_PCRE2_MATCH_LIMIT           100000 /* PCRE2 match limit to prevent ReDoS */
 #define SF_PCRE2_RECURSION_LIMIT       5000   /* PCRE2 recursion limit to prevent ReDoS */
 
+/*
+ * Profile-guided rule ordering
+ */
+#define SF_PROFILE_REORDER_INTERVAL    1024   /* validate() calls between reorders */
+
+/*
+ * Condition memoization
+ */
+#define SF_MEMO_STACK_SLOTS            64     /* Memo slots kept on the stack */
+
+/*
+ * Presence rules (required_if, required_with, ...)
+ */
+#define SF_PRESENCE_STACK_WORDS        4      /* Presence bitmap words (64 facts each) kept on the stack */
+
+/*
+ * Iteration strategy (see run_fields() in validator.c)
+ */
+#define SF_DATA_DRIVEN_RATIO           4      /* Data-driven when fields outnumber data keys this many times */
+#define SF_ROOT_STACK_SLOTS            64     /* Root presence marks kept on the stack */
+#define SF_RUN_STACK_SLOTS             64     /* Data-driven run lists kept on the stack */
+
+/*
+ * Parent-first field gating
+ */
+#define SF_FIELD_STATE_STACK_SLOTS     64     /* Field states kept on the stack */
+
+/*
+ * Named sub-schemas
+ */
+#define SF_MAX_SCHEMA_DEPTH            64     /* Maximum nesting of schema values */
+#define SF_MAX_SCHEMA_RUNS             100000 /* Schema values validated per validate() call */
+
 /* Backward compatibility alias */
 #define RULE_NAME_MAX_LENGTH SF_RULE_NAME_MAX_LENGTH
 
 extern zend_module_entry signalforge_validation_module_entry;
 #define phpext_signalforge_validation_ptr &signalforge_validation_module_entry
 
+/*
+ * Request-wide state, shared by every Validator in the request
+ */
+ZEND_BEGIN_MODULE_GLOBALS(signalforge_validation)
+    HashTable *enum_tables;     /* Backed enum case tables by class (see src/util/enum_table.c) */
+ZEND_END_MODULE_GLOBALS(signalforge_validation)
+
+ZEND_EXTERN_MODULE_GLOBALS(signalforge_validation)
+#define SF_G(v) ZEND_MODULE_GLOBALS_ACCESSOR(signalforge_validation, v)
+
 /* Class entries */
 extern zend_class_entry *signalforge_validator_ce;
 extern zend_class_entry *signalforge_validation_result_ce;
@@ -120,9 +162,12 @@ typedef struct {
     pcre2_match_context *match_context;  /* Contains ReDoS protection limits */
 } cached_regex_t;
 
+/* Compiled rule program (see src/program.h) */
+struct sf_program_s;
+
 /* Validator object */
 typedef struct {
-    HashTable *rules;           /* Parsed rules */
+    struct sf_program_s *program;   /* Compiled rules */
     HashTable *regex_cache;     /* Compiled regex patterns */
     zend_object std;
 } signalforge_validator_t;
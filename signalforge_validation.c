@@ -11,14 +11,18 @@
  * - InvalidRuleException: Thrown when rule definitions are malformed
  *
  * Thread Safety:
- * - All global state is limited to class entries (registered once at MINIT)
- * - Per-request state is stored in object instances
+ * - Process-wide state is limited to class entries (registered once at MINIT)
+ * - Per-request state is stored in object instances, except the enum case
+ *   tables shared between them, kept in module globals (SF_G)
  * - Regex cache is per-validator-instance, not global
  */
 
 #include "php_signalforge_validation.h"
 #include "src/validator.h"
 #include "src/result.h"
+#include "src/condition.h"
+#include "src/util/value_set.h"
+#include "src/util/enum_table.h"
 
 /*
  * Global class entry pointers.
@@ -31,6 +35,8 @@ zend_class_entry *signalforge_validator_ce = NULL;
 zend_class_entry *signalforge_validation_result_ce = NULL;
 zend_class_entry *signalforge_invalid_rule_exception_ce = NULL;
 
+ZEND_DECLARE_MODULE_GLOBALS(signalforge_validation)
+
 /* Thread safety for dynamically loaded module */
 #if defined(ZTS) && defined(COMPILE_DL_SIGNALFORGE_VALIDATION)
 ZEND_TSRMLS_CACHE_DEFINE()
@@ -56,16 +62,26 @@ PHP_MINFO_FUNCTION(signalforge_validation)
 
     php_info_print_table_start();
     php_info_print_table_header(2, "Supported Rules", "");
-    php_info_print_table_row(2, "Presence", "required, nullable, filled, present");
+    php_info_print_table_row(2, "Presence", "required, nullable, filled, present, bail");
     php_info_print_table_row(2, "Types", "string, integer, numeric, boolean, array");
+    php_info_print_table_row(2, "Array", "distinct, keys, strict, schema, unique, sorted, sum_min, sum_max, count_where");
     php_info_print_table_row(2, "String", "min, max, between, regex, alpha, alpha_num, alpha_dash");
-    php_info_print_table_row(2, "Comparison", "gt, gte, lt, lte, in, not_in, same, different, confirmed");
+    php_info_print_table_row(2, "Comparison", "gt, gte, lt, lte, in, not_in, enum, same, different, confirmed");
     php_info_print_table_row(2, "Format", "email, url, ip, uuid, json, date, date_format");
     php_info_print_table_row(2, "Regional", "oib, phone, iban, vat_eu");
-    php_info_print_table_row(2, "Conditional", "when");
+    php_info_print_table_row(2, "Conditional", "when, required_if, required_unless, required_with, required_with_all, required_without, required_without_all, prohibited_if, exclude_if");
     php_info_print_table_end();
 }
 
+/* Globals initialization (per thread under ZTS) */
+static PHP_GINIT_FUNCTION(signalforge_validation)
+{
+#if defined(ZTS) && defined(COMPILE_DL_SIGNALFORGE_VALIDATION)
+    ZEND_TSRMLS_CACHE_UPDATE();
+#endif
+    memset(signalforge_validation_globals, 0, sizeof(*signalforge_validation_globals));
+}
+
 /* Module initialization */
 PHP_MINIT_FUNCTION(signalforge_validation)
 {
@@ -82,6 +98,12 @@ PHP_MINIT_FUNCTION(signalforge_validation)
     /* Register ValidationResult class */
     signalforge_register_result_class();
 
+    /* Intern condition @type names */
+    sf_condition_minit();
+
+    /* Seed the hash sets behind distinct and unique */
+    sf_hash_set_minit();
+
     return SUCCESS;
 }
 
@@ -103,6 +125,9 @@ PHP_RINIT_FUNCTION(signalforge_validation)
 /* Request shutdown */
 PHP_RSHUTDOWN_FUNCTION(signalforge_validation)
 {
+    /* Case objects die with the request */
+    sf_enum_table_rshutdown();
+
     return SUCCESS;
 }
 
@@ -117,7 +142,11 @@ zend_module_entry signalforge_validation_module_entry = {
     PHP_RSHUTDOWN(signalforge_validation),  /* RSHUTDOWN */
     PHP_MINFO(signalforge_validation),      /* MINFO */
     PHP_SIGNALFORGE_VALIDATION_VERSION,
-    STANDARD_MODULE_PROPERTIES
+    PHP_MODULE_GLOBALS(signalforge_validation),
+    PHP_GINIT(signalforge_validation),      /* GINIT */
+    NULL,                                   /* GSHUTDOWN */
+    NULL,                                   /* Post-deactivate */
+    STANDARD_MODULE_PROPERTIES_EX
 };
 
 #ifdef COMPILE_DL_SIGNALFORGE_VALIDATION
@@ -6,13 +6,65 @@
  *
  * Supported condition types:
  * - Simple: ['field', 'operator', 'value'] e.g., ['status', '=', 'active']
+ * - Nested field: ['address.country', '=', 'HR'] - dot notation
  * - Self-referential: ['@length', '>', 5] - check current field properties
  * - Compound: ['and', cond1, cond2, ...] or ['or', cond1, cond2, ...]
+ *
+ * Conditions are parsed into a temporary tree, then compiled into a flat
+ * sequence of tests with short-circuit jumps (see condition.h). Operands
+ * are prepared at the same time: field names become pre-hashed paths,
+ * constants pick a typed comparison, and in/not_in lists become hash sets.
  */
 
 #include "condition.h"
 #include "validator.h"
-#include "util/utf8.h"
+
+/* @type names, interned once at module startup */
+typedef enum {
+    SF_TYPE_NULL,
+    SF_TYPE_BOOLEAN,
+    SF_TYPE_INTEGER,
+    SF_TYPE_DOUBLE,
+    SF_TYPE_STRING,
+    SF_TYPE_ARRAY,
+    SF_TYPE_OBJECT,
+    SF_TYPE_UNKNOWN,
+    SF_TYPE_COUNT
+} sf_type_name_t;
+
+static zend_string *sf_type_names[SF_TYPE_COUNT];
+
+/* Create the interned @type names */
+void sf_condition_minit(void)
+{
+    static const char *names[SF_TYPE_COUNT] = {
+        "null", "boolean", "integer", "double", "string", "array", "object", "unknown"
+    };
+
+    for (int i = 0; i < SF_TYPE_COUNT; i++) {
+        sf_type_names[i] = zend_string_init_interned(names[i], strlen(names[i]), 1);
+    }
+}
+
+/* @type name of a value */
+static zend_string *type_name(zval *value)
+{
+    if (!value) {
+        return sf_type_names[SF_TYPE_NULL];
+    }
+
+    switch (Z_TYPE_P(value)) {
+        case IS_NULL: return sf_type_names[SF_TYPE_NULL];
+        case IS_TRUE:
+        case IS_FALSE: return sf_type_names[SF_TYPE_BOOLEAN];
+        case IS_LONG: return sf_type_names[SF_TYPE_INTEGER];
+        case IS_DOUBLE: return sf_type_names[SF_TYPE_DOUBLE];
+        case IS_STRING: return sf_type_names[SF_TYPE_STRING];
+        case IS_ARRAY: return sf_type_names[SF_TYPE_ARRAY];
+        case IS_OBJECT: return sf_type_names[SF_TYPE_OBJECT];
+        default: return sf_type_names[SF_TYPE_UNKNOWN];
+    }
+}
 
 /* Check if a value is considered "empty" */
 bool sf_is_empty(zval *value)
@@ -78,23 +130,89 @@ static sf_condition_op_t parse_operator(const char *op, size_t len)
     return COND_OP_EQ; /* Default */
 }
 
-/*
- * Parse a condition from PHP array (public API).
- * Delegates to depth-tracking version starting at depth 0.
- */
-sf_condition_t *sf_parse_condition(zval *condition_array)
+/* Condition tree node, only alive between parsing and compilation */
+typedef enum {
+    COND_SIMPLE,
+    COND_AND,
+    COND_OR,
+} sf_condition_kind_t;
+
+typedef struct sf_cond_node_s {
+    sf_condition_kind_t kind;
+    sf_condition_test_t test;               /* COND_SIMPLE */
+    struct sf_cond_node_s **children;       /* COND_AND / COND_OR */
+    size_t count;
+} sf_cond_node_t;
+
+/* Release the operands of a test */
+static void free_test(sf_condition_test_t *test)
+{
+    sf_path_destroy(&test->path);
+    if (test->field) {
+        zend_string_release(test->field);
+    }
+    sf_value_set_release(test->set);
+    zval_ptr_dtor(&test->value);
+}
+
+static void free_node(sf_cond_node_t *node)
+{
+    if (node->kind == COND_SIMPLE) {
+        free_test(&node->test);
+    } else {
+        for (size_t i = 0; i < node->count; i++) {
+            free_node(node->children[i]);
+        }
+        if (node->children) {
+            efree(node->children);
+        }
+    }
+
+    efree(node);
+}
+
+/* Pick the comparison for a test's constant operand */
+static void prepare_operand(sf_condition_test_t *test)
 {
-    return sf_parse_condition_with_depth(condition_array, 0);
+    switch (test->op) {
+        case COND_OP_IN:
+        case COND_OP_NOT_IN:
+            if (Z_TYPE(test->value) == IS_ARRAY) {
+                test->set = sf_value_set_build(Z_ARRVAL(test->value), SF_SET_LOOSE);
+            }
+            break;
+
+        case COND_OP_EQ:
+        case COND_OP_NEQ:
+        case COND_OP_GT:
+        case COND_OP_GTE:
+        case COND_OP_LT:
+        case COND_OP_LTE:
+            if (Z_TYPE(test->value) == IS_LONG) {
+                test->operand = OPERAND_LONG;
+            } else if (Z_TYPE(test->value) == IS_DOUBLE) {
+                test->operand = OPERAND_DOUBLE;
+            } else if (Z_TYPE(test->value) == IS_STRING
+                && !is_numeric_string(Z_STRVAL(test->value), Z_STRLEN(test->value), NULL, NULL, 0)) {
+                /* Numeric strings compare numerically against each other */
+                test->operand = OPERAND_STRING;
+            }
+            break;
+
+        default:
+            break;
+    }
 }
 
 /*
- * Parse a condition from PHP array with depth tracking.
+ * Parse a condition tree from PHP array with depth tracking.
  *
  * Security: Prevents stack overflow from maliciously crafted deeply nested
  * conditions by limiting recursion depth to SF_MAX_CONDITION_PARSE_DEPTH.
- * Returns NULL if depth is exceeded.
+ * Returns NULL if depth is exceeded. Compilation and evaluation need no
+ * further depth checks.
  */
-sf_condition_t *sf_parse_condition_with_depth(zval *condition_array, size_t depth)
+static sf_cond_node_t *parse_node(zval *condition_array, size_t depth)
 {
     /* Security: Check recursion depth to prevent stack overflow */
     if (depth > SF_MAX_CONDITION_PARSE_DEPTH) {
@@ -118,110 +236,250 @@ sf_condition_t *sf_parse_condition_with_depth(zval *condition_array, size_t dept
     const char *first_val = ZSTR_VAL(first_str);
     size_t first_len = ZSTR_LEN(first_str);
 
-    sf_condition_t *cond = ecalloc(1, sizeof(sf_condition_t));
+    sf_cond_node_t *node = ecalloc(1, sizeof(sf_cond_node_t));
+    ZVAL_NULL(&node->test.value);
 
     /* Check for compound conditions: and, or */
-    if (first_len == 3 && memcmp(first_val, "and", 3) == 0) {
-        cond->kind = COND_AND;
-        size_t count = zend_hash_num_elements(arr) - 1;
-        cond->compound.conditions = ecalloc(count, sizeof(sf_condition_t *));
-        cond->compound.count = 0;
-
-        for (size_t i = 1; i <= count; i++) {
-            zval *sub = zend_hash_index_find(arr, i);
-            if (sub && Z_TYPE_P(sub) == IS_ARRAY) {
-                /* Recursive call with incremented depth */
-                sf_condition_t *sub_cond = sf_parse_condition_with_depth(sub, depth + 1);
-                if (sub_cond) {
-                    cond->compound.conditions[cond->compound.count++] = sub_cond;
-                }
-            }
-        }
-        return cond;
-    }
+    bool is_and = first_len == 3 && memcmp(first_val, "and", 3) == 0;
+    bool is_or = first_len == 2 && memcmp(first_val, "or", 2) == 0;
 
-    if (first_len == 2 && memcmp(first_val, "or", 2) == 0) {
-        cond->kind = COND_OR;
+    if (is_and || is_or) {
+        node->kind = is_and ? COND_AND : COND_OR;
         size_t count = zend_hash_num_elements(arr) - 1;
-        cond->compound.conditions = ecalloc(count, sizeof(sf_condition_t *));
-        cond->compound.count = 0;
+        node->children = count ? ecalloc(count, sizeof(sf_cond_node_t *)) : NULL;
+        node->count = 0;
 
         for (size_t i = 1; i <= count; i++) {
             zval *sub = zend_hash_index_find(arr, i);
             if (sub && Z_TYPE_P(sub) == IS_ARRAY) {
                 /* Recursive call with incremented depth */
-                sf_condition_t *sub_cond = sf_parse_condition_with_depth(sub, depth + 1);
-                if (sub_cond) {
-                    cond->compound.conditions[cond->compound.count++] = sub_cond;
+                sf_cond_node_t *child = parse_node(sub, depth + 1);
+                if (child) {
+                    node->children[node->count++] = child;
                 }
             }
         }
-        return cond;
+        return node;
     }
 
     /* Simple condition */
-    cond->kind = COND_SIMPLE;
+    node->kind = COND_SIMPLE;
+    sf_condition_test_t *test = &node->test;
 
     /* Check for self-referential subjects starting with @ */
     if (first_val[0] == '@') {
         if (first_len == 7 && memcmp(first_val, "@length", 7) == 0) {
-            cond->simple.subject = SUBJECT_SELF_LENGTH;
+            test->subject = SUBJECT_SELF_LENGTH;
         } else if (first_len == 6 && memcmp(first_val, "@value", 6) == 0) {
-            cond->simple.subject = SUBJECT_SELF_VALUE;
+            test->subject = SUBJECT_SELF_VALUE;
         } else if (first_len == 5 && memcmp(first_val, "@type", 5) == 0) {
-            cond->simple.subject = SUBJECT_SELF_TYPE;
+            test->subject = SUBJECT_SELF_TYPE;
         } else if (first_len == 6 && memcmp(first_val, "@empty", 6) == 0) {
-            cond->simple.subject = SUBJECT_SELF_EMPTY;
-            cond->simple.op = COND_OP_EMPTY;
-            efree(cond);
-            cond = ecalloc(1, sizeof(sf_condition_t));
-            cond->kind = COND_SIMPLE;
-            cond->simple.subject = SUBJECT_SELF_EMPTY;
-            return cond;
+            test->subject = SUBJECT_SELF_EMPTY;
+            return node;
         } else if (first_len == 7 && memcmp(first_val, "@filled", 7) == 0) {
-            cond->simple.subject = SUBJECT_SELF_FILLED;
-            efree(cond);
-            cond = ecalloc(1, sizeof(sf_condition_t));
-            cond->kind = COND_SIMPLE;
-            cond->simple.subject = SUBJECT_SELF_FILLED;
-            return cond;
+            test->subject = SUBJECT_SELF_FILLED;
+            return node;
         } else if (first_len == 8 && memcmp(first_val, "@matches", 8) == 0) {
-            cond->simple.subject = SUBJECT_SELF_MATCHES;
+            test->subject = SUBJECT_SELF_MATCHES;
             zval *pattern = zend_hash_index_find(arr, 1);
             if (pattern && Z_TYPE_P(pattern) == IS_STRING) {
-                ZVAL_COPY(&cond->simple.value, pattern);
+                ZVAL_COPY(&test->value, pattern);
             }
-            return cond;
+            return node;
         } else {
-            efree(cond);
+            efree(node);
             return NULL;
         }
     } else {
-        /* Cross-field reference */
-        cond->simple.subject = SUBJECT_OTHER_FIELD;
-        cond->simple.field_name = estrndup(first_val, first_len);
-        cond->simple.field_len = first_len;
+        /*
+         * Cross-field reference, resolved as a dot path. A dotted name
+         * also keeps the literal key for data with dots in its keys.
+         */
+        test->subject = SUBJECT_OTHER_FIELD;
+        sf_path_init(&test->path, first_val, first_len);
+        if (test->path.count != 1) {
+            test->field = zend_string_init(first_val, first_len, 0);
+            zend_string_hash_val(test->field);
+        }
     }
 
     /* Get operator */
     zval *op_zval = zend_hash_index_find(arr, 1);
     if (op_zval && Z_TYPE_P(op_zval) == IS_STRING) {
-        cond->simple.op = parse_operator(Z_STRVAL_P(op_zval), Z_STRLEN_P(op_zval));
+        test->op = parse_operator(Z_STRVAL_P(op_zval), Z_STRLEN_P(op_zval));
 
         /* Check for unary operators */
-        if (cond->simple.op == COND_OP_FILLED || cond->simple.op == COND_OP_EMPTY) {
-            return cond;
+        if (test->op == COND_OP_FILLED || test->op == COND_OP_EMPTY) {
+            return node;
         }
     } else {
-        cond->simple.op = COND_OP_EQ;
+        test->op = COND_OP_EQ;
     }
 
     /* Get value */
     zval *value_zval = zend_hash_index_find(arr, 2);
     if (value_zval) {
-        ZVAL_COPY(&cond->simple.value, value_zval);
-    } else {
-        ZVAL_NULL(&cond->simple.value);
+        ZVAL_COPY(&test->value, value_zval);
+    }
+
+    prepare_operand(test);
+
+    return node;
+}
+
+/*
+ * Compilation.
+ *
+ * Short-circuit code is generated with backpatching: compiling a node
+ * returns the list of exits (on_true/on_false slots) still waiting for a
+ * target when the node holds, and the list when it does not. An 'and'
+ * wires each child's true exits to the next child; an 'or' wires the
+ * false exits. Pending lists are threaded through the unpatched slots
+ * themselves. A slot is encoded as test index * 2 + (1 for on_false).
+ */
+#define SF_COND_NIL (UINT32_MAX - 2)   /* End of a pending-exit list */
+
+static uint32_t *slot_ptr(sf_condition_t *cond, uint32_t slot)
+{
+    sf_condition_test_t *test = &cond->tests[slot >> 1];
+    return (slot & 1) ? &test->on_false : &test->on_true;
+}
+
+/* Point every slot in a pending list at target */
+static void patch(sf_condition_t *cond, uint32_t list, uint32_t target)
+{
+    while (list != SF_COND_NIL) {
+        uint32_t *slot = slot_ptr(cond, list);
+        list = *slot;
+        *slot = target;
+    }
+}
+
+/* Concatenate two pending lists */
+static uint32_t merge(sf_condition_t *cond, uint32_t a, uint32_t b)
+{
+    if (a == SF_COND_NIL) {
+        return b;
+    }
+
+    uint32_t *slot = slot_ptr(cond, a);
+    while (*slot != SF_COND_NIL) {
+        slot = slot_ptr(cond, *slot);
+    }
+    *slot = b;
+
+    return a;
+}
+
+/* Number of tests a node compiles to */
+static uint32_t count_tests(const sf_cond_node_t *node)
+{
+    if (node->kind == COND_SIMPLE || node->count == 0) {
+        return 1;
+    }
+
+    uint32_t count = 0;
+    for (size_t i = 0; i < node->count; i++) {
+        count += count_tests(node->children[i]);
+    }
+    return count;
+}
+
+/*
+ * Emit the tests for a node, moving leaf operands out of the tree.
+ * Recursion is bounded by SF_MAX_CONDITION_PARSE_DEPTH.
+ */
+static void compile_node(sf_condition_t *cond, sf_cond_node_t *node, uint32_t *true_exits, uint32_t *false_exits)
+{
+    if (node->kind == COND_SIMPLE || node->count == 0) {
+        uint32_t pc = cond->count++;
+        sf_condition_test_t *test = &cond->tests[pc];
+
+        if (node->kind == COND_SIMPLE) {
+            *test = node->test;
+            memset(&node->test, 0, sizeof(node->test));
+            ZVAL_NULL(&node->test.value);
+            test->on_true = SF_COND_NIL;
+            test->on_false = SF_COND_NIL;
+            *true_exits = pc * 2;
+            *false_exits = pc * 2 + 1;
+            return;
+        }
+
+        /* Empty 'and' always holds, empty 'or' never does */
+        memset(test, 0, sizeof(*test));
+        test->subject = SUBJECT_TRUE;
+        ZVAL_NULL(&test->value);
+        test->on_true = SF_COND_NIL;
+        test->on_false = SF_COND_REJECT;  /* Never taken */
+        if (node->kind == COND_AND) {
+            *true_exits = pc * 2;
+            *false_exits = SF_COND_NIL;
+        } else {
+            *true_exits = SF_COND_NIL;
+            *false_exits = pc * 2;
+        }
+        return;
+    }
+
+    uint32_t trues = SF_COND_NIL;
+    uint32_t falses = SF_COND_NIL;
+
+    for (size_t i = 0; i < node->count; i++) {
+        uint32_t t, f;
+        compile_node(cond, node->children[i], &t, &f);
+
+        bool last = i + 1 == node->count;
+        if (node->kind == COND_AND) {
+            /* Holds: try the next child. Fails: the whole 'and' fails. */
+            falses = merge(cond, falses, f);
+            if (last) {
+                trues = t;
+            } else {
+                patch(cond, t, cond->count);
+            }
+        } else {
+            /* Holds: the whole 'or' holds. Fails: try the next child. */
+            trues = merge(cond, trues, t);
+            if (last) {
+                falses = f;
+            } else {
+                patch(cond, f, cond->count);
+            }
+        }
+    }
+
+    *true_exits = trues;
+    *false_exits = falses;
+}
+
+/* Parse and compile a condition from PHP array */
+sf_condition_t *sf_parse_condition(zval *condition_array)
+{
+    sf_cond_node_t *root = parse_node(condition_array, 0);
+    if (!root) {
+        return NULL;
+    }
+
+    sf_condition_t *cond = ecalloc(1, sizeof(sf_condition_t));
+    cond->tests = safe_emalloc(count_tests(root), sizeof(sf_condition_test_t), 0);
+
+    uint32_t true_exits, false_exits;
+    compile_node(cond, root, &true_exits, &false_exits);
+    patch(cond, true_exits, SF_COND_ACCEPT);
+    patch(cond, false_exits, SF_COND_REJECT);
+
+    free_node(root);
+
+    cond->invariant = 1;
+    cond->memo = SF_COND_NO_MEMO;
+    for (uint32_t i = 0; i < cond->count; i++) {
+        sf_condition_subject_t subject = cond->tests[i].subject;
+        if (subject != SUBJECT_OTHER_FIELD && subject != SUBJECT_TRUE) {
+            cond->invariant = 0;
+            break;
+        }
     }
 
     return cond;
@@ -237,54 +495,97 @@ static int compare_zvals(zval *a, zval *b)
     return 0;
 }
 
-/* Check if value is in array */
-static bool value_in_array(zval *value, zval *array_val)
+/*
+ * Compare a subject with a test's constant.
+ *
+ * The typed paths give the same result as compare_function() for the
+ * pairings they accept: integer/integer and float/float compare by value,
+ * and two strings of which one is non-numeric compare byte by byte.
+ */
+static int compare_operand(sf_condition_test_t *test, zval *subject)
 {
-    if (Z_TYPE_P(array_val) != IS_ARRAY) {
-        return 0;
+    switch (test->operand) {
+        case OPERAND_LONG:
+            if (Z_TYPE_P(subject) == IS_LONG) {
+                zend_long a = Z_LVAL_P(subject);
+                zend_long b = Z_LVAL(test->value);
+                return (a > b) - (a < b);
+            }
+            break;
+
+        case OPERAND_DOUBLE:
+            if (Z_TYPE_P(subject) == IS_DOUBLE) {
+                double a = Z_DVAL_P(subject);
+                double b = Z_DVAL(test->value);
+#ifdef ZEND_THREEWAY_COMPARE
+                return ZEND_THREEWAY_COMPARE(a, b);
+#else
+                return ZEND_NORMALIZE_BOOL(a - b);
+#endif
+            }
+            break;
+
+        case OPERAND_STRING:
+            if (Z_TYPE_P(subject) == IS_STRING) {
+                return ZEND_NORMALIZE_BOOL(zend_binary_strcmp(
+                    Z_STRVAL_P(subject), Z_STRLEN_P(subject),
+                    Z_STRVAL(test->value), Z_STRLEN(test->value)));
+            }
+            break;
+
+        case OPERAND_GENERIC:
+            break;
     }
 
-    HashTable *arr = Z_ARRVAL_P(array_val);
-    zval *item;
+    return compare_zvals(subject, &test->value);
+}
 
-    ZEND_HASH_FOREACH_VAL(arr, item) {
-        if (compare_zvals(value, item) == 0) {
-            return 1;
-        }
-    } ZEND_HASH_FOREACH_END();
+/* Check if a value is in a test's list, through its set when possible */
+static bool value_in_list(sf_condition_test_t *test, zval *value)
+{
+    if (Z_TYPE(test->value) != IS_ARRAY) {
+        return 0;
+    }
 
-    return 0;
+    return sf_value_set_contains(test->set, Z_ARRVAL(test->value), SF_SET_LOOSE, value);
 }
 
 /*
- * Evaluate a simple condition against current value and data context.
+ * Evaluate a single test against current value and data context.
  *
  * This function handles various condition types including self-referential
  * conditions (@length, @value, @type) and cross-field comparisons.
  *
  * Memory management: subject_value is used as a temporary zval for computed
- * values. We track whether it needs cleanup with needs_cleanup flag to ensure
- * proper resource management.
+ * values. It only ever holds a long or an interned string, so it needs no
+ * cleanup.
  */
-static bool evaluate_simple_condition(
-    sf_condition_t *cond,
+static bool evaluate_test(
+    sf_condition_test_t *test,
     zval *current_value,
+    sf_value_analysis_t *analysis,
     HashTable *all_data,
+    zval *const *frames,
     const char *current_field,
     signalforge_validator_t *validator
 )
 {
     zval subject_value;
     zval *subject_ptr = NULL;
-    bool needs_cleanup = 0; /* Track if subject_value needs zval_ptr_dtor */
 
     ZVAL_UNDEF(&subject_value);
 
-    switch (cond->simple.subject) {
+    switch (test->subject) {
         case SUBJECT_SELF_LENGTH: {
             if (current_value && Z_TYPE_P(current_value) == IS_STRING) {
-                size_t len = sf_utf8_strlen(Z_STRVAL_P(current_value), Z_STRLEN_P(current_value));
-                ZVAL_LONG(&subject_value, (zend_long)len);
+                /* Against an integer, counting up to it is enough to compare */
+                if (test->operand == OPERAND_LONG) {
+                    zend_long bound = Z_LVAL(test->value);
+                    ZVAL_LONG(&subject_value,
+                        sf_analysis_length_within(analysis, Z_STR_P(current_value), bound, bound));
+                } else {
+                    ZVAL_LONG(&subject_value, (zend_long)sf_analysis_length(analysis, Z_STR_P(current_value)));
+                }
             } else if (current_value && Z_TYPE_P(current_value) == IS_ARRAY) {
                 ZVAL_LONG(&subject_value, (zend_long)zend_hash_num_elements(Z_ARRVAL_P(current_value)));
             } else {
@@ -298,26 +599,10 @@ static bool evaluate_simple_condition(
             subject_ptr = current_value;
             break;
 
-        case SUBJECT_SELF_TYPE: {
-            if (!current_value) {
-                ZVAL_STRING(&subject_value, "null");
-            } else {
-                switch (Z_TYPE_P(current_value)) {
-                    case IS_NULL: ZVAL_STRING(&subject_value, "null"); break;
-                    case IS_TRUE:
-                    case IS_FALSE: ZVAL_STRING(&subject_value, "boolean"); break;
-                    case IS_LONG: ZVAL_STRING(&subject_value, "integer"); break;
-                    case IS_DOUBLE: ZVAL_STRING(&subject_value, "double"); break;
-                    case IS_STRING: ZVAL_STRING(&subject_value, "string"); break;
-                    case IS_ARRAY: ZVAL_STRING(&subject_value, "array"); break;
-                    case IS_OBJECT: ZVAL_STRING(&subject_value, "object"); break;
-                    default: ZVAL_STRING(&subject_value, "unknown"); break;
-                }
-            }
+        case SUBJECT_SELF_TYPE:
+            ZVAL_INTERNED_STR(&subject_value, type_name(current_value));
             subject_ptr = &subject_value;
-            needs_cleanup = 1;
             break;
-        }
 
         case SUBJECT_SELF_EMPTY:
             return sf_is_empty(current_value);
@@ -329,7 +614,7 @@ static bool evaluate_simple_condition(
             if (!current_value || Z_TYPE_P(current_value) != IS_STRING) {
                 return 0;
             }
-            if (Z_TYPE(cond->simple.value) != IS_STRING) {
+            if (Z_TYPE(test->value) != IS_STRING) {
                 return 0;
             }
 
@@ -340,8 +625,8 @@ static bool evaluate_simple_condition(
             if (validator) {
                 cached_regex_t *cached = sf_get_or_compile_regex(
                     validator,
-                    Z_STRVAL(cond->simple.value),
-                    Z_STRLEN(cond->simple.value)
+                    Z_STRVAL(test->value),
+                    Z_STRLEN(test->value)
                 );
 
                 if (!cached) {
@@ -358,7 +643,7 @@ static bool evaluate_simple_condition(
                     (PCRE2_SPTR)Z_STRVAL_P(current_value),
                     Z_STRLEN_P(current_value),
                     0,
-                    0,
+                    sf_analysis_utf8_valid(analysis, Z_STR_P(current_value)) ? PCRE2_NO_UTF_CHECK : 0,
                     cached->match_data,
                     cached->match_context
                 );
@@ -371,8 +656,8 @@ static bool evaluate_simple_condition(
                 int errcode;
 
                 re = pcre2_compile(
-                    (PCRE2_SPTR)Z_STRVAL(cond->simple.value),
-                    Z_STRLEN(cond->simple.value),
+                    (PCRE2_SPTR)Z_STRVAL(test->value),
+                    Z_STRLEN(test->value),
                     PCRE2_UTF,
                     &errcode,
                     &erroffset,
@@ -401,32 +686,35 @@ static bool evaluate_simple_condition(
             }
         }
 
-        case SUBJECT_OTHER_FIELD: {
-            zend_string *field_key = zend_string_init(cond->simple.field_name, cond->simple.field_len, 0);
-            subject_ptr = zend_hash_find(all_data, field_key);
-            zend_string_release(field_key);
+        case SUBJECT_TRUE:
+            return 1;
+
+        case SUBJECT_OTHER_FIELD:
+            subject_ptr = sf_path_resolve_at(&test->path, all_data, frames);
+            if (!subject_ptr && test->field && all_data) {
+                subject_ptr = zend_hash_find(all_data, test->field);
+            }
             break;
-        }
     }
 
     /* Apply operator - handle NULL subject_ptr safely */
     bool result = 0;
 
-    switch (cond->simple.op) {
+    switch (test->op) {
         case COND_OP_EQ:
             if (!subject_ptr) {
                 /* NULL equals NULL */
-                result = Z_TYPE(cond->simple.value) == IS_NULL;
+                result = Z_TYPE(test->value) == IS_NULL;
             } else {
-                result = compare_zvals(subject_ptr, &cond->simple.value) == 0;
+                result = compare_operand(test, subject_ptr) == 0;
             }
             break;
 
         case COND_OP_NEQ:
             if (!subject_ptr) {
-                result = Z_TYPE(cond->simple.value) != IS_NULL;
+                result = Z_TYPE(test->value) != IS_NULL;
             } else {
-                result = compare_zvals(subject_ptr, &cond->simple.value) != 0;
+                result = compare_operand(test, subject_ptr) != 0;
             }
             break;
 
@@ -434,23 +722,23 @@ static bool evaluate_simple_condition(
             if (!subject_ptr) {
                 result = 0; /* NULL is not greater than anything */
             } else {
-                result = compare_zvals(subject_ptr, &cond->simple.value) > 0;
+                result = compare_operand(test, subject_ptr) > 0;
             }
             break;
 
         case COND_OP_GTE:
             if (!subject_ptr) {
-                result = Z_TYPE(cond->simple.value) == IS_NULL;
+                result = Z_TYPE(test->value) == IS_NULL;
             } else {
-                result = compare_zvals(subject_ptr, &cond->simple.value) >= 0;
+                result = compare_operand(test, subject_ptr) >= 0;
             }
             break;
 
         case COND_OP_LT:
             if (!subject_ptr) {
-                result = Z_TYPE(cond->simple.value) != IS_NULL;
+                result = Z_TYPE(test->value) != IS_NULL;
             } else {
-                result = compare_zvals(subject_ptr, &cond->simple.value) < 0;
+                result = compare_operand(test, subject_ptr) < 0;
             }
             break;
 
@@ -458,7 +746,7 @@ static bool evaluate_simple_condition(
             if (!subject_ptr) {
                 result = 1; /* NULL is less than or equal to everything */
             } else {
-                result = compare_zvals(subject_ptr, &cond->simple.value) <= 0;
+                result = compare_operand(test, subject_ptr) <= 0;
             }
             break;
 
@@ -466,7 +754,7 @@ static bool evaluate_simple_condition(
             if (!subject_ptr) {
                 result = 0;
             } else {
-                result = value_in_array(subject_ptr, &cond->simple.value);
+                result = value_in_list(test, subject_ptr);
             }
             break;
 
@@ -474,7 +762,7 @@ static bool evaluate_simple_condition(
             if (!subject_ptr) {
                 result = 1;
             } else {
-                result = !value_in_array(subject_ptr, &cond->simple.value);
+                result = !value_in_list(test, subject_ptr);
             }
             break;
 
@@ -492,100 +780,204 @@ static bool evaluate_simple_condition(
             break;
     }
 
-    /* Cleanup temporary values */
-    if (needs_cleanup && Z_TYPE(subject_value) != IS_UNDEF) {
-        zval_ptr_dtor(&subject_value);
-    }
-
     return result;
 }
 
 /*
- * Evaluate a condition (public API).
- * Delegates to depth-tracking version starting at depth 0.
+ * Evaluate a compiled condition.
+ *
+ * Each test picks the next one to run; the loop ends on SF_COND_ACCEPT or
+ * SF_COND_REJECT. Jumps only go forward, so no depth or step limit is
+ * needed.
  */
 bool sf_evaluate_condition(
     sf_condition_t *cond,
     zval *current_value,
+    sf_value_analysis_t *analysis,
     HashTable *all_data,
+    zval *const *frames,
     const char *current_field,
     signalforge_validator_t *validator
 )
 {
-    return sf_evaluate_condition_with_depth(cond, current_value, all_data, current_field, validator, 0);
+    if (!cond) {
+        return 1;
+    }
+
+    sf_condition_test_t *tests = cond->tests;
+    uint32_t pc = 0;
+
+    while (pc < cond->count) {
+        sf_condition_test_t *test = &tests[pc];
+        pc = evaluate_test(test, current_value, analysis, all_data, frames, current_field, validator)
+            ? test->on_true
+            : test->on_false;
+    }
+
+    return pc == SF_COND_ACCEPT;
 }
 
-/*
- * Evaluate a condition with depth tracking.
- *
- * Security: Prevents stack overflow from deeply nested conditions by limiting
- * recursion depth. Returns 0 (fails safe) if depth exceeded - this means
- * conditional validation rules will not apply if conditions are too deep.
- */
-bool sf_evaluate_condition_with_depth(
+/* Evaluate a condition through a per-call memo */
+bool sf_evaluate_condition_memo(
     sf_condition_t *cond,
+    uint8_t *memo,
     zval *current_value,
+    sf_value_analysis_t *analysis,
     HashTable *all_data,
+    zval *const *frames,
     const char *current_field,
-    signalforge_validator_t *validator,
-    size_t depth
+    signalforge_validator_t *validator
 )
 {
-    if (!cond) {
-        return 1;
+    if (!memo || !cond || cond->memo == SF_COND_NO_MEMO) {
+        return sf_evaluate_condition(cond, current_value, analysis, all_data, frames, current_field, validator);
     }
 
-    /* Security: Check recursion depth to prevent stack overflow */
-    if (depth > SF_MAX_CONDITION_EVAL_DEPTH) {
-        php_error_docref(NULL, E_WARNING,
-            "Condition evaluation depth exceeds maximum of %d", SF_MAX_CONDITION_EVAL_DEPTH);
-        return 0; /* Fail safe - condition not met */
+    uint8_t *state = &memo[cond->memo];
+    if (*state == SF_MEMO_UNKNOWN) {
+        *state = sf_evaluate_condition(cond, current_value, analysis, all_data, frames, current_field, validator)
+            ? SF_MEMO_TRUE
+            : SF_MEMO_FALSE;
     }
 
-    switch (cond->kind) {
-        case COND_SIMPLE:
-            return evaluate_simple_condition(cond, current_value, all_data, current_field, validator);
+    return *state == SF_MEMO_TRUE;
+}
 
-        case COND_AND: {
-            for (size_t i = 0; i < cond->compound.count; i++) {
-                if (!sf_evaluate_condition_with_depth(cond->compound.conditions[i], current_value, all_data, current_field, validator, depth + 1)) {
-                    return 0;
-                }
-            }
-            return 1;
+/* Bind field subjects to the field the condition is used on */
+bool sf_condition_bind(sf_condition_t *cond, const sf_path_t *field)
+{
+    for (uint32_t i = 0; i < cond->count; i++) {
+        sf_condition_test_t *test = &cond->tests[i];
+        if (test->subject != SUBJECT_OTHER_FIELD) {
+            continue;
         }
 
-        case COND_OR: {
-            for (size_t i = 0; i < cond->compound.count; i++) {
-                if (sf_evaluate_condition_with_depth(cond->compound.conditions[i], current_value, all_data, current_field, validator, depth + 1)) {
-                    return 1;
-                }
-            }
+        /* A relative subject is rewritten; its literal key means nothing */
+        if (sf_path_is_relative(&test->path) && test->field) {
+            zend_string_release(test->field);
+            test->field = NULL;
+        }
+
+        if (!sf_path_bind(&test->path, field)) {
             return 0;
         }
+
+        if (test->path.anchor != SF_PATH_ROOT) {
+            cond->invariant = 0;
+        }
     }
 
-    return 0;
+    return 1;
 }
 
-/* Free a condition */
-void sf_free_condition(sf_condition_t *cond)
+/* Whether two compiled conditions always have the same outcome */
+bool sf_condition_equals(const sf_condition_t *a, const sf_condition_t *b)
 {
-    if (!cond) return;
+    if (a->count != b->count) {
+        return 0;
+    }
 
-    if (cond->kind == COND_SIMPLE) {
-        if (cond->simple.field_name) {
-            efree(cond->simple.field_name);
+    for (uint32_t i = 0; i < a->count; i++) {
+        sf_condition_test_t *x = &a->tests[i];
+        sf_condition_test_t *y = &b->tests[i];
+
+        if (x->subject != y->subject || x->op != y->op
+            || x->on_true != y->on_true || x->on_false != y->on_false
+            || !sf_path_equals(&x->path, &y->path)
+            || !zend_is_identical(&x->value, &y->value)) {
+            return 0;
         }
-        zval_ptr_dtor(&cond->simple.value);
-    } else {
-        for (size_t i = 0; i < cond->compound.count; i++) {
-            sf_free_condition(cond->compound.conditions[i]);
+    }
+
+    return 1;
+}
+
+/* Fold one word into a digest */
+static zend_always_inline uint64_t digest_fold(uint64_t h, uint64_t word)
+{
+    h = (h ^ word) * 0x9e3779b97f4a7c15ULL;
+    return h ^ (h >> 29);
+}
+
+/* Digest of a constant, consistent with zend_is_identical() */
+static uint64_t value_digest(zval *value)
+{
+    uint64_t h = Z_TYPE_P(value);
+
+    switch (Z_TYPE_P(value)) {
+        case IS_LONG:
+            return digest_fold(h, (uint64_t)Z_LVAL_P(value));
+        case IS_DOUBLE: {
+            /* 0.0 and -0.0 are identical */
+            double d = Z_DVAL_P(value) == 0.0 ? 0.0 : Z_DVAL_P(value);
+            uint64_t bits;
+            memcpy(&bits, &d, sizeof(bits));
+            return digest_fold(h, bits);
         }
-        if (cond->compound.conditions) {
-            efree(cond->compound.conditions);
+        case IS_STRING:
+            return digest_fold(h, ZSTR_HASH(Z_STR_P(value)));
+        case IS_ARRAY:
+            return digest_fold(h, zend_hash_num_elements(Z_ARRVAL_P(value)));
+        default:
+            return h;
+    }
+}
+
+/* Digest of a compiled condition's tests */
+zend_ulong sf_condition_digest(const sf_condition_t *cond)
+{
+    uint64_t h = cond->count;
+
+    for (uint32_t i = 0; i < cond->count; i++) {
+        sf_condition_test_t *test = &cond->tests[i];
+
+        h = digest_fold(h, ((uint64_t)test->subject << 8) | test->op);
+        h = digest_fold(h, ((uint64_t)test->on_true << 32) | test->on_false);
+        h = digest_fold(h, sf_path_digest(&test->path));
+        h = digest_fold(h, value_digest(&test->value));
+    }
+
+    return (zend_ulong)h;
+}
+
+/* Deep copy a condition */
+sf_condition_t *sf_clone_condition(const sf_condition_t *src)
+{
+    if (!src) {
+        return NULL;
+    }
+
+    sf_condition_t *dst = ecalloc(1, sizeof(sf_condition_t));
+    dst->tests = safe_emalloc(src->count, sizeof(sf_condition_test_t), 0);
+    dst->count = src->count;
+    dst->invariant = src->invariant;
+    dst->memo = src->memo;
+
+    for (uint32_t i = 0; i < src->count; i++) {
+        const sf_condition_test_t *from = &src->tests[i];
+        sf_condition_test_t *to = &dst->tests[i];
+
+        *to = *from;
+        sf_path_copy(&to->path, &from->path);
+        if (from->field) {
+            zend_string_addref(to->field);
         }
+        to->set = sf_value_set_copy(from->set);
+        ZVAL_COPY(&to->value, &from->value);
+    }
+
+    return dst;
+}
+
+/* Free a condition */
+void sf_free_condition(sf_condition_t *cond)
+{
+    if (!cond) return;
+
+    for (uint32_t i = 0; i < cond->count; i++) {
+        free_test(&cond->tests[i]);
     }
+    efree(cond->tests);
 
     efree(cond);
 }
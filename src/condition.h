@@ -6,6 +6,9 @@
 #define SIGNALFORGE_CONDITION_H
 
 #include "php_signalforge_validation.h"
+#include "path.h"
+#include "util/analysis.h"
+#include "util/value_set.h"
 
 /* Condition operators */
 typedef enum {
@@ -31,82 +34,139 @@ typedef enum {
     SUBJECT_SELF_FILLED,   /* @filled */
     SUBJECT_SELF_MATCHES,  /* @matches */
     SUBJECT_OTHER_FIELD,   /* field name */
+    SUBJECT_TRUE,          /* Always holds (stands in for an empty and/or) */
 } sf_condition_subject_t;
 
-/* Condition kind */
+/*
+ * Constant operand specialization.
+ *
+ * Comparison tests against an integer, float or non-numeric string
+ * constant compare a subject of the same type directly; any other pairing
+ * goes through compare_function(), so results are unchanged.
+ */
 typedef enum {
-    COND_SIMPLE,
-    COND_AND,
-    COND_OR,
-} sf_condition_kind_t;
+    OPERAND_GENERIC,   /* compare_function() */
+    OPERAND_LONG,      /* Integer constant */
+    OPERAND_DOUBLE,    /* Float constant */
+    OPERAND_STRING,    /* Non-numeric string constant: byte comparison */
+} sf_condition_operand_t;
 
-/* Forward declaration */
-struct sf_condition_s;
+/*
+ * Compiled condition.
+ *
+ * Condition trees ('and'/'or' of simple tests) are compiled at parse time
+ * into a flat sequence of tests. Each test names the test to run next for
+ * either outcome, so short-circuiting is a jump and evaluation is a loop
+ * with no recursion:
+ *
+ *     ['or', ['and', A, B], C]   =>   0: A   true -> 1       false -> 2
+ *                                     1: B   true -> ACCEPT  false -> 2
+ *                                     2: C   true -> ACCEPT  false -> REJECT
+ *
+ * Jumps only go forward, so evaluation ends after at most `count` tests.
+ * Nesting depth is limited once, while parsing (SF_MAX_CONDITION_PARSE_DEPTH).
+ */
+#define SF_COND_ACCEPT  UINT32_MAX          /* Condition holds */
+#define SF_COND_REJECT  (UINT32_MAX - 1)    /* Condition does not hold */
 
-/* Condition structure */
+/*
+ * Memoization.
+ *
+ * A condition that reads only other fields (no @-subjects, no subjects
+ * bound to the current element) is invariant: within one validate() call
+ * it has the same outcome for every field and wildcard element that
+ * evaluates it. The compiler gives each distinct
+ * invariant condition a slot in a per-call memo of SF_MEMO_* states.
+ */
+#define SF_COND_NO_MEMO UINT32_MAX
+
+#define SF_MEMO_UNKNOWN 0
+#define SF_MEMO_FALSE   1
+#define SF_MEMO_TRUE    2
+
+/* A single test of a compiled condition */
+typedef struct {
+    sf_condition_subject_t subject;
+    sf_condition_op_t op;
+    sf_condition_operand_t operand;
+    sf_path_t path;        /* For SUBJECT_OTHER_FIELD, dot notation */
+    zend_string *field;    /* Literal key fallback for dotted field names */
+    zval value;            /* The value to compare against */
+    sf_value_set_t *set;   /* in/not_in lists, if keyable (see value_set.h) */
+    uint32_t on_true;      /* Next test, SF_COND_ACCEPT or SF_COND_REJECT */
+    uint32_t on_false;
+} sf_condition_test_t;
+
+/* Compiled condition structure */
 typedef struct sf_condition_s {
-    sf_condition_kind_t kind;
-    union {
-        /* Simple condition */
-        struct {
-            sf_condition_subject_t subject;
-            char *field_name;      /* For SUBJECT_OTHER_FIELD */
-            size_t field_len;
-            sf_condition_op_t op;
-            zval value;            /* The value to compare against */
-        } simple;
-
-        /* Compound condition (AND/OR) */
-        struct {
-            struct sf_condition_s **conditions;
-            size_t count;
-        } compound;
-    };
+    sf_condition_test_t *tests;
+    uint32_t count;
+    bool invariant;        /* Independent of the current value */
+    uint32_t memo;         /* Memo slot, or SF_COND_NO_MEMO */
 } sf_condition_t;
 
 /*
- * Parse a condition from PHP array.
+ * Parse and compile a condition from PHP array.
  *
- * Security: Uses internal depth tracking to prevent stack overflow from
- * deeply nested conditions. Returns NULL if depth exceeds SF_MAX_CONDITION_PARSE_DEPTH.
+ * Security: Limits nesting to SF_MAX_CONDITION_PARSE_DEPTH to prevent
+ * stack overflow while parsing. Returns NULL if the depth is exceeded.
  */
 sf_condition_t *sf_parse_condition(zval *condition_array);
 
 /*
- * Internal parsing function with explicit depth tracking.
- * Users should call sf_parse_condition() which starts at depth 0.
- */
-sf_condition_t *sf_parse_condition_with_depth(zval *condition_array, size_t depth);
-
-/*
- * Evaluate a condition against data.
- *
- * Security: Uses internal depth tracking to prevent stack overflow from
- * deeply nested conditions. Returns false (fails safe) if depth exceeded.
+ * Evaluate a condition against data. A NULL condition always holds.
+ * frames are the values along the current wildcard element's path (NULL
+ * outside wildcard fields), for subjects bound by sf_condition_bind().
+ * analysis holds what the field's rules already know about current_value
+ * (@length and @matches reuse and extend it).
  */
 bool sf_evaluate_condition(
     sf_condition_t *cond,
     zval *current_value,
+    sf_value_analysis_t *analysis,
     HashTable *all_data,
+    zval *const *frames,
     const char *current_field,
     signalforge_validator_t *validator
 );
 
 /*
- * Internal evaluation function with explicit depth tracking.
+ * Evaluate a condition through a per-call memo (see above). Conditions
+ * without a slot, or a NULL memo, are evaluated directly.
  */
-bool sf_evaluate_condition_with_depth(
+bool sf_evaluate_condition_memo(
     sf_condition_t *cond,
+    uint8_t *memo,
     zval *current_value,
+    sf_value_analysis_t *analysis,
     HashTable *all_data,
+    zval *const *frames,
     const char *current_field,
-    signalforge_validator_t *validator,
-    size_t depth
+    signalforge_validator_t *validator
 );
 
+/*
+ * Bind field subjects to the field the condition is used on (see
+ * sf_path_bind). A condition with subjects resolved per element is no
+ * longer invariant. Returns 0 if a subject does not fit the field.
+ */
+bool sf_condition_bind(sf_condition_t *cond, const sf_path_t *field);
+
+/* Whether two compiled conditions always have the same outcome */
+bool sf_condition_equals(const sf_condition_t *a, const sf_condition_t *b);
+
+/* Digest of what sf_condition_equals() compares (see sf_path_digest()) */
+zend_ulong sf_condition_digest(const sf_condition_t *cond);
+
+/* Deep copy a condition */
+sf_condition_t *sf_clone_condition(const sf_condition_t *src);
+
 /* Free a condition */
 void sf_free_condition(sf_condition_t *cond);
 
+/* Create the interned @type names (module startup) */
+void sf_condition_minit(void);
+
 /* Helper to check if a value is considered "filled" */
 bool sf_is_filled(zval *value);
 
@@ -0,0 +1,250 @@
+/*
+ * Rule-chain optimizer
+ *
+ * Runs on the parse tree between sf_parse_rules() and sf_compile_rules()
+ * unless the Validator was built with 'optimize' => false. It only
+ * rewrites each field's rule list; instruction selection (superinstructions,
+ * specialized variants) stays in the compiler, which gets more chances to
+ * fuse once the lists are tidied up here.
+ *
+ * Passes, per rule list:
+ *
+ *  1. Redundancy. A 'string' guard directly followed by a rule that already
+ *     rejects every non-string (email, url, regex, alpha, ...) is dropped,
+ *     as is a repeated 'nullable'. The field fails on exactly the same
+ *     inputs; a non-string reports only the stronger rule's error.
+ *
+ *  2. Cost ordering, bail fields only. Between barriers (rules whose effect
+ *     depends on their position: nullable, filled, when, variant) rules are stably
+ *     sorted so cheap checks run before expensive ones such as regex, json
+ *     or date parsing. A bail field stops at its first failure, so a cheap
+ *     failing check saves the expensive ones entirely. Without bail every
+ *     rule runs regardless, and declaration order is kept so errors come
+ *     out in the order the rules were written.
+ *
+ * Nullable hoisting and min/max merging are done while compiling (see
+ * sf_compile_rules() and compile_fused() in program.c).
+ */
+
+#include "optimizer.h"
+
+/* Relative execution cost of a rule, used to order independent rules */
+typedef enum {
+    SF_COST_TRIVIAL,    /* Presence and type checks */
+    SF_COST_COMPARE,    /* Size and value comparisons, field lookups */
+    SF_COST_SCAN,       /* One pass over the value or a parameter list */
+    SF_COST_PARSE,      /* Structured format parsing */
+    SF_COST_HEAVY,      /* Regex matching, JSON and date parsing */
+} sf_rule_cost_t;
+
+static sf_rule_cost_t rule_cost(sf_rule_type_t type)
+{
+    switch (type) {
+        case RULE_MIN:
+        case RULE_MAX:
+        case RULE_BETWEEN:
+        case RULE_GT:
+        case RULE_GTE:
+        case RULE_LT:
+        case RULE_LTE:
+        case RULE_SAME:
+        case RULE_DIFFERENT:
+        case RULE_CONFIRMED:
+        case RULE_ENUM:
+            return SF_COST_COMPARE;
+
+        case RULE_ALPHA:
+        case RULE_ALPHA_NUM:
+        case RULE_ALPHA_DASH:
+        case RULE_LOWERCASE:
+        case RULE_UPPERCASE:
+        case RULE_STARTS_WITH:
+        case RULE_ENDS_WITH:
+        case RULE_CONTAINS:
+        case RULE_IN:
+        case RULE_NOT_IN:
+        case RULE_DISTINCT:
+        case RULE_KEYS:
+        case RULE_STRICT:
+        case RULE_UUID:
+        case RULE_OIB:
+        case RULE_PHONE:
+        case RULE_IBAN:
+        case RULE_VAT_EU:
+            return SF_COST_SCAN;
+
+        case RULE_EMAIL:
+        case RULE_URL:
+        case RULE_IP:
+            return SF_COST_PARSE;
+
+        case RULE_REGEX:
+        case RULE_NOT_REGEX:
+        case RULE_JSON:
+        case RULE_DATE:
+        case RULE_DATE_FORMAT:
+        case RULE_AFTER:
+        case RULE_BEFORE:
+        case RULE_AFTER_OR_EQUAL:
+        case RULE_BEFORE_OR_EQUAL:
+            return SF_COST_HEAVY;
+
+        default:
+            return SF_COST_TRIVIAL;
+    }
+}
+
+/* Rules that must not move relative to the rules around them */
+static bool is_barrier(sf_rule_type_t type)
+{
+    /*
+     * nullable/filled can skip the rest of the chain; when/variant may
+     * contain them; combinators only run as a whole; schema queues the
+     * value's validation once it passes; collection rules accumulate only
+     * the values the rules before them let through; presence rules
+     * (required_if, exclude_if, ...) may skip the rest of the chain
+     */
+    return type == RULE_NULLABLE || type == RULE_FILLED || type == RULE_WHEN || type == RULE_VARIANT
+        || SF_RULE_IS_COMBINATOR(type) || type == RULE_SCHEMA || SF_RULE_IS_AGGREGATE(type)
+        || SF_RULE_IS_PRESENCE(type);
+}
+
+/* Rules that fail (with their own error) for every non-string value */
+static bool rejects_non_strings(sf_rule_type_t type)
+{
+    switch (type) {
+        case RULE_REGEX:
+        case RULE_ALPHA:
+        case RULE_ALPHA_NUM:
+        case RULE_ALPHA_DASH:
+        case RULE_LOWERCASE:
+        case RULE_UPPERCASE:
+        case RULE_STARTS_WITH:
+        case RULE_ENDS_WITH:
+        case RULE_CONTAINS:
+        case RULE_EMAIL:
+        case RULE_URL:
+        case RULE_IP:
+        case RULE_UUID:
+        case RULE_JSON:
+        case RULE_DATE:
+        case RULE_DATE_FORMAT:
+        case RULE_OIB:
+        case RULE_PHONE:
+        case RULE_IBAN:
+        case RULE_VAT_EU:
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+/* Drop rules[i] from the list and free it */
+static void remove_rule(sf_parsed_rule_t **rules, size_t *count, size_t i)
+{
+    sf_free_parsed_rule(rules[i]);
+    memmove(&rules[i], &rules[i + 1], (*count - i - 1) * sizeof(sf_parsed_rule_t *));
+    (*count)--;
+}
+
+/* Pass 1: drop rules whose outcome is implied by another rule */
+static void remove_redundant(sf_parsed_rule_t **rules, size_t *count)
+{
+    bool seen_nullable = 0;
+    size_t i = 0;
+
+    while (i < *count) {
+        sf_rule_type_t type = rules[i]->type;
+
+        if (type == RULE_NULLABLE) {
+            if (seen_nullable) {
+                remove_rule(rules, count, i);
+                continue;
+            }
+            seen_nullable = 1;
+        } else if (type == RULE_STRING && i + 1 < *count && rejects_non_strings(rules[i + 1]->type)) {
+            remove_rule(rules, count, i);
+            continue;
+        }
+
+        i++;
+    }
+}
+
+/* Pass 2: stable-sort each run of non-barrier rules by cost */
+static void order_by_cost(sf_parsed_rule_t **rules, size_t count)
+{
+    size_t lo = 0;
+
+    while (lo < count) {
+        if (is_barrier(rules[lo]->type)) {
+            lo++;
+            continue;
+        }
+
+        size_t hi = lo + 1;
+        while (hi < count && !is_barrier(rules[hi]->type)) {
+            hi++;
+        }
+
+        /* Insertion sort: lists are short and it keeps equal-cost rules in order */
+        for (size_t i = lo + 1; i < hi; i++) {
+            sf_parsed_rule_t *rule = rules[i];
+            sf_rule_cost_t cost = rule_cost(rule->type);
+            size_t j = i;
+
+            while (j > lo && rule_cost(rules[j - 1]->type) > cost) {
+                rules[j] = rules[j - 1];
+                j--;
+            }
+            rules[j] = rule;
+        }
+
+        lo = hi;
+    }
+}
+
+/*
+ * Optimize a rule list in place. Recursion into 'when', 'variant' and combinator branches is bounded
+ * by SF_MAX_RULE_PARSE_DEPTH, enforced by the parser.
+ */
+void sf_optimize_rule_list(sf_parsed_rule_t **rules, size_t *count, bool bail)
+{
+    remove_redundant(rules, count);
+
+    if (bail) {
+        order_by_cost(rules, *count);
+    }
+
+    for (size_t i = 0; i < *count; i++) {
+        if (rules[i]->type == RULE_WHEN) {
+            sf_optimize_rule_list(
+                rules[i]->params.conditional.then_rules,
+                &rules[i]->params.conditional.then_count,
+                bail);
+            sf_optimize_rule_list(
+                rules[i]->params.conditional.else_rules,
+                &rules[i]->params.conditional.else_count,
+                bail);
+        } else if (rules[i]->type == RULE_VARIANT) {
+            for (uint32_t k = 0; k < rules[i]->params.variant.case_count; k++) {
+                sf_optimize_rule_list(
+                    rules[i]->params.variant.case_rules[k],
+                    &rules[i]->params.variant.case_counts[k],
+                    bail);
+            }
+            sf_optimize_rule_list(
+                rules[i]->params.variant.default_rules,
+                &rules[i]->params.variant.default_count,
+                bail);
+        } else if (SF_RULE_IS_COMBINATOR(rules[i]->type)) {
+            for (uint32_t k = 0; k < rules[i]->params.combinator.branch_count; k++) {
+                sf_optimize_rule_list(
+                    rules[i]->params.combinator.branch_rules[k],
+                    &rules[i]->params.combinator.branch_counts[k],
+                    bail);
+            }
+        }
+    }
+}
@@ -0,0 +1,20 @@
+/*
+ * Rule-chain optimizer
+ */
+
+#ifndef SIGNALFORGE_OPTIMIZER_H
+#define SIGNALFORGE_OPTIMIZER_H
+
+#include "php_signalforge_validation.h"
+#include "parser.h"
+
+/*
+ * Optimize a parsed rule list in place (recursing into 'when' branches).
+ *
+ * `count` may shrink; rules dropped from the list are freed. Rules are
+ * only reordered when `bail` is set, since without it every rule runs and
+ * declaration order decides the error order.
+ */
+void sf_optimize_rule_list(sf_parsed_rule_t **rules, size_t *count, bool bail);
+
+#endif /* SIGNALFORGE_OPTIMIZER_H */
@@ -9,6 +9,13 @@
  * - Simple rules: 'required', 'email', etc.
  * - Parameterized rules: ['min', 5], ['between', 1, 10]
  * - Conditional rules: ['when', condition, then_rules, else_rules]
+ * - Discriminated unions: ['variant', 'type', ['card' => rules, ...], default_rules]
+ * - Combinators: ['any_of', ['iban'], [['regex', '/^\d{10}$/']]] (also all_of, none_of)
+ * - Named sub-schemas: ['schema', 'address'] (declared in the 'schemas' option)
+ * - Collection rules on wildcard fields: 'unique', ['sum_max', 100],
+ *   ['count_where', true, 1]
+ * - Relative field references inside wildcard fields: ['after', '^.start']
+ *   or ['after', 'items.*.start'] on 'items.*.end' (see sf_path_bind)
  */
 
 #include "parser.h"
@@ -36,6 +43,16 @@ static const sf_rule_lookup_t rule_lookup[] = {
     {"filled", 6, RULE_FILLED},
     {"present", 7, RULE_PRESENT},
 
+    /* Cross-field presence rules - answered from a per-run bitmap */
+    {"required_if", 11, RULE_REQUIRED_IF},
+    {"required_unless", 15, RULE_REQUIRED_UNLESS},
+    {"prohibited_if", 13, RULE_PROHIBITED_IF},
+    {"exclude_if", 10, RULE_EXCLUDE_IF},
+    {"required_with", 13, RULE_REQUIRED_WITH},
+    {"required_with_all", 17, RULE_REQUIRED_WITH_ALL},
+    {"required_without", 16, RULE_REQUIRED_WITHOUT},
+    {"required_without_all", 20, RULE_REQUIRED_WITHOUT_ALL},
+
     /* Type rules - validate PHP type */
     {"string", 6, RULE_STRING},
     {"integer", 7, RULE_INTEGER},
@@ -66,6 +83,15 @@ static const sf_rule_lookup_t rule_lookup[] = {
 
     /* Array rules */
     {"distinct", 8, RULE_DISTINCT},
+    {"keys", 4, RULE_KEYS},
+    {"strict", 6, RULE_STRICT},
+
+    /* Collection rules - wildcard fields only, checked across all elements */
+    {"unique", 6, RULE_UNIQUE},
+    {"sorted", 6, RULE_SORTED},
+    {"sum_min", 7, RULE_SUM_MIN},
+    {"sum_max", 7, RULE_SUM_MAX},
+    {"count_where", 11, RULE_COUNT_WHERE},
 
     /* Format rules - structured data validation */
     {"email", 5, RULE_EMAIL},
@@ -83,6 +109,7 @@ static const sf_rule_lookup_t rule_lookup[] = {
     /* Comparison rules - cross-field validation */
     {"in", 2, RULE_IN},
     {"not_in", 6, RULE_NOT_IN},
+    {"enum", 4, RULE_ENUM},
     {"same", 4, RULE_SAME},
     {"different", 9, RULE_DIFFERENT},
     {"confirmed", 9, RULE_CONFIRMED},
@@ -95,6 +122,20 @@ static const sf_rule_lookup_t rule_lookup[] = {
 
     /* Conditional - dynamic rule application */
     {"when", 4, RULE_WHEN},
+    {"variant", 7, RULE_VARIANT},
+
+    /* Combinators - branches of rule lists */
+    {"any_of", 6, RULE_ANY_OF},
+    {"all_of", 6, RULE_ALL_OF},
+    {"none_of", 7, RULE_NONE_OF},
+
+    /* Named sub-schemas - resolved against the 'schemas' option */
+    {"schema", 6, RULE_SCHEMA},
+
+    /* Chain control - stop the field at its first failure, or skip it
+     * (and every field below it) when it is absent */
+    {"bail", 4, RULE_BAIL},
+    {"sometimes", 9, RULE_SOMETIMES},
 
     /* Sentinel - marks end of table */
     {NULL, 0, RULE_UNKNOWN}
@@ -134,6 +175,17 @@ sf_rule_type_t sf_get_rule_type(const char *name, size_t len)
     return RULE_UNKNOWN;
 }
 
+/* Get rule name from type */
+const char *sf_get_rule_name(sf_rule_type_t type)
+{
+    for (const sf_rule_lookup_t *entry = rule_lookup; entry->name != NULL; entry++) {
+        if (entry->type == type) {
+            return entry->name;
+        }
+    }
+    return NULL;
+}
+
 /* Forward declaration for recursive parsing with depth tracking */
 static sf_parsed_rule_t *parse_single_rule_with_depth(zval *rule_zval, size_t depth);
 
@@ -146,6 +198,370 @@ static sf_parsed_rule_t *parse_single_rule(zval *rule_zval)
     return parse_single_rule_with_depth(rule_zval, 0);
 }
 
+/* Parse a list of rules one level down; throws and returns 0 on error */
+static bool parse_rule_list(HashTable *arr, size_t depth, sf_parsed_rule_t ***rules, size_t *count)
+{
+    *rules = ecalloc(zend_hash_num_elements(arr), sizeof(sf_parsed_rule_t *));
+    *count = 0;
+
+    zval *rule_zval;
+    ZEND_HASH_FOREACH_VAL(arr, rule_zval) {
+        sf_parsed_rule_t *parsed = parse_single_rule_with_depth(rule_zval, depth + 1);
+        if (!parsed) {
+            return 0;
+        }
+        (*rules)[(*count)++] = parsed;
+    } ZEND_HASH_FOREACH_END();
+
+    return 1;
+}
+
+/*
+ * Parse ['variant', field, cases, default_rules?]. Cases map discriminator
+ * values (the array keys) to rule lists. Leaves partial results on the rule
+ * for sf_free_parsed_rule() on error.
+ */
+static bool parse_variant(sf_parsed_rule_t *rule, HashTable *arr, size_t depth)
+{
+    zval *field = zend_hash_index_find(arr, 1);
+    zval *cases = zend_hash_index_find(arr, 2);
+    zval *default_zval = zend_hash_index_find(arr, 3);
+
+    if (!field || Z_TYPE_P(field) != IS_STRING || Z_STRLEN_P(field) == 0) {
+        zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+            "Rule 'variant' requires a discriminator field name");
+        return 0;
+    }
+
+    if (!cases || Z_TYPE_P(cases) != IS_ARRAY || zend_hash_num_elements(Z_ARRVAL_P(cases)) == 0) {
+        zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+            "Rule 'variant' requires an array of cases");
+        return 0;
+    }
+
+    if (default_zval && Z_TYPE_P(default_zval) != IS_ARRAY) {
+        zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+            "Rule 'variant' default rules must be an array");
+        return 0;
+    }
+
+    rule->params.variant.field = estrndup(Z_STRVAL_P(field), Z_STRLEN_P(field));
+    rule->params.variant.len = Z_STRLEN_P(field);
+    sf_path_init(&rule->params.variant.path, Z_STRVAL_P(field), Z_STRLEN_P(field));
+    if (rule->params.variant.path.count != 1) {
+        /* As for condition subjects, a dotted name also tries its literal key */
+        rule->params.variant.key = zend_string_init(Z_STRVAL_P(field), Z_STRLEN_P(field), 0);
+        zend_string_hash_val(rule->params.variant.key);
+    }
+
+    HashTable *case_arr = Z_ARRVAL_P(cases);
+    uint32_t case_count = zend_hash_num_elements(case_arr);
+
+    ALLOC_HASHTABLE(rule->params.variant.cases);
+    zend_hash_init(rule->params.variant.cases, case_count, NULL, NULL, 0);
+    rule->params.variant.case_rules = ecalloc(case_count, sizeof(sf_parsed_rule_t **));
+    rule->params.variant.case_counts = ecalloc(case_count, sizeof(size_t));
+
+    zend_ulong h;
+    zend_string *key;
+    zval *case_rules;
+    ZEND_HASH_FOREACH_KEY_VAL(case_arr, h, key, case_rules) {
+        uint32_t k = rule->params.variant.case_count;
+
+        if (Z_TYPE_P(case_rules) != IS_ARRAY) {
+            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                "Rule 'variant' case rules must be an array");
+            return 0;
+        }
+
+        zval num;
+        ZVAL_LONG(&num, k);
+        if (key) {
+            zend_hash_add_new(rule->params.variant.cases, key, &num);
+        } else {
+            zend_hash_index_add_new(rule->params.variant.cases, h, &num);
+        }
+        rule->params.variant.case_count++;
+
+        if (!parse_rule_list(Z_ARRVAL_P(case_rules), depth,
+                &rule->params.variant.case_rules[k], &rule->params.variant.case_counts[k])) {
+            return 0;
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    if (default_zval && !parse_rule_list(Z_ARRVAL_P(default_zval), depth,
+            &rule->params.variant.default_rules, &rule->params.variant.default_count)) {
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Find a rule whose effect is only known after the chain has run: a
+ * 'schema' validates its value later, a collection rule accumulates
+ * across elements. any_of and none_of try branches and drop the failed
+ * ones, which these cannot take part in. Returns the first, or NULL.
+ * Recursion is bounded by SF_MAX_RULE_PARSE_DEPTH.
+ */
+static const sf_parsed_rule_t *find_deferred_rule(sf_parsed_rule_t **rules, size_t count)
+{
+    const sf_parsed_rule_t *found = NULL;
+
+    for (size_t i = 0; i < count && !found; i++) {
+        sf_parsed_rule_t *rule = rules[i];
+
+        if (rule->type == RULE_SCHEMA || SF_RULE_IS_AGGREGATE(rule->type)) {
+            return rule;
+        }
+
+        if (rule->type == RULE_WHEN) {
+            found = find_deferred_rule(rule->params.conditional.then_rules, rule->params.conditional.then_count);
+            if (!found) {
+                found = find_deferred_rule(rule->params.conditional.else_rules, rule->params.conditional.else_count);
+            }
+        } else if (rule->type == RULE_VARIANT) {
+            for (uint32_t k = 0; k < rule->params.variant.case_count && !found; k++) {
+                found = find_deferred_rule(rule->params.variant.case_rules[k], rule->params.variant.case_counts[k]);
+            }
+            if (!found) {
+                found = find_deferred_rule(rule->params.variant.default_rules, rule->params.variant.default_count);
+            }
+        } else if (SF_RULE_IS_COMBINATOR(rule->type)) {
+            for (uint32_t k = 0; k < rule->params.combinator.branch_count && !found; k++) {
+                found = find_deferred_rule(rule->params.combinator.branch_rules[k],
+                    rule->params.combinator.branch_counts[k]);
+            }
+        }
+    }
+
+    return found;
+}
+
+/*
+ * Parse [name, branch, ...] for any_of, all_of and none_of. A branch is a
+ * rule list, or a single rule name. Leaves partial results on the rule for
+ * sf_free_parsed_rule() on error.
+ */
+static bool parse_combinator(sf_parsed_rule_t *rule, HashTable *arr, size_t depth, const char *name)
+{
+    uint32_t count = zend_hash_num_elements(arr) - 1;
+
+    if (count == 0) {
+        zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+            "Rule '%s' requires at least one branch", name);
+        return 0;
+    }
+
+    rule->params.combinator.branch_rules = ecalloc(count, sizeof(sf_parsed_rule_t **));
+    rule->params.combinator.branch_counts = ecalloc(count, sizeof(size_t));
+
+    zend_ulong h;
+    zend_string *key;
+    zval *branch;
+    ZEND_HASH_FOREACH_KEY_VAL(arr, h, key, branch) {
+        if (!key && h == 0) {
+            continue;
+        }
+
+        uint32_t k = rule->params.combinator.branch_count++;
+
+        if (Z_TYPE_P(branch) == IS_ARRAY) {
+            if (!parse_rule_list(Z_ARRVAL_P(branch), depth,
+                    &rule->params.combinator.branch_rules[k], &rule->params.combinator.branch_counts[k])) {
+                return 0;
+            }
+        } else if (Z_TYPE_P(branch) == IS_STRING) {
+            rule->params.combinator.branch_rules[k] = ecalloc(1, sizeof(sf_parsed_rule_t *));
+            rule->params.combinator.branch_rules[k][0] = parse_single_rule_with_depth(branch, depth + 1);
+            if (!rule->params.combinator.branch_rules[k][0]) {
+                return 0;
+            }
+            rule->params.combinator.branch_counts[k] = 1;
+        } else {
+            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                "Rule '%s' branches must be rule arrays", name);
+            return 0;
+        }
+
+        const sf_parsed_rule_t *deferred = rule->type == RULE_ALL_OF ? NULL
+            : find_deferred_rule(rule->params.combinator.branch_rules[k], rule->params.combinator.branch_counts[k]);
+        if (deferred) {
+            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                "Rule '%s' cannot be used inside '%s'", sf_get_rule_name(deferred->type), name);
+            return 0;
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    return 1;
+}
+
+/*
+ * Parse a collection rule's parameters; arr is NULL for the plain string
+ * form. Throws and returns 0 on missing or invalid parameters.
+ *
+ *   'unique'                       no parameters
+ *   'sorted', ['sorted', 'desc']   direction 'asc' (default) or 'desc'
+ *   ['sum_min', n], ['sum_max', n] integer or float bound
+ *   ['count_where', value, max]    scalar value, non-negative count
+ */
+static bool parse_aggregate(sf_parsed_rule_t *rule, HashTable *arr, const char *name)
+{
+    zval *first = arr ? zend_hash_index_find(arr, 1) : NULL;
+    zval *second = arr ? zend_hash_index_find(arr, 2) : NULL;
+
+    switch (rule->type) {
+        case RULE_SORTED:
+            if (first && (Z_TYPE_P(first) != IS_STRING
+                    || (!zend_string_equals_literal(Z_STR_P(first), "asc")
+                        && !zend_string_equals_literal(Z_STR_P(first), "desc")))) {
+                zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                    "Rule 'sorted' direction must be 'asc' or 'desc'");
+                return 0;
+            }
+            rule->params.aggregate.descending = first && zend_string_equals_literal(Z_STR_P(first), "desc");
+            return 1;
+
+        case RULE_SUM_MIN:
+        case RULE_SUM_MAX:
+            if (!first || (Z_TYPE_P(first) != IS_LONG && Z_TYPE_P(first) != IS_DOUBLE)) {
+                zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                    "Rule '%s' requires a numeric parameter", name);
+                return 0;
+            }
+            ZVAL_COPY_VALUE(&rule->params.aggregate.operand, first);
+            return 1;
+
+        case RULE_COUNT_WHERE:
+            if (!first || !second
+                || Z_TYPE_P(first) == IS_NULL || Z_TYPE_P(first) >= IS_ARRAY
+                || Z_TYPE_P(second) != IS_LONG || Z_LVAL_P(second) < 0) {
+                zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                    "Rule 'count_where' requires a scalar value and a maximum count");
+                return 0;
+            }
+            ZVAL_COPY(&rule->params.aggregate.operand, first);
+            rule->params.aggregate.max = Z_LVAL_P(second);
+            return 1;
+
+        default:
+            return 1;
+    }
+}
+
+/* Free a presence rule's parameters */
+static void free_presence(sf_parsed_rule_t *rule)
+{
+    for (uint32_t k = 0; k < rule->params.presence.ref_count; k++) {
+        efree(rule->params.presence.refs[k].field);
+        sf_path_destroy(&rule->params.presence.refs[k].path);
+    }
+    if (rule->params.presence.refs) {
+        efree(rule->params.presence.refs);
+    }
+    if (rule->params.presence.values) {
+        zend_hash_destroy(rule->params.presence.values);
+        FREE_HASHTABLE(rule->params.presence.values);
+    }
+    sf_value_set_release(rule->params.presence.set);
+}
+
+/* Add a field to a presence rule; 0 if it is not a field name */
+static bool add_presence_ref(sf_parsed_rule_t *rule, zval *field)
+{
+    if (Z_TYPE_P(field) != IS_STRING || Z_STRLEN_P(field) == 0) {
+        return 0;
+    }
+
+    sf_presence_ref_t *ref = &rule->params.presence.refs[rule->params.presence.ref_count++];
+    ref->field = estrndup(Z_STRVAL_P(field), Z_STRLEN_P(field));
+    ref->len = Z_STRLEN_P(field);
+    sf_path_init(&ref->path, Z_STRVAL_P(field), Z_STRLEN_P(field));
+    ref->fact = SF_NO_FACT;
+    return 1;
+}
+
+/*
+ * Parse a presence rule's parameters. Throws and returns 0 on missing or
+ * invalid parameters (freeing what was parsed).
+ *
+ *   ['required_if', field, value, ...]     also required_unless,
+ *   ['required_if', field, [value, ...]]   prohibited_if and exclude_if
+ *   ['required_with', field, ...]          also required_with_all,
+ *   ['required_with', [field, ...]]        required_without(_all)
+ */
+static bool parse_presence(sf_parsed_rule_t *rule, HashTable *arr, const char *name)
+{
+    uint32_t argc = zend_hash_num_elements(arr) - 1;
+    zval *first = zend_hash_index_find(arr, 1);
+    zval *second = zend_hash_index_find(arr, 2);
+    zval *item;
+
+    if (SF_RULE_IS_PRESENCE_MATCH(rule->type)) {
+        if (!first || !second || argc < 2 || Z_TYPE_P(first) != IS_STRING || Z_STRLEN_P(first) == 0
+            || (Z_TYPE_P(second) == IS_ARRAY && (argc > 2 || zend_hash_num_elements(Z_ARRVAL_P(second)) == 0))) {
+            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                "Rule '%s' requires a field name and at least one value", name);
+            return 0;
+        }
+
+        rule->params.presence.refs = ecalloc(1, sizeof(sf_presence_ref_t));
+        add_presence_ref(rule, first);
+
+        HashTable *values;
+        ALLOC_HASHTABLE(values);
+        if (Z_TYPE_P(second) == IS_ARRAY) {
+            zend_hash_init(values, zend_hash_num_elements(Z_ARRVAL_P(second)), NULL, ZVAL_PTR_DTOR, 0);
+            zend_hash_copy(values, Z_ARRVAL_P(second), zval_add_ref);
+        } else {
+            zend_hash_init(values, argc - 1, NULL, ZVAL_PTR_DTOR, 0);
+            for (zend_ulong k = 2; (item = zend_hash_index_find(arr, k)); k++) {
+                Z_TRY_ADDREF_P(item);
+                zend_hash_next_index_insert(values, item);
+            }
+        }
+        rule->params.presence.values = values;
+        rule->params.presence.set = sf_value_set_build(values, SF_SET_LOOSE);
+        return 1;
+    }
+
+    /* A single array holds the field names */
+    HashTable *fields = arr;
+    uint32_t count = argc;
+    if (first && argc == 1 && Z_TYPE_P(first) == IS_ARRAY) {
+        fields = Z_ARRVAL_P(first);
+        count = zend_hash_num_elements(fields);
+    }
+
+    if (count == 0) {
+        zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+            "Rule '%s' requires at least one field name", name);
+        return 0;
+    }
+
+    rule->params.presence.refs = ecalloc(count, sizeof(sf_presence_ref_t));
+    bool ok = 1;
+    if (fields == arr) {
+        for (zend_ulong k = 1; ok && (item = zend_hash_index_find(arr, k)); k++) {
+            ok = add_presence_ref(rule, item);
+        }
+    } else {
+        ZEND_HASH_FOREACH_VAL(fields, item) {
+            if (!(ok = add_presence_ref(rule, item))) {
+                break;
+            }
+        } ZEND_HASH_FOREACH_END();
+    }
+
+    if (!ok) {
+        zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+            "Rule '%s' requires at least one field name", name);
+        free_presence(rule);
+        return 0;
+    }
+    return 1;
+}
+
 /*
  * Parse a single rule from PHP value with depth tracking.
  *
@@ -174,6 +590,42 @@ static sf_parsed_rule_t *parse_single_rule_with_depth(zval *rule_zval, size_t de
             efree(rule);
             return NULL;
         }
+
+        if (SF_RULE_IS_COMBINATOR(rule->type)) {
+            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                "Rule '%s' requires at least one branch", ZSTR_VAL(name));
+            efree(rule);
+            return NULL;
+        }
+
+        if (SF_RULE_IS_AGGREGATE(rule->type) && !parse_aggregate(rule, NULL, ZSTR_VAL(name))) {
+            efree(rule);
+            return NULL;
+        }
+
+        if (rule->type == RULE_ENUM) {
+            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                "Rule 'enum' requires a backed enum class");
+            efree(rule);
+            return NULL;
+        }
+
+        if (rule->type == RULE_KEYS) {
+            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                "Rule 'keys' requires an array of keys");
+            efree(rule);
+            return NULL;
+        }
+
+        if (SF_RULE_IS_PRESENCE(rule->type)) {
+            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                SF_RULE_IS_PRESENCE_MATCH(rule->type)
+                    ? "Rule '%s' requires a field name and at least one value"
+                    : "Rule '%s' requires at least one field name",
+                ZSTR_VAL(name));
+            efree(rule);
+            return NULL;
+        }
     } else if (Z_TYPE_P(rule_zval) == IS_ARRAY) {
         /* Parameterized rule: ['min', 5], ['between', 1, 10], etc. */
         HashTable *arr = Z_ARRVAL_P(rule_zval);
@@ -286,6 +738,7 @@ static sf_parsed_rule_t *parse_single_rule_with_depth(zval *rule_zval, size_t de
                 }
                 rule->params.field_ref.field = estrndup(Z_STRVAL_P(field), Z_STRLEN_P(field));
                 rule->params.field_ref.len = Z_STRLEN_P(field);
+                sf_path_init(&rule->params.field_ref.path, Z_STRVAL_P(field), Z_STRLEN_P(field));
                 break;
             }
 
@@ -301,6 +754,97 @@ static sf_parsed_rule_t *parse_single_rule_with_depth(zval *rule_zval, size_t de
                 ALLOC_HASHTABLE(rule->params.in_list.values);
                 zend_hash_init(rule->params.in_list.values, zend_hash_num_elements(Z_ARRVAL_P(values)), NULL, ZVAL_PTR_DTOR, 0);
                 zend_hash_copy(rule->params.in_list.values, Z_ARRVAL_P(values), zval_add_ref);
+
+                /* Optional comparison mode: ['in', [...], 'strict'|'ci'] */
+                zval *mode = zend_hash_index_find(arr, 2);
+                rule->params.in_list.mode = SF_SET_LOOSE;
+                if (mode) {
+                    if (Z_TYPE_P(mode) == IS_STRING && zend_string_equals_literal(Z_STR_P(mode), "strict")) {
+                        rule->params.in_list.mode = SF_SET_STRICT;
+                    } else if (Z_TYPE_P(mode) == IS_STRING && zend_string_equals_literal(Z_STR_P(mode), "ci")) {
+                        rule->params.in_list.mode = SF_SET_CI;
+                    } else {
+                        zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                            "Rule '%s' mode must be 'strict' or 'ci'", ZSTR_VAL(name));
+                        zend_hash_destroy(rule->params.in_list.values);
+                        FREE_HASHTABLE(rule->params.in_list.values);
+                        efree(rule);
+                        return NULL;
+                    }
+                }
+                rule->params.in_list.set = sf_value_set_build(rule->params.in_list.values, rule->params.in_list.mode);
+                break;
+            }
+
+            case RULE_KEYS: {
+                /* ['keys', [key, ...]] */
+                zval *list = zend_hash_index_find(arr, 1);
+                if (!list || Z_TYPE_P(list) != IS_ARRAY) {
+                    zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                        "Rule 'keys' requires an array of keys");
+                    efree(rule);
+                    return NULL;
+                }
+
+                HashTable *keys;
+                ALLOC_HASHTABLE(keys);
+                zend_hash_init(keys, zend_hash_num_elements(Z_ARRVAL_P(list)), NULL, NULL, 0);
+
+                zval *key, empty;
+                ZVAL_NULL(&empty);
+                ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(list), key) {
+                    ZVAL_DEREF(key);
+                    if (Z_TYPE_P(key) == IS_STRING) {
+                        /* "12" names the integer key 12, as in an array */
+                        zend_symtable_update(keys, Z_STR_P(key), &empty);
+                    } else if (Z_TYPE_P(key) == IS_LONG) {
+                        zend_hash_index_update(keys, (zend_ulong)Z_LVAL_P(key), &empty);
+                    } else {
+                        zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                            "Rule 'keys' keys must be strings or integers");
+                        zend_hash_destroy(keys);
+                        FREE_HASHTABLE(keys);
+                        efree(rule);
+                        return NULL;
+                    }
+                } ZEND_HASH_FOREACH_END();
+
+                rule->params.key_index.keys = keys;
+                break;
+            }
+
+            case RULE_ENUM: {
+                /* ['enum', Status::class, 'cast'?] */
+                zval *class_name = zend_hash_index_find(arr, 1);
+                zval *option = zend_hash_index_find(arr, 2);
+                zend_class_entry *ce = NULL;
+
+                if (class_name && Z_TYPE_P(class_name) == IS_STRING) {
+                    ce = zend_lookup_class(Z_STR_P(class_name));
+                }
+                if (!ce || !(ce->ce_flags & ZEND_ACC_ENUM) || ce->enum_backing_type == IS_UNDEF) {
+                    /* Keep an autoloader's exception */
+                    if (!EG(exception)) {
+                        zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                            "Rule 'enum' requires a backed enum class");
+                    }
+                    efree(rule);
+                    return NULL;
+                }
+
+                if (option && (Z_TYPE_P(option) != IS_STRING || !zend_string_equals_literal(Z_STR_P(option), "cast"))) {
+                    zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                        "Rule 'enum' option must be 'cast'");
+                    efree(rule);
+                    return NULL;
+                }
+
+                rule->params.enum_cases.table = sf_enum_table_get(ce);
+                if (!rule->params.enum_cases.table) {
+                    efree(rule);
+                    return NULL;
+                }
+                rule->params.enum_cases.cast = option != NULL;
                 break;
             }
 
@@ -387,6 +931,60 @@ static sf_parsed_rule_t *parse_single_rule_with_depth(zval *rule_zval, size_t de
                 break;
             }
 
+            case RULE_VARIANT:
+                if (!parse_variant(rule, arr, depth)) {
+                    sf_free_parsed_rule(rule);
+                    return NULL;
+                }
+                break;
+
+            case RULE_ANY_OF:
+            case RULE_ALL_OF:
+            case RULE_NONE_OF:
+                if (!parse_combinator(rule, arr, depth, ZSTR_VAL(name))) {
+                    sf_free_parsed_rule(rule);
+                    return NULL;
+                }
+                break;
+
+            case RULE_UNIQUE:
+            case RULE_SORTED:
+            case RULE_SUM_MIN:
+            case RULE_SUM_MAX:
+            case RULE_COUNT_WHERE:
+                if (!parse_aggregate(rule, arr, ZSTR_VAL(name))) {
+                    efree(rule);
+                    return NULL;
+                }
+                break;
+
+            case RULE_REQUIRED_IF:
+            case RULE_REQUIRED_UNLESS:
+            case RULE_PROHIBITED_IF:
+            case RULE_EXCLUDE_IF:
+            case RULE_REQUIRED_WITH:
+            case RULE_REQUIRED_WITH_ALL:
+            case RULE_REQUIRED_WITHOUT:
+            case RULE_REQUIRED_WITHOUT_ALL:
+                if (!parse_presence(rule, arr, ZSTR_VAL(name))) {
+                    efree(rule);
+                    return NULL;
+                }
+                break;
+
+            case RULE_SCHEMA: {
+                /* ['schema', name]; the name is resolved when compiling */
+                zval *schema = zend_hash_index_find(arr, 1);
+                if (!schema || Z_TYPE_P(schema) != IS_STRING || Z_STRLEN_P(schema) == 0) {
+                    zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                        "Rule 'schema' requires a schema name");
+                    efree(rule);
+                    return NULL;
+                }
+                rule->params.schema.name = zend_string_copy(Z_STR_P(schema));
+                break;
+            }
+
             default:
                 /* No parameters needed or already handled */
                 break;
@@ -401,110 +999,296 @@ static sf_parsed_rule_t *parse_single_rule_with_depth(zval *rule_zval, size_t de
     return rule;
 }
 
-/* Parse rules from PHP array */
-HashTable *sf_parse_rules(HashTable *rules_array)
+/* Whether a path has a '*' segment */
+static bool path_has_wildcard(const sf_path_t *path)
 {
-    HashTable *parsed_rules;
-    ALLOC_HASHTABLE(parsed_rules);
-    zend_hash_init(parsed_rules, zend_hash_num_elements(rules_array), NULL, NULL, 0);
-
-    zend_string *field_name;
-    zval *field_rules;
-
-    ZEND_HASH_FOREACH_STR_KEY_VAL(rules_array, field_name, field_rules) {
-        if (!field_name) {
-            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
-                "Field names must be strings");
-            sf_free_parsed_rules_ht(parsed_rules);
-            return NULL;
+    for (uint32_t i = 0; i < path->count; i++) {
+        if (path->segments[i].is_wildcard) {
+            return 1;
         }
+    }
+    return 0;
+}
 
-        /* Check field name length to prevent resource exhaustion */
-        if (ZSTR_LEN(field_name) == 0) {
-            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
-                "Field name cannot be empty");
-            sf_free_parsed_rules_ht(parsed_rules);
-            return NULL;
-        }
+/*
+ * Bind the field references and condition subjects of a rule list to the
+ * field it belongs to. Throws and returns 0 on a reference that does not
+ * fit the field, or on a collection rule outside a wildcard field.
+ * Recursion is bounded by SF_MAX_RULE_PARSE_DEPTH.
+ */
+static bool bind_references(sf_parsed_rule_t **rules, size_t count, const sf_path_t *field, const char *field_name)
+{
+    for (size_t i = 0; i < count; i++) {
+        sf_parsed_rule_t *rule = rules[i];
 
-        if (ZSTR_LEN(field_name) > SF_FIELD_NAME_MAX_LENGTH) {
-            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
-                "Field name exceeds maximum length of %d characters",
-                SF_FIELD_NAME_MAX_LENGTH);
-            sf_free_parsed_rules_ht(parsed_rules);
-            return NULL;
-        }
+        switch (rule->type) {
+            case RULE_SAME:
+            case RULE_DIFFERENT:
+            case RULE_AFTER:
+            case RULE_BEFORE:
+            case RULE_AFTER_OR_EQUAL:
+            case RULE_BEFORE_OR_EQUAL:
+                if (!sf_path_bind(&rule->params.field_ref.path, field)) {
+                    zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                        "Field reference '%s' does not fit field '%s'",
+                        rule->params.field_ref.field, field_name);
+                    return 0;
+                }
+                break;
 
-        /* Validate field name characters */
-        if (!sf_validate_rule_name(ZSTR_VAL(field_name), ZSTR_LEN(field_name))) {
-            /* Allow dot notation for nested fields: items.*.name */
-            const char *p = ZSTR_VAL(field_name);
-            size_t len = ZSTR_LEN(field_name);
-            bool valid = 1;
+            case RULE_WHEN:
+                if (!sf_condition_bind(rule->params.conditional.condition, field)) {
+                    zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                        "Condition field reference does not fit field '%s'", field_name);
+                    return 0;
+                }
+                if (!bind_references(rule->params.conditional.then_rules,
+                        rule->params.conditional.then_count, field, field_name)
+                    || !bind_references(rule->params.conditional.else_rules,
+                        rule->params.conditional.else_count, field, field_name)) {
+                    return 0;
+                }
+                break;
 
-            /* First character must be a letter or underscore (not digit, dot, or asterisk) */
-            if (len > 0) {
-                char first = p[0];
-                if (!((first >= 'a' && first <= 'z') || first == '_')) {
-                    valid = 0;
+            case RULE_VARIANT:
+                /* A relative discriminator is rewritten; its literal key means nothing */
+                if (sf_path_is_relative(&rule->params.variant.path) && rule->params.variant.key) {
+                    zend_string_release(rule->params.variant.key);
+                    rule->params.variant.key = NULL;
                 }
-            }
+                if (!sf_path_bind(&rule->params.variant.path, field)) {
+                    zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                        "Field reference '%s' does not fit field '%s'",
+                        rule->params.variant.field, field_name);
+                    return 0;
+                }
+                for (uint32_t k = 0; k < rule->params.variant.case_count; k++) {
+                    if (!bind_references(rule->params.variant.case_rules[k],
+                            rule->params.variant.case_counts[k], field, field_name)) {
+                        return 0;
+                    }
+                }
+                if (!bind_references(rule->params.variant.default_rules,
+                        rule->params.variant.default_count, field, field_name)) {
+                    return 0;
+                }
+                break;
 
-            for (size_t i = 1; i < len && valid; i++) {
-                char c = p[i];
-                if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '*')) {
-                    valid = 0;
+            case RULE_ANY_OF:
+            case RULE_ALL_OF:
+            case RULE_NONE_OF:
+                for (uint32_t k = 0; k < rule->params.combinator.branch_count; k++) {
+                    if (!bind_references(rule->params.combinator.branch_rules[k],
+                            rule->params.combinator.branch_counts[k], field, field_name)) {
+                        return 0;
+                    }
                 }
-            }
+                break;
 
-            /* Don't allow consecutive dots or ending with dot */
-            if (valid && len > 1) {
-                for (size_t i = 1; i < len && valid; i++) {
-                    if (p[i] == '.' && p[i-1] == '.') {
-                        valid = 0;
+            case RULE_REQUIRED_IF:
+            case RULE_REQUIRED_UNLESS:
+            case RULE_PROHIBITED_IF:
+            case RULE_EXCLUDE_IF:
+            case RULE_REQUIRED_WITH:
+            case RULE_REQUIRED_WITH_ALL:
+            case RULE_REQUIRED_WITHOUT:
+            case RULE_REQUIRED_WITHOUT_ALL:
+                for (uint32_t k = 0; k < rule->params.presence.ref_count; k++) {
+                    sf_presence_ref_t *ref = &rule->params.presence.refs[k];
+                    if (!sf_path_bind(&ref->path, field)) {
+                        zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                            "Field reference '%s' does not fit field '%s'", ref->field, field_name);
+                        return 0;
                     }
                 }
-                if (p[len-1] == '.') {
-                    valid = 0;
+                break;
+
+            case RULE_UNIQUE:
+            case RULE_SORTED:
+            case RULE_SUM_MIN:
+            case RULE_SUM_MAX:
+            case RULE_COUNT_WHERE:
+                if (!path_has_wildcard(field)) {
+                    zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                        "Rule '%s' requires a wildcard field, not '%s'",
+                        sf_get_rule_name(rule->type), field_name);
+                    return 0;
                 }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return 1;
+}
+
+/* Check a field name; throws and returns 0 if it is not acceptable */
+static bool check_field_name(zend_string *field_name)
+{
+    if (!field_name) {
+        zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+            "Field names must be strings");
+        return 0;
+    }
+
+    /* Check field name length to prevent resource exhaustion */
+    if (ZSTR_LEN(field_name) == 0) {
+        zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+            "Field name cannot be empty");
+        return 0;
+    }
+
+    if (ZSTR_LEN(field_name) > SF_FIELD_NAME_MAX_LENGTH) {
+        zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+            "Field name exceeds maximum length of %d characters",
+            SF_FIELD_NAME_MAX_LENGTH);
+        return 0;
+    }
+
+    /* Validate field name characters */
+    if (!sf_validate_rule_name(ZSTR_VAL(field_name), ZSTR_LEN(field_name))) {
+        /* Allow dot notation for nested fields: items.*.name */
+        const char *p = ZSTR_VAL(field_name);
+        size_t len = ZSTR_LEN(field_name);
+        bool valid = 1;
+
+        /* First character must be a letter or underscore (not digit, dot, or asterisk) */
+        if (len > 0) {
+            char first = p[0];
+            if (!((first >= 'a' && first <= 'z') || first == '_')) {
+                valid = 0;
             }
+        }
 
-            if (!valid) {
-                zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
-                    "Invalid field name: %s", ZSTR_VAL(field_name));
-                sf_free_parsed_rules_ht(parsed_rules);
-                return NULL;
+        for (size_t i = 1; i < len && valid; i++) {
+            char c = p[i];
+            if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '*')) {
+                valid = 0;
+            }
+        }
+
+        /* Don't allow consecutive dots or ending with dot */
+        if (valid && len > 1) {
+            for (size_t i = 1; i < len && valid; i++) {
+                if (p[i] == '.' && p[i-1] == '.') {
+                    valid = 0;
+                }
+            }
+            if (p[len-1] == '.') {
+                valid = 0;
             }
         }
 
-        if (Z_TYPE_P(field_rules) != IS_ARRAY) {
+        if (!valid) {
             zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
-                "Rules for field '%s' must be an array", ZSTR_VAL(field_name));
+                "Invalid field name: %s", ZSTR_VAL(field_name));
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Check that a field's rules are given as an array */
+static bool check_rules_array(zend_string *field_name, zval *field_rules)
+{
+    if (Z_TYPE_P(field_rules) != IS_ARRAY) {
+        zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+            "Rules for field '%s' must be an array", ZSTR_VAL(field_name));
+        return 0;
+    }
+    return 1;
+}
+
+/* Parse one field's rules */
+sf_field_rules_t *sf_parse_field_rules(zend_string *field_name, zval *field_rules)
+{
+    if (!check_field_name(field_name) || !check_rules_array(field_name, field_rules)) {
+        return NULL;
+    }
+
+    /* Create field rules structure */
+    sf_field_rules_t *fr = ecalloc(1, sizeof(sf_field_rules_t));
+    fr->field_name = estrndup(ZSTR_VAL(field_name), ZSTR_LEN(field_name));
+    fr->field_len = ZSTR_LEN(field_name);
+
+    HashTable *rules_arr = Z_ARRVAL_P(field_rules);
+    size_t rule_count = zend_hash_num_elements(rules_arr);
+    fr->rules = ecalloc(rule_count, sizeof(sf_parsed_rule_t *));
+    fr->rule_count = 0;
+
+    zval *rule_zval;
+    ZEND_HASH_FOREACH_VAL(rules_arr, rule_zval) {
+        sf_parsed_rule_t *parsed = parse_single_rule(rule_zval);
+        if (!parsed) {
+            sf_free_field_rules(fr);
+            return NULL;
+        }
+        fr->rules[fr->rule_count++] = parsed;
+    } ZEND_HASH_FOREACH_END();
+
+    /* Relative references resolve against this field's path */
+    sf_path_t field_path;
+    sf_path_init(&field_path, fr->field_name, fr->field_len);
+    bool bound = bind_references(fr->rules, fr->rule_count, &field_path, fr->field_name);
+    sf_path_destroy(&field_path);
+
+    if (!bound) {
+        sf_free_field_rules(fr);
+        return NULL;
+    }
+
+    return fr;
+}
+
+/* Parse rules from PHP array */
+HashTable *sf_parse_rules(HashTable *rules_array)
+{
+    HashTable *parsed_rules;
+    ALLOC_HASHTABLE(parsed_rules);
+    zend_hash_init(parsed_rules, zend_hash_num_elements(rules_array), NULL, NULL, 0);
+
+    zend_string *field_name;
+    zval *field_rules;
+
+    ZEND_HASH_FOREACH_STR_KEY_VAL(rules_array, field_name, field_rules) {
+        sf_field_rules_t *fr = sf_parse_field_rules(field_name, field_rules);
+        if (!fr) {
+            sf_free_parsed_rules_ht(parsed_rules);
+            return NULL;
+        }
+
+        zend_hash_add_ptr(parsed_rules, field_name, fr);
+    } ZEND_HASH_FOREACH_END();
+
+    return parsed_rules;
+}
+
+/*
+ * Check field names only, keeping each field's rules array unparsed in
+ * sf_field_rules_t.source (lazy mode; see sf_compile_field).
+ */
+HashTable *sf_parse_rules_deferred(HashTable *rules_array)
+{
+    HashTable *parsed_rules;
+    ALLOC_HASHTABLE(parsed_rules);
+    zend_hash_init(parsed_rules, zend_hash_num_elements(rules_array), NULL, NULL, 0);
+
+    zend_string *field_name;
+    zval *field_rules;
+
+    ZEND_HASH_FOREACH_STR_KEY_VAL(rules_array, field_name, field_rules) {
+        if (!check_field_name(field_name) || !check_rules_array(field_name, field_rules)) {
             sf_free_parsed_rules_ht(parsed_rules);
             return NULL;
         }
 
-        /* Create field rules structure */
         sf_field_rules_t *fr = ecalloc(1, sizeof(sf_field_rules_t));
         fr->field_name = estrndup(ZSTR_VAL(field_name), ZSTR_LEN(field_name));
         fr->field_len = ZSTR_LEN(field_name);
-
-        HashTable *rules_arr = Z_ARRVAL_P(field_rules);
-        size_t rule_count = zend_hash_num_elements(rules_arr);
-        fr->rules = ecalloc(rule_count, sizeof(sf_parsed_rule_t *));
-        fr->rule_count = 0;
-
-        zval *rule_zval;
-        ZEND_HASH_FOREACH_VAL(rules_arr, rule_zval) {
-            sf_parsed_rule_t *parsed = parse_single_rule(rule_zval);
-            if (!parsed) {
-                /* Cleanup */
-                sf_free_field_rules(fr);
-                sf_free_parsed_rules_ht(parsed_rules);
-                return NULL;
-            }
-            fr->rules[fr->rule_count++] = parsed;
-        } ZEND_HASH_FOREACH_END();
+        ZVAL_COPY(&fr->source, field_rules);
 
         zend_hash_add_ptr(parsed_rules, field_name, fr);
     } ZEND_HASH_FOREACH_END();
@@ -512,11 +1296,40 @@ HashTable *sf_parse_rules(HashTable *rules_array)
     return parsed_rules;
 }
 
-/* Free a parsed rule */
-void sf_free_parsed_rule(sf_parsed_rule_t *rule)
+/* Whether an unparsed rules array names a rule of the given type at its top level */
+bool sf_source_has_rule(zval *source, sf_rule_type_t type)
 {
-    if (!rule) return;
+    zval *rule;
+    ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(source), rule) {
+        if (Z_TYPE_P(rule) == IS_STRING
+            && sf_get_rule_type(Z_STRVAL_P(rule), Z_STRLEN_P(rule)) == type) {
+            return 1;
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    return 0;
+}
+
+/* Whether the first rule of an unparsed rules array, past 'bail' and 'sometimes', is of the given type */
+bool sf_source_leads_with(zval *source, sf_rule_type_t type)
+{
+    zval *rule;
+    ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(source), rule) {
+        if (Z_TYPE_P(rule) != IS_STRING) {
+            return 0;
+        }
+        sf_rule_type_t found = sf_get_rule_type(Z_STRVAL_P(rule), Z_STRLEN_P(rule));
+        if (found != RULE_BAIL && found != RULE_SOMETIMES) {
+            return found == type;
+        }
+    } ZEND_HASH_FOREACH_END();
 
+    return 0;
+}
+
+/* Free the parameters owned by a parsed rule, leaving the struct itself */
+void sf_free_rule_params(sf_parsed_rule_t *rule)
+{
     switch (rule->type) {
         case RULE_REGEX:
         case RULE_NOT_REGEX:
@@ -536,6 +1349,7 @@ void sf_free_parsed_rule(sf_parsed_rule_t *rule)
 
         case RULE_SAME:
         case RULE_DIFFERENT:
+        case RULE_CONFIRMED:
         case RULE_AFTER:
         case RULE_BEFORE:
         case RULE_AFTER_OR_EQUAL:
@@ -543,6 +1357,18 @@ void sf_free_parsed_rule(sf_parsed_rule_t *rule)
             if (rule->params.field_ref.field) {
                 efree(rule->params.field_ref.field);
             }
+            sf_path_destroy(&rule->params.field_ref.path);
+            break;
+
+        case RULE_REQUIRED_IF:
+        case RULE_REQUIRED_UNLESS:
+        case RULE_PROHIBITED_IF:
+        case RULE_EXCLUDE_IF:
+        case RULE_REQUIRED_WITH:
+        case RULE_REQUIRED_WITH_ALL:
+        case RULE_REQUIRED_WITHOUT:
+        case RULE_REQUIRED_WITHOUT_ALL:
+            free_presence(rule);
             break;
 
         case RULE_IN:
@@ -551,6 +1377,15 @@ void sf_free_parsed_rule(sf_parsed_rule_t *rule)
                 zend_hash_destroy(rule->params.in_list.values);
                 FREE_HASHTABLE(rule->params.in_list.values);
             }
+            sf_value_set_release(rule->params.in_list.set);
+            break;
+
+        case RULE_KEYS:
+        case RULE_STRICT:
+            if (rule->params.key_index.keys) {
+                zend_hash_destroy(rule->params.key_index.keys);
+                FREE_HASHTABLE(rule->params.key_index.keys);
+            }
             break;
 
         case RULE_WHEN:
@@ -571,10 +1406,85 @@ void sf_free_parsed_rule(sf_parsed_rule_t *rule)
             }
             break;
 
+        case RULE_VARIANT:
+            if (rule->params.variant.field) {
+                efree(rule->params.variant.field);
+            }
+            sf_path_destroy(&rule->params.variant.path);
+            if (rule->params.variant.key) {
+                zend_string_release(rule->params.variant.key);
+            }
+            if (rule->params.variant.cases) {
+                zend_hash_destroy(rule->params.variant.cases);
+                FREE_HASHTABLE(rule->params.variant.cases);
+            }
+            sf_value_set_release(rule->params.variant.set);
+            if (rule->params.variant.case_rules) {
+                for (uint32_t k = 0; k < rule->params.variant.case_count; k++) {
+                    sf_parsed_rule_t **list = rule->params.variant.case_rules[k];
+                    for (size_t i = 0; list && i < rule->params.variant.case_counts[k]; i++) {
+                        sf_free_parsed_rule(list[i]);
+                    }
+                    if (list) {
+                        efree(list);
+                    }
+                }
+                efree(rule->params.variant.case_rules);
+                efree(rule->params.variant.case_counts);
+            }
+            if (rule->params.variant.default_rules) {
+                for (size_t i = 0; i < rule->params.variant.default_count; i++) {
+                    sf_free_parsed_rule(rule->params.variant.default_rules[i]);
+                }
+                efree(rule->params.variant.default_rules);
+            }
+            if (rule->params.variant.starts) {
+                efree(rule->params.variant.starts);
+            }
+            break;
+
+        case RULE_ANY_OF:
+        case RULE_ALL_OF:
+        case RULE_NONE_OF:
+            if (rule->params.combinator.branch_rules) {
+                for (uint32_t k = 0; k < rule->params.combinator.branch_count; k++) {
+                    sf_parsed_rule_t **list = rule->params.combinator.branch_rules[k];
+                    for (size_t i = 0; list && i < rule->params.combinator.branch_counts[k]; i++) {
+                        sf_free_parsed_rule(list[i]);
+                    }
+                    if (list) {
+                        efree(list);
+                    }
+                }
+                efree(rule->params.combinator.branch_rules);
+                efree(rule->params.combinator.branch_counts);
+            }
+            if (rule->params.combinator.starts) {
+                efree(rule->params.combinator.starts);
+            }
+            break;
+
+        case RULE_COUNT_WHERE:
+            zval_ptr_dtor(&rule->params.aggregate.operand);
+            break;
+
+        case RULE_SCHEMA:
+            if (rule->params.schema.name) {
+                zend_string_release(rule->params.schema.name);
+            }
+            break;
+
         default:
             break;
     }
+}
 
+/* Free a parsed rule */
+void sf_free_parsed_rule(sf_parsed_rule_t *rule)
+{
+    if (!rule) return;
+
+    sf_free_rule_params(rule);
     efree(rule);
 }
 
@@ -594,6 +1504,8 @@ void sf_free_field_rules(sf_field_rules_t *field_rules)
         efree(field_rules->rules);
     }
 
+    zval_ptr_dtor(&field_rules->source);
+
     efree(field_rules);
 }
 
@@ -7,6 +7,8 @@
 
 #include "php_signalforge_validation.h"
 #include "condition.h"
+#include "util/value_set.h"
+#include "util/enum_table.h"
 
 /* Rule types */
 typedef enum {
@@ -16,6 +18,16 @@ typedef enum {
     RULE_FILLED,
     RULE_PRESENT,
 
+    /* Cross-field presence rules */
+    RULE_REQUIRED_IF,
+    RULE_REQUIRED_UNLESS,
+    RULE_PROHIBITED_IF,
+    RULE_EXCLUDE_IF,
+    RULE_REQUIRED_WITH,
+    RULE_REQUIRED_WITH_ALL,
+    RULE_REQUIRED_WITHOUT,
+    RULE_REQUIRED_WITHOUT_ALL,
+
     /* Type rules */
     RULE_STRING,
     RULE_INTEGER,
@@ -46,6 +58,15 @@ typedef enum {
 
     /* Array rules (reuse MIN, MAX, BETWEEN) */
     RULE_DISTINCT,
+    RULE_KEYS,
+    RULE_STRICT,
+
+    /* Collection rules: accumulate over the elements of a wildcard field */
+    RULE_UNIQUE,
+    RULE_SORTED,
+    RULE_SUM_MIN,
+    RULE_SUM_MAX,
+    RULE_COUNT_WHERE,
 
     /* Format rules */
     RULE_EMAIL,
@@ -63,6 +84,7 @@ typedef enum {
     /* Comparison rules */
     RULE_IN,
     RULE_NOT_IN,
+    RULE_ENUM,
     RULE_SAME,
     RULE_DIFFERENT,
     RULE_CONFIRMED,
@@ -75,6 +97,19 @@ typedef enum {
 
     /* Conditional */
     RULE_WHEN,
+    RULE_VARIANT,
+
+    /* Combinators */
+    RULE_ANY_OF,
+    RULE_ALL_OF,
+    RULE_NONE_OF,
+
+    /* Named sub-schemas */
+    RULE_SCHEMA,
+
+    /* Chain control */
+    RULE_BAIL,
+    RULE_SOMETIMES,
 
     /* Sentinel */
     RULE_UNKNOWN
@@ -83,6 +118,20 @@ typedef enum {
 /* Forward declaration */
 struct sf_parsed_rule_s;
 
+/* Presence rules: the field has no fact in the per-run bitmap */
+#define SF_NO_FACT UINT32_MAX
+
+/* Test a fact in a run's presence bitmap */
+#define SF_FACT_IS_SET(bits, fact) (((bits)[(fact) / 64] >> ((fact) % 64)) & 1)
+
+/* A field read by a presence rule */
+typedef struct {
+    char *field;
+    size_t len;
+    sf_path_t path;         /* Compiled from field */
+    uint32_t fact;          /* Compiled: bit in the per-run presence bitmap, or SF_NO_FACT */
+} sf_presence_ref_t;
+
 /* Parsed rule structure */
 typedef struct sf_parsed_rule_s {
     sf_rule_type_t type;
@@ -114,13 +163,35 @@ typedef struct sf_parsed_rule_s {
         struct {
             char *field;
             size_t len;
+            sf_path_t path;     /* Compiled from field */
         } field_ref;
 
         /* For in, not_in */
         struct {
             HashTable *values;
+            sf_set_mode_t mode;
+            sf_value_set_t *set;       /* Keyed members; NULL: compare one by one */
         } in_list;
 
+        /* For required_if and the other cross-field presence rules */
+        struct {
+            sf_presence_ref_t *refs;
+            uint32_t ref_count;
+            HashTable *values;      /* _if, _unless: values of refs[0] that trigger the rule */
+            sf_value_set_t *set;
+        } presence;
+
+        /* For keys, strict: the keys an array value may have */
+        struct {
+            HashTable *keys;        /* strict: compiled from the fields below; NULL: any key */
+        } key_index;
+
+        /* For enum */
+        struct {
+            sf_enum_table_t *table; /* Request-wide, shared (see util/enum_table.h) */
+            bool cast;              /* Validated output holds the case object */
+        } enum_cases;
+
         /* For when conditional */
         struct {
             sf_condition_t *condition;
@@ -129,24 +200,115 @@ typedef struct sf_parsed_rule_s {
             struct sf_parsed_rule_s **else_rules;
             size_t else_count;
         } conditional;
+
+        /*
+         * For variant: ['variant', field, [value => rules, ...], default_rules?]
+         *
+         * Also produced by the compiler for chains of 'when' rules testing
+         * one field against distinct constants (see src/program.c).
+         */
+        struct {
+            char *field;            /* Discriminator field, NULL if lowered */
+            size_t len;
+            sf_path_t path;         /* Compiled from field */
+            zend_string *key;       /* Literal key fallback for dotted names */
+            HashTable *cases;       /* Case value => case number, in case order */
+            uint32_t case_count;
+            struct sf_parsed_rule_s ***case_rules;   /* Parse tree: rules per case */
+            size_t *case_counts;
+            struct sf_parsed_rule_s **default_rules;
+            size_t default_count;
+            uint32_t *starts;       /* Compiled: first instruction per case, then the default's */
+            uint32_t end;           /* Compiled: first instruction after the variant */
+            sf_value_set_t *set;    /* Compiled: the case values keyed (sf_value_set_find); NULL: scan */
+            bool all_matches;       /* Compiled: run every case equal to the value, not the first */
+        } variant;
+
+        /* For any_of, all_of, none_of: [name, branch_rules, ...] */
+        struct {
+            struct sf_parsed_rule_s ***branch_rules;  /* Parse tree: rules per branch */
+            size_t *branch_counts;
+            uint32_t branch_count;
+            uint32_t *starts;       /* Compiled: first instruction per branch, then the end */
+        } combinator;
+
+        /*
+         * For unique, sorted, sum_min, sum_max, count_where:
+         * ['sorted', 'desc'], ['sum_max', bound], ['count_where', value, max]
+         */
+        struct {
+            zval operand;           /* sum_min/sum_max: the bound; count_where: the value counted */
+            zend_long max;          /* count_where: most elements that may equal operand */
+            bool descending;        /* sorted */
+            uint32_t slot;          /* Compiled: accumulator index (see sf_aggregate_t) */
+        } aggregate;
+
+        /* For schema: ['schema', name] */
+        struct {
+            zend_string *name;
+            uint32_t id;            /* Compiled: index into the schema table */
+        } schema;
+
+        /* For compiled superinstructions (see src/program.c) */
+        struct {
+            zend_long min;
+            zend_long max;
+            uint32_t flags;         /* SF_FUSED_* */
+            sf_rule_type_t compare; /* Comparison rule fused after 'integer' */
+        } fused;
     } params;
 } sf_parsed_rule_t;
 
+/* Whether a rule type is any_of, all_of or none_of */
+#define SF_RULE_IS_COMBINATOR(type) ((type) >= RULE_ANY_OF && (type) <= RULE_NONE_OF)
+
+/* Whether a rule type is a cross-field presence rule */
+#define SF_RULE_IS_PRESENCE(type) ((type) >= RULE_REQUIRED_IF && (type) <= RULE_REQUIRED_WITHOUT_ALL)
+
+/* Whether a presence rule compares a field's value (rather than testing fields are filled) */
+#define SF_RULE_IS_PRESENCE_MATCH(type) ((type) >= RULE_REQUIRED_IF && (type) <= RULE_EXCLUDE_IF)
+
+/* Whether a rule type is a collection rule accumulating across elements */
+#define SF_RULE_IS_AGGREGATE(type) ((type) >= RULE_UNIQUE && (type) <= RULE_COUNT_WHERE)
+
+/* Flags for params.fused */
+#define SF_FUSED_HAS_MIN    (1 << 0)
+#define SF_FUSED_HAS_MAX    (1 << 1)
+#define SF_FUSED_MAX_FIRST  (1 << 2)   /* max was declared before min */
+#define SF_FUSED_BETWEEN    (1 << 3)   /* Report as a single between rule */
+
 /* Field rules structure */
 typedef struct {
     char *field_name;
     size_t field_len;
     sf_parsed_rule_t **rules;
     size_t rule_count;
+    zval source;        /* Lazy mode: the unparsed rules array, else UNDEF */
 } sf_field_rules_t;
 
 /* Parse rules from PHP array */
 HashTable *sf_parse_rules(HashTable *rules_array);
 
+/* Parse one field's rules; NULL with an exception thrown on error */
+sf_field_rules_t *sf_parse_field_rules(zend_string *field_name, zval *field_rules);
+
+/*
+ * Check field names only, keeping each field's rules array unparsed in
+ * sf_field_rules_t.source for sf_parse_field_rules() later.
+ */
+HashTable *sf_parse_rules_deferred(HashTable *rules_array);
+
+/* Whether an unparsed rules array lists a plain rule of the given type */
+bool sf_source_has_rule(zval *source, sf_rule_type_t type);
+
+/* Whether the first rule of an unparsed rules array, past 'bail' and 'sometimes', is of the given type */
+bool sf_source_leads_with(zval *source, sf_rule_type_t type);
+
 /* Free parsed rules */
 void sf_free_field_rules(sf_field_rules_t *field_rules);
 void sf_free_parsed_rule(sf_parsed_rule_t *rule);
 void sf_free_parsed_rules_ht(HashTable *rules);
+void sf_free_rule_params(sf_parsed_rule_t *rule);
 
 /* Validate rule name */
 bool sf_validate_rule_name(const char *name, size_t len);
@@ -154,4 +316,7 @@ bool sf_validate_rule_name(const char *name, size_t len);
 /* Get rule type from string */
 sf_rule_type_t sf_get_rule_type(const char *name, size_t len);
 
+/* Get rule name from type (NULL for RULE_UNKNOWN) */
+const char *sf_get_rule_name(sf_rule_type_t type);
+
 #endif /* SIGNALFORGE_PARSER_H */
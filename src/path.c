@@ -0,0 +1,262 @@
+/*
+ * Precompiled dot-notation paths
+ *
+ * Field names, field references and condition subjects are fixed when the
+ * Validator is built, so they are split and hashed once here instead of
+ * on every lookup. Segment keys are interned where the engine allows it:
+ * input arrays built from literals use interned keys too, and the hash
+ * lookup then matches on pointer equality.
+ *
+ * References used inside wildcard fields may be bound to the element being
+ * validated ("^.start", "items.*.start"); they start from a value the
+ * traversal already holds instead of walking down from the root again.
+ */
+
+#include "path.h"
+
+/* Split a dotted path into interned, pre-hashed segments */
+void sf_path_init(sf_path_t *path, const char *str, size_t len)
+{
+    uint32_t count = 0;
+    size_t pos = 0;
+
+    /* A trailing dot does not start a new segment (as in sf_get_nested_value) */
+    while (pos < len) {
+        const char *dot = memchr(str + pos, '.', len - pos);
+        pos = dot ? (size_t)(dot - str) + 1 : len;
+        count++;
+    }
+
+    path->segments = count ? safe_emalloc(count, sizeof(sf_path_segment_t), 0) : NULL;
+    path->count = count;
+    path->anchor = SF_PATH_ROOT;
+
+    pos = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const char *segment = str + pos;
+        const char *dot = memchr(segment, '.', len - pos);
+        size_t segment_len = dot ? (size_t)(dot - segment) : len - pos;
+        sf_path_segment_t *seg = &path->segments[i];
+
+        seg->key = zend_new_interned_string(zend_string_init(segment, segment_len, 0));
+        zend_string_hash_val(seg->key);
+
+        /* Integer fallback matches strtol() on the whole segment */
+        char *end;
+        zend_long index = ZEND_STRTOL(ZSTR_VAL(seg->key), &end, 10);
+        seg->is_index = end == ZSTR_VAL(seg->key) + segment_len;
+        seg->index = (zend_ulong)index;
+        seg->is_wildcard = segment_len == 1 && segment[0] == '*';
+
+        pos += segment_len + 1;
+    }
+}
+
+/* Whether a segment is the '^' step of a relative reference */
+static zend_always_inline bool is_parent_step(const sf_path_segment_t *seg)
+{
+    return ZSTR_LEN(seg->key) == 1 && ZSTR_VAL(seg->key)[0] == '^';
+}
+
+/* Whether a reference uses a relative form */
+bool sf_path_is_relative(const sf_path_t *ref)
+{
+    for (uint32_t i = 0; i < ref->count; i++) {
+        if (ref->segments[i].is_wildcard || is_parent_step(&ref->segments[i])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Bind a reference to the field it is used on */
+bool sf_path_bind(sf_path_t *ref, const sf_path_t *field)
+{
+    uint32_t ups = 0;
+    while (ups < ref->count && is_parent_step(&ref->segments[ups])) {
+        ups++;
+    }
+
+    uint32_t last_wildcard = SF_PATH_ROOT;
+    for (uint32_t i = ups; i < ref->count; i++) {
+        if (is_parent_step(&ref->segments[i])) {
+            return 0;
+        }
+        if (ref->segments[i].is_wildcard) {
+            last_wildcard = i;
+        }
+    }
+
+    /* A plain reference from the data root */
+    if (ups == 0 && last_wildcard == SF_PATH_ROOT) {
+        return 1;
+    }
+
+    uint32_t anchor;
+    if (ups > 0) {
+        if (last_wildcard != SF_PATH_ROOT || ups > field->count) {
+            return 0;
+        }
+        anchor = field->count - ups;
+    } else {
+        if (last_wildcard >= field->count) {
+            return 0;
+        }
+        for (uint32_t i = 0; i <= last_wildcard; i++) {
+            const sf_path_segment_t *a = &ref->segments[i];
+            const sf_path_segment_t *b = &field->segments[i];
+            if (a->is_wildcard != b->is_wildcard
+                || (!a->is_wildcard && !zend_string_equals(a->key, b->key))) {
+                return 0;
+            }
+        }
+        anchor = last_wildcard + 1;
+    }
+
+    uint32_t skip = ups > 0 ? ups : anchor;
+
+    /* Anchored below a wildcard: resolved per element */
+    bool concrete = 1;
+    for (uint32_t i = 0; i < anchor; i++) {
+        if (field->segments[i].is_wildcard) {
+            concrete = 0;
+            break;
+        }
+    }
+
+    uint32_t head = concrete ? anchor : 0;
+    uint32_t count = head + ref->count - skip;
+    sf_path_segment_t *segments = count ? safe_emalloc(count, sizeof(sf_path_segment_t), 0) : NULL;
+
+    for (uint32_t i = 0; i < head; i++) {
+        segments[i] = field->segments[i];
+        zend_string_copy(segments[i].key);
+    }
+    for (uint32_t i = skip; i < ref->count; i++) {
+        segments[head + i - skip] = ref->segments[i];
+    }
+    for (uint32_t i = 0; i < skip; i++) {
+        zend_string_release(ref->segments[i].key);
+    }
+
+    if (ref->segments) {
+        efree(ref->segments);
+    }
+    ref->segments = segments;
+    ref->count = count;
+    ref->anchor = concrete ? SF_PATH_ROOT : anchor;
+
+    return 1;
+}
+
+/* Resolve a path against data */
+zval *sf_path_resolve(const sf_path_t *path, HashTable *data)
+{
+    if (!data || path->count == 0) {
+        return NULL;
+    }
+
+    HashTable *current = data;
+
+    for (uint32_t i = 0; ; i++) {
+        const sf_path_segment_t *seg = &path->segments[i];
+
+        zval *value = zend_hash_find(current, seg->key);
+        if (!value && seg->is_index) {
+            value = zend_hash_index_find(current, seg->index);
+        }
+
+        if (!value || i + 1 == path->count) {
+            return value;
+        }
+
+        if (Z_TYPE_P(value) != IS_ARRAY) {
+            return NULL;
+        }
+        current = Z_ARRVAL_P(value);
+    }
+}
+
+/* Resolve a possibly bound path */
+zval *sf_path_resolve_at(const sf_path_t *path, HashTable *data, zval *const *frames)
+{
+    if (path->anchor == SF_PATH_ROOT) {
+        return sf_path_resolve(path, data);
+    }
+
+    zval *base = frames ? frames[path->anchor] : NULL;
+    if (!base || path->count == 0) {
+        return base;
+    }
+
+    return Z_TYPE_P(base) == IS_ARRAY ? sf_path_resolve(path, Z_ARRVAL_P(base)) : NULL;
+}
+
+/* Whether two paths name the same field */
+bool sf_path_equals(const sf_path_t *a, const sf_path_t *b)
+{
+    if (a->count != b->count || a->anchor != b->anchor) {
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < a->count; i++) {
+        if (!zend_string_equals(a->segments[i].key, b->segments[i].key)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Fold one word into a digest */
+static zend_always_inline uint64_t digest_fold(uint64_t h, uint64_t word)
+{
+    h = (h ^ word) * 0x9e3779b97f4a7c15ULL;
+    return h ^ (h >> 29);
+}
+
+/* Digest of a path's anchor and segment keys */
+zend_ulong sf_path_digest(const sf_path_t *path)
+{
+    uint64_t h = digest_fold(path->count, path->anchor);
+
+    for (uint32_t i = 0; i < path->count; i++) {
+        h = digest_fold(h, ZSTR_HASH(path->segments[i].key));
+    }
+
+    return (zend_ulong)h;
+}
+
+/* Copy a path, sharing the segment keys */
+void sf_path_copy(sf_path_t *dst, const sf_path_t *src)
+{
+    dst->count = src->count;
+    dst->anchor = src->anchor;
+    dst->segments = NULL;
+
+    if (src->count == 0) {
+        return;
+    }
+
+    dst->segments = safe_emalloc(src->count, sizeof(sf_path_segment_t), 0);
+    for (uint32_t i = 0; i < src->count; i++) {
+        dst->segments[i] = src->segments[i];
+        zend_string_copy(dst->segments[i].key);
+    }
+}
+
+/* Release a path's segments */
+void sf_path_destroy(sf_path_t *path)
+{
+    for (uint32_t i = 0; i < path->count; i++) {
+        zend_string_release(path->segments[i].key);
+    }
+
+    if (path->segments) {
+        efree(path->segments);
+    }
+
+    path->segments = NULL;
+    path->count = 0;
+    path->anchor = SF_PATH_ROOT;
+}
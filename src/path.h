@@ -0,0 +1,90 @@
+/*
+ * Precompiled dot-notation paths
+ */
+
+#ifndef SIGNALFORGE_PATH_H
+#define SIGNALFORGE_PATH_H
+
+#include "php_signalforge_validation.h"
+
+/* One segment of a path, ready for hash lookups */
+typedef struct {
+    zend_string *key;    /* Segment as an interned, pre-hashed string key */
+    zend_ulong index;    /* Segment as an integer key */
+    bool is_index;       /* Segment also reads as an integer key */
+    bool is_wildcard;    /* Segment is '*' (see sf_walk_wildcards) */
+} sf_path_segment_t;
+
+/*
+ * Compiled path like "user.address.city".
+ *
+ * A path bound to a wildcard position (see sf_path_bind) is resolved from
+ * the current element rather than the data root: anchor is the number of
+ * leading segments of the element's concrete path whose value it starts
+ * from.
+ */
+typedef struct {
+    sf_path_segment_t *segments;
+    uint32_t count;
+    uint32_t anchor;     /* SF_PATH_ROOT, or the anchoring depth */
+} sf_path_t;
+
+#define SF_PATH_ROOT UINT32_MAX
+
+/* Split a dotted path into interned, pre-hashed segments */
+void sf_path_init(sf_path_t *path, const char *str, size_t len);
+
+/*
+ * Bind a reference to the field it is used on. Two forms are relative:
+ *
+ *   "^.start"        leading '^' segments step up from the field: one '^'
+ *                    is the element holding the field, each further '^'
+ *                    one level above
+ *   "items.*.start"  the pattern up to the last '*' must be a prefix of
+ *                    the field's pattern; each '*' stands for the element
+ *                    currently being validated
+ *
+ * The bound path keeps only the segments after the anchor. References that
+ * land on a wildcard-free prefix become plain paths from the root. Other
+ * references are left as they are. Returns 0 if the reference does not fit
+ * the field (stray '^', or '*' not matching the field's wildcards).
+ */
+bool sf_path_bind(sf_path_t *ref, const sf_path_t *field);
+
+/* Whether a reference uses a relative form that sf_path_bind() rewrites */
+bool sf_path_is_relative(const sf_path_t *ref);
+
+/*
+ * Resolve a path against data.
+ *
+ * Same lookup rules as sf_get_nested_value() (string key first, then
+ * integer key; every intermediate value must be an array), but without
+ * allocating or hashing at run time. Returns NULL if not found.
+ */
+zval *sf_path_resolve(const sf_path_t *path, HashTable *data);
+
+/*
+ * Resolve a possibly bound path. frames[k] is the value at the first k
+ * segments of the current element's path (frames[0] the data root), or
+ * frames is NULL outside wildcard fields. A bound path with no segments
+ * left resolves to its anchor value itself.
+ */
+zval *sf_path_resolve_at(const sf_path_t *path, HashTable *data, zval *const *frames);
+
+/* Whether two paths name the same field (bound paths: from the same anchor) */
+bool sf_path_equals(const sf_path_t *a, const sf_path_t *b);
+
+/*
+ * Digest of what sf_path_equals() compares: equal paths have equal
+ * digests, so deduplicating tables key by it and compare only paths
+ * with the same digest.
+ */
+zend_ulong sf_path_digest(const sf_path_t *path);
+
+/* Copy a path, sharing the segment keys */
+void sf_path_copy(sf_path_t *dst, const sf_path_t *src);
+
+/* Release a path's segments */
+void sf_path_destroy(sf_path_t *path);
+
+#endif /* SIGNALFORGE_PATH_H */
@@ -0,0 +1,403 @@
+/*
+ * Profile-guided rule ordering
+ *
+ * With the 'profile' option, validate() records for every rule instruction
+ * of a bail field how often it ran, how often it failed and how long it
+ * took. Every SF_PROFILE_REORDER_INTERVAL calls, each field's independent
+ * rules are re-sorted so that the rules most likely to reject input per
+ * nanosecond spent run first: for a chain that stops at its first failure
+ * the expected cost is minimal when rules are ordered by
+ *
+ *     rank = avg_cost / failure_rate        (ascending)
+ *
+ * Only bail fields are profiled and reordered - without bail every rule
+ * runs anyway, and declaration order decides the error order.
+ *
+ * Independent rules are maximal runs of rule instructions that contain no
+ * nullable/filled (which can skip the rest of the chain) and no branch,
+ * jump or jump target. Statistics travel with their instruction; a
+ * type-specialized rule moved ahead of the guard it relied on falls back
+ * to its generic opcode.
+ *
+ * Statistics can be exported and imported so a warm ordering survives
+ * worker restarts. Entries are identified by field and compile-time slot,
+ * and carry the rule name as a consistency check.
+ */
+
+#include "profile.h"
+#include "zend_exceptions.h"
+
+/* Segments are left alone until every rule in them ran this often */
+#define SF_PROFILE_MIN_RUNS 16
+
+/* Temporary flag: specialized rule whose guard precedes it in its segment */
+#define SF_INSN_LOCAL_GUARD (1 << 15)
+
+/* Allocate zeroed statistics for every instruction */
+void sf_profile_init(sf_program_t *prog)
+{
+    if (prog->profile) {
+        return;
+    }
+
+    prog->profile = ecalloc(prog->code_len ? prog->code_len : 1, sizeof(sf_insn_profile_t));
+
+    for (uint32_t i = 0; i < prog->field_count; i++) {
+        const sf_field_program_t *field = &prog->fields[i];
+        for (uint32_t pc = field->start; pc < field->end; pc++) {
+            prog->profile[pc].origin = pc - field->start;
+        }
+    }
+}
+
+/* Extend statistics to a field chain compiled at [from, code_len) */
+void sf_profile_grow(sf_program_t *prog, uint32_t from)
+{
+    if (prog->code_len <= from) {
+        return;
+    }
+
+    prog->profile = safe_erealloc(prog->profile, prog->code_len, sizeof(sf_insn_profile_t), 0);
+    memset(&prog->profile[from], 0, (prog->code_len - from) * sizeof(sf_insn_profile_t));
+
+    for (uint32_t pc = from; pc < prog->code_len; pc++) {
+        prog->profile[pc].origin = pc - from;
+    }
+}
+
+/* Rule name of an instruction, stable across specialization */
+static const char *insn_name(const sf_insn_t *insn)
+{
+    uint32_t op = (insn->flags & SF_INSN_SPECIALIZED) ? insn->b : insn->op;
+
+    switch (op) {
+        case SF_OP_STRING_SIZE:     return "string_size";
+        case SF_OP_INTEGER_COMPARE: return "integer_compare";
+        case SF_OP_REQUIRED_EMAIL:  return "required_email";
+        case SF_OP_SIZE_RANGE:      return "size_range";
+        default: {
+            const char *name = sf_get_rule_name((sf_rule_type_t)op);
+            return name ? name : "unknown";
+        }
+    }
+}
+
+/*
+ * Instructions that end a run of independent rules (schema queues work once
+ * it passes; collection rules accumulate what got past the rules before)
+ */
+static bool is_barrier(const sf_insn_t *insn)
+{
+    return !SF_OP_IS_RULE(insn->op) || insn->op == RULE_NULLABLE || insn->op == RULE_FILLED
+        || insn->op == RULE_SCHEMA || SF_RULE_IS_AGGREGATE(insn->op) || SF_RULE_IS_PRESENCE(insn->op);
+}
+
+/* Type established by a guard instruction, or IS_UNDEF */
+static zend_uchar guard_type(const sf_insn_t *insn)
+{
+    if (!(insn->flags & SF_INSN_GUARD)) {
+        return IS_UNDEF;
+    }
+    return insn->op == RULE_ARRAY ? IS_ARRAY : IS_STRING;
+}
+
+/* Type a specialized instruction relies on */
+static zend_uchar specialized_type(const sf_insn_t *insn)
+{
+    return insn->op >= SF_OP_MIN_ARRAY && insn->op <= SF_OP_BETWEEN_ARRAY ? IS_ARRAY : IS_STRING;
+}
+
+/* Expected cost per rejection; lower runs first */
+static double insn_rank(const sf_insn_profile_t *stats)
+{
+    double cost = ((double)stats->time + 1.0) / ((double)stats->runs + 1.0);
+    double fail_rate = ((double)stats->fails + 1.0) / ((double)stats->runs + 2.0);
+    return cost / fail_rate;
+}
+
+/* Sort code[lo, hi) by rank, keeping statistics and specialization consistent */
+static void sort_segment(sf_program_t *prog, uint32_t lo, uint32_t hi)
+{
+    sf_insn_t *code = prog->code;
+    sf_insn_profile_t *profile = prog->profile;
+    bool seen_string = 0, seen_array = 0;
+
+    for (uint32_t i = lo; i < hi; i++) {
+        if (profile[i].runs < SF_PROFILE_MIN_RUNS) {
+            return;
+        }
+    }
+
+    /* Note which specialized rules depend on a guard inside this segment */
+    for (uint32_t i = lo; i < hi; i++) {
+        if (code[i].flags & SF_INSN_SPECIALIZED) {
+            if (specialized_type(&code[i]) == IS_ARRAY ? seen_array : seen_string) {
+                code[i].flags |= SF_INSN_LOCAL_GUARD;
+            }
+        }
+        seen_string |= guard_type(&code[i]) == IS_STRING;
+        seen_array |= guard_type(&code[i]) == IS_ARRAY;
+    }
+
+    /* Stable insertion sort: segments are short */
+    for (uint32_t i = lo + 1; i < hi; i++) {
+        sf_insn_t insn = code[i];
+        sf_insn_profile_t stats = profile[i];
+        double rank = insn_rank(&stats);
+        uint32_t j = i;
+
+        while (j > lo && insn_rank(&profile[j - 1]) > rank) {
+            code[j] = code[j - 1];
+            profile[j] = profile[j - 1];
+            j--;
+        }
+        code[j] = insn;
+        profile[j] = stats;
+    }
+
+    /* Fall back to the generic rule where the guard no longer precedes it */
+    seen_string = seen_array = 0;
+    for (uint32_t i = lo; i < hi; i++) {
+        if (code[i].flags & SF_INSN_LOCAL_GUARD) {
+            code[i].flags &= ~SF_INSN_LOCAL_GUARD;
+            if (!(specialized_type(&code[i]) == IS_ARRAY ? seen_array : seen_string)) {
+                code[i].op = (uint16_t)code[i].b;
+                code[i].b = 0;
+                code[i].flags &= ~SF_INSN_SPECIALIZED;
+            }
+        }
+        seen_string |= guard_type(&code[i]) == IS_STRING;
+        seen_array |= guard_type(&code[i]) == IS_ARRAY;
+    }
+}
+
+/* Reorder one field; `target` is scratch space of at least end - start bytes */
+static void reorder_field(sf_program_t *prog, const sf_field_program_t *field, bool *target)
+{
+    const sf_insn_t *code = prog->code;
+    uint32_t start = field->start;
+    uint32_t end = field->end;
+
+    /* Jump targets are join points: rules on either side are not independent */
+    memset(target, 0, (end - start) * sizeof(bool));
+    for (uint32_t pc = start; pc < end; pc++) {
+        uint32_t dest = end;
+        if (code[pc].op == SF_OP_BRANCH) {
+            dest = code[pc].b;
+        } else if (code[pc].op == SF_OP_JUMP) {
+            dest = code[pc].a;
+        } else if (code[pc].op == SF_OP_DISPATCH) {
+            /* Every case block and the default block are entered from here */
+            const sf_parsed_rule_t *variant = &prog->params[code[pc].a];
+            for (uint32_t k = 0; k <= variant->params.variant.case_count; k++) {
+                if (variant->params.variant.starts[k] < end) {
+                    target[variant->params.variant.starts[k] - start] = 1;
+                }
+            }
+            dest = variant->params.variant.end;
+        } else if (code[pc].op == SF_OP_COMBINE) {
+            /* Each branch starts a run of its own; rules after the combinator too */
+            const sf_parsed_rule_t *combinator = &prog->params[code[pc].a];
+            for (uint32_t k = 0; k <= combinator->params.combinator.branch_count; k++) {
+                if (combinator->params.combinator.starts[k] < end) {
+                    target[combinator->params.combinator.starts[k] - start] = 1;
+                }
+            }
+        }
+        if (dest < end) {
+            target[dest - start] = 1;
+        }
+    }
+
+    uint32_t pc = start;
+    while (pc < end) {
+        if (is_barrier(&code[pc])) {
+            pc++;
+            continue;
+        }
+
+        uint32_t hi = pc + 1;
+        while (hi < end && !is_barrier(&code[hi]) && !target[hi - start]) {
+            hi++;
+        }
+
+        if (hi - pc > 1) {
+            sort_segment(prog, pc, hi);
+        }
+        pc = hi;
+    }
+}
+
+/* Reorder every bail field */
+void sf_profile_reorder(sf_program_t *prog)
+{
+    prog->validations = 0;
+
+    if (!prog->profile || prog->code_len == 0) {
+        return;
+    }
+
+    bool *target = emalloc(prog->code_len * sizeof(bool));
+
+    for (uint32_t i = 0; i < prog->field_count; i++) {
+        if (prog->fields[i].bail) {
+            reorder_field(prog, &prog->fields[i], target);
+        }
+    }
+
+    efree(target);
+}
+
+/* Export statistics, in current execution order */
+void sf_profile_export(const sf_program_t *prog, zval *return_value)
+{
+    array_init(return_value);
+
+    if (!prog->profile) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < prog->field_count; i++) {
+        const sf_field_program_t *field = &prog->fields[i];
+        if (!field->bail) {
+            continue;
+        }
+
+        zval entries;
+        array_init(&entries);
+
+        for (uint32_t pc = field->start; pc < field->end; pc++) {
+            const sf_insn_t *insn = &prog->code[pc];
+            const sf_insn_profile_t *stats = &prog->profile[pc];
+
+            if (!SF_OP_IS_RULE(insn->op)) {
+                continue;
+            }
+
+            zval entry;
+            array_init(&entry);
+            add_assoc_string(&entry, "rule", (char *)insn_name(insn));
+            add_assoc_long(&entry, "slot", (zend_long)stats->origin);
+            add_assoc_long(&entry, "runs", (zend_long)stats->runs);
+            add_assoc_long(&entry, "fails", (zend_long)stats->fails);
+            add_assoc_long(&entry, "time", (zend_long)stats->time);
+            add_next_index_zval(&entries, &entry);
+        }
+
+        /* Numeric names become integer keys, as in the rules array */
+        zend_symtable_str_update(Z_ARRVAL_P(return_value), field->name, field->name_len, &entries);
+    }
+}
+
+/* Read a non-negative integer member of a profile entry */
+static bool entry_long(HashTable *entry, const char *key, size_t key_len, zend_long *out)
+{
+    zval *value = zend_hash_str_find(entry, key, key_len);
+    if (!value || Z_TYPE_P(value) != IS_LONG || Z_LVAL_P(value) < 0) {
+        return 0;
+    }
+    *out = Z_LVAL_P(value);
+    return 1;
+}
+
+/*
+ * Apply one exported entry to a field.
+ * Returns 0 if the entry is malformed; stale entries are skipped.
+ */
+static bool import_entry(sf_program_t *prog, const sf_field_program_t *field, zval *entry)
+{
+    if (Z_TYPE_P(entry) != IS_ARRAY) {
+        return 0;
+    }
+
+    HashTable *ht = Z_ARRVAL_P(entry);
+    zval *rule = zend_hash_str_find(ht, "rule", sizeof("rule") - 1);
+    zend_long slot, runs, fails, time;
+
+    if (!rule || Z_TYPE_P(rule) != IS_STRING ||
+        !entry_long(ht, "slot", sizeof("slot") - 1, &slot) ||
+        !entry_long(ht, "runs", sizeof("runs") - 1, &runs) ||
+        !entry_long(ht, "fails", sizeof("fails") - 1, &fails) ||
+        !entry_long(ht, "time", sizeof("time") - 1, &time) ||
+        fails > runs) {
+        return 0;
+    }
+
+    for (uint32_t pc = field->start; pc < field->end; pc++) {
+        sf_insn_profile_t *stats = &prog->profile[pc];
+
+        if (stats->origin != (uint32_t)slot) {
+            continue;
+        }
+
+        const sf_insn_t *insn = &prog->code[pc];
+        const char *expected = insn_name(insn);
+        if (SF_OP_IS_RULE(insn->op) && zend_string_equals_cstr(Z_STR_P(rule), expected, strlen(expected))) {
+            stats->runs = (uint64_t)runs;
+            stats->fails = (uint64_t)fails;
+            stats->time = (uint64_t)time;
+        }
+        break;
+    }
+
+    return 1;
+}
+
+/* Apply a field's exported entries; returns 0 if any is malformed */
+static bool import_field(sf_program_t *prog, const sf_field_program_t *field, HashTable *entries)
+{
+    zval *entry;
+    ZEND_HASH_FOREACH_VAL(entries, entry) {
+        if (Z_TYPE_P(entry) != IS_ARRAY) {
+            return 0;
+        }
+        /* Unknown or non-bail field: rules changed since export */
+        if (field && field->bail && !import_entry(prog, field, entry)) {
+            return 0;
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    return 1;
+}
+
+/* Import statistics and reorder */
+bool sf_profile_import(sf_program_t *prog, HashTable *profile)
+{
+    sf_profile_init(prog);
+
+    zend_string *key;
+    zend_ulong index;
+    zval *entries;
+    ZEND_HASH_FOREACH_KEY_VAL(profile, index, key, entries) {
+        if (Z_TYPE_P(entries) != IS_ARRAY) {
+            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                "Invalid profile: expected a list of rule entries per field");
+            return 0;
+        }
+
+        /* Numeric field names come back as integer keys */
+        zend_string *name = key ? zend_string_copy(key) : zend_long_to_str((zend_long)index);
+
+        const sf_field_program_t *field = NULL;
+        uint32_t i = sf_find_field(prog, name);
+        if (i != SF_NO_FIELD) {
+            /* Lazy mode: statistics need the field's compiled chain */
+            if (SF_FIELD_PENDING(&prog->fields[i]) && !sf_compile_field(prog, i)) {
+                zend_string_release(name);
+                return 0;
+            }
+            field = &prog->fields[i];
+        }
+
+        if (!import_field(prog, field, Z_ARRVAL_P(entries))) {
+            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                "Invalid profile entry for field '%s'", ZSTR_VAL(name));
+            zend_string_release(name);
+            return 0;
+        }
+        zend_string_release(name);
+    } ZEND_HASH_FOREACH_END();
+
+    sf_profile_reorder(prog);
+    return 1;
+}
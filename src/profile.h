@@ -0,0 +1,35 @@
+/*
+ * Profile-guided rule ordering
+ */
+
+#ifndef SIGNALFORGE_PROFILE_H
+#define SIGNALFORGE_PROFILE_H
+
+#include "php_signalforge_validation.h"
+#include "program.h"
+
+/* Allocate zeroed statistics for every instruction (no-op if present) */
+void sf_profile_init(sf_program_t *prog);
+
+/* Extend statistics to a field chain compiled at [from, code_len) */
+void sf_profile_grow(sf_program_t *prog, uint32_t from);
+
+/*
+ * Reorder the independent rules of every bail field by observed cost and
+ * failure rate, and restart the validate() counter.
+ */
+void sf_profile_reorder(sf_program_t *prog);
+
+/* Export statistics as [field => [['rule', 'slot', 'runs', 'fails', 'time'], ...]] */
+void sf_profile_export(const sf_program_t *prog, zval *return_value);
+
+/*
+ * Import statistics produced by sf_profile_export() and reorder.
+ *
+ * Entries that no longer match the program (rules changed since export)
+ * are ignored. Returns 0 with an InvalidRuleException thrown if the
+ * profile is malformed.
+ */
+bool sf_profile_import(sf_program_t *prog, HashTable *profile);
+
+#endif /* SIGNALFORGE_PROFILE_H */
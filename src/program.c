@@ -0,0 +1,1795 @@
+/*
+ * Rule program compiler
+ *
+ * Lowers the parse tree produced by sf_parse_rules() into a flat program:
+ * one contiguous instruction array shared by every field, a side table of
+ * rule parameters, and a per-field table of [start, end) ranges into the
+ * instruction array.
+ *
+ * Conditional rules become branches:
+ *
+ *     ['when', cond, [A, B], [C]]   =>   BRANCH cond, else
+ *                                        A
+ *                                        B
+ *                                        JUMP end
+ *                                  else: C
+ *                                   end:
+ *
+ * so nested conditionals cost no recursion at validation time, and the
+ * parse tree (one allocation per rule) can be dropped after construction.
+ *
+ * Variants become a dispatch on the discriminator followed by the case
+ * blocks:
+ *
+ *     ['variant', 'type', ['a' => [A], 'b' => [B]], [D]]
+ *
+ *         =>   DISPATCH v        (v: 'a' => 0, 'b' => 1)
+ *           0: A
+ *              JUMP end
+ *           1: B
+ *              JUMP end
+ *        default: D
+ *         end:
+ *
+ * The case table is a hash on the case values, so only the matching block
+ * runs however many cases there are. A run of 'when' rules that test the
+ * same field for equality with distinct integer or string constants is
+ * lowered to the same dispatch.
+ *
+ * Combinators emit one instruction followed by their branches; the
+ * executor runs the branches itself and continues after the last one:
+ *
+ *     ['any_of', [A], [B, C]]   =>   COMBINE c     (c: starts = 0, 1, end)
+ *                                 0: A
+ *                                 1: B
+ *                                    C
+ *                               end:
+ *
+ * While emitting, common rule sequences are replaced with superinstructions
+ * (string+min+max, integer+gt, required+email), and rules that follow a
+ * string/array type guard are emitted as type-specialized variants that
+ * skip the type check. Specialized instructions keep their generic opcode
+ * in operand b; the executor switches back to it once a guard has failed
+ * or the value is a nullable empty value.
+ *
+ * Adjacent min/max pairs become a single size-range check, and 'bail' and
+ * 'sometimes' are lowered to per-field flags rather than instructions.
+ *
+ * Wildcard fields are merged into a traversal trie on their common
+ * prefixes (see wildcard.c); the first field of each top-level group walks
+ * the whole group.
+ *
+ * Fields run parents first: a plain field whose path is a prefix of other
+ * fields' paths ("items" for "items.*.name") runs before them, and if it
+ * fails the wildcard fields below it are not walked at all - a 'max' on
+ * the collection bounds the work done for its elements.
+ *
+ * In lazy mode only field names are checked up front; each field is parsed
+ * and compiled the first time validate() runs it (sf_compile_field), and
+ * its chain is appended to the shared instruction array.
+ *
+ * Conditions that do not depend on the current value get a memo slot, so
+ * validate() evaluates each of them at most once however many fields and
+ * wildcard elements branch on it. Identical conditions share a slot.
+ * Likewise each collection rule (unique, sorted, sum_min, ...) gets an
+ * accumulator slot, live for one walk of its field's group.
+ *
+ * Named sub-schemas (the 'schemas' option) are compiled once each into a
+ * program of their own; every 'schema' rule naming one - from top-level
+ * fields, other schemas or the schema itself - refers to it by index.
+ */
+
+#include "program.h"
+#include "condition.h"
+#include "optimizer.h"
+#include "profile.h"
+#include "wildcard.h"
+#include "util/value_set.h"
+
+#define SF_PROGRAM_INITIAL_CODE   32
+#define SF_PROGRAM_INITIAL_PARAMS 16
+
+/* Shortest chain of 'when' tests lowered to a dispatch; fewer are cheaper as branches */
+#define SF_DISPATCH_MIN_CASES 3
+
+/* Whether a rule type carries parameters in the side table */
+static bool rule_has_params(sf_rule_type_t type)
+{
+    switch (type) {
+        case RULE_MIN:
+        case RULE_MAX:
+        case RULE_GT:
+        case RULE_GTE:
+        case RULE_LT:
+        case RULE_LTE:
+        case RULE_BETWEEN:
+        case RULE_REGEX:
+        case RULE_NOT_REGEX:
+        case RULE_STARTS_WITH:
+        case RULE_ENDS_WITH:
+        case RULE_CONTAINS:
+        case RULE_DATE_FORMAT:
+        case RULE_SAME:
+        case RULE_DIFFERENT:
+        case RULE_CONFIRMED:
+        case RULE_AFTER:
+        case RULE_BEFORE:
+        case RULE_AFTER_OR_EQUAL:
+        case RULE_BEFORE_OR_EQUAL:
+        case RULE_IN:
+        case RULE_NOT_IN:
+        case RULE_KEYS:
+        case RULE_STRICT:
+        case RULE_ENUM:
+        case RULE_REQUIRED_IF:
+        case RULE_REQUIRED_UNLESS:
+        case RULE_PROHIBITED_IF:
+        case RULE_EXCLUDE_IF:
+        case RULE_REQUIRED_WITH:
+        case RULE_REQUIRED_WITH_ALL:
+        case RULE_REQUIRED_WITHOUT:
+        case RULE_REQUIRED_WITHOUT_ALL:
+        case RULE_WHEN:
+        case RULE_ANY_OF:
+        case RULE_ALL_OF:
+        case RULE_NONE_OF:
+        case RULE_SCHEMA:
+        case RULE_UNIQUE:
+        case RULE_SORTED:
+        case RULE_SUM_MIN:
+        case RULE_SUM_MAX:
+        case RULE_COUNT_WHERE:
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+/* Append an instruction, returning its index */
+static uint32_t emit_insn(sf_program_t *prog, uint16_t op, uint32_t a, uint32_t b)
+{
+    if (prog->code_len == prog->code_cap) {
+        prog->code_cap = prog->code_cap ? prog->code_cap * 2 : SF_PROGRAM_INITIAL_CODE;
+        prog->code = safe_erealloc(prog->code, prog->code_cap, sizeof(sf_insn_t), 0);
+    }
+
+    sf_insn_t *insn = &prog->code[prog->code_len];
+    insn->op = op;
+    insn->flags = 0;
+    insn->a = a;
+    insn->b = b;
+
+    return prog->code_len++;
+}
+
+/* Reserve a slot in the param table, returning its index */
+static uint32_t alloc_param(sf_program_t *prog)
+{
+    if (prog->param_count == prog->param_cap) {
+        prog->param_cap = prog->param_cap ? prog->param_cap * 2 : SF_PROGRAM_INITIAL_PARAMS;
+        prog->params = safe_erealloc(prog->params, prog->param_cap, sizeof(sf_parsed_rule_t), 0);
+    }
+
+    memset(&prog->params[prog->param_count], 0, sizeof(sf_parsed_rule_t));
+    return prog->param_count++;
+}
+
+/*
+ * Move a rule's parameters into the side table.
+ *
+ * Ownership of heap parameters passes to the program; the source rule is
+ * left without parameters so freeing the parse tree does not touch them.
+ * For conditionals only the condition moves - the then/else lists stay on
+ * the source rule and are compiled inline by the caller. Likewise variants
+ * move their discriminator and case table but not their case lists, and
+ * combinators move nothing but their type.
+ */
+static uint32_t move_params(sf_program_t *prog, sf_parsed_rule_t *rule)
+{
+    uint32_t idx = alloc_param(prog);
+    sf_parsed_rule_t *param = &prog->params[idx];
+
+    param->type = rule->type;
+
+    if (rule->type == RULE_WHEN) {
+        param->params.conditional.condition = rule->params.conditional.condition;
+        rule->params.conditional.condition = NULL;
+    } else if (rule->type == RULE_VARIANT) {
+        param->params.variant.field = rule->params.variant.field;
+        param->params.variant.len = rule->params.variant.len;
+        param->params.variant.path = rule->params.variant.path;
+        param->params.variant.key = rule->params.variant.key;
+        param->params.variant.cases = rule->params.variant.cases;
+        param->params.variant.case_count = rule->params.variant.case_count;
+        rule->params.variant.field = NULL;
+        rule->params.variant.path.segments = NULL;
+        rule->params.variant.path.count = 0;
+        rule->params.variant.key = NULL;
+        rule->params.variant.cases = NULL;
+    } else if (SF_RULE_IS_COMBINATOR(rule->type)) {
+        param->params.combinator.branch_count = rule->params.combinator.branch_count;
+    } else {
+        param->params = rule->params;
+        memset(&rule->params, 0, sizeof(rule->params));
+    }
+
+    return idx;
+}
+
+static void compile_rule_list(sf_program_t *prog, sf_parsed_rule_t **rules, size_t count, zend_uchar guard);
+
+/*
+ * Compile-time deduplication tables key entries by a structural digest
+ * (sf_condition_digest(), sf_path_digest()) and confirm a hit with the
+ * full comparison. Entries with the same digest but different contents
+ * take the next free integer key, so a lookup walks consecutive keys
+ * from the digest until a match or a free key. Entries are never
+ * removed, so the walk never stops early.
+ */
+static HashTable *new_index(void)
+{
+    HashTable *index;
+    ALLOC_HASHTABLE(index);
+    zend_hash_init(index, SF_HASH_INITIAL_SIZE, NULL, NULL, 0);
+    return index;
+}
+
+/* Param holding a memoized condition equal to param idx's; idx itself (now indexed) if none */
+static uint32_t index_memo(sf_program_t *prog, uint32_t idx)
+{
+    const sf_condition_t *cond = prog->params[idx].params.conditional.condition;
+    zend_ulong key = sf_condition_digest(cond);
+    zval *entry;
+
+    while ((entry = zend_hash_index_find(prog->memo_index, key)) != NULL) {
+        uint32_t other = (uint32_t)Z_LVAL_P(entry);
+        if (sf_condition_equals(cond, prog->params[other].params.conditional.condition)) {
+            return other;
+        }
+        key++;
+    }
+
+    zval value;
+    ZVAL_LONG(&value, idx);
+    zend_hash_index_add_new(prog->memo_index, key, &value);
+    return idx;
+}
+
+/* Give an invariant condition a memo slot, reusing an identical one's */
+static void assign_memo(sf_program_t *prog, uint32_t idx)
+{
+    sf_condition_t *cond = prog->params[idx].params.conditional.condition;
+
+    if (!cond || !cond->invariant) {
+        return;
+    }
+
+    /* Built on first use, and again after a clone */
+    if (!prog->memo_index) {
+        prog->memo_index = new_index();
+        for (uint32_t i = 1; i < idx; i++) {
+            const sf_parsed_rule_t *param = &prog->params[i];
+            if (param->type == RULE_WHEN && param->params.conditional.condition
+                && param->params.conditional.condition->memo != SF_COND_NO_MEMO) {
+                index_memo(prog, i);
+            }
+        }
+    }
+
+    uint32_t same = index_memo(prog, idx);
+    cond->memo = same != idx ? prog->params[same].params.conditional.condition->memo : prog->memo_count++;
+}
+
+/* Filled fact for a path; fact_count (now indexed) if there is none yet */
+static uint32_t index_fact(sf_program_t *prog, const sf_path_t *path, uint32_t next)
+{
+    zend_ulong key = sf_path_digest(path);
+    zval *entry;
+
+    while ((entry = zend_hash_index_find(prog->fact_index, key)) != NULL) {
+        uint32_t f = (uint32_t)Z_LVAL_P(entry);
+        if (sf_path_equals(&prog->facts[f].path, path)) {
+            return f;
+        }
+        key++;
+    }
+
+    zval value;
+    ZVAL_LONG(&value, next);
+    zend_hash_index_add_new(prog->fact_index, key, &value);
+    return next;
+}
+
+/*
+ * Give a presence rule's root-anchored fields a fact in the per-run
+ * bitmap. Filled facts are shared between rules; fields bound to the
+ * current wildcard element are resolved per element instead.
+ */
+static void assign_facts(sf_program_t *prog, uint32_t idx)
+{
+    sf_parsed_rule_t *param = &prog->params[idx];
+    bool match = SF_RULE_IS_PRESENCE_MATCH(param->type);
+
+    /* Built on first use, and again after a clone */
+    if (!match && !prog->fact_index) {
+        prog->fact_index = new_index();
+        for (uint32_t f = 0; f < prog->fact_count; f++) {
+            if (prog->facts[f].param == 0) {
+                index_fact(prog, &prog->facts[f].path, f);
+            }
+        }
+    }
+
+    for (uint32_t k = 0; k < param->params.presence.ref_count; k++) {
+        sf_presence_ref_t *ref = &param->params.presence.refs[k];
+
+        if (ref->path.anchor != SF_PATH_ROOT) {
+            continue;
+        }
+
+        uint32_t f = match ? prog->fact_count : index_fact(prog, &ref->path, prog->fact_count);
+
+        if (f == prog->fact_count) {
+            if (prog->fact_count == prog->fact_cap) {
+                prog->fact_cap = prog->fact_cap ? prog->fact_cap * 2 : SF_HASH_INITIAL_SIZE;
+                prog->facts = safe_erealloc(prog->facts, prog->fact_cap, sizeof(sf_presence_fact_t), 0);
+            }
+            sf_path_copy(&prog->facts[f].path, &ref->path);
+            prog->facts[f].param = match ? idx : 0;
+            prog->fact_count++;
+        }
+
+        ref->fact = f;
+    }
+}
+
+/* Type-specialized variant of a rule under a guard, or RULE_UNKNOWN */
+static uint16_t specialized_op(sf_rule_type_t type, zend_uchar guard)
+{
+    if (guard == IS_STRING) {
+        switch (type) {
+            case RULE_MIN:      return SF_OP_MIN_STRING;
+            case RULE_MAX:      return SF_OP_MAX_STRING;
+            case RULE_BETWEEN:  return SF_OP_BETWEEN_STRING;
+            case RULE_REGEX:    return SF_OP_REGEX_STRING;
+            case RULE_EMAIL:    return SF_OP_EMAIL_STRING;
+            default:            break;
+        }
+    } else if (guard == IS_ARRAY) {
+        switch (type) {
+            case RULE_MIN:      return SF_OP_MIN_ARRAY;
+            case RULE_MAX:      return SF_OP_MAX_ARRAY;
+            case RULE_BETWEEN:  return SF_OP_BETWEEN_ARRAY;
+            default:            break;
+        }
+    }
+
+    return RULE_UNKNOWN;
+}
+
+/* Allocate a parameter slot for a superinstruction */
+static uint32_t alloc_fused_param(sf_program_t *prog)
+{
+    uint32_t idx = alloc_param(prog);
+    prog->params[idx].type = RULE_UNKNOWN;  /* Owns no heap memory */
+    return idx;
+}
+
+/*
+ * Try to fuse a rule sequence starting at rules[0].
+ * Returns the number of rules consumed, or 0 if no superinstruction applies.
+ */
+static size_t compile_fused(sf_program_t *prog, sf_parsed_rule_t **rules, size_t count, zend_uchar *guard)
+{
+    sf_rule_type_t first = rules[0]->type;
+    sf_rule_type_t second = count > 1 ? rules[1]->type : RULE_UNKNOWN;
+
+    /* string + between, string + min [+ max], string + max [+ min] */
+    if (first == RULE_STRING && (second == RULE_MIN || second == RULE_MAX || second == RULE_BETWEEN)) {
+        uint32_t idx = alloc_fused_param(prog);
+        sf_parsed_rule_t *param = &prog->params[idx];
+        size_t used = 1;
+
+        if (second == RULE_BETWEEN) {
+            param->params.fused.flags = SF_FUSED_BETWEEN;
+            param->params.fused.min = rules[1]->params.range.min;
+            param->params.fused.max = rules[1]->params.range.max;
+            used = 2;
+        } else {
+            if (second == RULE_MAX) {
+                param->params.fused.flags |= SF_FUSED_MAX_FIRST;
+            }
+            while (used < count && used < 3) {
+                sf_rule_type_t t = rules[used]->type;
+                if (t == RULE_MIN && !(param->params.fused.flags & SF_FUSED_HAS_MIN)) {
+                    param->params.fused.flags |= SF_FUSED_HAS_MIN;
+                    param->params.fused.min = rules[used]->params.size.value;
+                } else if (t == RULE_MAX && !(param->params.fused.flags & SF_FUSED_HAS_MAX)) {
+                    param->params.fused.flags |= SF_FUSED_HAS_MAX;
+                    param->params.fused.max = rules[used]->params.size.value;
+                } else {
+                    break;
+                }
+                used++;
+            }
+        }
+
+        uint32_t pc = emit_insn(prog, SF_OP_STRING_SIZE, idx, 0);
+        prog->code[pc].flags = SF_INSN_GUARD;
+        if (*guard == IS_UNDEF) {
+            *guard = IS_STRING;
+        }
+        return used;
+    }
+
+    /* min + max, max + min */
+    if ((first == RULE_MIN && second == RULE_MAX) || (first == RULE_MAX && second == RULE_MIN)) {
+        uint32_t idx = alloc_fused_param(prog);
+        sf_parsed_rule_t *param = &prog->params[idx];
+        sf_parsed_rule_t *min = first == RULE_MIN ? rules[0] : rules[1];
+        sf_parsed_rule_t *max = first == RULE_MAX ? rules[0] : rules[1];
+
+        param->params.fused.flags = SF_FUSED_HAS_MIN | SF_FUSED_HAS_MAX;
+        if (first == RULE_MAX) {
+            param->params.fused.flags |= SF_FUSED_MAX_FIRST;
+        }
+        param->params.fused.min = min->params.size.value;
+        param->params.fused.max = max->params.size.value;
+
+        emit_insn(prog, SF_OP_SIZE_RANGE, idx, 0);
+        return 2;
+    }
+
+    /* integer + gt/gte/lt/lte */
+    if (first == RULE_INTEGER &&
+        (second == RULE_GT || second == RULE_GTE || second == RULE_LT || second == RULE_LTE)) {
+        uint32_t idx = alloc_fused_param(prog);
+        prog->params[idx].params.fused.compare = second;
+        prog->params[idx].params.fused.min = rules[1]->params.size.value;
+        emit_insn(prog, SF_OP_INTEGER_COMPARE, idx, 0);
+        return 2;
+    }
+
+    /* required + email */
+    if (first == RULE_REQUIRED && second == RULE_EMAIL) {
+        emit_insn(prog, SF_OP_REQUIRED_EMAIL, 0, 0);
+        return 2;
+    }
+
+    return 0;
+}
+
+/*
+ * Emit a combinator (param idx) followed by its branches. lists[k] /
+ * counts[k] are the rules of branch k.
+ */
+static void compile_combinator(sf_program_t *prog, uint32_t idx, sf_parsed_rule_t ***lists, size_t *counts, zend_uchar guard)
+{
+    uint32_t n = prog->params[idx].params.combinator.branch_count;
+    uint32_t *starts = safe_emalloc(n + 1, sizeof(uint32_t), 0);
+
+    emit_insn(prog, SF_OP_COMBINE, idx, 0);
+
+    /* Branches may not run: a guard inside one dominates nothing after it */
+    for (uint32_t k = 0; k < n; k++) {
+        starts[k] = prog->code_len;
+        compile_rule_list(prog, lists[k], counts[k], guard);
+    }
+    starts[n] = prog->code_len;
+
+    prog->params[idx].params.combinator.starts = starts;
+}
+
+/*
+ * Emit a dispatch on variant param idx followed by its case blocks and
+ * default block. lists[k] / counts[k] are the rules of case k.
+ */
+static void compile_dispatch(
+    sf_program_t *prog,
+    uint32_t idx,
+    sf_parsed_rule_t ***lists,
+    size_t *counts,
+    sf_parsed_rule_t **default_rules,
+    size_t default_count,
+    zend_uchar guard
+)
+{
+    uint32_t n = prog->params[idx].params.variant.case_count;
+    uint32_t *starts = safe_emalloc(n + 1, sizeof(uint32_t), 0);
+    uint32_t *jumps = safe_emalloc(n, sizeof(uint32_t), 0);
+
+    emit_insn(prog, SF_OP_DISPATCH, idx, 0);
+
+    /* As with branches, a guard inside a case does not dominate the rules after it */
+    for (uint32_t k = 0; k < n; k++) {
+        starts[k] = prog->code_len;
+        compile_rule_list(prog, lists[k], counts[k], guard);
+        jumps[k] = emit_insn(prog, SF_OP_JUMP, 0, 0);
+    }
+
+    starts[n] = prog->code_len;
+    compile_rule_list(prog, default_rules, default_count, guard);
+
+    for (uint32_t k = 0; k < n; k++) {
+        prog->code[jumps[k]].a = prog->code_len;
+    }
+    efree(jumps);
+
+    /* Compiling the cases may have reallocated the param table */
+    sf_parsed_rule_t *param = &prog->params[idx];
+    param->params.variant.starts = starts;
+    param->params.variant.end = prog->code_len;
+    param->params.variant.set = sf_value_set_build_keys(param->params.variant.cases);
+}
+
+/* The equality test of a 'when' rule that can serve as a dispatch case, or NULL */
+static const sf_condition_test_t *case_test(const sf_parsed_rule_t *rule)
+{
+    if (rule->type != RULE_WHEN || rule->params.conditional.else_count > 0) {
+        return NULL;
+    }
+
+    const sf_condition_t *cond = rule->params.conditional.condition;
+    if (!cond || cond->count != 1) {
+        return NULL;
+    }
+
+    const sf_condition_test_t *test = &cond->tests[0];
+    if (test->subject != SUBJECT_OTHER_FIELD || test->op != COND_OP_EQ
+        || (Z_TYPE(test->value) != IS_LONG && Z_TYPE(test->value) != IS_STRING)) {
+        return NULL;
+    }
+
+    return test;
+}
+
+/* Whether two tests read the same field */
+static bool same_subject(const sf_condition_test_t *a, const sf_condition_test_t *b)
+{
+    if (!sf_path_equals(&a->path, &b->path)) {
+        return 0;
+    }
+    if (!a->field || !b->field) {
+        return a->field == b->field;
+    }
+    return zend_string_equals(a->field, b->field);
+}
+
+/* Add a 'when' constant as case k; 0 if an earlier case has the same key */
+static bool add_case(HashTable *cases, const zval *value, uint32_t k)
+{
+    zval num;
+    zend_ulong index;
+
+    ZVAL_LONG(&num, k);
+
+    if (Z_TYPE_P(value) == IS_LONG) {
+        return zend_hash_index_add(cases, (zend_ulong)Z_LVAL_P(value), &num) != NULL;
+    }
+
+    /* Integer strings become integer keys, as in PHP arrays */
+    if (ZEND_HANDLE_NUMERIC_STR(Z_STR_P(value), index)) {
+        return zend_hash_index_add(cases, index, &num) != NULL;
+    }
+    return zend_hash_add(cases, Z_STR_P(value), &num) != NULL;
+}
+
+/*
+ * Lower a run of 'when' rules at rules[0] that test one field for equality
+ * with distinct constants, none with an else branch, to a dispatch.
+ *
+ * For integer and string values at most one of the tests holds, so the
+ * dispatch runs the one matching block. Values that compare loosely
+ * against several constants (booleans, null) still run every block whose
+ * test holds, in order (see all_matches). Returns the number of rules
+ * consumed, 0 if the run is too short to be worth it.
+ */
+static size_t compile_when_chain(sf_program_t *prog, sf_parsed_rule_t **rules, size_t count, zend_uchar guard)
+{
+    const sf_condition_test_t *first = case_test(rules[0]);
+    if (!first || count < SF_DISPATCH_MIN_CASES) {
+        return 0;
+    }
+
+    HashTable *cases;
+    ALLOC_HASHTABLE(cases);
+    zend_hash_init(cases, count, NULL, NULL, 0);
+
+    size_t n = 0;
+    while (n < count) {
+        const sf_condition_test_t *test = case_test(rules[n]);
+        if (!test || !same_subject(test, first) || !add_case(cases, &test->value, n)) {
+            break;
+        }
+        n++;
+    }
+
+    if (n < SF_DISPATCH_MIN_CASES) {
+        zend_hash_destroy(cases);
+        FREE_HASHTABLE(cases);
+        return 0;
+    }
+
+    uint32_t idx = alloc_param(prog);
+    sf_parsed_rule_t *param = &prog->params[idx];
+    param->type = RULE_VARIANT;
+    sf_path_copy(&param->params.variant.path, &first->path);
+    param->params.variant.key = first->field ? zend_string_copy(first->field) : NULL;
+    param->params.variant.cases = cases;
+    param->params.variant.case_count = (uint32_t)n;
+    param->params.variant.all_matches = 1;
+
+    sf_parsed_rule_t ***lists = safe_emalloc(n, sizeof(sf_parsed_rule_t **), 0);
+    size_t *counts = safe_emalloc(n, sizeof(size_t), 0);
+    for (size_t k = 0; k < n; k++) {
+        lists[k] = rules[k]->params.conditional.then_rules;
+        counts[k] = rules[k]->params.conditional.then_count;
+    }
+
+    compile_dispatch(prog, idx, lists, counts, NULL, 0, guard);
+
+    efree(lists);
+    efree(counts);
+    return n;
+}
+
+/*
+ * Compile one rule. `guard` is the type established by an earlier guard
+ * in an enclosing or the current list (IS_UNDEF if none); it may be set
+ * here for the rules that follow. Recursion is bounded by
+ * SF_MAX_RULE_PARSE_DEPTH.
+ */
+static void compile_rule(sf_program_t *prog, sf_parsed_rule_t *rule, zend_uchar *guard)
+{
+    if (rule->type == RULE_WHEN) {
+        uint32_t cond = move_params(prog, rule);
+        uint32_t branch = emit_insn(prog, SF_OP_BRANCH, cond, 0);
+        assign_memo(prog, cond);
+
+        /* A guard inside a branch does not dominate the rules after it */
+        compile_rule_list(prog,
+            rule->params.conditional.then_rules,
+            rule->params.conditional.then_count,
+            *guard);
+
+        if (rule->params.conditional.else_count > 0) {
+            uint32_t jump = emit_insn(prog, SF_OP_JUMP, 0, 0);
+            prog->code[branch].b = prog->code_len;
+
+            compile_rule_list(prog,
+                rule->params.conditional.else_rules,
+                rule->params.conditional.else_count,
+                *guard);
+
+            prog->code[jump].a = prog->code_len;
+        } else {
+            prog->code[branch].b = prog->code_len;
+        }
+        return;
+    }
+
+    if (rule->type == RULE_VARIANT) {
+        uint32_t idx = move_params(prog, rule);
+        compile_dispatch(prog, idx,
+            rule->params.variant.case_rules,
+            rule->params.variant.case_counts,
+            rule->params.variant.default_rules,
+            rule->params.variant.default_count,
+            *guard);
+        return;
+    }
+
+    if (SF_RULE_IS_COMBINATOR(rule->type)) {
+        uint32_t idx = move_params(prog, rule);
+        compile_combinator(prog, idx,
+            rule->params.combinator.branch_rules,
+            rule->params.combinator.branch_counts,
+            *guard);
+        return;
+    }
+
+    if (rule->type == RULE_BAIL || rule->type == RULE_SOMETIMES) {
+        /* Lowered to sf_field_program_t flags by sf_compile_rules() */
+        return;
+    }
+
+    uint32_t idx = rule_has_params(rule->type) ? move_params(prog, rule) : 0;
+    uint16_t variant = specialized_op(rule->type, *guard);
+
+    /* Every collection rule accumulates on its own */
+    if (SF_RULE_IS_AGGREGATE(rule->type)) {
+        prog->params[idx].params.aggregate.slot = prog->aggregate_count++;
+    }
+
+    if (SF_RULE_IS_PRESENCE(rule->type)) {
+        assign_facts(prog, idx);
+    }
+
+    if (variant != RULE_UNKNOWN) {
+        uint32_t pc = emit_insn(prog, variant, idx, (uint32_t)rule->type);
+        prog->code[pc].flags = SF_INSN_SPECIALIZED;
+        return;
+    }
+
+    uint32_t pc = emit_insn(prog, (uint16_t)rule->type, idx, 0);
+
+    if (rule->type == RULE_STRING || rule->type == RULE_ARRAY) {
+        prog->code[pc].flags = SF_INSN_GUARD;
+        if (*guard == IS_UNDEF) {
+            *guard = rule->type == RULE_STRING ? IS_STRING : IS_ARRAY;
+        }
+    }
+}
+
+static void compile_rule_list(sf_program_t *prog, sf_parsed_rule_t **rules, size_t count, zend_uchar guard)
+{
+    size_t i = 0;
+
+    while (i < count) {
+        size_t used = compile_when_chain(prog, rules + i, count - i, guard);
+        if (used == 0) {
+            used = compile_fused(prog, rules + i, count - i, &guard);
+        }
+        if (used == 0) {
+            compile_rule(prog, rules[i], &guard);
+            used = 1;
+        }
+        i += used;
+    }
+}
+
+/*
+ * Give 'confirmed' rules the compiled path of their {field}_confirmation
+ * field. In wildcard fields it is a sibling of the element's value
+ * ("^.pin_confirmation"); fields ending in '*' build it per element.
+ */
+static void bind_confirmed(sf_parsed_rule_t **rules, size_t count, const sf_field_program_t *owner)
+{
+    const char *name = owner->name;
+    size_t name_len = owner->name_len;
+
+    if (owner->has_wildcard) {
+        const sf_path_segment_t *last = &owner->path.segments[owner->path.count - 1];
+        if (last->is_wildcard) {
+            return;
+        }
+        name = ZSTR_VAL(last->key);
+        name_len = ZSTR_LEN(last->key);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        sf_parsed_rule_t *rule = rules[i];
+
+        if (rule->type == RULE_WHEN) {
+            bind_confirmed(rule->params.conditional.then_rules,
+                rule->params.conditional.then_count, owner);
+            bind_confirmed(rule->params.conditional.else_rules,
+                rule->params.conditional.else_count, owner);
+        } else if (rule->type == RULE_VARIANT) {
+            for (uint32_t k = 0; k < rule->params.variant.case_count; k++) {
+                bind_confirmed(rule->params.variant.case_rules[k],
+                    rule->params.variant.case_counts[k], owner);
+            }
+            bind_confirmed(rule->params.variant.default_rules,
+                rule->params.variant.default_count, owner);
+        } else if (SF_RULE_IS_COMBINATOR(rule->type)) {
+            for (uint32_t k = 0; k < rule->params.combinator.branch_count; k++) {
+                bind_confirmed(rule->params.combinator.branch_rules[k],
+                    rule->params.combinator.branch_counts[k], owner);
+            }
+        } else if (rule->type == RULE_CONFIRMED && !rule->params.field_ref.field) {
+            size_t prefix = owner->has_wildcard ? sizeof("^.") - 1 : 0;
+            size_t len = prefix + name_len + sizeof("_confirmation") - 1;
+            char *field = emalloc(len + 1);
+            memcpy(field, "^.", prefix);
+            memcpy(field + prefix, name, name_len);
+            memcpy(field + prefix + name_len, "_confirmation", sizeof("_confirmation"));
+
+            rule->params.field_ref.field = field;
+            rule->params.field_ref.len = len;
+            sf_path_init(&rule->params.field_ref.path, field, len);
+            sf_path_bind(&rule->params.field_ref.path, &owner->path);
+        }
+    }
+}
+
+/* Whether a top-level rule list contains a rule of the given type */
+static bool list_has_rule(sf_parsed_rule_t **rules, size_t count, sf_rule_type_t type)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (rules[i]->type == type) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Group the wildcard fields into the traversal trie */
+static void build_walk_trie(sf_program_t *prog)
+{
+    memset(&prog->walk, 0, sizeof(prog->walk));
+    prog->walk.gate = SF_NO_FIELD;
+
+    for (uint32_t i = 0; i < prog->field_count; i++) {
+        sf_field_program_t *field = &prog->fields[i];
+
+        field->walk_leader = 0;
+        field->walk_group = 0;
+        if (field->has_wildcard) {
+            field->walk_group = sf_walk_trie_add(&prog->walk, &field->path, i, &field->walk_leader);
+        }
+    }
+}
+
+/* Give every distinct first path segment a slot, for presence passes over the data's keys */
+static void build_root_index(sf_program_t *prog)
+{
+    ALLOC_HASHTABLE(prog->roots);
+    zend_hash_init(prog->roots, SF_HASH_INITIAL_SIZE, NULL, NULL, 0);
+    prog->root_count = 0;
+
+    for (uint32_t i = 0; i < prog->field_count; i++) {
+        sf_field_program_t *field = &prog->fields[i];
+
+        field->root = SF_NO_FIELD;
+        if (field->path.count == 0 || field->path.segments[0].is_wildcard) {
+            continue;
+        }
+
+        /* Keyed as an array would key it, so data keys look up directly */
+        zval *slot = zend_symtable_find(prog->roots, field->path.segments[0].key);
+        if (!slot) {
+            zval next;
+            ZVAL_LONG(&next, prog->root_count++);
+            slot = zend_symtable_update(prog->roots, field->path.segments[0].key, &next);
+        }
+        field->root = (uint32_t)Z_LVAL_P(slot);
+    }
+}
+
+/*
+ * Group the run order by root, for data-driven runs (see run_fields()).
+ * root_fields holds positions in order, so the entries of one root stay
+ * in run order: root slot r has those from root_start[r] to
+ * root_start[r + 1], and slot root_count those of fields whose first
+ * segment is '*', which run whatever the data holds.
+ *
+ * absent_fields lists the plain fields that still run when their first
+ * segment is absent: those that can report on an absent value (not
+ * absent_quiet), unless an absent 'sometimes' field above them skips
+ * them.
+ */
+static void build_root_lists(sf_program_t *prog)
+{
+    uint32_t slots = prog->root_count + 1;
+
+    prog->root_start = ecalloc(slots + 1, sizeof(uint32_t));
+    prog->root_fields = NULL;
+    prog->absent_fields = NULL;
+    prog->absent_count = 0;
+    if (prog->order_len == 0) {
+        return;
+    }
+
+    prog->root_fields = safe_emalloc(prog->order_len, sizeof(uint32_t), 0);
+    prog->absent_fields = safe_emalloc(prog->order_len, sizeof(uint32_t), 0);
+
+    /* Count per slot, then place in run order */
+    for (uint32_t o = 0; o < prog->order_len; o++) {
+        uint32_t root = prog->fields[prog->order[o]].root;
+        prog->root_start[(root == SF_NO_FIELD ? prog->root_count : root) + 1]++;
+    }
+    for (uint32_t r = 0; r < slots; r++) {
+        prog->root_start[r + 1] += prog->root_start[r];
+    }
+
+    uint32_t *next = safe_emalloc(slots, sizeof(uint32_t), 0);
+    memcpy(next, prog->root_start, slots * sizeof(uint32_t));
+
+    /* Fields skipped when their root is absent; parents come first in order */
+    bool *skipped = ecalloc(prog->field_count, sizeof(bool));
+
+    for (uint32_t o = 0; o < prog->order_len; o++) {
+        uint32_t i = prog->order[o];
+        const sf_field_program_t *field = &prog->fields[i];
+        uint32_t slot = field->root == SF_NO_FIELD ? prog->root_count : field->root;
+
+        prog->root_fields[next[slot]++] = o;
+
+        if (field->has_wildcard || field->root == SF_NO_FIELD) {
+            continue;
+        }
+        skipped[i] = (field->absent_quiet && field->sometimes)
+            || (field->parent != SF_NO_FIELD && skipped[field->parent]);
+        if (!skipped[i] && !field->absent_quiet) {
+            prog->absent_fields[prog->absent_count++] = o;
+        }
+    }
+
+    efree(skipped);
+    efree(next);
+}
+
+/*
+ * Hash key of a path's first `count` segments: each segment's length, then
+ * its bytes. Built from the contents, since segment keys are only interned
+ * where the engine allows it and equal segments may sit at different
+ * addresses.
+ */
+static zend_string *prefix_key(const sf_path_t *path, uint32_t count)
+{
+    size_t len = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        len += sizeof(uint32_t) + ZSTR_LEN(path->segments[i].key);
+    }
+
+    zend_string *key = zend_string_alloc(len, 0);
+    char *p = ZSTR_VAL(key);
+
+    for (uint32_t i = 0; i < count; i++) {
+        const zend_string *segment = path->segments[i].key;
+        uint32_t segment_len = (uint32_t)ZSTR_LEN(segment);
+
+        memcpy(p, &segment_len, sizeof(segment_len));
+        memcpy(p + sizeof(segment_len), ZSTR_VAL(segment), segment_len);
+        p += sizeof(segment_len) + segment_len;
+    }
+    *p = '\0';
+    return key;
+}
+
+/* Free an entry of the child key index */
+static void child_keys_dtor(zval *zv)
+{
+    if (Z_TYPE_P(zv) == IS_PTR) {
+        zend_hash_destroy(Z_PTR_P(zv));
+        FREE_HASHTABLE(Z_PTR_P(zv));
+    }
+}
+
+/*
+ * Index the keys declared below every path prefix of the fields: prefix
+ * => table of next segments, or null if a wildcard field stands for any
+ * key there. Built on first use, in one pass over the fields.
+ */
+static void build_child_keys(sf_program_t *prog)
+{
+    ALLOC_HASHTABLE(prog->child_keys);
+    zend_hash_init(prog->child_keys, SF_HASH_INITIAL_SIZE, NULL, child_keys_dtor, 0);
+
+    zval empty;
+    ZVAL_NULL(&empty);
+
+    for (uint32_t i = 0; i < prog->field_count; i++) {
+        const sf_path_t *path = &prog->fields[i].path;
+
+        for (uint32_t d = 0; d < path->count; d++) {
+            zend_string *key = prefix_key(path, d);
+            zval *slot = zend_hash_find(prog->child_keys, key);
+
+            if (!slot) {
+                HashTable *keys;
+                ALLOC_HASHTABLE(keys);
+                zend_hash_init(keys, 8, NULL, NULL, 0);
+
+                zval ptr;
+                ZVAL_PTR(&ptr, keys);
+                slot = zend_hash_add_new(prog->child_keys, key, &ptr);
+            }
+            zend_string_release(key);
+
+            if (Z_TYPE_P(slot) != IS_PTR) {
+                continue;
+            }
+            if (path->segments[d].is_wildcard) {
+                child_keys_dtor(slot);
+                ZVAL_NULL(slot);
+                continue;
+            }
+            zend_symtable_update(Z_PTR_P(slot), path->segments[d].key, &empty);
+        }
+    }
+}
+
+/*
+ * The keys declared directly below a path: the next segment of every
+ * field under it. NULL if a wildcard field stands for any key there.
+ */
+static HashTable *declared_keys(sf_program_t *prog, const sf_path_t *path)
+{
+    if (!prog->child_keys) {
+        build_child_keys(prog);
+    }
+
+    zend_string *key = prefix_key(path, path->count);
+    zval *slot = zend_hash_find(prog->child_keys, key);
+    zend_string_release(key);
+
+    if (!slot) {
+        HashTable *keys;
+        ALLOC_HASHTABLE(keys);
+        zend_hash_init(keys, 0, NULL, NULL, 0);
+        return keys;
+    }
+
+    return Z_TYPE_P(slot) == IS_PTR ? zend_array_dup(Z_PTR_P(slot)) : NULL;
+}
+
+/* Give a compiled field's 'strict' rules the keys declared below the field */
+static void index_strict_keys(sf_program_t *prog, const sf_field_program_t *field)
+{
+    for (uint32_t pc = field->start; pc < field->end; pc++) {
+        if (prog->code[pc].op == RULE_STRICT) {
+            prog->params[prog->code[pc].a].params.key_index.keys = declared_keys(prog, &field->path);
+        }
+    }
+}
+
+/* Scheduling state while building the run order */
+typedef struct {
+    sf_program_t *prog;
+    bool *scheduled;
+    uint32_t *group_leader;     /* Leader field per walk group */
+} sf_schedule_t;
+
+static void schedule_field(sf_schedule_t *s, uint32_t i);
+
+/* Schedule the plain fields gating nodes of a walk subtree */
+static void schedule_gates(sf_schedule_t *s, const sf_walk_node_t *node)
+{
+    if (node->gate != SF_NO_FIELD) {
+        schedule_field(s, node->gate);
+    }
+    for (uint32_t i = 0; i < node->child_count; i++) {
+        schedule_gates(s, &node->children[i]);
+    }
+}
+
+/*
+ * Append field i to the run order after the fields it depends on: its
+ * parent, or for a wildcard field every gate of its walk group (the group
+ * is entered once, through its leader). Recursion follows strictly
+ * shorter paths, so it terminates.
+ */
+static void schedule_field(sf_schedule_t *s, uint32_t i)
+{
+    sf_program_t *prog = s->prog;
+    sf_field_program_t *field = &prog->fields[i];
+
+    if (field->has_wildcard) {
+        i = s->group_leader[field->walk_group];
+        field = &prog->fields[i];
+    }
+
+    if (s->scheduled[i]) {
+        return;
+    }
+    s->scheduled[i] = 1;
+
+    if (field->has_wildcard) {
+        schedule_gates(s, &prog->walk.children[field->walk_group]);
+    } else if (field->parent != SF_NO_FIELD) {
+        schedule_field(s, field->parent);
+    }
+
+    prog->order[prog->order_len++] = i;
+}
+
+/*
+ * Link plain fields to their nearest plain ancestor, make them gates of
+ * the walk trie, and order the fields so every gate runs before what it
+ * gates. Fields without such a dependency keep their declaration order.
+ */
+static void build_schedule(sf_program_t *prog)
+{
+    uint32_t n = prog->field_count;
+
+    prog->order = n ? safe_emalloc(n, sizeof(uint32_t), 0) : NULL;
+    prog->order_len = 0;
+    if (n == 0) {
+        return;
+    }
+
+    /* Plain fields by path, first declared wins */
+    HashTable plain;
+    zend_hash_init(&plain, n, NULL, NULL, 0);
+    for (uint32_t i = 0; i < n; i++) {
+        const sf_field_program_t *field = &prog->fields[i];
+        if (!field->has_wildcard) {
+            zend_string *key = prefix_key(&field->path, field->path.count);
+            zval index;
+            ZVAL_LONG(&index, i);
+            zend_hash_add(&plain, key, &index);
+            zend_string_release(key);
+        }
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        sf_field_program_t *field = &prog->fields[i];
+
+        field->parent = SF_NO_FIELD;
+        if (field->has_wildcard) {
+            continue;
+        }
+
+        /* The longest proper prefix that is a plain field */
+        for (uint32_t d = field->path.count; d-- > 1 && field->parent == SF_NO_FIELD;) {
+            zend_string *key = prefix_key(&field->path, d);
+            zval *parent = zend_hash_find(&plain, key);
+            zend_string_release(key);
+            if (parent) {
+                field->parent = (uint32_t)Z_LVAL_P(parent);
+            }
+        }
+
+        sf_walk_trie_gate(&prog->walk, &field->path, i);
+    }
+    zend_hash_destroy(&plain);
+
+    sf_schedule_t s;
+    s.prog = prog;
+    s.scheduled = ecalloc(n, sizeof(bool));
+    s.group_leader = safe_emalloc(prog->walk.child_count ? prog->walk.child_count : 1, sizeof(uint32_t), 0);
+
+    for (uint32_t i = 0; i < n; i++) {
+        if (prog->fields[i].walk_leader) {
+            s.group_leader[prog->fields[i].walk_group] = i;
+        }
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        schedule_field(&s, i);
+    }
+
+    efree(s.scheduled);
+    efree(s.group_leader);
+}
+
+/*
+ * Resolve the 'schema' rules of a rule list to schema table indices.
+ * Throws and returns 0 on a name the table does not have. Recursion is
+ * bounded by SF_MAX_RULE_PARSE_DEPTH.
+ */
+static bool resolve_schemas(const sf_schema_t *schemas, uint32_t schema_count, sf_parsed_rule_t **rules, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        sf_parsed_rule_t *rule = rules[i];
+
+        if (rule->type == RULE_SCHEMA) {
+            zend_string *name = rule->params.schema.name;
+            if (!name) {
+                zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                    "Rule 'schema' requires a schema name");
+                return 0;
+            }
+
+            uint32_t k = 0;
+            while (k < schema_count && !zend_string_equals(schemas[k].name, name)) {
+                k++;
+            }
+            if (k == schema_count) {
+                zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                    "Unknown schema '%s'", ZSTR_VAL(name));
+                return 0;
+            }
+            rule->params.schema.id = k;
+        } else if (rule->type == RULE_WHEN) {
+            if (!resolve_schemas(schemas, schema_count,
+                    rule->params.conditional.then_rules, rule->params.conditional.then_count)
+                || !resolve_schemas(schemas, schema_count,
+                    rule->params.conditional.else_rules, rule->params.conditional.else_count)) {
+                return 0;
+            }
+        } else if (rule->type == RULE_VARIANT) {
+            for (uint32_t k = 0; k < rule->params.variant.case_count; k++) {
+                if (!resolve_schemas(schemas, schema_count,
+                        rule->params.variant.case_rules[k], rule->params.variant.case_counts[k])) {
+                    return 0;
+                }
+            }
+            if (!resolve_schemas(schemas, schema_count,
+                    rule->params.variant.default_rules, rule->params.variant.default_count)) {
+                return 0;
+            }
+        } else if (SF_RULE_IS_COMBINATOR(rule->type)) {
+            for (uint32_t k = 0; k < rule->params.combinator.branch_count; k++) {
+                if (!resolve_schemas(schemas, schema_count,
+                        rule->params.combinator.branch_rules[k], rule->params.combinator.branch_counts[k])) {
+                    return 0;
+                }
+            }
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Compile one field's parsed rules, appending its chain to the program.
+ * Leaves the rule list to the caller.
+ */
+static void compile_field(sf_program_t *prog, sf_field_program_t *field, sf_field_rules_t *fr)
+{
+    const sf_compile_options_t *options = &prog->options;
+
+    bind_confirmed(fr->rules, fr->rule_count, field);
+    field->bail = options->bail || list_has_rule(fr->rules, fr->rule_count, RULE_BAIL);
+    field->sometimes = list_has_rule(fr->rules, fr->rule_count, RULE_SOMETIMES);
+
+    if (options->optimize) {
+        sf_optimize_rule_list(fr->rules, &fr->rule_count, field->bail);
+    }
+
+    field->has_nullable = list_has_rule(fr->rules, fr->rule_count, RULE_NULLABLE);
+
+    /* 'bail' and 'sometimes' emit nothing; look past them for a leading nullable */
+    size_t first = 0;
+    while (first < fr->rule_count
+        && (fr->rules[first]->type == RULE_BAIL || fr->rules[first]->type == RULE_SOMETIMES)) {
+        first++;
+    }
+
+    /* Nothing in a chain that stops at its leading nullable looks at an absent value */
+    bool leading_nullable = first < fr->rule_count && fr->rules[first]->type == RULE_NULLABLE;
+    field->absent_quiet = field->sometimes || leading_nullable;
+
+    field->skip_empty = 0;
+    if (options->optimize && leading_nullable) {
+        field->skip_empty = 1;
+        first++;
+    }
+
+    uint32_t aggregates = prog->aggregate_count;
+
+    field->start = prog->code_len;
+    compile_rule_list(prog, fr->rules + first, fr->rule_count - first, IS_UNDEF);
+    field->end = prog->code_len;
+
+    field->has_aggregates = prog->aggregate_count > aggregates;
+}
+
+/*
+ * Compile parsed rules into a program, consuming the parse tree.
+ *
+ * Fields parsed by sf_parse_rules_deferred() are kept uncompiled until
+ * sf_compile_field() is called for them.
+ *
+ * With options->optimize the rule lists are first rewritten by the
+ * optimizer (see optimizer.c), and a leading 'nullable' is hoisted out of
+ * the chain: the field skips its chain for null/empty values without
+ * dispatching a single instruction.
+ *
+ * Returns NULL with an exception thrown if a 'schema' rule names a schema
+ * the table does not have.
+ */
+static sf_program_t *compile_program(
+    HashTable *parsed_rules,
+    const sf_compile_options_t *options,
+    sf_schema_t *schemas,
+    uint32_t schema_count
+)
+{
+    sf_field_rules_t *fr;
+
+    /* Unknown schema names fail before anything is compiled */
+    ZEND_HASH_FOREACH_PTR(parsed_rules, fr) {
+        if (Z_ISUNDEF(fr->source) && !resolve_schemas(schemas, schema_count, fr->rules, fr->rule_count)) {
+            sf_free_parsed_rules_ht(parsed_rules);
+            return NULL;
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    sf_program_t *prog = ecalloc(1, sizeof(sf_program_t));
+    prog->schemas = schemas;
+    prog->schema_count = schema_count;
+
+    /* Slot 0: empty params for parameterless rules */
+    alloc_param(prog);
+    prog->params[0].type = RULE_UNKNOWN;
+
+    uint32_t field_count = zend_hash_num_elements(parsed_rules);
+    prog->fields = field_count ? safe_emalloc(field_count, sizeof(sf_field_program_t), 0) : NULL;
+    prog->field_count = 0;
+
+    prog->options = *options;
+
+    ZEND_HASH_FOREACH_PTR(parsed_rules, fr) {
+        sf_field_program_t *field = &prog->fields[prog->field_count++];
+
+        /* Take the name over from the parse tree */
+        field->name = fr->field_name;
+        field->name_len = fr->field_len;
+        fr->field_name = NULL;
+
+        field->has_wildcard = sf_has_wildcard(field->name, field->name_len);
+        sf_path_init(&field->path, field->name, field->name_len);
+
+        ZVAL_UNDEF(&field->pending);
+        if (Z_ISUNDEF(fr->source)) {
+            compile_field(prog, field, fr);
+            continue;
+        }
+
+        /* Lazy: keep the rules for sf_compile_field(); gating needs 'sometimes' and absent_quiet now */
+        ZVAL_COPY_VALUE(&field->pending, &fr->source);
+        ZVAL_UNDEF(&fr->source);
+
+        field->bail = options->bail || sf_source_has_rule(&field->pending, RULE_BAIL);
+        field->sometimes = sf_source_has_rule(&field->pending, RULE_SOMETIMES);
+        field->absent_quiet = field->sometimes || sf_source_leads_with(&field->pending, RULE_NULLABLE);
+        field->has_nullable = 0;
+        field->skip_empty = 0;
+        field->has_aggregates = 0;
+        field->start = field->end = 0;
+    } ZEND_HASH_FOREACH_END();
+
+    sf_free_parsed_rules_ht(parsed_rules);
+
+    /* Every field is known now: index the keys 'strict' accepts */
+    for (uint32_t i = 0; i < prog->field_count; i++) {
+        if (!SF_FIELD_PENDING(&prog->fields[i])) {
+            index_strict_keys(prog, &prog->fields[i]);
+        }
+    }
+
+    if (options->profile) {
+        sf_profile_init(prog);
+        prog->profiling = 1;
+    }
+
+    return prog;
+}
+
+/* Release a schema table and the schema programs in it */
+static void free_schemas(sf_schema_t *schemas, uint32_t count)
+{
+    for (uint32_t k = 0; k < count; k++) {
+        if (schemas[k].name) {
+            zend_string_release(schemas[k].name);
+        }
+        sf_free_program(schemas[k].program);
+    }
+    if (schemas) {
+        efree(schemas);
+    }
+}
+
+/*
+ * Parse and compile the 'schemas' option into a schema table. All names
+ * are entered before any schema compiles, so schemas can refer to each
+ * other and to themselves. Returns 0 with an exception thrown (and the
+ * table released) on an invalid schema.
+ */
+static bool compile_schemas(
+    HashTable *definitions,
+    const sf_compile_options_t *options,
+    sf_schema_t **table,
+    uint32_t *count
+)
+{
+    sf_schema_t *schemas = ecalloc(zend_hash_num_elements(definitions), sizeof(sf_schema_t));
+    uint32_t n = 0;
+    zend_string *name;
+    zval *definition;
+
+    ZEND_HASH_FOREACH_STR_KEY_VAL(definitions, name, definition) {
+        if (!name || ZSTR_LEN(name) == 0) {
+            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                "Schema names must be non-empty strings");
+            free_schemas(schemas, n);
+            return 0;
+        }
+        if (Z_TYPE_P(definition) != IS_ARRAY) {
+            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                "Schema '%s' must be an array of field rules", ZSTR_VAL(name));
+            free_schemas(schemas, n);
+            return 0;
+        }
+        schemas[n++].name = zend_string_copy(name);
+    } ZEND_HASH_FOREACH_END();
+
+    /* Statistics cover the top-level fields only */
+    sf_compile_options_t schema_options = *options;
+    schema_options.profile = 0;
+
+    uint32_t k = 0;
+    ZEND_HASH_FOREACH_VAL(definitions, definition) {
+        HashTable *parsed = options->lazy
+            ? sf_parse_rules_deferred(Z_ARRVAL_P(definition))
+            : sf_parse_rules(Z_ARRVAL_P(definition));
+        if (parsed) {
+            schemas[k].program = compile_program(parsed, &schema_options, schemas, n);
+        }
+        if (!schemas[k].program) {
+            free_schemas(schemas, n);
+            return 0;
+        }
+        k++;
+    } ZEND_HASH_FOREACH_END();
+
+    *table = schemas;
+    *count = n;
+    return 1;
+}
+
+/* Compile a Validator's rules and schemas */
+sf_program_t *sf_compile_rules(HashTable *parsed_rules, HashTable *schemas, const sf_compile_options_t *options)
+{
+    sf_schema_t *table = NULL;
+    uint32_t count = 0;
+
+    if (schemas && zend_hash_num_elements(schemas) > 0
+        && !compile_schemas(schemas, options, &table, &count)) {
+        sf_free_parsed_rules_ht(parsed_rules);
+        return NULL;
+    }
+
+    sf_program_t *prog = compile_program(parsed_rules, options, table, count);
+    if (!prog) {
+        free_schemas(table, count);
+        return NULL;
+    }
+
+    prog->owns_schemas = 1;
+    return prog;
+}
+
+/* Build what runs need over all fields, once */
+void sf_prepare_program(sf_program_t *prog)
+{
+    if (prog->prepared) {
+        return;
+    }
+
+    if (prog->options.strict) {
+        sf_path_t root = {NULL, 0, SF_PATH_ROOT};
+        prog->strict_keys = declared_keys(prog, &root);
+    }
+
+    build_walk_trie(prog);
+    build_schedule(prog);
+    build_root_index(prog);
+    build_root_lists(prog);
+    prog->prepared = 1;
+}
+
+/* Find a field by name, through an index built on first use */
+uint32_t sf_find_field(sf_program_t *prog, zend_string *name)
+{
+    if (!prog->field_index) {
+        ALLOC_HASHTABLE(prog->field_index);
+        zend_hash_init(prog->field_index, prog->field_count, NULL, NULL, 0);
+        for (uint32_t i = 0; i < prog->field_count; i++) {
+            zval slot;
+            ZVAL_LONG(&slot, i);
+            /* Keyed as the rules array keys it: "7" is the integer 7 */
+            zend_symtable_str_update(prog->field_index, prog->fields[i].name, prog->fields[i].name_len, &slot);
+        }
+    }
+
+    zval *slot = zend_symtable_find(prog->field_index, name);
+    return slot ? (uint32_t)Z_LVAL_P(slot) : SF_NO_FIELD;
+}
+
+/* Compile a lazy field's pending rules */
+bool sf_compile_field(sf_program_t *prog, uint32_t index)
+{
+    sf_field_program_t *field = &prog->fields[index];
+
+    if (!SF_FIELD_PENDING(field)) {
+        return 1;
+    }
+
+    zend_string *name = zend_string_init(field->name, field->name_len, 0);
+    sf_field_rules_t *fr = sf_parse_field_rules(name, &field->pending);
+    zend_string_release(name);
+
+    if (!fr) {
+        return 0;
+    }
+
+    if (!resolve_schemas(prog->schemas, prog->schema_count, fr->rules, fr->rule_count)) {
+        sf_free_field_rules(fr);
+        return 0;
+    }
+
+    uint32_t from = prog->code_len;
+    compile_field(prog, field, fr);
+    sf_free_field_rules(fr);
+    index_strict_keys(prog, field);
+
+    zval_ptr_dtor(&field->pending);
+    ZVAL_UNDEF(&field->pending);
+
+    if (prog->profile) {
+        sf_profile_grow(prog, from);
+    }
+
+    return 1;
+}
+
+/* Deep copy the heap parameters of one side-table entry */
+static void copy_params(sf_parsed_rule_t *dst, const sf_parsed_rule_t *src)
+{
+    *dst = *src;
+
+    switch (src->type) {
+        case RULE_REGEX:
+        case RULE_NOT_REGEX:
+            if (src->params.regex.pattern) {
+                dst->params.regex.pattern = estrndup(src->params.regex.pattern, src->params.regex.len);
+            }
+            break;
+
+        case RULE_STARTS_WITH:
+        case RULE_ENDS_WITH:
+        case RULE_CONTAINS:
+        case RULE_DATE_FORMAT:
+            if (src->params.string.str) {
+                dst->params.string.str = estrndup(src->params.string.str, src->params.string.len);
+            }
+            break;
+
+        case RULE_SAME:
+        case RULE_DIFFERENT:
+        case RULE_CONFIRMED:
+        case RULE_AFTER:
+        case RULE_BEFORE:
+        case RULE_AFTER_OR_EQUAL:
+        case RULE_BEFORE_OR_EQUAL:
+            if (src->params.field_ref.field) {
+                dst->params.field_ref.field = estrndup(src->params.field_ref.field, src->params.field_ref.len);
+            }
+            sf_path_copy(&dst->params.field_ref.path, &src->params.field_ref.path);
+            break;
+
+        case RULE_IN:
+        case RULE_NOT_IN:
+            if (src->params.in_list.values) {
+                ALLOC_HASHTABLE(dst->params.in_list.values);
+                zend_hash_init(dst->params.in_list.values,
+                    zend_hash_num_elements(src->params.in_list.values),
+                    NULL, ZVAL_PTR_DTOR, 0);
+                zend_hash_copy(dst->params.in_list.values, src->params.in_list.values, zval_add_ref);
+            }
+            dst->params.in_list.set = sf_value_set_copy(src->params.in_list.set);
+            break;
+
+        case RULE_KEYS:
+        case RULE_STRICT:
+            if (src->params.key_index.keys) {
+                dst->params.key_index.keys = zend_array_dup(src->params.key_index.keys);
+            }
+            break;
+
+        case RULE_REQUIRED_IF:
+        case RULE_REQUIRED_UNLESS:
+        case RULE_PROHIBITED_IF:
+        case RULE_EXCLUDE_IF:
+        case RULE_REQUIRED_WITH:
+        case RULE_REQUIRED_WITH_ALL:
+        case RULE_REQUIRED_WITHOUT:
+        case RULE_REQUIRED_WITHOUT_ALL:
+            if (src->params.presence.refs) {
+                dst->params.presence.refs = safe_emalloc(src->params.presence.ref_count, sizeof(sf_presence_ref_t), 0);
+                for (uint32_t k = 0; k < src->params.presence.ref_count; k++) {
+                    const sf_presence_ref_t *from = &src->params.presence.refs[k];
+                    sf_presence_ref_t *to = &dst->params.presence.refs[k];
+                    to->field = estrndup(from->field, from->len);
+                    to->len = from->len;
+                    sf_path_copy(&to->path, &from->path);
+                    to->fact = from->fact;
+                }
+            }
+            if (src->params.presence.values) {
+                dst->params.presence.values = zend_array_dup(src->params.presence.values);
+            }
+            dst->params.presence.set = sf_value_set_copy(src->params.presence.set);
+            break;
+
+        case RULE_WHEN:
+            dst->params.conditional.condition = sf_clone_condition(src->params.conditional.condition);
+            break;
+
+        case RULE_VARIANT:
+            if (src->params.variant.field) {
+                dst->params.variant.field = estrndup(src->params.variant.field, src->params.variant.len);
+            }
+            sf_path_copy(&dst->params.variant.path, &src->params.variant.path);
+            if (src->params.variant.key) {
+                zend_string_addref(src->params.variant.key);
+            }
+            dst->params.variant.cases = zend_array_dup(src->params.variant.cases);
+            dst->params.variant.set = sf_value_set_copy(src->params.variant.set);
+            dst->params.variant.starts = safe_emalloc(src->params.variant.case_count + 1, sizeof(uint32_t), 0);
+            memcpy(dst->params.variant.starts, src->params.variant.starts,
+                (src->params.variant.case_count + 1) * sizeof(uint32_t));
+            break;
+
+        case RULE_ANY_OF:
+        case RULE_ALL_OF:
+        case RULE_NONE_OF:
+            dst->params.combinator.starts = safe_emalloc(src->params.combinator.branch_count + 1, sizeof(uint32_t), 0);
+            memcpy(dst->params.combinator.starts, src->params.combinator.starts,
+                (src->params.combinator.branch_count + 1) * sizeof(uint32_t));
+            break;
+
+        case RULE_SCHEMA:
+            if (src->params.schema.name) {
+                zend_string_addref(src->params.schema.name);
+            }
+            break;
+
+        case RULE_COUNT_WHERE:
+            Z_TRY_ADDREF(dst->params.aggregate.operand);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* Deep copy a program */
+sf_program_t *sf_clone_program(const sf_program_t *src)
+{
+    if (!src) {
+        return NULL;
+    }
+
+    sf_program_t *dst = ecalloc(1, sizeof(sf_program_t));
+
+    if (src->code_len > 0) {
+        dst->code = safe_emalloc(src->code_len, sizeof(sf_insn_t), 0);
+        memcpy(dst->code, src->code, src->code_len * sizeof(sf_insn_t));
+    }
+    dst->code_len = src->code_len;
+    dst->code_cap = src->code_len;
+
+    dst->params = safe_emalloc(src->param_count, sizeof(sf_parsed_rule_t), 0);
+    for (uint32_t i = 0; i < src->param_count; i++) {
+        copy_params(&dst->params[i], &src->params[i]);
+    }
+    dst->param_count = src->param_count;
+    dst->param_cap = src->param_count;
+
+    if (src->field_count > 0) {
+        dst->fields = safe_emalloc(src->field_count, sizeof(sf_field_program_t), 0);
+        for (uint32_t i = 0; i < src->field_count; i++) {
+            dst->fields[i] = src->fields[i];
+            dst->fields[i].name = estrndup(src->fields[i].name, src->fields[i].name_len);
+            sf_path_copy(&dst->fields[i].path, &src->fields[i].path);
+            ZVAL_COPY(&dst->fields[i].pending, &src->fields[i].pending);
+        }
+    }
+    dst->field_count = src->field_count;
+    dst->options = src->options;
+    dst->memo_count = src->memo_count;
+    dst->aggregate_count = src->aggregate_count;
+
+    if (src->fact_count > 0) {
+        dst->facts = safe_emalloc(src->fact_count, sizeof(sf_presence_fact_t), 0);
+        for (uint32_t f = 0; f < src->fact_count; f++) {
+            sf_path_copy(&dst->facts[f].path, &src->facts[f].path);
+            dst->facts[f].param = src->facts[f].param;
+        }
+    }
+    dst->fact_count = src->fact_count;
+    dst->fact_cap = src->fact_count;
+
+    /* Run structures and key indexes are rebuilt on first use */
+
+    if (src->profile) {
+        size_t profile_len = src->code_len ? src->code_len : 1;
+        dst->profile = safe_emalloc(profile_len, sizeof(sf_insn_profile_t), 0);
+        memcpy(dst->profile, src->profile, profile_len * sizeof(sf_insn_profile_t));
+    }
+    dst->profiling = src->profiling;
+    dst->validations = src->validations;
+
+    /* Schema programs share the table; its owner copies it for them */
+    dst->schemas = src->schemas;
+    dst->schema_count = src->schema_count;
+    if (src->owns_schemas && src->schema_count > 0) {
+        dst->schemas = safe_emalloc(src->schema_count, sizeof(sf_schema_t), 0);
+        for (uint32_t k = 0; k < src->schema_count; k++) {
+            dst->schemas[k].name = zend_string_copy(src->schemas[k].name);
+            dst->schemas[k].program = sf_clone_program(src->schemas[k].program);
+            dst->schemas[k].program->schemas = dst->schemas;
+        }
+    }
+    dst->owns_schemas = src->owns_schemas;
+
+    return dst;
+}
+
+/* Free a program */
+void sf_free_program(sf_program_t *prog)
+{
+    if (!prog) return;
+
+    for (uint32_t i = 0; i < prog->param_count; i++) {
+        sf_free_rule_params(&prog->params[i]);
+    }
+    if (prog->params) {
+        efree(prog->params);
+    }
+
+    for (uint32_t i = 0; i < prog->field_count; i++) {
+        efree(prog->fields[i].name);
+        sf_path_destroy(&prog->fields[i].path);
+        zval_ptr_dtor(&prog->fields[i].pending);
+    }
+    if (prog->fields) {
+        efree(prog->fields);
+    }
+
+    for (uint32_t f = 0; f < prog->fact_count; f++) {
+        sf_path_destroy(&prog->facts[f].path);
+    }
+    if (prog->facts) {
+        efree(prog->facts);
+    }
+
+    if (prog->strict_keys) {
+        zend_hash_destroy(prog->strict_keys);
+        FREE_HASHTABLE(prog->strict_keys);
+    }
+
+    if (prog->field_index) {
+        zend_hash_destroy(prog->field_index);
+        FREE_HASHTABLE(prog->field_index);
+    }
+
+    if (prog->memo_index) {
+        zend_hash_destroy(prog->memo_index);
+        FREE_HASHTABLE(prog->memo_index);
+    }
+
+    if (prog->fact_index) {
+        zend_hash_destroy(prog->fact_index);
+        FREE_HASHTABLE(prog->fact_index);
+    }
+
+    if (prog->roots) {
+        zend_hash_destroy(prog->roots);
+        FREE_HASHTABLE(prog->roots);
+    }
+
+    if (prog->child_keys) {
+        zend_hash_destroy(prog->child_keys);
+        FREE_HASHTABLE(prog->child_keys);
+    }
+
+    sf_walk_trie_free(&prog->walk);
+
+    if (prog->order) {
+        efree(prog->order);
+    }
+
+    if (prog->root_start) {
+        efree(prog->root_start);
+    }
+
+    if (prog->root_fields) {
+        efree(prog->root_fields);
+    }
+
+    if (prog->absent_fields) {
+        efree(prog->absent_fields);
+    }
+
+    if (prog->code) {
+        efree(prog->code);
+    }
+
+    if (prog->profile) {
+        efree(prog->profile);
+    }
+
+    if (prog->owns_schemas) {
+        free_schemas(prog->schemas, prog->schema_count);
+    }
+
+    efree(prog);
+}
@@ -0,0 +1,222 @@
+/*
+ * Compiled rule programs
+ */
+
+#ifndef SIGNALFORGE_PROGRAM_H
+#define SIGNALFORGE_PROGRAM_H
+
+#include "php_signalforge_validation.h"
+#include "parser.h"
+#include "rules/rules.h"
+#include "wildcard.h"
+
+/*
+ * Opcodes.
+ *
+ * Rule opcodes share their numbering with sf_rule_type_t (and the compiled-
+ * only sf_handler_op_t) so the handler table can be indexed directly by
+ * opcode. Control-flow opcodes follow. RULE_WHEN itself is never emitted -
+ * it is lowered to SF_OP_BRANCH / SF_OP_JUMP - and RULE_VARIANT becomes
+ * SF_OP_DISPATCH followed by one block per case, each ending in a jump
+ * past the default block. Combinators become SF_OP_COMBINE followed by
+ * their branches back to back.
+ */
+typedef enum {
+    SF_OP_BRANCH = SF_OP_HANDLER_COUNT,  /* a = condition param, b = else target */
+    SF_OP_JUMP,                          /* a = target */
+    SF_OP_DISPATCH,                      /* a = variant param */
+    SF_OP_COMBINE,                       /* a = combinator param */
+} sf_opcode_t;
+
+/* Returns true if the opcode is dispatched through the handler table */
+#define SF_OP_IS_RULE(op) ((op) < SF_OP_HANDLER_COUNT)
+
+/* Instruction flags */
+#define SF_INSN_GUARD        (1 << 0)  /* Type guard: failure disables specialized variants */
+#define SF_INSN_SPECIALIZED  (1 << 1)  /* Type-specialized; b = generic opcode */
+
+/*
+ * A single instruction. Kept small and fixed-size so a field's rule chain
+ * is one contiguous run of memory.
+ */
+typedef struct {
+    uint16_t op;        /* sf_rule_type_t or sf_opcode_t */
+    uint16_t flags;
+    uint32_t a;         /* Param index (rules, branch) or jump target */
+    uint32_t b;         /* Else target (branch) or generic opcode (specialized) */
+} sf_insn_t;
+
+/* Per-field entry point into the program */
+typedef struct {
+    char *name;
+    size_t name_len;
+    sf_path_t path;     /* Compiled name (a pattern for wildcard fields) */
+    uint32_t start;     /* First instruction */
+    uint32_t end;       /* One past the last instruction */
+    bool has_nullable;  /* Chain contains a top-level nullable rule */
+    bool has_wildcard;  /* Field path contains '*' */
+    bool skip_empty;    /* Leading nullable hoisted: null/empty skips the chain */
+    bool bail;          /* Stop the chain at its first failure */
+    bool sometimes;     /* Absent: skip the chain and every field below it */
+    bool absent_quiet;  /* Absent: the chain reports nothing ('sometimes' or a leading nullable) */
+    bool has_aggregates; /* Chain holds collection rules (see sf_aggregate_t) */
+    bool walk_leader;   /* First field of its traversal group: walks it */
+    uint32_t walk_group; /* Wildcard fields: top-level group in the walk trie */
+    uint32_t parent;    /* Plain fields: nearest plain ancestor field, or SF_NO_FIELD */
+    uint32_t root;      /* Slot of the first path segment in the root index, or SF_NO_FIELD for '*' */
+    zval pending;       /* Lazy mode: rules array not compiled yet, else UNDEF */
+} sf_field_program_t;
+
+/* Whether a field still waits for sf_compile_field() */
+#define SF_FIELD_PENDING(field) (!Z_ISUNDEF((field)->pending))
+
+/*
+ * Per-call field states, indexed by field. A plain field that did not pass
+ * closes its subtree: wildcard fields below a failed or skipped field are
+ * not walked, and plain fields below a skipped one do not run.
+ */
+#define SF_FIELD_PASSED  0
+#define SF_FIELD_FAILED  1   /* A rule failed (or an ancestor failed) */
+#define SF_FIELD_SKIPPED 2   /* Absent 'sometimes' field (or below one) */
+
+/* Options given to the Validator constructor */
+typedef struct {
+    bool optimize;      /* Run the rule-chain optimizer (default on) */
+    bool bail;          /* Every field stops at its first failure */
+    bool profile;       /* Record rule statistics and reorder bail fields */
+    bool lazy;          /* Compile each field on first use (see sf_compile_field) */
+    bool strict;        /* Reject top-level keys no field declares */
+} sf_compile_options_t;
+
+/*
+ * Per-instruction execution statistics for profile-guided ordering (see
+ * profile.c). Entries parallel the instruction array and move with their
+ * instruction when a field is reordered.
+ */
+typedef struct {
+    uint32_t origin;    /* Compile-time position within the field */
+    uint64_t runs;      /* Times executed */
+    uint64_t fails;     /* Times failed */
+    uint64_t time;      /* Total execution time, nanoseconds */
+} sf_insn_profile_t;
+
+/*
+ * A field state presence rules test, computed once per run of the program
+ * (see run_fields() in validator.c) into a bitmap indexed by fact. Plain
+ * facts say whether the field is filled and are shared by every rule
+ * reading the field; a required_if-style rule's fact says whether the
+ * field's value is one of the rule's values.
+ */
+typedef struct {
+    sf_path_t path;     /* Root-anchored */
+    uint32_t param;     /* The comparing rule's param, or 0 for a filled fact */
+} sf_presence_fact_t;
+
+/*
+ * A named sub-schema: its fields compiled once into a program of their
+ * own, run against every value a 'schema' rule names it for.
+ */
+typedef struct {
+    zend_string *name;
+    struct sf_program_s *program;
+} sf_schema_t;
+
+/*
+ * Compiled program for a whole Validator.
+ *
+ * Rule parameters live in a side table referenced by index; params[0] is an
+ * always-empty slot used by rules without parameters.
+ */
+typedef struct sf_program_s {
+    sf_insn_t *code;
+    uint32_t code_len;
+    uint32_t code_cap;
+
+    sf_parsed_rule_t *params;
+    uint32_t param_count;
+    uint32_t param_cap;
+
+    sf_field_program_t *fields;
+    uint32_t field_count;
+
+    uint32_t memo_count;        /* Memo slots for invariant conditions */
+    uint32_t aggregate_count;   /* Accumulators for collection rules */
+
+    sf_presence_fact_t *facts;  /* Fields presence rules read, resolved once per run */
+    uint32_t fact_count;
+    uint32_t fact_cap;
+
+    HashTable *memo_index;      /* Condition digest => param holding a memoized condition (see assign_memo()) */
+    HashTable *fact_index;      /* Path digest => filled fact (see assign_facts()) */
+
+    sf_compile_options_t options;
+
+    HashTable *strict_keys;     /* Strict option: top-level keys the fields declare; NULL: no check */
+    HashTable *child_keys;      /* Path prefix => keys declared below it, built for 'strict' */
+
+    HashTable *field_index;     /* Field name => field, built on first lookup (sf_find_field()) */
+    HashTable *roots;           /* First path segments of the fields => slot (see run_fields()) */
+    uint32_t root_count;
+    uint64_t rule_driven_runs;  /* Runs that looked every field up in the data */
+    uint64_t data_driven_runs;  /* Runs that marked the data's keys first (sparse input) */
+
+    sf_walk_node_t walk;        /* Traversal trie of the wildcard fields */
+
+    uint32_t *order;            /* Fields to run, parents first; one entry per walk group */
+    uint32_t order_len;
+    uint32_t *root_fields;      /* Positions in order, grouped by root slot ('*' fields last) */
+    uint32_t *root_start;       /* Root slot => its first entry in root_fields; root_count + 2 entries */
+    uint32_t *absent_fields;    /* Positions in order of the fields to run when their root is absent */
+    uint32_t absent_count;
+    bool prepared;              /* walk, order, roots, root lists and strict_keys are built (sf_prepare_program()) */
+
+    sf_schema_t *schemas;       /* Named sub-schemas, shared by all programs of a Validator */
+    uint32_t schema_count;
+    bool owns_schemas;          /* The Validator's top-level program */
+
+    sf_insn_profile_t *profile; /* Parallel to code; NULL unless profiled */
+    bool profiling;             /* Record statistics during validate() */
+    uint32_t validations;       /* validate() calls since the last reorder */
+} sf_program_t;
+
+/*
+ * Compile parsed rules (as returned by sf_parse_rules) into a program.
+ *
+ * schemas is the 'schemas' option (name => field rules), or NULL. Each
+ * schema is parsed and compiled into its own program with the same
+ * options (profiling aside), and 'schema' rules anywhere are resolved
+ * against them.
+ *
+ * Takes ownership of parsed_rules: rule parameters are moved into the
+ * program and the parse tree is freed. Returns NULL with an
+ * InvalidRuleException thrown on an invalid schema or an unknown schema
+ * name.
+ */
+sf_program_t *sf_compile_rules(HashTable *parsed_rules, HashTable *schemas, const sf_compile_options_t *options);
+
+/*
+ * Build the structures a run needs over all fields (walk trie, run order,
+ * root index, top-level strict keys) if not built yet. Called at the start
+ * of every run, so constructing a Validator does no per-field passes
+ * beyond parsing.
+ */
+void sf_prepare_program(sf_program_t *prog);
+
+/*
+ * Compile a lazy field's pending rules into the program. Code, params,
+ * memo slots, accumulators and presence facts grow; indices handed out before stay valid. Returns 0 with an
+ * InvalidRuleException thrown if the rules are invalid (the field stays
+ * pending).
+ */
+bool sf_compile_field(sf_program_t *prog, uint32_t field);
+
+/* Index of the field declared under a name, or SF_NO_FIELD */
+uint32_t sf_find_field(sf_program_t *prog, zend_string *name);
+
+/* Deep copy a program, with its schemas */
+sf_program_t *sf_clone_program(const sf_program_t *src);
+
+/* Free a program (and the schemas it owns) */
+void sf_free_program(sf_program_t *prog);
+
+#endif /* SIGNALFORGE_PROGRAM_H */
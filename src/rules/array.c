@@ -4,8 +4,9 @@
 
 #include "rules.h"
 #include "src/condition.h"
+#include "src/validator.h"
 
-/* distinct - All array values must be unique */
+/* distinct - All array values must be unique (see sf_hash_set_t for equality) */
 sf_rule_result_t sf_rule_distinct(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
 {
     if (ctx->has_nullable && ctx->is_null_or_empty) {
@@ -18,76 +19,304 @@ sf_rule_result_t sf_rule_distinct(sf_validation_context_t *ctx, sf_parsed_rule_t
     }
 
     HashTable *arr = Z_ARRVAL_P(ctx->value);
-    HashTable seen;
-    zend_hash_init(&seen, zend_hash_num_elements(arr), NULL, NULL, 0);
+    sf_hash_set_t seen;
+    sf_hash_set_init(&seen, zend_hash_num_elements(arr));
 
     zval *item;
     bool has_duplicate = 0;
 
     ZEND_HASH_FOREACH_VAL(arr, item) {
-        /* Convert value to string for comparison */
-        zend_string *key_str = NULL;
-
-        switch (Z_TYPE_P(item)) {
-            case IS_STRING:
-                key_str = Z_STR_P(item);
-                break;
-
-            case IS_LONG: {
-                char buf[32];
-                int len = snprintf(buf, sizeof(buf), ZEND_LONG_FMT, Z_LVAL_P(item));
-                key_str = zend_string_init(buf, len, 0);
-                break;
-            }
+        if (sf_hash_set_add(&seen, item) == SF_HASH_PRESENT) {
+            has_duplicate = 1;
+            break;
+        }
+    } ZEND_HASH_FOREACH_END();
 
-            case IS_DOUBLE: {
-                char buf[64];
-                int len = snprintf(buf, sizeof(buf), "%g", Z_DVAL_P(item));
-                key_str = zend_string_init(buf, len, 0);
-                break;
-            }
+    sf_hash_set_destroy(&seen);
 
-            case IS_TRUE:
-                key_str = zend_string_init("1", 1, 0);
-                break;
+    if (has_duplicate) {
+        sf_add_error(ctx, "validation.distinct");
+        return RULE_FAIL;
+    }
 
-            case IS_FALSE:
-                key_str = zend_string_init("0", 1, 0);
-                break;
+    return RULE_PASS;
+}
+
+/* Whether an array key is in a key index */
+static zend_always_inline bool key_declared(const HashTable *keys, zend_string *key, zend_ulong index)
+{
+    return key ? zend_hash_exists(keys, key) : zend_hash_index_exists(keys, index);
+}
 
-            case IS_NULL:
-                key_str = zend_string_init("", 0, 0);
-                break;
+/* Report undeclared keys under their own paths */
+bool sf_report_undeclared_keys(sf_validation_context_t *ctx, HashTable *arr, const HashTable *keys)
+{
+    sf_validation_context_t sub = *ctx;
+    zend_string *key;
+    zend_ulong index;
+    bool found = 0;
 
-            default:
-                continue;  /* Skip complex types */
+    ZEND_HASH_FOREACH_KEY(arr, index, key) {
+        if (key_declared(keys, key, index)) {
+            continue;
         }
 
-        if (key_str) {
-            if (zend_hash_exists(&seen, key_str)) {
-                has_duplicate = 1;
-                if (Z_TYPE_P(item) != IS_STRING) {
-                    zend_string_release(key_str);
-                }
-                break;
-            }
+        zend_string *name = key ? zend_string_copy(key) : zend_long_to_str((zend_long)index);
+        if (ctx->field_len > 0) {
+            zend_string *path = zend_string_concat3(ctx->field_name, ctx->field_len, ".", 1,
+                ZSTR_VAL(name), ZSTR_LEN(name));
+            zend_string_release(name);
+            name = path;
+        }
 
-            zval dummy;
-            ZVAL_TRUE(&dummy);
-            zend_hash_add(&seen, key_str, &dummy);
+        sub.field_name = ZSTR_VAL(name);
+        sub.field_len = ZSTR_LEN(name);
+        sf_add_error(&sub, "validation.strict");
+        zend_string_release(name);
+        found = 1;
+    } ZEND_HASH_FOREACH_END();
 
-            if (Z_TYPE_P(item) != IS_STRING) {
-                zend_string_release(key_str);
-            }
+    return found;
+}
+
+/* keys - Value must be an array whose keys are all in the list */
+sf_rule_result_t sf_rule_keys(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    if (ctx->has_nullable && ctx->is_null_or_empty) {
+        return RULE_PASS;
+    }
+
+    if (!ctx->value || Z_TYPE_P(ctx->value) != IS_ARRAY) {
+        sf_add_error(ctx, "validation.keys");
+        return RULE_FAIL;
+    }
+
+    zend_string *key;
+    zend_ulong index;
+    ZEND_HASH_FOREACH_KEY(Z_ARRVAL_P(ctx->value), index, key) {
+        if (!key_declared(rule->params.key_index.keys, key, index)) {
+            sf_add_error(ctx, "validation.keys");
+            return RULE_FAIL;
         }
     } ZEND_HASH_FOREACH_END();
 
-    zend_hash_destroy(&seen);
+    return RULE_PASS;
+}
 
-    if (has_duplicate) {
-        sf_add_error(ctx, "validation.distinct");
+/*
+ * strict - An array value may only have the keys of the fields declared
+ * below this one; the others are reported under their own paths. Other
+ * values are left to the type rules.
+ */
+sf_rule_result_t sf_rule_strict(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    if (!ctx->value || Z_TYPE_P(ctx->value) != IS_ARRAY || !rule->params.key_index.keys) {
+        return RULE_PASS;
+    }
+
+    return sf_report_undeclared_keys(ctx, Z_ARRVAL_P(ctx->value), rule->params.key_index.keys)
+        ? RULE_FAIL : RULE_PASS;
+}
+
+/*
+ * schema - Value must be an array; its fields are validated against a
+ * named schema once the current program has run (see validator.c)
+ */
+sf_rule_result_t sf_rule_schema(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    if (ctx->has_nullable && ctx->is_null_or_empty) {
+        return RULE_PASS;
+    }
+
+    if (!ctx->value || Z_TYPE_P(ctx->value) != IS_ARRAY) {
+        sf_add_error(ctx, "validation.schema");
+        return RULE_FAIL;
+    }
+
+    if (!sf_push_schema(ctx->schemas, rule->params.schema.id, ctx->value, ctx->field_name, ctx->field_len)) {
+        sf_add_error(ctx, "validation.schema_limit");
         return RULE_FAIL;
     }
 
     return RULE_PASS;
 }
+
+/*
+ * Collection rules.
+ *
+ * These run once per element of a wildcard field, like any rule, but
+ * accumulate into the field's sf_aggregate_t as they go, so constraints
+ * across elements are checked during the same walk that validates them.
+ * Elements are seen in input order. Absent and null values are not part
+ * of the collection, nor are null/empty values of a nullable field.
+ */
+
+/* Accumulator of a collection rule for the current walk */
+static sf_aggregate_t *aggregate_of(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    ZEND_ASSERT(ctx->aggregates);
+    return &ctx->aggregates[rule->params.aggregate.slot];
+}
+
+/* Whether the current value stays out of the collection */
+static bool aggregate_skips(sf_validation_context_t *ctx)
+{
+    return !ctx->value || Z_TYPE_P(ctx->value) == IS_NULL
+        || (ctx->has_nullable && ctx->is_null_or_empty);
+}
+
+/* unique - No two elements of the field are equal */
+sf_rule_result_t sf_rule_unique(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    if (aggregate_skips(ctx)) {
+        return RULE_PASS;
+    }
+
+    sf_aggregate_t *acc = aggregate_of(ctx, rule);
+    if (!acc->seen) {
+        acc->seen = emalloc(sizeof(sf_hash_set_t));
+        sf_hash_set_init(acc->seen, 0);
+    }
+    acc->count++;
+
+    if (sf_hash_set_add(acc->seen, ctx->value) == SF_HASH_PRESENT) {
+        sf_add_error(ctx, "validation.unique");
+        return RULE_FAIL;
+    }
+
+    return RULE_PASS;
+}
+
+/* sorted - Each element compares >= (or <= for 'desc') to the one before */
+sf_rule_result_t sf_rule_sorted(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    if (aggregate_skips(ctx)) {
+        return RULE_PASS;
+    }
+
+    sf_aggregate_t *acc = aggregate_of(ctx, rule);
+    zval *last = acc->last;
+
+    /* Values belong to the input data, which outlives the walk */
+    acc->last = ctx->value;
+    acc->count++;
+
+    if (last) {
+        int cmp = zend_compare(last, ctx->value);
+        if (rule->params.aggregate.descending ? cmp < 0 : cmp > 0) {
+            sf_add_error(ctx, "validation.sorted");
+            return RULE_FAIL;
+        }
+    }
+
+    return RULE_PASS;
+}
+
+/* sum_min, sum_max - Elements are numeric; the total is checked by sf_aggregate_finish() */
+sf_rule_result_t sf_rule_sum(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    if (aggregate_skips(ctx)) {
+        return RULE_PASS;
+    }
+
+    const char *key = rule->type == RULE_SUM_MIN ? "validation.sum_min" : "validation.sum_max";
+    zval number;
+
+    switch (Z_TYPE_P(ctx->value)) {
+        case IS_LONG:
+        case IS_DOUBLE:
+            ZVAL_COPY_VALUE(&number, ctx->value);
+            break;
+
+        case IS_STRING: {
+            zend_long lval;
+            double dval;
+            zend_uchar type = sf_analysis_numeric(&ctx->analysis, Z_STR_P(ctx->value), &lval, &dval);
+            if (type == IS_LONG) {
+                ZVAL_LONG(&number, lval);
+            } else if (type == IS_DOUBLE) {
+                ZVAL_DOUBLE(&number, dval);
+            } else {
+                sf_add_error(ctx, key);
+                return RULE_FAIL;
+            }
+            break;
+        }
+
+        default:
+            sf_add_error(ctx, key);
+            return RULE_FAIL;
+    }
+
+    sf_aggregate_t *acc = aggregate_of(ctx, rule);
+    if (acc->count++ == 0) {
+        ZVAL_LONG(&acc->sum, 0);
+    }
+
+    /* Integer totals switch to float on overflow */
+    add_function(&acc->sum, &acc->sum, &number);
+
+    return RULE_PASS;
+}
+
+/* count_where - At most max elements are equal (==) to the value */
+sf_rule_result_t sf_rule_count_where(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    if (aggregate_skips(ctx)) {
+        return RULE_PASS;
+    }
+
+    if (zend_compare(ctx->value, &rule->params.aggregate.operand) != 0) {
+        return RULE_PASS;
+    }
+
+    sf_aggregate_t *acc = aggregate_of(ctx, rule);
+    if ((zend_long)++acc->count > rule->params.aggregate.max) {
+        HashTable params;
+        zend_hash_init(&params, 1, NULL, ZVAL_PTR_DTOR, 0);
+
+        zval limit;
+        ZVAL_LONG(&limit, rule->params.aggregate.max);
+        zend_hash_str_add(&params, "max", 3, &limit);
+
+        sf_add_error_with_params(ctx, "validation.count_where", &params);
+        zend_hash_destroy(&params);
+        return RULE_FAIL;
+    }
+
+    return RULE_PASS;
+}
+
+/* Check a sum_min/sum_max total; nothing to check if no element was summed */
+sf_rule_result_t sf_aggregate_finish(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    sf_aggregate_t *acc = aggregate_of(ctx, rule);
+    if (acc->count == 0) {
+        return RULE_PASS;
+    }
+
+    int cmp = zend_compare(&acc->sum, &rule->params.aggregate.operand);
+    bool is_min = rule->type == RULE_SUM_MIN;
+    if (is_min ? cmp >= 0 : cmp <= 0) {
+        return RULE_PASS;
+    }
+
+    HashTable params;
+    zend_hash_init(&params, 2, NULL, ZVAL_PTR_DTOR, 0);
+    zend_hash_str_add(&params, "sum", 3, &acc->sum);
+    zend_hash_str_add(&params, is_min ? "min" : "max", 3, &rule->params.aggregate.operand);
+
+    sf_add_error_with_params(ctx, is_min ? "validation.sum_min" : "validation.sum_max", &params);
+    zend_hash_destroy(&params);
+    return RULE_FAIL;
+}
+
+/* Release an accumulator and reset it */
+void sf_aggregate_release(sf_aggregate_t *acc)
+{
+    if (acc->seen) {
+        sf_hash_set_destroy(acc->seen);
+        efree(acc->seen);
+    }
+    memset(acc, 0, sizeof(*acc));
+}
@@ -5,6 +5,7 @@
 #include "rules.h"
 #include "src/condition.h"
 #include "src/wildcard.h"
+#include "src/path.h"
 
 /* Compare two zvals for equality */
 static bool values_equal(zval *a, zval *b)
@@ -20,6 +21,13 @@ static bool values_equal(zval *a, zval *b)
     return 0;
 }
 
+/* Whether a value is in an in / not_in list */
+static bool in_list(sf_parsed_rule_t *rule, zval *value)
+{
+    return sf_value_set_contains(rule->params.in_list.set, rule->params.in_list.values,
+        rule->params.in_list.mode, value);
+}
+
 /* in - Value must be in a list */
 sf_rule_result_t sf_rule_in(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
 {
@@ -27,23 +35,7 @@ sf_rule_result_t sf_rule_in(sf_validation_context_t *ctx, sf_parsed_rule_t *rule
         return RULE_PASS;
     }
 
-    if (!ctx->value) {
-        sf_add_error(ctx, "validation.in");
-        return RULE_FAIL;
-    }
-
-    HashTable *values = rule->params.in_list.values;
-    zval *item;
-    bool found = 0;
-
-    ZEND_HASH_FOREACH_VAL(values, item) {
-        if (values_equal(ctx->value, item)) {
-            found = 1;
-            break;
-        }
-    } ZEND_HASH_FOREACH_END();
-
-    if (!found) {
+    if (!ctx->value || !in_list(rule, ctx->value)) {
         sf_add_error(ctx, "validation.in");
         return RULE_FAIL;
     }
@@ -62,15 +54,31 @@ sf_rule_result_t sf_rule_not_in(sf_validation_context_t *ctx, sf_parsed_rule_t *
         return RULE_PASS;  /* null is not in any list */
     }
 
-    HashTable *values = rule->params.in_list.values;
-    zval *item;
+    if (in_list(rule, ctx->value)) {
+        sf_add_error(ctx, "validation.not_in");
+        return RULE_FAIL;
+    }
 
-    ZEND_HASH_FOREACH_VAL(values, item) {
-        if (values_equal(ctx->value, item)) {
-            sf_add_error(ctx, "validation.not_in");
-            return RULE_FAIL;
-        }
-    } ZEND_HASH_FOREACH_END();
+    return RULE_PASS;
+}
+
+/* enum - Value must name a case of a backed enum */
+sf_rule_result_t sf_rule_enum(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    if (ctx->has_nullable && ctx->is_null_or_empty) {
+        return RULE_PASS;
+    }
+
+    zend_object *found = ctx->value ? sf_enum_table_find(rule->params.enum_cases.table, ctx->value) : NULL;
+    if (!found) {
+        sf_add_error(ctx, "validation.enum");
+        return RULE_FAIL;
+    }
+
+    if (rule->params.enum_cases.cast) {
+        zval_ptr_dtor(&ctx->output);
+        ZVAL_OBJ_COPY(&ctx->output, found);
+    }
 
     return RULE_PASS;
 }
@@ -82,11 +90,7 @@ sf_rule_result_t sf_rule_same(sf_validation_context_t *ctx, sf_parsed_rule_t *ru
         return RULE_PASS;
     }
 
-    zval *other_value = sf_get_nested_value(
-        rule->params.field_ref.field,
-        rule->params.field_ref.len,
-        ctx->data
-    );
+    zval *other_value = sf_path_resolve_at(&rule->params.field_ref.path, ctx->data, ctx->frames);
 
     if (!values_equal(ctx->value, other_value)) {
         HashTable params;
@@ -111,11 +115,7 @@ sf_rule_result_t sf_rule_different(sf_validation_context_t *ctx, sf_parsed_rule_
         return RULE_PASS;
     }
 
-    zval *other_value = sf_get_nested_value(
-        rule->params.field_ref.field,
-        rule->params.field_ref.len,
-        ctx->data
-    );
+    zval *other_value = sf_path_resolve_at(&rule->params.field_ref.path, ctx->data, ctx->frames);
 
     if (values_equal(ctx->value, other_value)) {
         HashTable params;
@@ -146,6 +146,17 @@ sf_rule_result_t sf_rule_confirmed(sf_validation_context_t *ctx, sf_parsed_rule_
         return RULE_PASS;
     }
 
+    /* Fixed field names get the confirmation path compiled (program.c) */
+    if (rule->params.field_ref.field) {
+        zval *confirmation_value = sf_path_resolve_at(&rule->params.field_ref.path, ctx->data, ctx->frames);
+
+        if (!values_equal(ctx->value, confirmation_value)) {
+            sf_add_error(ctx, "validation.confirmed");
+            return RULE_FAIL;
+        }
+        return RULE_PASS;
+    }
+
     /*
      * Security: Check for integer overflow before allocation.
      *
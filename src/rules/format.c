@@ -4,7 +4,7 @@
 
 #include "rules.h"
 #include "src/condition.h"
-#include "src/wildcard.h"
+#include "src/path.h"
 #include <arpa/inet.h>
 #include <time.h>
 
@@ -79,6 +79,12 @@ sf_rule_result_t sf_rule_email(sf_validation_context_t *ctx, sf_parsed_rule_t *r
         return RULE_FAIL;
     }
 
+    return sf_rule_email_string(ctx, rule);
+}
+
+/* email, specialized for a value already known to be a string */
+sf_rule_result_t sf_rule_email_string(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
     if (!validate_email_fast(Z_STRVAL_P(ctx->value), Z_STRLEN_P(ctx->value))) {
         sf_add_error(ctx, "validation.email");
         return RULE_FAIL;
@@ -87,6 +93,30 @@ sf_rule_result_t sf_rule_email(sf_validation_context_t *ctx, sf_parsed_rule_t *r
     return RULE_PASS;
 }
 
+/*
+ * Superinstruction: required followed by email.
+ *
+ * A non-empty string satisfies 'required' and the type check of 'email'
+ * in one test; anything else runs both rules as written.
+ */
+sf_rule_result_t sf_rule_required_email(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    if (EXPECTED(ctx->value && Z_TYPE_P(ctx->value) == IS_STRING && Z_STRLEN_P(ctx->value) > 0)) {
+        return sf_rule_email_string(ctx, rule);
+    }
+
+    sf_rule_result_t result = sf_rule_required(ctx, rule);
+    if (result == RULE_FAIL && ctx->bail) {
+        return RULE_FAIL;
+    }
+
+    if (sf_rule_email(ctx, rule) == RULE_FAIL) {
+        return RULE_FAIL;
+    }
+
+    return result;
+}
+
 /*
  * URL validation with security checks.
  *
@@ -618,11 +648,7 @@ sf_rule_result_t sf_rule_after(sf_validation_context_t *ctx, sf_parsed_rule_t *r
     }
 
     /* Get comparison date from field */
-    zval *compare_value = sf_get_nested_value(
-        rule->params.field_ref.field,
-        rule->params.field_ref.len,
-        ctx->data
-    );
+    zval *compare_value = sf_path_resolve_at(&rule->params.field_ref.path, ctx->data, ctx->frames);
 
     time_t compare_date;
     if (!parse_date(compare_value, &compare_date)) {
@@ -651,11 +677,7 @@ sf_rule_result_t sf_rule_before(sf_validation_context_t *ctx, sf_parsed_rule_t *
         return RULE_FAIL;
     }
 
-    zval *compare_value = sf_get_nested_value(
-        rule->params.field_ref.field,
-        rule->params.field_ref.len,
-        ctx->data
-    );
+    zval *compare_value = sf_path_resolve_at(&rule->params.field_ref.path, ctx->data, ctx->frames);
 
     time_t compare_date;
     if (!parse_date(compare_value, &compare_date)) {
@@ -684,11 +706,7 @@ sf_rule_result_t sf_rule_after_or_equal(sf_validation_context_t *ctx, sf_parsed_
         return RULE_FAIL;
     }
 
-    zval *compare_value = sf_get_nested_value(
-        rule->params.field_ref.field,
-        rule->params.field_ref.len,
-        ctx->data
-    );
+    zval *compare_value = sf_path_resolve_at(&rule->params.field_ref.path, ctx->data, ctx->frames);
 
     time_t compare_date;
     if (!parse_date(compare_value, &compare_date)) {
@@ -717,11 +735,7 @@ sf_rule_result_t sf_rule_before_or_equal(sf_validation_context_t *ctx, sf_parsed
         return RULE_FAIL;
     }
 
-    zval *compare_value = sf_get_nested_value(
-        rule->params.field_ref.field,
-        rule->params.field_ref.len,
-        ctx->data
-    );
+    zval *compare_value = sf_path_resolve_at(&rule->params.field_ref.path, ctx->data, ctx->frames);
 
     time_t compare_date;
     if (!parse_date(compare_value, &compare_date)) {
@@ -5,9 +5,11 @@
 #include "rules.h"
 #include "src/condition.h"
 
-/* Get numeric value from zval */
-static bool get_numeric_value(zval *value, double *result)
+/* Get numeric value of the context's value */
+static bool get_numeric_value(sf_validation_context_t *ctx, double *result)
 {
+    zval *value = ctx->value;
+
     if (!value) return 0;
 
     switch (Z_TYPE_P(value)) {
@@ -22,7 +24,7 @@ static bool get_numeric_value(zval *value, double *result)
         case IS_STRING: {
             zend_long lval;
             double dval;
-            int type = is_numeric_string(Z_STRVAL_P(value), Z_STRLEN_P(value), &lval, &dval, 0);
+            zend_uchar type = sf_analysis_numeric(&ctx->analysis, Z_STR_P(value), &lval, &dval);
             if (type == IS_LONG) {
                 *result = (double)lval;
                 return 1;
@@ -46,7 +48,7 @@ sf_rule_result_t sf_rule_gt(sf_validation_context_t *ctx, sf_parsed_rule_t *rule
     }
 
     double val;
-    if (!get_numeric_value(ctx->value, &val)) {
+    if (!get_numeric_value(ctx, &val)) {
         sf_add_error(ctx, "validation.gt");
         return RULE_FAIL;
     }
@@ -75,7 +77,7 @@ sf_rule_result_t sf_rule_gte(sf_validation_context_t *ctx, sf_parsed_rule_t *rul
     }
 
     double val;
-    if (!get_numeric_value(ctx->value, &val)) {
+    if (!get_numeric_value(ctx, &val)) {
         sf_add_error(ctx, "validation.gte");
         return RULE_FAIL;
     }
@@ -104,7 +106,7 @@ sf_rule_result_t sf_rule_lt(sf_validation_context_t *ctx, sf_parsed_rule_t *rule
     }
 
     double val;
-    if (!get_numeric_value(ctx->value, &val)) {
+    if (!get_numeric_value(ctx, &val)) {
         sf_add_error(ctx, "validation.lt");
         return RULE_FAIL;
     }
@@ -133,7 +135,7 @@ sf_rule_result_t sf_rule_lte(sf_validation_context_t *ctx, sf_parsed_rule_t *rul
     }
 
     double val;
-    if (!get_numeric_value(ctx->value, &val)) {
+    if (!get_numeric_value(ctx, &val)) {
         sf_add_error(ctx, "validation.lte");
         return RULE_FAIL;
     }
@@ -153,3 +155,49 @@ sf_rule_result_t sf_rule_lte(sf_validation_context_t *ctx, sf_parsed_rule_t *rul
 
     return RULE_PASS;
 }
+
+/*
+ * Superinstruction: integer followed by gt/gte/lt/lte.
+ *
+ * A PHP int satisfies 'integer' outright and is compared without going
+ * through get_numeric_value(). Anything else (integer strings, invalid
+ * values) runs both rules as written, keeping the error output unchanged.
+ */
+sf_rule_result_t sf_rule_integer_compare(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    if (ctx->has_nullable && ctx->is_null_or_empty) {
+        return RULE_PASS;
+    }
+
+    sf_parsed_rule_t compare;
+    compare.type = rule->params.fused.compare;
+    compare.params.size.value = rule->params.fused.min;
+
+    if (EXPECTED(ctx->value && Z_TYPE_P(ctx->value) == IS_LONG)) {
+        double val = (double)Z_LVAL_P(ctx->value);
+        double limit = (double)compare.params.size.value;
+        bool ok;
+
+        switch (compare.type) {
+            case RULE_GT:  ok = val > limit; break;
+            case RULE_GTE: ok = val >= limit; break;
+            case RULE_LT:  ok = val < limit; break;
+            default:       ok = val <= limit; break;
+        }
+
+        if (ok) {
+            return RULE_PASS;
+        }
+    }
+
+    sf_rule_result_t result = sf_rule_integer(ctx, rule);
+    if (result == RULE_FAIL && ctx->bail) {
+        return RULE_FAIL;
+    }
+
+    if (sf_rule_handlers[compare.type](ctx, &compare) == RULE_FAIL) {
+        return RULE_FAIL;
+    }
+
+    return result;
+}
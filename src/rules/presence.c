@@ -126,3 +126,169 @@ sf_rule_result_t sf_rule_present(sf_validation_context_t *ctx, sf_parsed_rule_t
     }
     return RULE_PASS;
 }
+
+/*
+ * Presence rules reading other fields. Root-anchored fields were resolved
+ * once for the whole run into ctx->presence (see reserve_facts() in
+ * validator.c); fields bound to the current wildcard element are resolved
+ * here.
+ */
+
+/* Whether a referenced field is filled */
+static bool ref_filled(sf_validation_context_t *ctx, const sf_presence_ref_t *ref)
+{
+    if (ref->fact != SF_NO_FACT) {
+        return SF_FACT_IS_SET(ctx->presence, ref->fact);
+    }
+    return sf_is_filled(sf_path_resolve_at(&ref->path, ctx->data, ctx->frames));
+}
+
+/* Whether a referenced field holds one of the rule's values (absent never does) */
+static bool ref_matches(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    const sf_presence_ref_t *ref = &rule->params.presence.refs[0];
+
+    if (ref->fact != SF_NO_FACT) {
+        return SF_FACT_IS_SET(ctx->presence, ref->fact);
+    }
+
+    zval *other = sf_path_resolve_at(&ref->path, ctx->data, ctx->frames);
+    return other && sf_value_set_contains(rule->params.presence.set, rule->params.presence.values,
+        SF_SET_LOOSE, other);
+}
+
+/* How many of the rule's fields are filled */
+static uint32_t count_filled(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    uint32_t filled = 0;
+    for (uint32_t k = 0; k < rule->params.presence.ref_count; k++) {
+        filled += ref_filled(ctx, &rule->params.presence.refs[k]);
+    }
+    return filled;
+}
+
+/*
+ * Required when the condition holds; otherwise an empty value skips the
+ * rest of the chain, as nullable would.
+ */
+static sf_rule_result_t require_when(sf_validation_context_t *ctx, sf_parsed_rule_t *rule, bool required)
+{
+    if (!ctx->is_null_or_empty) {
+        return RULE_PASS;
+    }
+    if (!required) {
+        return RULE_SKIP;
+    }
+
+    HashTable params;
+    zend_hash_init(&params, 2, NULL, ZVAL_PTR_DTOR, 0);
+
+    zval names;
+    if (SF_RULE_IS_PRESENCE_MATCH(rule->type)) {
+        ZVAL_STRINGL(&names, rule->params.presence.refs[0].field, rule->params.presence.refs[0].len);
+        zend_hash_str_add(&params, "other", 5, &names);
+    } else {
+        /* "a, b, c" */
+        const sf_presence_ref_t *refs = rule->params.presence.refs;
+        size_t len = 0;
+        for (uint32_t k = 0; k < rule->params.presence.ref_count; k++) {
+            len += refs[k].len + (k > 0 ? 2 : 0);
+        }
+
+        zend_string *joined = zend_string_alloc(len, 0);
+        char *p = ZSTR_VAL(joined);
+        for (uint32_t k = 0; k < rule->params.presence.ref_count; k++) {
+            if (k > 0) {
+                memcpy(p, ", ", 2);
+                p += 2;
+            }
+            memcpy(p, refs[k].field, refs[k].len);
+            p += refs[k].len;
+        }
+        *p = '\0';
+        ZVAL_STR(&names, joined);
+        zend_hash_str_add(&params, "values", 6, &names);
+    }
+
+    const char *key;
+    switch (rule->type) {
+        case RULE_REQUIRED_IF:          key = "validation.required_if"; break;
+        case RULE_REQUIRED_UNLESS:      key = "validation.required_unless"; break;
+        case RULE_REQUIRED_WITH:        key = "validation.required_with"; break;
+        case RULE_REQUIRED_WITH_ALL:    key = "validation.required_with_all"; break;
+        case RULE_REQUIRED_WITHOUT:     key = "validation.required_without"; break;
+        default:                        key = "validation.required_without_all"; break;
+    }
+
+    sf_add_error_with_params(ctx, key, &params);
+    zend_hash_destroy(&params);
+    return RULE_FAIL;
+}
+
+/* required_if - Required if another field holds one of the values */
+sf_rule_result_t sf_rule_required_if(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    return require_when(ctx, rule, ref_matches(ctx, rule));
+}
+
+/* required_unless - Required unless another field holds one of the values */
+sf_rule_result_t sf_rule_required_unless(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    return require_when(ctx, rule, !ref_matches(ctx, rule));
+}
+
+/* required_with - Required if any of the other fields is filled */
+sf_rule_result_t sf_rule_required_with(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    return require_when(ctx, rule, count_filled(ctx, rule) > 0);
+}
+
+/* required_with_all - Required if all of the other fields are filled */
+sf_rule_result_t sf_rule_required_with_all(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    return require_when(ctx, rule, count_filled(ctx, rule) == rule->params.presence.ref_count);
+}
+
+/* required_without - Required if any of the other fields is empty */
+sf_rule_result_t sf_rule_required_without(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    return require_when(ctx, rule, count_filled(ctx, rule) < rule->params.presence.ref_count);
+}
+
+/* required_without_all - Required if all of the other fields are empty */
+sf_rule_result_t sf_rule_required_without_all(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    return require_when(ctx, rule, count_filled(ctx, rule) == 0);
+}
+
+/* prohibited_if - Must be empty if another field holds one of the values */
+sf_rule_result_t sf_rule_prohibited_if(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    if (!ref_matches(ctx, rule)) {
+        return RULE_PASS;
+    }
+    if (ctx->is_null_or_empty) {
+        return RULE_SKIP;
+    }
+
+    HashTable params;
+    zend_hash_init(&params, 2, NULL, ZVAL_PTR_DTOR, 0);
+
+    zval other;
+    ZVAL_STRINGL(&other, rule->params.presence.refs[0].field, rule->params.presence.refs[0].len);
+    zend_hash_str_add(&params, "other", 5, &other);
+
+    sf_add_error_with_params(ctx, "validation.prohibited_if", &params);
+    zend_hash_destroy(&params);
+    return RULE_FAIL;
+}
+
+/* exclude_if - Drop the field, unvalidated, if another field holds one of the values */
+sf_rule_result_t sf_rule_exclude_if(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    if (ref_matches(ctx, rule)) {
+        ctx->excluded = 1;
+        return RULE_SKIP;
+    }
+    return RULE_PASS;
+}
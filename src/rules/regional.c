@@ -270,160 +270,107 @@ sf_rule_result_t sf_rule_vat_eu(sf_validation_context_t *ctx, sf_parsed_rule_t *
     return RULE_PASS;
 }
 
-/*
- * Shared conditional (RULE_WHEN) handler. Evaluates the condition and
- * recursively applies the then/else rule list. Used by both the top-level
- * validator loop AND by sf_execute_rule when a when-rule appears inside a
- * nested then/else branch — without this second path, nested conditionals
- * silently PASS without executing (bug #8).
- *
- * Depth-bounded to protect against adversarial rule trees.
- *
- * Returns:
- *   RULE_PASS if no inner rule failed (or the branch was empty)
- *   RULE_FAIL if any inner rule failed
- *   RULE_SKIP if an inner rule returned SKIP (propagate to outer loop)
- */
-sf_rule_result_t sf_execute_conditional(
-    sf_validation_context_t *ctx,
-    sf_parsed_rule_t *rule,
-    unsigned int depth)
-{
-    if (depth > SF_MAX_CONDITION_EVAL_DEPTH) {
-        /* Fail safe — don't stack-overflow on pathological rule sets. */
-        sf_add_error(ctx, "validation.when.depth_exceeded");
-        return RULE_FAIL;
-    }
-
-    bool condition_met = sf_evaluate_condition(
-        rule->params.conditional.condition,
-        ctx->value,
-        ctx->data,
-        ctx->field_name,
-        ctx->validator
-    );
-
-    sf_parsed_rule_t **rules_to_apply;
-    size_t rules_count;
-
-    if (condition_met) {
-        rules_to_apply = rule->params.conditional.then_rules;
-        rules_count = rule->params.conditional.then_count;
-    } else {
-        rules_to_apply = rule->params.conditional.else_rules;
-        rules_count = rule->params.conditional.else_count;
-    }
-
-    if (!rules_to_apply) {
-        return RULE_PASS;
-    }
-
-    sf_rule_result_t branch_result = RULE_PASS;
-    for (size_t j = 0; j < rules_count; j++) {
-        sf_parsed_rule_t *inner = rules_to_apply[j];
-
-        /* Key fix: if the inner rule is itself a RULE_WHEN, we must recurse
-         * into sf_execute_conditional directly. Before this, the inner when
-         * hit the `case RULE_WHEN: return RULE_PASS` fallthrough and no inner
-         * rules ever ran. */
-        sf_rule_result_t r;
-        if (inner->type == RULE_WHEN) {
-            r = sf_execute_conditional(ctx, inner, depth + 1);
-        } else {
-            r = sf_execute_rule(ctx, inner);
-        }
-
-        if (r == RULE_FAIL) {
-            branch_result = RULE_FAIL;
-            if (ctx->bail) {
-                break;
-            }
-        } else if (r == RULE_SKIP) {
-            /* SKIP means "stop processing further rules in this chain" — we
-             * propagate so the outer loop can stop too. */
-            return RULE_SKIP;
-        }
-    }
-
-    return branch_result;
-}
-
-/* Rule dispatcher - execute a rule by type */
-sf_rule_result_t sf_execute_rule(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
-{
-    switch (rule->type) {
-        /* Presence */
-        case RULE_REQUIRED:     return sf_rule_required(ctx, rule);
-        case RULE_NULLABLE:     return sf_rule_nullable(ctx, rule);
-        case RULE_FILLED:       return sf_rule_filled(ctx, rule);
-        case RULE_PRESENT:      return sf_rule_present(ctx, rule);
-
-        /* Types */
-        case RULE_STRING:       return sf_rule_string(ctx, rule);
-        case RULE_INTEGER:      return sf_rule_integer(ctx, rule);
-        case RULE_NUMERIC:      return sf_rule_numeric(ctx, rule);
-        case RULE_BOOLEAN:      return sf_rule_boolean(ctx, rule);
-        case RULE_ARRAY:        return sf_rule_array(ctx, rule);
-
-        /* String */
-        case RULE_MIN:          return sf_rule_min(ctx, rule);
-        case RULE_MAX:          return sf_rule_max(ctx, rule);
-        case RULE_BETWEEN:      return sf_rule_between(ctx, rule);
-        case RULE_REGEX:        return sf_rule_regex(ctx, rule);
-        case RULE_NOT_REGEX:    return sf_rule_not_regex(ctx, rule);
-        case RULE_ALPHA:        return sf_rule_alpha(ctx, rule);
-        case RULE_ALPHA_NUM:    return sf_rule_alpha_num(ctx, rule);
-        case RULE_ALPHA_DASH:   return sf_rule_alpha_dash(ctx, rule);
-        case RULE_LOWERCASE:    return sf_rule_lowercase(ctx, rule);
-        case RULE_UPPERCASE:    return sf_rule_uppercase(ctx, rule);
-        case RULE_STARTS_WITH:  return sf_rule_starts_with(ctx, rule);
-        case RULE_ENDS_WITH:    return sf_rule_ends_with(ctx, rule);
-        case RULE_CONTAINS:     return sf_rule_contains(ctx, rule);
-
-        /* Numeric */
-        case RULE_GT:           return sf_rule_gt(ctx, rule);
-        case RULE_GTE:          return sf_rule_gte(ctx, rule);
-        case RULE_LT:           return sf_rule_lt(ctx, rule);
-        case RULE_LTE:          return sf_rule_lte(ctx, rule);
-
-        /* Array */
-        case RULE_DISTINCT:     return sf_rule_distinct(ctx, rule);
-
-        /* Format */
-        case RULE_EMAIL:        return sf_rule_email(ctx, rule);
-        case RULE_URL:          return sf_rule_url(ctx, rule);
-        case RULE_IP:           return sf_rule_ip(ctx, rule);
-        case RULE_UUID:         return sf_rule_uuid(ctx, rule);
-        case RULE_JSON:         return sf_rule_json(ctx, rule);
-        case RULE_DATE:         return sf_rule_date(ctx, rule);
-        case RULE_DATE_FORMAT:  return sf_rule_date_format(ctx, rule);
-        case RULE_AFTER:        return sf_rule_after(ctx, rule);
-        case RULE_BEFORE:       return sf_rule_before(ctx, rule);
-        case RULE_AFTER_OR_EQUAL:   return sf_rule_after_or_equal(ctx, rule);
-        case RULE_BEFORE_OR_EQUAL:  return sf_rule_before_or_equal(ctx, rule);
-
-        /* Comparison */
-        case RULE_IN:           return sf_rule_in(ctx, rule);
-        case RULE_NOT_IN:       return sf_rule_not_in(ctx, rule);
-        case RULE_SAME:         return sf_rule_same(ctx, rule);
-        case RULE_DIFFERENT:    return sf_rule_different(ctx, rule);
-        case RULE_CONFIRMED:    return sf_rule_confirmed(ctx, rule);
-
-        /* Regional */
-        case RULE_OIB:          return sf_rule_oib(ctx, rule);
-        case RULE_PHONE:        return sf_rule_phone(ctx, rule);
-        case RULE_IBAN:         return sf_rule_iban(ctx, rule);
-        case RULE_VAT_EU:       return sf_rule_vat_eu(ctx, rule);
-
-        /* Conditional. Historically this returned RULE_PASS on the assumption
-         * that only the top-level validator loop ever saw RULE_WHEN — but
-         * nested when-in-then rule sets DO land here via recursion, and the
-         * old early-return silently dropped them. Delegate to the shared
-         * helper so nested conditionals actually execute. */
-        case RULE_WHEN:
-            return sf_execute_conditional(ctx, rule, 1);
-
-        default:
-            return RULE_PASS;
-    }
-}
+/* Rule handler table - indexed by sf_rule_type_t / sf_handler_op_t */
+const sf_rule_handler_t sf_rule_handlers[SF_OP_HANDLER_COUNT] = {
+    /* Presence */
+    [RULE_REQUIRED]         = sf_rule_required,
+    [RULE_NULLABLE]         = sf_rule_nullable,
+    [RULE_FILLED]           = sf_rule_filled,
+    [RULE_PRESENT]          = sf_rule_present,
+    [RULE_REQUIRED_IF]      = sf_rule_required_if,
+    [RULE_REQUIRED_UNLESS]  = sf_rule_required_unless,
+    [RULE_PROHIBITED_IF]    = sf_rule_prohibited_if,
+    [RULE_EXCLUDE_IF]       = sf_rule_exclude_if,
+    [RULE_REQUIRED_WITH]    = sf_rule_required_with,
+    [RULE_REQUIRED_WITH_ALL] = sf_rule_required_with_all,
+    [RULE_REQUIRED_WITHOUT] = sf_rule_required_without,
+    [RULE_REQUIRED_WITHOUT_ALL] = sf_rule_required_without_all,
+
+    /* Types */
+    [RULE_STRING]           = sf_rule_string,
+    [RULE_INTEGER]          = sf_rule_integer,
+    [RULE_NUMERIC]          = sf_rule_numeric,
+    [RULE_BOOLEAN]          = sf_rule_boolean,
+    [RULE_ARRAY]            = sf_rule_array,
+
+    /* String */
+    [RULE_MIN]              = sf_rule_min,
+    [RULE_MAX]              = sf_rule_max,
+    [RULE_BETWEEN]          = sf_rule_between,
+    [RULE_REGEX]            = sf_rule_regex,
+    [RULE_NOT_REGEX]        = sf_rule_not_regex,
+    [RULE_ALPHA]            = sf_rule_alpha,
+    [RULE_ALPHA_NUM]        = sf_rule_alpha_num,
+    [RULE_ALPHA_DASH]       = sf_rule_alpha_dash,
+    [RULE_LOWERCASE]        = sf_rule_lowercase,
+    [RULE_UPPERCASE]        = sf_rule_uppercase,
+    [RULE_STARTS_WITH]      = sf_rule_starts_with,
+    [RULE_ENDS_WITH]        = sf_rule_ends_with,
+    [RULE_CONTAINS]         = sf_rule_contains,
+
+    /* Numeric */
+    [RULE_GT]               = sf_rule_gt,
+    [RULE_GTE]              = sf_rule_gte,
+    [RULE_LT]               = sf_rule_lt,
+    [RULE_LTE]              = sf_rule_lte,
+
+    /* Array */
+    [RULE_DISTINCT]         = sf_rule_distinct,
+    [RULE_KEYS]             = sf_rule_keys,
+    [RULE_STRICT]           = sf_rule_strict,
+    [RULE_SCHEMA]           = sf_rule_schema,
+
+    /* Collection */
+    [RULE_UNIQUE]           = sf_rule_unique,
+    [RULE_SORTED]           = sf_rule_sorted,
+    [RULE_SUM_MIN]          = sf_rule_sum,
+    [RULE_SUM_MAX]          = sf_rule_sum,
+    [RULE_COUNT_WHERE]      = sf_rule_count_where,
+
+    /* Format */
+    [RULE_EMAIL]            = sf_rule_email,
+    [RULE_URL]              = sf_rule_url,
+    [RULE_IP]               = sf_rule_ip,
+    [RULE_UUID]             = sf_rule_uuid,
+    [RULE_JSON]             = sf_rule_json,
+    [RULE_DATE]             = sf_rule_date,
+    [RULE_DATE_FORMAT]      = sf_rule_date_format,
+    [RULE_AFTER]            = sf_rule_after,
+    [RULE_BEFORE]           = sf_rule_before,
+    [RULE_AFTER_OR_EQUAL]   = sf_rule_after_or_equal,
+    [RULE_BEFORE_OR_EQUAL]  = sf_rule_before_or_equal,
+
+    /* Comparison */
+    [RULE_IN]               = sf_rule_in,
+    [RULE_NOT_IN]           = sf_rule_not_in,
+    [RULE_ENUM]             = sf_rule_enum,
+    [RULE_SAME]             = sf_rule_same,
+    [RULE_DIFFERENT]        = sf_rule_different,
+    [RULE_CONFIRMED]        = sf_rule_confirmed,
+
+    /* Regional */
+    [RULE_OIB]              = sf_rule_oib,
+    [RULE_PHONE]            = sf_rule_phone,
+    [RULE_IBAN]             = sf_rule_iban,
+    [RULE_VAT_EU]           = sf_rule_vat_eu,
+
+    /* RULE_WHEN is compiled to branches, RULE_VARIANT to a dispatch,
+     * combinators to SF_OP_COMBINE, RULE_BAIL and RULE_SOMETIMES to field
+     * flags */
+
+    /* Superinstructions */
+    [SF_OP_STRING_SIZE]     = sf_rule_string_size,
+    [SF_OP_INTEGER_COMPARE] = sf_rule_integer_compare,
+    [SF_OP_REQUIRED_EMAIL]  = sf_rule_required_email,
+    [SF_OP_SIZE_RANGE]      = sf_rule_size_range,
+
+    /* Type-specialized variants */
+    [SF_OP_MIN_STRING]      = sf_rule_min_string,
+    [SF_OP_MAX_STRING]      = sf_rule_max_string,
+    [SF_OP_BETWEEN_STRING]  = sf_rule_between_string,
+    [SF_OP_REGEX_STRING]    = sf_rule_regex_string,
+    [SF_OP_EMAIL_STRING]    = sf_rule_email_string,
+    [SF_OP_MIN_ARRAY]       = sf_rule_min_array,
+    [SF_OP_MAX_ARRAY]       = sf_rule_max_array,
+    [SF_OP_BETWEEN_ARRAY]   = sf_rule_between_array,
+};
@@ -7,6 +7,23 @@
 
 #include "php_signalforge_validation.h"
 #include "src/parser.h"
+#include "src/util/value_set.h"
+#include "src/util/analysis.h"
+
+/* Schema validations waiting to run during one validate() call (see validator.c) */
+typedef struct sf_schema_stack_s sf_schema_stack_t;
+
+/*
+ * Accumulator of one collection rule over the elements of a wildcard
+ * field. Lives for one walk of the field's group (see run_fields() in
+ * validator.c); all-zero when the walk starts.
+ */
+typedef struct {
+    uint32_t count;              /* Elements accumulated */
+    zval *last;                  /* sorted: previous element's value */
+    zval sum;                    /* sum_min, sum_max: running total */
+    sf_hash_set_t *seen;         /* unique: the values so far */
+} sf_aggregate_t;
 
 /* Validation context passed to rule functions */
 typedef struct {
@@ -15,10 +32,18 @@ typedef struct {
     const char *field_name;      /* Current field being validated */
     size_t field_len;
     zval *value;                 /* Current field value */
+    sf_value_analysis_t analysis; /* Facts about a string value, computed on first use */
     HashTable *errors;           /* Errors hashtable to populate */
     bool has_nullable;      /* Whether nullable rule is present */
     bool is_null_or_empty;  /* Whether value is null or empty */
     bool bail;              /* Stop on first error */
+    uint8_t *memo;          /* Invariant condition results for this validate() call */
+    zval *const *frames;    /* Values along a wildcard element's path, or NULL */
+    sf_schema_stack_t *schemas; /* Where 'schema' rules queue their value */
+    sf_aggregate_t *aggregates; /* Collection rule accumulators, NULL outside wildcard walks */
+    zval output;            /* Replaces the value in validated output if set ('enum' cast) */
+    const uint64_t *presence;   /* Presence facts of this program run (see sf_presence_fact_t) */
+    bool excluded;          /* Set by exclude_if: leave the field out of validated output */
 } sf_validation_context_t;
 
 /* Rule validation result */
@@ -34,11 +59,57 @@ void sf_add_error(sf_validation_context_t *ctx, const char *key, ...);
 /* Add an error with params hashtable */
 void sf_add_error_with_params(sf_validation_context_t *ctx, const char *key, HashTable *params);
 
+/*
+ * Report every key of arr that keys does not hold as its own field below
+ * the context's field ("address.extra", or "extra" for an empty field
+ * name), with a validation.strict error. Returns whether any was.
+ */
+bool sf_report_undeclared_keys(sf_validation_context_t *ctx, HashTable *arr, const HashTable *keys);
+
+/*
+ * Compiled-only opcodes, numbered after RULE_UNKNOWN so one handler table
+ * covers both plain rules and these.
+ *
+ * Superinstructions replace a common rule sequence with one handler.
+ * Specialized variants are emitted only after a type guard (string/array)
+ * in the same chain; the executor falls back to the generic rule whenever
+ * that guard did not pass.
+ */
+typedef enum {
+    /* Superinstructions */
+    SF_OP_STRING_SIZE = RULE_UNKNOWN + 1,   /* string + min/max/between */
+    SF_OP_INTEGER_COMPARE,                  /* integer + gt/gte/lt/lte */
+    SF_OP_REQUIRED_EMAIL,                   /* required + email */
+    SF_OP_SIZE_RANGE,                       /* min + max */
+
+    /* Specialized for a value known to be a string */
+    SF_OP_MIN_STRING,
+    SF_OP_MAX_STRING,
+    SF_OP_BETWEEN_STRING,
+    SF_OP_REGEX_STRING,
+    SF_OP_EMAIL_STRING,
+
+    /* Specialized for a value known to be an array */
+    SF_OP_MIN_ARRAY,
+    SF_OP_MAX_ARRAY,
+    SF_OP_BETWEEN_ARRAY,
+
+    SF_OP_HANDLER_COUNT
+} sf_handler_op_t;
+
 /* Presence rules */
 sf_rule_result_t sf_rule_required(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
 sf_rule_result_t sf_rule_nullable(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
 sf_rule_result_t sf_rule_filled(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
 sf_rule_result_t sf_rule_present(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_required_if(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_required_unless(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_prohibited_if(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_exclude_if(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_required_with(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_required_with_all(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_required_without(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_required_without_all(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
 
 /* Type rules */
 sf_rule_result_t sf_rule_string(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
@@ -70,6 +141,24 @@ sf_rule_result_t sf_rule_lte(sf_validation_context_t *ctx, sf_parsed_rule_t *rul
 
 /* Array rules */
 sf_rule_result_t sf_rule_distinct(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_keys(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_strict(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_schema(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+
+/* Collection rules */
+sf_rule_result_t sf_rule_unique(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_sorted(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_sum(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_count_where(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+
+/*
+ * Check a sum_min/sum_max total once its field's walk is over; the error
+ * goes under ctx->field_name (the field's pattern)
+ */
+sf_rule_result_t sf_aggregate_finish(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+
+/* Release what an accumulator holds and reset it for the next walk */
+void sf_aggregate_release(sf_aggregate_t *acc);
 
 /* Format rules */
 sf_rule_result_t sf_rule_email(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
@@ -87,6 +176,7 @@ sf_rule_result_t sf_rule_before_or_equal(sf_validation_context_t *ctx, sf_parsed
 /* Comparison rules */
 sf_rule_result_t sf_rule_in(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
 sf_rule_result_t sf_rule_not_in(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_enum(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
 sf_rule_result_t sf_rule_same(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
 sf_rule_result_t sf_rule_different(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
 sf_rule_result_t sf_rule_confirmed(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
@@ -97,16 +187,32 @@ sf_rule_result_t sf_rule_phone(sf_validation_context_t *ctx, sf_parsed_rule_t *r
 sf_rule_result_t sf_rule_iban(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
 sf_rule_result_t sf_rule_vat_eu(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
 
-/* Dispatch function - execute a rule by type */
-sf_rule_result_t sf_execute_rule(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
-
-/* Shared handler for RULE_WHEN used by both the validator loop and recursive
- * rule execution. Returns PASS if no inner rule failed, FAIL if any did,
- * SKIP to stop processing further rules. */
-sf_rule_result_t sf_execute_conditional(
-    sf_validation_context_t *ctx,
-    sf_parsed_rule_t *rule,
-    unsigned int depth
-);
+/* Superinstructions */
+sf_rule_result_t sf_rule_string_size(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_integer_compare(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_required_email(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_size_range(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+
+/* Type-specialized variants */
+sf_rule_result_t sf_rule_min_string(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_max_string(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_between_string(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_regex_string(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_email_string(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_min_array(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_max_array(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+sf_rule_result_t sf_rule_between_array(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+
+/* Rule handler signature */
+typedef sf_rule_result_t (*sf_rule_handler_t)(sf_validation_context_t *ctx, sf_parsed_rule_t *rule);
+
+/*
+ * Rule handlers indexed by rule type or sf_handler_op_t. Compiled programs
+ * dispatch through this table directly; RULE_WHEN (lowered to branches),
+ * RULE_VARIANT (lowered to a dispatch), the combinators (run by the
+ * executor) and RULE_BAIL / RULE_SOMETIMES (per-field flags) have no
+ * entry.
+ */
+extern const sf_rule_handler_t sf_rule_handlers[SF_OP_HANDLER_COUNT];
 
 #endif /* SIGNALFORGE_RULES_H */
@@ -5,16 +5,21 @@
 #include "rules.h"
 #include "src/condition.h"
 #include "src/validator.h"
-#include "src/util/utf8.h"
 
-/* Get size based on value type */
-static zend_long get_size(zval *value)
+/*
+ * Get size of the context's value based on its type. A string's length is
+ * only counted as far as comparing it with lo and hi needs (see
+ * sf_analysis_length_within()).
+ */
+static zend_long get_size(sf_validation_context_t *ctx, zend_long lo, zend_long hi)
 {
+    zval *value = ctx->value;
+
     if (!value) return 0;
 
     switch (Z_TYPE_P(value)) {
         case IS_STRING:
-            return (zend_long)sf_utf8_strlen(Z_STRVAL_P(value), Z_STRLEN_P(value));
+            return sf_analysis_length_within(&ctx->analysis, Z_STR_P(value), lo, hi);
 
         case IS_ARRAY:
             return (zend_long)zend_hash_num_elements(Z_ARRVAL_P(value));
@@ -30,6 +35,53 @@ static zend_long get_size(zval *value)
     }
 }
 
+/* Record a min failure with its parameter */
+static sf_rule_result_t fail_min(sf_validation_context_t *ctx, zend_long min)
+{
+    HashTable params;
+    zend_hash_init(&params, 2, NULL, ZVAL_PTR_DTOR, 0);
+
+    zval min_val;
+    ZVAL_LONG(&min_val, min);
+    zend_hash_str_add(&params, "min", 3, &min_val);
+
+    sf_add_error_with_params(ctx, "validation.min", &params);
+    zend_hash_destroy(&params);
+    return RULE_FAIL;
+}
+
+/* Record a max failure with its parameter */
+static sf_rule_result_t fail_max(sf_validation_context_t *ctx, zend_long max)
+{
+    HashTable params;
+    zend_hash_init(&params, 2, NULL, ZVAL_PTR_DTOR, 0);
+
+    zval max_val;
+    ZVAL_LONG(&max_val, max);
+    zend_hash_str_add(&params, "max", 3, &max_val);
+
+    sf_add_error_with_params(ctx, "validation.max", &params);
+    zend_hash_destroy(&params);
+    return RULE_FAIL;
+}
+
+/* Record a between failure with its parameters */
+static sf_rule_result_t fail_between(sf_validation_context_t *ctx, zend_long min, zend_long max)
+{
+    HashTable params;
+    zend_hash_init(&params, 4, NULL, ZVAL_PTR_DTOR, 0);
+
+    zval min_val, max_val;
+    ZVAL_LONG(&min_val, min);
+    ZVAL_LONG(&max_val, max);
+    zend_hash_str_add(&params, "min", 3, &min_val);
+    zend_hash_str_add(&params, "max", 3, &max_val);
+
+    sf_add_error_with_params(ctx, "validation.between", &params);
+    zend_hash_destroy(&params);
+    return RULE_FAIL;
+}
+
 /* min - Minimum size/length/value */
 sf_rule_result_t sf_rule_min(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
 {
@@ -37,18 +89,9 @@ sf_rule_result_t sf_rule_min(sf_validation_context_t *ctx, sf_parsed_rule_t *rul
         return RULE_PASS;
     }
 
-    zend_long size = get_size(ctx->value);
+    zend_long size = get_size(ctx, rule->params.size.value, ZEND_LONG_MAX);
     if (size < rule->params.size.value) {
-        HashTable params;
-        zend_hash_init(&params, 2, NULL, ZVAL_PTR_DTOR, 0);
-
-        zval min_val;
-        ZVAL_LONG(&min_val, rule->params.size.value);
-        zend_hash_str_add(&params, "min", 3, &min_val);
-
-        sf_add_error_with_params(ctx, "validation.min", &params);
-        zend_hash_destroy(&params);
-        return RULE_FAIL;
+        return fail_min(ctx, rule->params.size.value);
     }
 
     return RULE_PASS;
@@ -61,18 +104,9 @@ sf_rule_result_t sf_rule_max(sf_validation_context_t *ctx, sf_parsed_rule_t *rul
         return RULE_PASS;
     }
 
-    zend_long size = get_size(ctx->value);
+    zend_long size = get_size(ctx, ZEND_LONG_MIN, rule->params.size.value);
     if (size > rule->params.size.value) {
-        HashTable params;
-        zend_hash_init(&params, 2, NULL, ZVAL_PTR_DTOR, 0);
-
-        zval max_val;
-        ZVAL_LONG(&max_val, rule->params.size.value);
-        zend_hash_str_add(&params, "max", 3, &max_val);
-
-        sf_add_error_with_params(ctx, "validation.max", &params);
-        zend_hash_destroy(&params);
-        return RULE_FAIL;
+        return fail_max(ctx, rule->params.size.value);
     }
 
     return RULE_PASS;
@@ -85,37 +119,183 @@ sf_rule_result_t sf_rule_between(sf_validation_context_t *ctx, sf_parsed_rule_t
         return RULE_PASS;
     }
 
-    zend_long size = get_size(ctx->value);
+    zend_long size = get_size(ctx, rule->params.range.min, rule->params.range.max);
     if (size < rule->params.range.min || size > rule->params.range.max) {
-        HashTable params;
-        zend_hash_init(&params, 4, NULL, ZVAL_PTR_DTOR, 0);
+        return fail_between(ctx, rule->params.range.min, rule->params.range.max);
+    }
+
+    return RULE_PASS;
+}
+
+/* Lower bound of a fused instruction, for counting a length */
+static zend_always_inline zend_long fused_lo(const sf_parsed_rule_t *rule)
+{
+    return rule->params.fused.flags & (SF_FUSED_BETWEEN | SF_FUSED_HAS_MIN)
+        ? rule->params.fused.min : ZEND_LONG_MIN;
+}
 
-        zval min_val, max_val;
-        ZVAL_LONG(&min_val, rule->params.range.min);
-        ZVAL_LONG(&max_val, rule->params.range.max);
-        zend_hash_str_add(&params, "min", 3, &min_val);
-        zend_hash_str_add(&params, "max", 3, &max_val);
+/* Upper bound of a fused instruction, for counting a length */
+static zend_always_inline zend_long fused_hi(const sf_parsed_rule_t *rule)
+{
+    return rule->params.fused.flags & (SF_FUSED_BETWEEN | SF_FUSED_HAS_MAX)
+        ? rule->params.fused.max : ZEND_LONG_MAX;
+}
 
-        sf_add_error_with_params(ctx, "validation.between", &params);
-        zend_hash_destroy(&params);
-        return RULE_FAIL;
+/*
+ * Check a size against fused bounds, emitting errors in declaration order.
+ * `result` carries any failure already recorded by the fused instruction.
+ */
+static sf_rule_result_t check_fused_bounds(
+    sf_validation_context_t *ctx,
+    zend_long size,
+    sf_parsed_rule_t *rule,
+    sf_rule_result_t result
+)
+{
+    uint32_t flags = rule->params.fused.flags;
+    zend_long min = rule->params.fused.min;
+    zend_long max = rule->params.fused.max;
+
+    if (flags & SF_FUSED_BETWEEN) {
+        if (size < min || size > max) {
+            return fail_between(ctx, min, max);
+        }
+        return result;
     }
 
-    return RULE_PASS;
+    if (flags & SF_FUSED_MAX_FIRST) {
+        if ((flags & SF_FUSED_HAS_MAX) && size > max) {
+            result = fail_max(ctx, max);
+            if (ctx->bail) return result;
+        }
+        if ((flags & SF_FUSED_HAS_MIN) && size < min) {
+            result = fail_min(ctx, min);
+        }
+    } else {
+        if ((flags & SF_FUSED_HAS_MIN) && size < min) {
+            result = fail_min(ctx, min);
+            if (ctx->bail) return result;
+        }
+        if ((flags & SF_FUSED_HAS_MAX) && size > max) {
+            result = fail_max(ctx, max);
+        }
+    }
+
+    return result;
 }
 
-/* regex - Must match regex pattern */
-sf_rule_result_t sf_rule_regex(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+/*
+ * Superinstruction: string followed by min/max (or between).
+ *
+ * Counts the UTF-8 length once, as far as the bounds need, and checks both. Non-strings still
+ * get the size checks they would have had as separate rules, so the error
+ * output is identical to the unfused chain.
+ */
+sf_rule_result_t sf_rule_string_size(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
 {
     if (ctx->has_nullable && ctx->is_null_or_empty) {
         return RULE_PASS;
     }
 
     if (!ctx->value || Z_TYPE_P(ctx->value) != IS_STRING) {
-        sf_add_error(ctx, "validation.regex");
-        return RULE_FAIL;
+        sf_add_error(ctx, "validation.string");
+        if (ctx->bail) {
+            return RULE_FAIL;
+        }
+        return check_fused_bounds(ctx, get_size(ctx, fused_lo(rule), fused_hi(rule)), rule, RULE_FAIL);
+    }
+
+    zend_long size = sf_analysis_length_within(&ctx->analysis, Z_STR_P(ctx->value),
+        fused_lo(rule), fused_hi(rule));
+    return check_fused_bounds(ctx, size, rule, RULE_PASS);
+}
+
+/*
+ * min + max superinstruction (adjacent min/max in either order).
+ *
+ * Computes the size once; errors match the two separate rules.
+ */
+sf_rule_result_t sf_rule_size_range(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    if (ctx->has_nullable && ctx->is_null_or_empty) {
+        return RULE_PASS;
     }
 
+    return check_fused_bounds(ctx, get_size(ctx, fused_lo(rule), fused_hi(rule)), rule, RULE_PASS);
+}
+
+/*
+ * Type-specialized size rules. These are only emitted after a passing
+ * string/array guard, so the value type is known and the nullable check
+ * is handled by the executor.
+ */
+static zend_always_inline zend_long string_size(sf_validation_context_t *ctx, zend_long lo, zend_long hi)
+{
+    return sf_analysis_length_within(&ctx->analysis, Z_STR_P(ctx->value), lo, hi);
+}
+
+static zend_always_inline zend_long array_size(sf_validation_context_t *ctx)
+{
+    return (zend_long)zend_hash_num_elements(Z_ARRVAL_P(ctx->value));
+}
+
+sf_rule_result_t sf_rule_min_string(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    zend_long min = rule->params.size.value;
+    return string_size(ctx, min, ZEND_LONG_MAX) < min ? fail_min(ctx, min) : RULE_PASS;
+}
+
+sf_rule_result_t sf_rule_max_string(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    zend_long max = rule->params.size.value;
+    return string_size(ctx, ZEND_LONG_MIN, max) > max ? fail_max(ctx, max) : RULE_PASS;
+}
+
+sf_rule_result_t sf_rule_between_string(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    zend_long size = string_size(ctx, rule->params.range.min, rule->params.range.max);
+    if (size < rule->params.range.min || size > rule->params.range.max) {
+        return fail_between(ctx, rule->params.range.min, rule->params.range.max);
+    }
+    return RULE_PASS;
+}
+
+sf_rule_result_t sf_rule_min_array(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    return array_size(ctx) < rule->params.size.value ? fail_min(ctx, rule->params.size.value) : RULE_PASS;
+}
+
+sf_rule_result_t sf_rule_max_array(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    return array_size(ctx) > rule->params.size.value ? fail_max(ctx, rule->params.size.value) : RULE_PASS;
+}
+
+sf_rule_result_t sf_rule_between_array(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    zend_long size = array_size(ctx);
+    if (size < rule->params.range.min || size > rule->params.range.max) {
+        return fail_between(ctx, rule->params.range.min, rule->params.range.max);
+    }
+    return RULE_PASS;
+}
+
+/*
+ * pcre2_match() options for the string value. Patterns are compiled with
+ * PCRE2_UTF; once the value is known to be valid UTF-8, PCRE need not
+ * check it again. Invalid values are left to PCRE, which rejects them.
+ */
+static zend_always_inline uint32_t match_options(sf_validation_context_t *ctx)
+{
+    return sf_analysis_utf8_valid(&ctx->analysis, Z_STR_P(ctx->value)) ? PCRE2_NO_UTF_CHECK : 0;
+}
+
+/*
+ * Match a string value against the rule's pattern.
+ * Returns the pcre2_match() result, or PCRE2_ERROR_NOMATCH if the pattern
+ * could not be compiled.
+ */
+static int match_regex(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
     cached_regex_t *cached = sf_get_or_compile_regex(
         ctx->validator,
         rule->params.regex.pattern,
@@ -123,8 +303,7 @@ sf_rule_result_t sf_rule_regex(sf_validation_context_t *ctx, sf_parsed_rule_t *r
     );
 
     if (!cached) {
-        sf_add_error(ctx, "validation.regex");
-        return RULE_FAIL;
+        return PCRE2_ERROR_NOMATCH;
     }
 
     /*
@@ -132,17 +311,36 @@ sf_rule_result_t sf_rule_regex(sf_validation_context_t *ctx, sf_parsed_rule_t *r
      * If limits are exceeded, rc will be negative (PCRE2_ERROR_MATCHLIMIT
      * or PCRE2_ERROR_RECURSIONLIMIT), and the regex validation fails safely.
      */
-    int rc = pcre2_match(
+    return pcre2_match(
         cached->compiled,
         (PCRE2_SPTR)Z_STRVAL_P(ctx->value),
         Z_STRLEN_P(ctx->value),
         0,
-        0,
+        match_options(ctx),
         cached->match_data,
         cached->match_context
     );
+}
 
-    if (rc < 0) {
+/* regex - Must match regex pattern */
+sf_rule_result_t sf_rule_regex(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    if (ctx->has_nullable && ctx->is_null_or_empty) {
+        return RULE_PASS;
+    }
+
+    if (!ctx->value || Z_TYPE_P(ctx->value) != IS_STRING) {
+        sf_add_error(ctx, "validation.regex");
+        return RULE_FAIL;
+    }
+
+    return sf_rule_regex_string(ctx, rule);
+}
+
+/* regex, specialized for a value already known to be a string */
+sf_rule_result_t sf_rule_regex_string(sf_validation_context_t *ctx, sf_parsed_rule_t *rule)
+{
+    if (match_regex(ctx, rule) < 0) {
         sf_add_error(ctx, "validation.regex");
         return RULE_FAIL;
     }
@@ -179,7 +377,7 @@ sf_rule_result_t sf_rule_not_regex(sf_validation_context_t *ctx, sf_parsed_rule_
         (PCRE2_SPTR)Z_STRVAL_P(ctx->value),
         Z_STRLEN_P(ctx->value),
         0,
-        0,
+        match_options(ctx),
         cached->match_data,
         cached->match_context
     );
@@ -201,8 +399,8 @@ sf_rule_result_t sf_rule_not_regex(sf_validation_context_t *ctx, sf_parsed_rule_
  * 2. Potential security bypasses using overlong encodings
  * 3. Denial of service via malformed input
  *
- * The UTF-8 validation is performed once upfront for efficiency,
- * then we iterate through valid UTF-8 characters.
+ * The UTF-8 validation is performed once per value and shared with the
+ * field's other rules, then we iterate through valid UTF-8 characters.
  */
 
 /* alpha - Only alphabetic characters (ASCII + valid UTF-8 letters) */
@@ -225,7 +423,7 @@ sf_rule_result_t sf_rule_alpha(sf_validation_context_t *ctx, sf_parsed_rule_t *r
      * Invalid UTF-8 sequences could be crafted to bypass validation
      * (e.g., overlong encodings, invalid continuation bytes).
      */
-    if (!sf_utf8_is_valid(str, len)) {
+    if (!sf_analysis_utf8_valid(&ctx->analysis, Z_STR_P(ctx->value))) {
         sf_add_error(ctx, "validation.alpha");
         return RULE_FAIL;
     }
@@ -282,7 +480,7 @@ sf_rule_result_t sf_rule_alpha_num(sf_validation_context_t *ctx, sf_parsed_rule_
     size_t len = Z_STRLEN_P(ctx->value);
 
     /* Security: Validate UTF-8 encoding first */
-    if (!sf_utf8_is_valid(str, len)) {
+    if (!sf_analysis_utf8_valid(&ctx->analysis, Z_STR_P(ctx->value))) {
         sf_add_error(ctx, "validation.alpha_num");
         return RULE_FAIL;
     }
@@ -331,7 +529,7 @@ sf_rule_result_t sf_rule_alpha_dash(sf_validation_context_t *ctx, sf_parsed_rule
     size_t len = Z_STRLEN_P(ctx->value);
 
     /* Security: Validate UTF-8 encoding first */
-    if (!sf_utf8_is_valid(str, len)) {
+    if (!sf_analysis_utf8_valid(&ctx->analysis, Z_STR_P(ctx->value))) {
         sf_add_error(ctx, "validation.alpha_dash");
         return RULE_FAIL;
     }
@@ -116,18 +116,15 @@ sf_rule_result_t sf_rule_numeric(sf_validation_context_t *ctx, sf_parsed_rule_t
 
         case IS_STRING: {
             /* Check if string is numeric */
-            const char *str = Z_STRVAL_P(ctx->value);
-            size_t len = Z_STRLEN_P(ctx->value);
-
-            if (len == 0) {
+            if (Z_STRLEN_P(ctx->value) == 0) {
                 sf_add_error(ctx, "validation.numeric");
                 return RULE_FAIL;
             }
 
-            /* Use PHP's is_numeric_string */
+            /* PHP's is_numeric_string, shared with gt/lt and sum rules */
             zend_long lval;
             double dval;
-            if (is_numeric_string(str, len, &lval, &dval, 0) != 0) {
+            if (sf_analysis_numeric(&ctx->analysis, Z_STR_P(ctx->value), &lval, &dval) != 0) {
                 return RULE_PASS;
             }
             break;
@@ -0,0 +1,128 @@
+/*
+ * Per-value analysis shared by a field's rules
+ *
+ * min, max and @length conditions want the character count; alpha rules
+ * and regex matching want UTF-8 validity; numeric, gt/lt and sum rules
+ * want the parsed number. Asked separately each is a full pass over the
+ * string, so the answers are kept in the field's validation context and
+ * computed once: a single scan yields validity, length and the ASCII flag
+ * together.
+ *
+ * Length rules only compare the length with their bounds, so they count
+ * just far enough to decide them: 'max' => 255 reads at most 256
+ * characters of a multi-megabyte value.
+ */
+
+#include "analysis.h"
+#include "utf8.h"
+
+/* Validity, length and ASCII flag in one scan */
+static void scan(sf_value_analysis_t *analysis, zend_string *str)
+{
+    analysis->utf8_valid = sf_utf8_scan(ZSTR_VAL(str), ZSTR_LEN(str), &analysis->length, &analysis->ascii);
+    analysis->known |= SF_ANALYSIS_UTF8 | SF_ANALYSIS_LENGTH | SF_ANALYSIS_ASCII;
+
+#ifdef IS_STR_VALID_UTF8
+    /* Interned strings may be shared read-only between processes */
+    if (analysis->utf8_valid && !ZSTR_IS_INTERNED(str)) {
+        GC_ADD_FLAGS(str, IS_STR_VALID_UTF8);
+    }
+#endif
+}
+
+/* Whether a string is valid UTF-8 */
+bool sf_analysis_utf8_valid(sf_value_analysis_t *analysis, zend_string *str)
+{
+    if (!(analysis->known & SF_ANALYSIS_UTF8)) {
+#ifdef IS_STR_VALID_UTF8
+        if (ZSTR_IS_VALID_UTF8(str)) {
+            analysis->utf8_valid = 1;
+            analysis->known |= SF_ANALYSIS_UTF8;
+            return 1;
+        }
+#endif
+        scan(analysis, str);
+    }
+
+    return analysis->utf8_valid;
+}
+
+/* Length of a string in characters */
+size_t sf_analysis_length(sf_value_analysis_t *analysis, zend_string *str)
+{
+    if (!(analysis->known & SF_ANALYSIS_LENGTH)) {
+        scan(analysis, str);
+    }
+
+    return analysis->length;
+}
+
+/* Whether a string is already known to be valid UTF-8, without scanning it */
+static zend_always_inline bool known_valid(const sf_value_analysis_t *analysis, zend_string *str)
+{
+    if (analysis->known & SF_ANALYSIS_UTF8) {
+        return analysis->utf8_valid;
+    }
+#ifdef IS_STR_VALID_UTF8
+    return ZSTR_IS_VALID_UTF8(str);
+#else
+    return 0;
+#endif
+}
+
+/* Length of a string, counted only as far as two bounds need */
+zend_long sf_analysis_length_within(sf_value_analysis_t *analysis, zend_string *str, zend_long lo, zend_long hi)
+{
+    if (analysis->known & SF_ANALYSIS_LENGTH) {
+        return (zend_long)analysis->length;
+    }
+
+    /*
+     * Every character takes at least one byte and, in valid UTF-8, at most
+     * four. Malformed bytes count one each or not at all (continuations),
+     * so they only give the upper bound.
+     */
+    zend_long upper = (zend_long)ZSTR_LEN(str);
+    zend_long lower = known_valid(analysis, str) ? (upper + 3) / 4 : 0;
+    bool lo_decided = upper < lo || lower >= lo;
+    bool hi_decided = upper <= hi || lower > hi;
+
+    if (lo_decided && hi_decided) {
+        return upper < lo ? upper : lower;
+    }
+
+    /* hi is below upper if undecided, so hi + 1 cannot overflow */
+    zend_long limit;
+    if (lo_decided) {
+        limit = hi + 1;
+    } else if (hi_decided) {
+        limit = lo;
+    } else {
+        limit = MAX(lo, hi + 1);
+    }
+
+    size_t count = sf_utf8_strlen_upto(ZSTR_VAL(str), ZSTR_LEN(str), (size_t)limit);
+    if (count < (size_t)limit) {
+        /* Counted to the end */
+        analysis->length = count;
+        analysis->known |= SF_ANALYSIS_LENGTH;
+    }
+
+    return (zend_long)count;
+}
+
+/* Parse a string as a number */
+zend_uchar sf_analysis_numeric(sf_value_analysis_t *analysis, zend_string *str, zend_long *lval, double *dval)
+{
+    if (!(analysis->known & SF_ANALYSIS_NUMERIC)) {
+        analysis->numeric = is_numeric_string(ZSTR_VAL(str), ZSTR_LEN(str), &analysis->lval, &analysis->dval, 0);
+        analysis->known |= SF_ANALYSIS_NUMERIC;
+    }
+
+    if (analysis->numeric == IS_LONG) {
+        *lval = analysis->lval;
+    } else if (analysis->numeric == IS_DOUBLE) {
+        *dval = analysis->dval;
+    }
+    return analysis->numeric;
+}
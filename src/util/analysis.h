@@ -0,0 +1,55 @@
+/*
+ * Per-value analysis shared by a field's rules
+ */
+
+#ifndef SIGNALFORGE_ANALYSIS_H
+#define SIGNALFORGE_ANALYSIS_H
+
+#include "php.h"
+
+/* Facts of sf_value_analysis_t computed so far */
+#define SF_ANALYSIS_UTF8     (1 << 0)    /* utf8_valid */
+#define SF_ANALYSIS_LENGTH   (1 << 1)    /* length */
+#define SF_ANALYSIS_ASCII    (1 << 2)    /* ascii */
+#define SF_ANALYSIS_NUMERIC  (1 << 3)    /* numeric, lval, dval */
+
+/*
+ * What the rules of one field have learned about its string value. Each
+ * fact is computed the first time a rule asks for it; the record is reset
+ * (known = 0) whenever the value changes. All-zero is an empty record.
+ */
+typedef struct {
+    uint8_t known;              /* SF_ANALYSIS_* */
+    bool utf8_valid;
+    bool ascii;                 /* Valid and every byte below 0x80 */
+    zend_uchar numeric;         /* is_numeric_string() type, 0 if not numeric */
+    size_t length;              /* Characters, as sf_utf8_strlen() counts them */
+    zend_long lval;
+    double dval;
+} sf_value_analysis_t;
+
+/*
+ * Whether str is valid UTF-8. Trusts and, once proven, sets PHP's own
+ * valid-UTF-8 string flag where the engine has one (PHP 8.3+).
+ */
+bool sf_analysis_utf8_valid(sf_value_analysis_t *analysis, zend_string *str);
+
+/* Length of str in characters */
+size_t sf_analysis_length(sf_value_analysis_t *analysis, zend_string *str);
+
+/*
+ * Length of str in characters as far as comparing it with lo and hi goes:
+ * the result is below lo, above hi or in between exactly when the length
+ * is. Counts no further than the bounds need, and not at all when the
+ * byte length decides them (chars <= bytes, and chars >= bytes / 4 for
+ * valid UTF-8). Use sf_analysis_length() for the exact count.
+ */
+zend_long sf_analysis_length_within(sf_value_analysis_t *analysis, zend_string *str, zend_long lo, zend_long hi);
+
+/*
+ * is_numeric_string() of str (no errors allowed): IS_LONG, IS_DOUBLE or
+ * 0, with the number in lval or dval.
+ */
+zend_uchar sf_analysis_numeric(sf_value_analysis_t *analysis, zend_string *str, zend_long *lval, double *dval);
+
+#endif /* SIGNALFORGE_ANALYSIS_H */
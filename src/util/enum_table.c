@@ -0,0 +1,145 @@
+/*
+ * Backed enum case tables
+ *
+ * Tables are kept in a request-wide map from class entry to table, so a
+ * class's constants are walked and its case values evaluated once however
+ * many Validators name it. The map is dropped at request end, before the
+ * classes and case objects it points to.
+ */
+
+#include "php_signalforge_validation.h"
+#include "enum_table.h"
+#include "zend_enum.h"
+
+/* Free a table held by the map */
+static void table_dtor(zval *zv)
+{
+    sf_enum_table_t *table = Z_PTR_P(zv);
+    zend_hash_destroy(&table->cases);
+    efree(table);
+}
+
+/* Key the enum's cases by backing value */
+static sf_enum_table_t *build(zend_class_entry *ce)
+{
+    sf_enum_table_t *table = emalloc(sizeof(sf_enum_table_t));
+    zend_class_constant *c;
+    zend_string *name;
+
+    table->ce = ce;
+    table->backing_type = ce->enum_backing_type;
+    zend_hash_init(&table->cases, zend_hash_num_elements(CE_CONSTANTS_TABLE(ce)), NULL, ZVAL_PTR_DTOR, 0);
+
+    ZEND_HASH_FOREACH_STR_KEY_PTR(CE_CONSTANTS_TABLE(ce), name, c) {
+        if (!(ZEND_CLASS_CONST_FLAGS(c) & ZEND_CLASS_CONST_IS_CASE)) {
+            continue;
+        }
+
+        /* Evaluates the case (and its backing value) if not done yet */
+        if (Z_TYPE(c->value) == IS_CONSTANT_AST && zval_update_constant_ex(&c->value, c->ce) == FAILURE) {
+            zend_hash_destroy(&table->cases);
+            efree(table);
+            return NULL;
+        }
+
+        zend_object *obj = Z_OBJ(c->value);
+        zval *backing = zend_enum_fetch_case_value(obj);
+        zval case_zv;
+        ZVAL_OBJ_COPY(&case_zv, obj);
+
+        if (Z_TYPE_P(backing) == IS_LONG) {
+            zend_hash_index_update(&table->cases, (zend_ulong)Z_LVAL_P(backing), &case_zv);
+        } else {
+            zend_hash_update(&table->cases, Z_STR_P(backing), &case_zv);
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    return table;
+}
+
+/* The case table of a backed enum, built on first use */
+sf_enum_table_t *sf_enum_table_get(zend_class_entry *ce)
+{
+    HashTable *tables = SF_G(enum_tables);
+    zend_ulong key = (zend_ulong)(uintptr_t)ce;
+
+    if (tables) {
+        sf_enum_table_t *table = zend_hash_index_find_ptr(tables, key);
+        if (table) {
+            return table;
+        }
+    }
+
+    sf_enum_table_t *table = build(ce);
+    if (!table) {
+        return NULL;
+    }
+
+    if (!tables) {
+        ALLOC_HASHTABLE(tables);
+        zend_hash_init(tables, SF_HASH_INITIAL_SIZE, NULL, table_dtor, 0);
+        SF_G(enum_tables) = tables;
+    }
+    zend_hash_index_add_new_ptr(tables, key, table);
+    return table;
+}
+
+/* The case a value names */
+zend_object *sf_enum_table_find(const sf_enum_table_t *table, zval *value)
+{
+    zval *found = NULL;
+
+    ZVAL_DEREF(value);
+
+    switch (Z_TYPE_P(value)) {
+        case IS_OBJECT:
+            return Z_OBJCE_P(value) == table->ce ? Z_OBJ_P(value) : NULL;
+
+        case IS_LONG:
+            if (table->backing_type == IS_LONG) {
+                found = zend_hash_index_find(&table->cases, (zend_ulong)Z_LVAL_P(value));
+            } else {
+                char buf[MAX_LENGTH_OF_LONG + 1];
+                char *digits = zend_print_long_to_buf(buf + sizeof(buf) - 1, Z_LVAL_P(value));
+                found = zend_hash_str_find(&table->cases, digits, buf + sizeof(buf) - 1 - digits);
+            }
+            break;
+
+        case IS_DOUBLE: {
+            double d = Z_DVAL_P(value);
+            if (table->backing_type == IS_LONG && !zend_isnan(d) && ZEND_DOUBLE_FITS_LONG(d)
+                && d == (double)(zend_long)d) {
+                found = zend_hash_index_find(&table->cases, (zend_ulong)(zend_long)d);
+            }
+            break;
+        }
+
+        case IS_STRING:
+            if (table->backing_type == IS_STRING) {
+                found = zend_hash_find(&table->cases, Z_STR_P(value));
+            } else {
+                zend_long lval;
+                if (is_numeric_string(Z_STRVAL_P(value), Z_STRLEN_P(value), &lval, NULL, 0) == IS_LONG) {
+                    found = zend_hash_index_find(&table->cases, (zend_ulong)lval);
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return found ? Z_OBJ_P(found) : NULL;
+}
+
+/* Drop the request's tables */
+void sf_enum_table_rshutdown(void)
+{
+    HashTable *tables = SF_G(enum_tables);
+
+    if (tables) {
+        zend_hash_destroy(tables);
+        FREE_HASHTABLE(tables);
+        SF_G(enum_tables) = NULL;
+    }
+}
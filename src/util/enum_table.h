@@ -0,0 +1,38 @@
+/*
+ * Backed enum case tables
+ */
+
+#ifndef SIGNALFORGE_ENUM_TABLE_H
+#define SIGNALFORGE_ENUM_TABLE_H
+
+#include "php.h"
+
+/*
+ * A backed enum's cases keyed by backing value (integer or string keys,
+ * as the enum is backed), each holding its case object. Built once per
+ * class and request and shared by every Validator using the enum; case
+ * objects, like the class, only live for the request.
+ */
+typedef struct {
+    zend_class_entry *ce;
+    zend_uchar backing_type;    /* IS_LONG or IS_STRING */
+    HashTable cases;
+} sf_enum_table_t;
+
+/*
+ * The case table of a backed enum, built on first use. Returns NULL with
+ * an exception pending if a case value cannot be evaluated.
+ */
+sf_enum_table_t *sf_enum_table_get(zend_class_entry *ce);
+
+/*
+ * The case a value names: the case object itself, or its backing value
+ * as tryFrom() would coerce it (integer strings and integral floats for
+ * int-backed enums, integers for string-backed ones). NULL if none.
+ */
+zend_object *sf_enum_table_find(const sf_enum_table_t *table, zval *value);
+
+/* Drop the request's tables (RSHUTDOWN) */
+void sf_enum_table_rshutdown(void);
+
+#endif /* SIGNALFORGE_ENUM_TABLE_H */
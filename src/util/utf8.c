@@ -6,20 +6,103 @@
 
 /* Get the length of a UTF-8 string in characters (not bytes) */
 size_t sf_utf8_strlen(const char *str, size_t byte_len)
+{
+    return sf_utf8_strlen_upto(str, byte_len, SIZE_MAX);
+}
+
+/* Count characters as sf_utf8_strlen() does, stopping at limit */
+size_t sf_utf8_strlen_upto(const char *str, size_t byte_len, size_t limit)
 {
     size_t char_count = 0;
     const unsigned char *p = (const unsigned char *)str;
     const unsigned char *end = p + byte_len;
 
-    while (p < end) {
-        /* Count only lead bytes (not continuation bytes 10xxxxxx) */
+    /*
+     * Eight bytes at a time. Count only lead bytes (not continuation bytes
+     * 10xxxxxx): a byte is a continuation if its top bit is set and the
+     * next one, shifted into the top position, is not.
+     */
+    while (char_count < limit && (size_t)(end - p) >= sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        uint64_t continuation = word & ~(word << 1) & UINT64_C(0x8080808080808080);
+        char_count += sizeof(uint64_t)
+            - (size_t)(((continuation >> 7) * UINT64_C(0x0101010101010101)) >> 56);
+        p += sizeof(uint64_t);
+    }
+
+    while (char_count < limit && p < end) {
         if ((*p & 0xC0) != 0x80) {
             char_count++;
         }
         p++;
     }
 
-    return char_count;
+    return char_count < limit ? char_count : limit;
+}
+
+/*
+ * Length of the well-formed UTF-8 sequence starting at p, or 0 if it is
+ * malformed (bad lead or continuation byte, overlong, surrogate, above
+ * U+10FFFF or cut short by end).
+ */
+static zend_always_inline size_t sequence_length(const unsigned char *p, const unsigned char *end)
+{
+    if (*p < 0x80) {
+        /* ASCII: 0xxxxxxx */
+        return 1;
+    } else if ((*p & 0xE0) == 0xC0) {
+        /* 2-byte sequence: 110xxxxx 10xxxxxx */
+        if (p + 1 >= end) return 0;
+        if ((p[1] & 0xC0) != 0x80) return 0;
+        /* Check for overlong encoding */
+        if ((*p & 0x1E) == 0) return 0;
+        return 2;
+    } else if ((*p & 0xF0) == 0xE0) {
+        /* 3-byte sequence: 1110xxxx 10xxxxxx 10xxxxxx */
+        if (p + 2 >= end) return 0;
+        if ((p[1] & 0xC0) != 0x80) return 0;
+        if ((p[2] & 0xC0) != 0x80) return 0;
+        /* Check for overlong encoding */
+        if (*p == 0xE0 && (p[1] & 0x20) == 0) return 0;
+        /* Check for surrogate pairs */
+        if (*p == 0xED && (p[1] & 0x20) != 0) return 0;
+        return 3;
+    } else if ((*p & 0xF8) == 0xF0) {
+        /* 4-byte sequence: 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
+        if (p + 3 >= end) return 0;
+        if ((p[1] & 0xC0) != 0x80) return 0;
+        if ((p[2] & 0xC0) != 0x80) return 0;
+        if ((p[3] & 0xC0) != 0x80) return 0;
+        /* Check for overlong encoding */
+        if (*p == 0xF0 && (p[1] & 0x30) == 0) return 0;
+        /* Check for code points > U+10FFFF */
+        if (*p == 0xF4 && p[1] > 0x8F) return 0;
+        if (*p > 0xF4) return 0;
+        return 4;
+    }
+
+    /* Invalid lead byte */
+    return 0;
+}
+
+/* Length of the all-ASCII prefix, eight bytes at a time */
+static size_t ascii_prefix(const unsigned char *p, size_t byte_len)
+{
+    size_t i = 0;
+
+    for (; i + sizeof(uint64_t) <= byte_len; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, p + i, sizeof(word));
+        if (word & UINT64_C(0x8080808080808080)) {
+            break;
+        }
+    }
+    while (i < byte_len && p[i] < 0x80) {
+        i++;
+    }
+
+    return i;
 }
 
 /* Check if a string is valid UTF-8 */
@@ -28,45 +111,41 @@ bool sf_utf8_is_valid(const char *str, size_t byte_len)
     const unsigned char *p = (const unsigned char *)str;
     const unsigned char *end = p + byte_len;
 
+    p += ascii_prefix(p, byte_len);
+    while (p < end) {
+        size_t n = sequence_length(p, end);
+        if (n == 0) {
+            return 0;
+        }
+        p += n;
+    }
+
+    return 1;
+}
+
+/* Validate, count and classify a string in one pass */
+bool sf_utf8_scan(const char *str, size_t byte_len, size_t *char_len, bool *ascii)
+{
+    const unsigned char *p = (const unsigned char *)str;
+    const unsigned char *end = p + byte_len;
+    size_t prefix = ascii_prefix(p, byte_len);
+    size_t chars = prefix;
+
+    *ascii = prefix == byte_len;
+    p += prefix;
+
     while (p < end) {
-        if (*p < 0x80) {
-            /* ASCII: 0xxxxxxx */
-            p++;
-        } else if ((*p & 0xE0) == 0xC0) {
-            /* 2-byte sequence: 110xxxxx 10xxxxxx */
-            if (p + 1 >= end) return 0;
-            if ((p[1] & 0xC0) != 0x80) return 0;
-            /* Check for overlong encoding */
-            if ((*p & 0x1E) == 0) return 0;
-            p += 2;
-        } else if ((*p & 0xF0) == 0xE0) {
-            /* 3-byte sequence: 1110xxxx 10xxxxxx 10xxxxxx */
-            if (p + 2 >= end) return 0;
-            if ((p[1] & 0xC0) != 0x80) return 0;
-            if ((p[2] & 0xC0) != 0x80) return 0;
-            /* Check for overlong encoding */
-            if (*p == 0xE0 && (p[1] & 0x20) == 0) return 0;
-            /* Check for surrogate pairs */
-            if (*p == 0xED && (p[1] & 0x20) != 0) return 0;
-            p += 3;
-        } else if ((*p & 0xF8) == 0xF0) {
-            /* 4-byte sequence: 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
-            if (p + 3 >= end) return 0;
-            if ((p[1] & 0xC0) != 0x80) return 0;
-            if ((p[2] & 0xC0) != 0x80) return 0;
-            if ((p[3] & 0xC0) != 0x80) return 0;
-            /* Check for overlong encoding */
-            if (*p == 0xF0 && (p[1] & 0x30) == 0) return 0;
-            /* Check for code points > U+10FFFF */
-            if (*p == 0xF4 && p[1] > 0x8F) return 0;
-            if (*p > 0xF4) return 0;
-            p += 4;
-        } else {
-            /* Invalid lead byte */
+        size_t n = sequence_length(p, end);
+        if (n == 0) {
+            /* Count the rest as sf_utf8_strlen() would */
+            *char_len = chars + sf_utf8_strlen((const char *)p, (size_t)(end - p));
             return 0;
         }
+        chars++;
+        p += n;
     }
 
+    *char_len = chars;
     return 1;
 }
 
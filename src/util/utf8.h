@@ -10,9 +10,22 @@
 /* Get the length of a UTF-8 string in characters (not bytes) */
 size_t sf_utf8_strlen(const char *str, size_t byte_len);
 
+/*
+ * Count characters as sf_utf8_strlen() does, but stop once limit is
+ * reached: the result is the length if below limit, otherwise limit.
+ */
+size_t sf_utf8_strlen_upto(const char *str, size_t byte_len, size_t limit);
+
 /* Check if a string is valid UTF-8 */
 bool sf_utf8_is_valid(const char *str, size_t byte_len);
 
+/*
+ * Check validity, count characters and detect pure ASCII in one pass.
+ * Returns whether the string is valid UTF-8; char_len is what
+ * sf_utf8_strlen() would return either way.
+ */
+bool sf_utf8_scan(const char *str, size_t byte_len, size_t *char_len, bool *ascii);
+
 /* Get byte offset for a character position */
 size_t sf_utf8_char_to_byte_offset(const char *str, size_t byte_len, size_t char_pos);
 
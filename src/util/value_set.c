@@ -0,0 +1,794 @@
+/*
+ * Membership sets for value lists
+ *
+ * Under PHP 8 loose comparison a scalar value can only equal members of a
+ * few kinds:
+ *
+ *   - true, false and null equal members by truthiness (null also "")
+ *   - a number or numeric string equals members of the same numeric value
+ *   - a non-numeric string equals string members byte for byte, never a
+ *     number (whose string form is numeric, short of INF and NAN)
+ *
+ * so members are keyed by number or by string once, and a value is
+ * converted to the one key it could match. Strict mode keys members by
+ * type instead. Values and lists the keys cannot answer for fall back to
+ * comparing member by member.
+ */
+
+#include "value_set.h"
+#include "ext/random/php_random.h"
+
+/* Largest magnitude at which every integral double converts exactly */
+#define SF_SET_EXACT_DOUBLE 9007199254740992.0   /* 2^53 */
+
+/*
+ * Add a key as an empty element, or with its data. A member with data
+ * must be new: fails if an equal key is there already.
+ */
+static zend_always_inline bool add_index(HashTable *ht, zend_ulong h, zval *data)
+{
+    if (!data) {
+        zend_hash_index_add_empty_element(ht, h);
+        return 1;
+    }
+    if (!zend_hash_index_add(ht, h, data)) {
+        return 0;
+    }
+    Z_TRY_ADDREF_P(data);
+    return 1;
+}
+
+static zend_always_inline bool add_key(HashTable *ht, zend_string *key, zval *data)
+{
+    if (!data) {
+        zend_hash_add_empty_element(ht, key);
+        return 1;
+    }
+    if (!zend_hash_add(ht, key, data)) {
+        return 0;
+    }
+    Z_TRY_ADDREF_P(data);
+    return 1;
+}
+
+/* Key a float by its bits; -0.0 is 0.0 under both == and === */
+static zend_always_inline zval *find_double(const HashTable *doubles, double d)
+{
+    if (d == 0) {
+        d = 0;
+    }
+    return zend_hash_str_find(doubles, (const char *)&d, sizeof(d));
+}
+
+static bool add_double(HashTable *doubles, double d, zval *data)
+{
+    if (d == 0) {
+        d = 0;
+    }
+    zend_string *key = zend_string_init((const char *)&d, sizeof(d), 0);
+    bool added = add_key(doubles, key, data);
+    zend_string_release(key);
+    return added;
+}
+
+/* Loose: add a numeric member. Fails for values compared through rounding
+ * or through their string form. */
+static bool add_number(sf_value_set_t *set, double d, zval *data)
+{
+    if (zend_isnan(d) || zend_isinf(d) || d <= -SF_SET_EXACT_DOUBLE || d >= SF_SET_EXACT_DOUBLE) {
+        return 0;
+    }
+
+    zend_long l = (zend_long)d;
+    if ((double)l == d) {
+        return add_index(&set->ints, (zend_ulong)l, data);
+    }
+    return add_double(&set->doubles, d, data);
+}
+
+/* Add a string member as its mode keys it */
+static bool add_string(sf_value_set_t *set, zend_string *str, zval *data)
+{
+    if (set->mode != SF_SET_STRICT) {
+        zend_long lval;
+        double dval;
+        zend_uchar type = is_numeric_string(ZSTR_VAL(str), ZSTR_LEN(str), &lval, &dval, 0);
+
+        if (type == IS_LONG) {
+            return add_index(&set->ints, (zend_ulong)lval, data);
+        }
+        if (type == IS_DOUBLE) {
+            return add_number(set, dval, data);
+        }
+    }
+
+    if (set->mode == SF_SET_CI) {
+        zend_string *folded = zend_string_tolower(str);
+        bool added = add_key(&set->strings, folded, data);
+        zend_string_release(folded);
+        return added;
+    }
+    return add_key(&set->strings, str, data);
+}
+
+/* Add one member; fails if it cannot be keyed */
+static bool add_member(sf_value_set_t *set, zval *item)
+{
+    ZVAL_DEREF(item);
+
+    switch (Z_TYPE_P(item)) {
+        case IS_NULL:
+            set->has_null = 1;
+            return 1;
+
+        case IS_FALSE:
+            set->has_false = 1;
+            return 1;
+
+        case IS_TRUE:
+            set->has_true = 1;
+            return 1;
+
+        case IS_LONG:
+            add_index(&set->ints, (zend_ulong)Z_LVAL_P(item), NULL);
+            return 1;
+
+        case IS_DOUBLE:
+            if (set->mode == SF_SET_STRICT) {
+                /* NaN is identical to nothing */
+                if (!zend_isnan(Z_DVAL_P(item))) {
+                    add_double(&set->doubles, Z_DVAL_P(item), NULL);
+                }
+                return 1;
+            }
+            return add_number(set, Z_DVAL_P(item), NULL);
+
+        case IS_STRING:
+            return add_string(set, Z_STR_P(item), NULL);
+
+        default:
+            return 0;
+    }
+}
+
+/* Loose: note which of true, false and null equal a member */
+static void note_scalar_hits(sf_value_set_t *set, zval *item)
+{
+    zval t, f, n;
+
+    ZVAL_TRUE(&t);
+    ZVAL_FALSE(&f);
+    ZVAL_NULL(&n);
+
+    set->true_hit = set->true_hit || zend_compare(&t, item) == 0;
+    set->false_hit = set->false_hit || zend_compare(&f, item) == 0;
+    set->null_hit = set->null_hit || zend_compare(&n, item) == 0;
+}
+
+/* Move the integer members into a bitset if they span few values */
+static void build_bitset(sf_value_set_t *set)
+{
+    zend_ulong key;
+    zend_long min = ZEND_LONG_MAX, max = ZEND_LONG_MIN;
+
+    if (zend_hash_num_elements(&set->ints) == 0) {
+        return;
+    }
+
+    ZEND_HASH_FOREACH_NUM_KEY(&set->ints, key) {
+        zend_long l = (zend_long)key;
+        if (l < min) {
+            min = l;
+        }
+        if (l > max) {
+            max = l;
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    /* Unsigned, so a span crossing the whole range cannot overflow */
+    zend_ulong span = (zend_ulong)max - (zend_ulong)min + 1;
+    if (span == 0 || span > SF_SET_BITSET_SPAN) {
+        return;
+    }
+
+    set->base = min;
+    set->span = (uint32_t)span;
+    set->bits = ecalloc((span + 63) / 64, sizeof(uint64_t));
+
+    ZEND_HASH_FOREACH_NUM_KEY(&set->ints, key) {
+        zend_ulong bit = key - (zend_ulong)min;
+        set->bits[bit / 64] |= (uint64_t)1 << (bit % 64);
+    } ZEND_HASH_FOREACH_END();
+
+    zend_hash_clean(&set->ints);
+}
+
+/* Allocate an empty set */
+static sf_value_set_t *create(sf_set_mode_t mode, uint32_t size)
+{
+    sf_value_set_t *set = ecalloc(1, sizeof(sf_value_set_t));
+
+    set->refcount = 1;
+    set->mode = mode;
+    zend_hash_init(&set->ints, 8, NULL, ZVAL_PTR_DTOR, 0);
+    zend_hash_init(&set->doubles, 8, NULL, ZVAL_PTR_DTOR, 0);
+    zend_hash_init(&set->strings, size, NULL, ZVAL_PTR_DTOR, 0);
+    return set;
+}
+
+/* Free a set's storage */
+static void destroy(sf_value_set_t *set)
+{
+    zend_hash_destroy(&set->ints);
+    zend_hash_destroy(&set->doubles);
+    zend_hash_destroy(&set->strings);
+    if (set->bits) {
+        efree(set->bits);
+    }
+    efree(set);
+}
+
+/* Build the set for a list */
+sf_value_set_t *sf_value_set_build(HashTable *values, sf_set_mode_t mode)
+{
+    sf_value_set_t *set = create(mode, zend_hash_num_elements(values));
+    zval *item;
+
+    ZEND_HASH_FOREACH_VAL(values, item) {
+        if (!add_member(set, item)) {
+            destroy(set);
+            return NULL;
+        }
+
+        if (mode != SF_SET_STRICT) {
+            ZVAL_DEREF(item);
+            note_scalar_hits(set, item);
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    build_bitset(set);
+    return set;
+}
+
+/* Build a loose set from a table's keys */
+sf_value_set_t *sf_value_set_build_keys(HashTable *table)
+{
+    sf_value_set_t *set = create(SF_SET_LOOSE, zend_hash_num_elements(table));
+    zend_ulong h;
+    zend_string *key;
+    zval *data;
+
+    ZEND_HASH_FOREACH_KEY_VAL(table, h, key, data) {
+        zval item;
+        bool added;
+
+        if (key) {
+            added = add_string(set, key, data);
+            ZVAL_STR(&item, key);
+        } else {
+            added = add_index(&set->ints, h, data);
+            ZVAL_LONG(&item, (zend_long)h);
+        }
+        if (!added) {
+            destroy(set);
+            return NULL;
+        }
+        note_scalar_hits(set, &item);
+    } ZEND_HASH_FOREACH_END();
+
+    /* Members carry data, so integers stay hash keys */
+    return set;
+}
+
+/* Report a flag lookup */
+static zend_always_inline sf_set_result_t hit(bool found)
+{
+    return found ? SF_SET_HIT : SF_SET_MISS;
+}
+
+/* Report a key lookup, passing the key's data on */
+static zend_always_inline sf_set_result_t found(zval *data, zval **member)
+{
+    if (!data) {
+        return SF_SET_MISS;
+    }
+    if (member) {
+        *member = data;
+    }
+    return SF_SET_HIT;
+}
+
+/* Look up an integer member */
+static zend_always_inline sf_set_result_t find_long(const sf_value_set_t *set, zend_long l, zval **member)
+{
+    if (set->span) {
+        zend_ulong bit = (zend_ulong)l - (zend_ulong)set->base;
+        return hit(bit < set->span && (set->bits[bit / 64] >> (bit % 64)) & 1);
+    }
+    return found(zend_hash_index_find(&set->ints, (zend_ulong)l), member);
+}
+
+/* Loose: look up a float value among the numeric members */
+static sf_set_result_t find_number(const sf_value_set_t *set, double d, zval **member)
+{
+    if (d <= -SF_SET_EXACT_DOUBLE || d >= SF_SET_EXACT_DOUBLE) {
+        /* Integer members may round to d; leave it to the scan */
+        return SF_SET_UNKNOWN;
+    }
+
+    zend_long l = (zend_long)d;
+    if ((double)l == d) {
+        return find_long(set, l, member);
+    }
+    return found(find_double(&set->doubles, d), member);
+}
+
+/* Loose: whether a non-boolean value equals a true, false or null member */
+static zend_always_inline bool bool_hit(const sf_value_set_t *set, bool truthy, bool empty_string)
+{
+    if (truthy) {
+        return set->has_true;
+    }
+    return set->has_false || (set->has_null && empty_string);
+}
+
+/* Strict lookup: members of the value's own type */
+static sf_set_result_t lookup_strict(const sf_value_set_t *set, zval *value)
+{
+    switch (Z_TYPE_P(value)) {
+        case IS_NULL:
+            return hit(set->has_null);
+        case IS_FALSE:
+            return hit(set->has_false);
+        case IS_TRUE:
+            return hit(set->has_true);
+        case IS_LONG:
+            return find_long(set, Z_LVAL_P(value), NULL);
+        case IS_DOUBLE:
+            return hit(find_double(&set->doubles, Z_DVAL_P(value)) != NULL);
+        case IS_STRING:
+            return hit(zend_hash_find(&set->strings, Z_STR_P(value)) != NULL);
+        default:
+            return SF_SET_UNKNOWN;
+    }
+}
+
+/* Loose lookup of a number or string */
+static sf_set_result_t lookup_loose(const sf_value_set_t *set, zval *value, zval **member)
+{
+    switch (Z_TYPE_P(value)) {
+        case IS_LONG:
+            if (bool_hit(set, Z_LVAL_P(value) != 0, 1)) {
+                return SF_SET_HIT;
+            }
+            return find_long(set, Z_LVAL_P(value), member);
+
+        case IS_DOUBLE: {
+            double d = Z_DVAL_P(value);
+            if (zend_isnan(d) || zend_isinf(d)) {
+                /* Compared as "NAN"/"INF" against string members */
+                return SF_SET_UNKNOWN;
+            }
+            if (bool_hit(set, d != 0, 1)) {
+                return SF_SET_HIT;
+            }
+            return find_number(set, d, member);
+        }
+
+        case IS_STRING: {
+            zend_long lval;
+            double dval;
+            zend_uchar type = is_numeric_string(Z_STRVAL_P(value), Z_STRLEN_P(value), &lval, &dval, 0);
+
+            if (bool_hit(set, zend_is_true(value), Z_STRLEN_P(value) == 0)) {
+                return SF_SET_HIT;
+            }
+            if (type == IS_LONG) {
+                return find_long(set, lval, member);
+            }
+            if (type == IS_DOUBLE) {
+                return find_number(set, dval, member);
+            }
+            if (set->mode == SF_SET_CI) {
+                zend_string *folded = zend_string_tolower(Z_STR_P(value));
+                sf_set_result_t result = found(zend_hash_find(&set->strings, folded), member);
+                zend_string_release(folded);
+                return result;
+            }
+            return found(zend_hash_find(&set->strings, Z_STR_P(value)), member);
+        }
+
+        default:
+            return SF_SET_UNKNOWN;
+    }
+}
+
+/* Look up a value */
+sf_set_result_t sf_value_set_lookup(const sf_value_set_t *set, zval *value)
+{
+    ZVAL_DEREF(value);
+
+    if (set->mode == SF_SET_STRICT) {
+        return lookup_strict(set, value);
+    }
+
+    switch (Z_TYPE_P(value)) {
+        case IS_NULL:
+            return hit(set->null_hit);
+        case IS_FALSE:
+            return hit(set->false_hit);
+        case IS_TRUE:
+            return hit(set->true_hit);
+        default:
+            return lookup_loose(set, value, NULL);
+    }
+}
+
+/* Look up a value in a set built from a table's keys */
+sf_set_result_t sf_value_set_find(const sf_value_set_t *set, zval *value, zval **member)
+{
+    ZVAL_DEREF(value);
+
+    if (Z_TYPE_P(value) <= IS_TRUE) {
+        return SF_SET_UNKNOWN;
+    }
+    return lookup_loose(set, value, member);
+}
+
+/* Compare a value with one member as the mode says */
+bool sf_set_mode_equals(sf_set_mode_t mode, zval *value, zval *member)
+{
+    ZVAL_DEREF(value);
+    ZVAL_DEREF(member);
+
+    if (mode == SF_SET_STRICT) {
+        return zend_is_identical(value, member);
+    }
+
+    if (mode == SF_SET_CI && Z_TYPE_P(value) == IS_STRING && Z_TYPE_P(member) == IS_STRING
+        && !(is_numeric_string(Z_STRVAL_P(value), Z_STRLEN_P(value), NULL, NULL, 0)
+             && is_numeric_string(Z_STRVAL_P(member), Z_STRLEN_P(member), NULL, NULL, 0))) {
+        return zend_binary_strcasecmp(Z_STRVAL_P(value), Z_STRLEN_P(value),
+            Z_STRVAL_P(member), Z_STRLEN_P(member)) == 0;
+    }
+
+    return zend_compare(value, member) == 0;
+}
+
+/* Whether a value is in a list */
+bool sf_value_set_contains(const sf_value_set_t *set, HashTable *values, sf_set_mode_t mode, zval *value)
+{
+    if (set) {
+        sf_set_result_t result = sf_value_set_lookup(set, value);
+        if (result != SF_SET_UNKNOWN) {
+            return result == SF_SET_HIT;
+        }
+    }
+
+    zval *item;
+    ZEND_HASH_FOREACH_VAL(values, item) {
+        if (sf_set_mode_equals(mode, value, item)) {
+            return 1;
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    return 0;
+}
+
+/* Share a set */
+sf_value_set_t *sf_value_set_copy(sf_value_set_t *set)
+{
+    if (set) {
+        set->refcount++;
+    }
+    return set;
+}
+
+/* Release a set */
+void sf_value_set_release(sf_value_set_t *set)
+{
+    if (set && --set->refcount == 0) {
+        destroy(set);
+    }
+}
+
+/*
+ * Collecting sets (distinct, unique)
+ *
+ * Linear probing over a power-of-two table kept at most half full. Values
+ * are reduced to an integer, float or string key without allocating, and
+ * hashed with a seed picked at startup, so input cannot be crafted to make
+ * its keys collide. zend_string's cached hash is not reused for that
+ * reason: it is unseeded DJBX33A, for which colliding strings are easy to
+ * build.
+ */
+
+/* Process-wide seed, set once at MINIT */
+static uint64_t sf_hash_seed = 0x6a09e667f3bcc909ULL;
+
+#define SF_HASH_MUL 0x9e3779b97f4a7c15ULL
+
+/* Largest table, in slots; far more values than fit in memory as zvals */
+#define SF_HASH_SET_MAX_SLOTS (1U << 31)
+
+/* MurmurHash3 finalizer: every input bit affects every output bit */
+static zend_always_inline uint64_t mix64(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/* Final hash of a key; 0 is reserved for free slots */
+static zend_always_inline uint64_t finish(uint64_t h)
+{
+    h = mix64(h);
+    return h ? h : 1;
+}
+
+/* Seeded hash of a string's bytes, a word at a time */
+static uint64_t hash_bytes(const char *s, size_t len)
+{
+    uint64_t h = sf_hash_seed ^ ((uint64_t)len * SF_HASH_MUL);
+    uint64_t w;
+
+    while (len >= sizeof(w)) {
+        memcpy(&w, s, sizeof(w));
+        h = (h ^ w) * SF_HASH_MUL;
+        h ^= h >> 32;
+        s += sizeof(w);
+        len -= sizeof(w);
+    }
+
+    w = 0;
+    memcpy(&w, s, len);
+    return finish((h ^ w) * SF_HASH_MUL);
+}
+
+/* Pick the process-wide hash seed */
+void sf_hash_set_minit(void)
+{
+    uint64_t seed;
+
+    if (php_random_bytes_silent(&seed, sizeof(seed)) == SUCCESS) {
+        sf_hash_seed = seed;
+    }
+}
+
+/* A finite float's string form, as (string) writes it; returns its length */
+static size_t double_text(double d, char *buf)
+{
+    int precision = (int)EG(precision);
+
+    zend_gcvt(d, precision ? precision : 1, '.', 'E', buf);
+    return strlen(buf);
+}
+
+/*
+ * Key the string form of a finite float: an integer's digits as that
+ * integer, anything else as the float the form reads back as, which every
+ * float of that form shares.
+ */
+static void key_double_text(sf_hash_slot_t *slot, const char *text, size_t len)
+{
+    zend_ulong idx;
+
+    if (ZEND_HANDLE_NUMERIC_STR_EX(text, len, idx)) {
+        slot->type = IS_LONG;
+        slot->key.lval = (zend_long)idx;
+    } else {
+        slot->type = IS_DOUBLE;
+        slot->key.dval = zend_strtod(text, NULL);
+    }
+}
+
+/* Infinite and NaN floats, whose forms are "INF", "-INF" and "NAN" */
+static void key_special(sf_hash_slot_t *slot, double d)
+{
+    slot->type = IS_DOUBLE;
+    slot->key.dval = zend_isnan(d) ? ZEND_NAN : d;
+}
+
+/* Key a string: as a number if it is some number's string form */
+static void key_string(sf_hash_slot_t *slot, zend_string *str)
+{
+    zend_ulong idx;
+
+    if (ZEND_HANDLE_NUMERIC_STR(str, idx)) {
+        slot->type = IS_LONG;
+        slot->key.lval = (zend_long)idx;
+        return;
+    }
+
+    slot->type = IS_STRING;
+    slot->key.str = str;
+
+    if (is_numeric_string(ZSTR_VAL(str), ZSTR_LEN(str), NULL, NULL, 0)) {
+        double d = zend_strtod(ZSTR_VAL(str), NULL);
+        char buf[ZEND_DOUBLE_MAX_LENGTH];
+
+        if (zend_finite(d) && double_text(d, buf) == ZSTR_LEN(str)
+            && memcmp(buf, ZSTR_VAL(str), ZSTR_LEN(str)) == 0) {
+            key_double_text(slot, buf, ZSTR_LEN(str));
+        }
+    } else if (zend_string_equals_literal(str, "INF")) {
+        key_special(slot, ZEND_INFINITY);
+    } else if (zend_string_equals_literal(str, "-INF")) {
+        key_special(slot, -ZEND_INFINITY);
+    } else if (zend_string_equals_literal(str, "NAN")) {
+        key_special(slot, ZEND_NAN);
+    }
+}
+
+/*
+ * Normalize a value into slot's key and hash. Returns 0 for arrays and
+ * objects, which are not members.
+ */
+static bool normalize(zval *value, sf_hash_slot_t *slot)
+{
+    ZVAL_DEREF(value);
+
+    switch (Z_TYPE_P(value)) {
+        case IS_LONG:
+            slot->type = IS_LONG;
+            slot->key.lval = Z_LVAL_P(value);
+            break;
+
+        case IS_FALSE:
+        case IS_TRUE:
+            slot->type = IS_LONG;
+            slot->key.lval = Z_TYPE_P(value) == IS_TRUE;
+            break;
+
+        case IS_DOUBLE: {
+            double d = Z_DVAL_P(value);
+            if (!zend_finite(d)) {
+                key_special(slot, d);
+            } else {
+                char buf[ZEND_DOUBLE_MAX_LENGTH];
+                key_double_text(slot, buf, double_text(d, buf));
+            }
+            break;
+        }
+
+        case IS_NULL:
+            slot->type = IS_STRING;
+            slot->key.str = ZSTR_EMPTY_ALLOC();
+            break;
+
+        case IS_STRING:
+            key_string(slot, Z_STR_P(value));
+            break;
+
+        default:
+            return 0;
+    }
+
+    switch (slot->type) {
+        case IS_LONG:
+            slot->hash = finish((uint64_t)slot->key.lval ^ sf_hash_seed);
+            break;
+
+        case IS_DOUBLE: {
+            uint64_t bits;
+            memcpy(&bits, &slot->key.dval, sizeof(bits));
+            slot->hash = finish(bits ^ sf_hash_seed ^ SF_HASH_MUL);
+            break;
+        }
+
+        default:
+            slot->hash = hash_bytes(ZSTR_VAL(slot->key.str), ZSTR_LEN(slot->key.str));
+            break;
+    }
+
+    return 1;
+}
+
+/* Whether two normalized keys are equal; floats by bits, so NAN equals NAN as "NAN" does */
+static zend_always_inline bool same_key(const sf_hash_slot_t *a, const sf_hash_slot_t *b)
+{
+    if (a->hash != b->hash || a->type != b->type) {
+        return 0;
+    }
+
+    switch (a->type) {
+        case IS_LONG:
+            return a->key.lval == b->key.lval;
+        case IS_DOUBLE:
+            return memcmp(&a->key.dval, &b->key.dval, sizeof(double)) == 0;
+        default:
+            return zend_string_equal_content(a->key.str, b->key.str);
+    }
+}
+
+/* Place a key known to be absent */
+static void place(sf_hash_slot_t *slots, uint32_t mask, const sf_hash_slot_t *slot)
+{
+    uint32_t i = (uint32_t)slot->hash & mask;
+
+    while (slots[i].hash) {
+        i = (i + 1) & mask;
+    }
+    slots[i] = *slot;
+}
+
+/* Double the table */
+static void grow(sf_hash_set_t *set)
+{
+    uint32_t size = (set->mask + 1) * 2;
+    sf_hash_slot_t *slots = ecalloc(size, sizeof(sf_hash_slot_t));
+
+    for (uint32_t i = 0; i <= set->mask; i++) {
+        if (set->slots[i].hash) {
+            place(slots, size - 1, &set->slots[i]);
+        }
+    }
+
+    if (set->slots != set->inline_slots) {
+        efree(set->slots);
+    }
+    set->slots = slots;
+    set->mask = size - 1;
+}
+
+/* Set up an empty set */
+void sf_hash_set_init(sf_hash_set_t *set, uint32_t expected)
+{
+    uint32_t size = SF_HASH_SET_INLINE;
+
+    while (size < SF_HASH_SET_MAX_SLOTS && size / 2 < expected) {
+        size *= 2;
+    }
+
+    if (size == SF_HASH_SET_INLINE) {
+        memset(set->inline_slots, 0, sizeof(set->inline_slots));
+        set->slots = set->inline_slots;
+    } else {
+        set->slots = ecalloc(size, sizeof(sf_hash_slot_t));
+    }
+    set->mask = size - 1;
+    set->count = 0;
+}
+
+/* Add a value */
+sf_hash_add_t sf_hash_set_add(sf_hash_set_t *set, zval *value)
+{
+    sf_hash_slot_t slot;
+
+    if (!normalize(value, &slot)) {
+        return SF_HASH_IGNORED;
+    }
+
+    uint32_t i = (uint32_t)slot.hash & set->mask;
+    while (set->slots[i].hash) {
+        if (same_key(&set->slots[i], &slot)) {
+            return SF_HASH_PRESENT;
+        }
+        i = (i + 1) & set->mask;
+    }
+
+    /* At most half full, so probes stay short and always end */
+    if ((uint64_t)(set->count + 1) * 2 > (uint64_t)set->mask + 1
+        && set->mask + 1 < SF_HASH_SET_MAX_SLOTS) {
+        grow(set);
+        place(set->slots, set->mask, &slot);
+    } else {
+        set->slots[i] = slot;
+    }
+
+    set->count++;
+    return SF_HASH_ADDED;
+}
+
+/* Release a set's slots */
+void sf_hash_set_destroy(sf_hash_set_t *set)
+{
+    if (set->slots != set->inline_slots) {
+        efree(set->slots);
+    }
+    set->slots = NULL;
+    set->count = 0;
+}
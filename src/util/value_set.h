@@ -0,0 +1,155 @@
+/*
+ * Membership sets for value lists
+ *
+ * One set type answers every "is this value in that list" question asked
+ * with PHP comparison: the in / not_in rules, the value lists of
+ * required_if and friends, in / not_in conditions, and variant dispatch.
+ * A second one collects the values a rule has seen so far, for distinct
+ * and unique.
+ */
+
+#ifndef SIGNALFORGE_VALUE_SET_H
+#define SIGNALFORGE_VALUE_SET_H
+
+#include "php.h"
+
+/* How list members are compared with the value */
+typedef enum {
+    SF_SET_LOOSE,       /* == (default) */
+    SF_SET_STRICT,      /* === */
+    SF_SET_CI,          /* ==, with non-numeric strings compared ASCII case-insensitively */
+} sf_set_mode_t;
+
+/* Integer spans up to this many values are kept as a bitset */
+#define SF_SET_BITSET_SPAN 4096
+
+/*
+ * A list split by key type, built once when the rule or condition compiles:
+ *
+ *   - integer members (and, when loose, integral floats and numeric
+ *     strings) in a bitset if they span few values, else as hash keys
+ *   - other float members keyed by their bit pattern
+ *   - string members (when loose, non-numeric ones only) as hash keys,
+ *     ASCII-lowercased in case-insensitive mode
+ *   - booleans and null reduced to flags
+ *
+ * so a lookup is one probe. A set built from a table's keys (see
+ * sf_value_set_build_keys) keeps each key's data for sf_value_set_find.
+ * Shared between clones by reference count.
+ */
+typedef struct {
+    uint32_t refcount;
+    sf_set_mode_t mode;
+    zend_long base;         /* Bitset: smallest integer member */
+    uint32_t span;          /* Bitset: integers covered, 0 if no bitset */
+    uint64_t *bits;
+    HashTable ints;
+    HashTable doubles;
+    HashTable strings;
+    bool has_true;          /* Members true / false / null */
+    bool has_false;
+    bool has_null;
+    bool true_hit;          /* Loose: true, false and null equal some member */
+    bool false_hit;
+    bool null_hit;
+} sf_value_set_t;
+
+/* Outcome of a set lookup */
+typedef enum {
+    SF_SET_MISS,
+    SF_SET_HIT,
+    SF_SET_UNKNOWN,         /* The set cannot answer for this value; scan the list */
+} sf_set_result_t;
+
+/*
+ * Build the set for a list. Returns NULL if some member cannot be keyed
+ * (arrays, objects, and when loose, infinite floats and numbers beyond
+ * 2^53, whose comparisons depend on float rounding); the list is scanned
+ * then.
+ */
+sf_value_set_t *sf_value_set_build(HashTable *values, sf_set_mode_t mode);
+
+/*
+ * Build a loose set whose members are a table's keys, each carrying its
+ * data, so a hit names the one key equal to the value. Returns NULL as
+ * sf_value_set_build() does, and also if two keys are equal under ==
+ * ("1.5" and "1.50"): a value can match both then.
+ */
+sf_value_set_t *sf_value_set_build_keys(HashTable *table);
+
+/* Look up a value; see sf_set_result_t */
+sf_set_result_t sf_value_set_lookup(const sf_value_set_t *set, zval *value);
+
+/*
+ * Look up a value in a set built by sf_value_set_build_keys(), returning
+ * the matching key's data through *member on a hit. Booleans and null,
+ * which can equal several keys at once, are SF_SET_UNKNOWN.
+ */
+sf_set_result_t sf_value_set_find(const sf_value_set_t *set, zval *value, zval **member);
+
+/* Compare a value with one member as the mode says (the scan fallback) */
+bool sf_set_mode_equals(sf_set_mode_t mode, zval *value, zval *member);
+
+/* Whether a value is in a list: through its set if it has one, else by scanning */
+bool sf_value_set_contains(const sf_value_set_t *set, HashTable *values, sf_set_mode_t mode, zval *value);
+
+/* Share a set */
+sf_value_set_t *sf_value_set_copy(sf_value_set_t *set);
+
+/* Release a set */
+void sf_value_set_release(sf_value_set_t *set);
+
+/* Slots kept inside a collecting set itself; small sets never allocate */
+#define SF_HASH_SET_INLINE 16
+
+/* A member: a normalized key and its seeded hash (0 marks a free slot) */
+typedef struct {
+    uint64_t hash;
+    zend_uchar type;            /* IS_LONG, IS_DOUBLE or IS_STRING */
+    union {
+        zend_long lval;
+        double dval;
+        zend_string *str;       /* Borrowed from the values added */
+    } key;
+} sf_hash_slot_t;
+
+/*
+ * Set of the values seen so far, under the equality 'distinct' and 'unique'
+ * use: two values are equal when their string forms are. An integer is
+ * its decimal digits ("1", but not "01" or "1.0"), a float what (string)
+ * gives at the 'precision' setting (2.0 is "2", 1.5 is "1.5" but not
+ * "1.50"), true "1", false "0" and null "".
+ *
+ * Values are keyed by that form without building it: strings of an
+ * integer's digits as the integer, strings of a float's form as the
+ * float. Strings are not copied: the values added must outlive the set,
+ * as the input data does during validate(). Arrays and objects are not
+ * members.
+ */
+typedef struct {
+    sf_hash_slot_t *slots;
+    uint32_t mask;              /* Slot count - 1 (a power of two) */
+    uint32_t count;
+    sf_hash_slot_t inline_slots[SF_HASH_SET_INLINE];
+} sf_hash_set_t;
+
+/* Outcome of sf_hash_set_add() */
+typedef enum {
+    SF_HASH_ADDED,              /* New member */
+    SF_HASH_PRESENT,            /* An equal value was added before */
+    SF_HASH_IGNORED,            /* Not a scalar; not a member */
+} sf_hash_add_t;
+
+/* Pick the process-wide hash seed (MINIT) */
+void sf_hash_set_minit(void);
+
+/* Set up an empty set sized for about `expected` members */
+void sf_hash_set_init(sf_hash_set_t *set, uint32_t expected);
+
+/* Add a value; see sf_hash_add_t */
+sf_hash_add_t sf_hash_set_add(sf_hash_set_t *set, zval *value);
+
+/* Release a set's slots */
+void sf_hash_set_destroy(sf_hash_set_t *set);
+
+#endif /* SIGNALFORGE_VALUE_SET_H */
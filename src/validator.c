@@ -5,9 +5,14 @@
 #include "validator.h"
 #include "result.h"
 #include "parser.h"
+#include "program.h"
+#include "profile.h"
 #include "condition.h"
 #include "wildcard.h"
+#include "path.h"
 #include "rules/rules.h"
+#include "util/value_set.h"
+#include "ext/standard/hrtime.h"
 
 /* Object handlers */
 zend_object_handlers signalforge_validator_handlers;
@@ -40,7 +45,7 @@ static zend_object *signalforge_validator_create(zend_class_entry *ce)
 {
     signalforge_validator_t *intern = zend_object_alloc(sizeof(signalforge_validator_t), ce);
 
-    intern->rules = NULL;
+    intern->program = NULL;
 
     ALLOC_HASHTABLE(intern->regex_cache);
     zend_hash_init(intern->regex_cache, 8, NULL, free_cached_regex, 0);
@@ -57,9 +62,9 @@ static void signalforge_validator_free(zend_object *object)
 {
     signalforge_validator_t *intern = signalforge_validator_from_obj(object);
 
-    if (intern->rules) {
-        sf_free_parsed_rules_ht(intern->rules);
-        intern->rules = NULL;
+    if (intern->program) {
+        sf_free_program(intern->program);
+        intern->program = NULL;
     }
 
     if (intern->regex_cache) {
@@ -180,111 +185,1020 @@ cached_regex_t *sf_get_or_compile_regex(
     return cached;
 }
 
-/* Validate a single field against its rules */
-static void validate_field(
-    signalforge_validator_t *validator,
-    sf_field_rules_t *field_rules,
-    zval *value,
-    HashTable *data,
-    HashTable *errors,
-    HashTable *validated,
-    const char *actual_field_name,
-    size_t actual_field_len
+/* Dispatch one rule, recording its cost and outcome */
+static zend_never_inline sf_rule_result_t sf_run_profiled(
+    sf_validation_context_t *ctx,
+    uint32_t op,
+    sf_parsed_rule_t *rule,
+    sf_insn_profile_t *stats
 )
 {
-    sf_validation_context_t ctx;
-    ctx.validator = validator;
-    ctx.data = data;
-    ctx.field_name = actual_field_name;
-    ctx.field_len = actual_field_len;
-    ctx.value = value;
-    ctx.errors = errors;
-    ctx.has_nullable = 0;
-    ctx.is_null_or_empty = sf_is_empty(value);
-    ctx.bail = 0;
+    php_hrtime_t start = php_hrtime_current();
+    sf_rule_result_t result = sf_rule_handlers[op](ctx, rule);
 
-    /* Check for nullable rule first */
-    for (size_t i = 0; i < field_rules->rule_count; i++) {
-        if (field_rules->rules[i]->type == RULE_NULLABLE) {
-            ctx.has_nullable = 1;
-            break;
+    stats->time += php_hrtime_current() - start;
+    stats->runs++;
+    if (result == RULE_FAIL) {
+        stats->fails++;
+    }
+
+    return result;
+}
+
+/* Discriminator value of a variant, NULL if absent */
+static zval *variant_subject(const sf_parsed_rule_t *variant, sf_validation_context_t *ctx)
+{
+    zval *subject = sf_path_resolve_at(&variant->params.variant.path, ctx->data, ctx->frames);
+
+    if (!subject && variant->params.variant.key && ctx->data) {
+        subject = zend_hash_find(ctx->data, variant->params.variant.key);
+    }
+    return subject;
+}
+
+/*
+ * First case from case number `from` on whose value is loosely equal (==)
+ * to the subject; case_count if none is.
+ */
+static uint32_t variant_scan(const sf_parsed_rule_t *variant, zval *subject, uint32_t from)
+{
+    zend_ulong h;
+    zend_string *key;
+    zval *num;
+
+    ZEND_HASH_FOREACH_KEY_VAL(variant->params.variant.cases, h, key, num) {
+        if ((uint32_t)Z_LVAL_P(num) < from) {
+            continue;
+        }
+
+        zval value;
+        if (key) {
+            ZVAL_STR(&value, key);
+        } else {
+            ZVAL_LONG(&value, (zend_long)h);
         }
+        if (zend_compare(subject, &value) == 0) {
+            return (uint32_t)Z_LVAL_P(num);
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    return variant->params.variant.case_count;
+}
+
+/* Chain outcome flags returned by sf_run_program() */
+#define SF_RUN_FAILED   (1 << 0)   /* A rule failed */
+#define SF_RUN_STOPPED  (1 << 1)   /* Skip or bail cut the chain short */
+
+static uint8_t sf_run_program(
+    sf_validation_context_t *ctx,
+    const sf_program_t *prog,
+    uint32_t pc,
+    uint32_t end,
+    sf_insn_profile_t *profile,
+    bool generic
+);
+
+/* Append the errors collected in from to errors, field by field */
+static void merge_errors(HashTable *errors, HashTable *from)
+{
+    zend_string *field;
+    zval *list;
+
+    ZEND_HASH_FOREACH_STR_KEY_VAL(from, field, list) {
+        zval *target = zend_hash_find(errors, field);
+        if (!target) {
+            zval empty;
+            array_init(&empty);
+            target = zend_hash_add(errors, field, &empty);
+        }
+
+        zval *entry;
+        ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(list), entry) {
+            Z_TRY_ADDREF_P(entry);
+            add_next_index_zval(target, entry);
+        } ZEND_HASH_FOREACH_END();
+    } ZEND_HASH_FOREACH_END();
+}
+
+/*
+ * Run a combinator's branches in order, stopping at the first one that
+ * decides the outcome: a failing branch for all_of, a passing one for
+ * any_of and none_of. A branch passes if none of its rules failed; a skip
+ * (nullable on an empty value) ends only that branch.
+ *
+ * all_of reports the failing branch's errors. any_of reports every
+ * branch's errors, and only if none passed; none_of reports its own.
+ *
+ * A branch any_of does not take, and every none_of branch, leaves no
+ * trace: an enum cast or exclude_if mark it made is undone. Rules with
+ * effects that outlast the chain (schema, collection rules) are rejected
+ * in those branches by the parser.
+ */
+static sf_rule_result_t run_combinator(
+    sf_validation_context_t *ctx,
+    const sf_program_t *prog,
+    const sf_parsed_rule_t *combinator,
+    sf_insn_profile_t *profile,
+    bool generic
+)
+{
+    const uint32_t *starts = combinator->params.combinator.starts;
+    uint32_t count = combinator->params.combinator.branch_count;
+
+    if (combinator->type == RULE_ALL_OF) {
+        for (uint32_t k = 0; k < count; k++) {
+            if (sf_run_program(ctx, prog, starts[k], starts[k + 1], profile, generic) & SF_RUN_FAILED) {
+                return RULE_FAIL;
+            }
+        }
+        return RULE_PASS;
     }
 
-    /* Execute each rule */
-    bool has_error = 0;
-    for (size_t i = 0; i < field_rules->rule_count; i++) {
-        sf_parsed_rule_t *rule = field_rules->rules[i];
-
-        /* Handle conditional rules via the shared helper so nested when
-         * rules (when-inside-then) actually execute. */
-        if (rule->type == RULE_WHEN) {
-            sf_rule_result_t wresult = sf_execute_conditional(&ctx, rule, 0);
-            if (wresult == RULE_FAIL) {
-                has_error = 1;
-                if (ctx.bail) break;
-            } else if (wresult == RULE_SKIP) {
-                break;
+    /* Branch errors wait aside until the outcome is known */
+    HashTable *errors = ctx->errors;
+    HashTable pending;
+    zend_hash_init(&pending, 8, NULL, ZVAL_PTR_DTOR, 0);
+    ctx->errors = &pending;
+
+    /* What the chain had set before the branches, to restore after a dropped one */
+    zval output;
+    ZVAL_COPY(&output, &ctx->output);
+    bool excluded = ctx->excluded;
+
+    bool passed = 0;
+    for (uint32_t k = 0; k < count && !passed; k++) {
+        passed = !(sf_run_program(ctx, prog, starts[k], starts[k + 1], profile, generic) & SF_RUN_FAILED);
+
+        if (!passed || combinator->type == RULE_NONE_OF) {
+            zval_ptr_dtor(&ctx->output);
+            ZVAL_COPY(&ctx->output, &output);
+            ctx->excluded = excluded;
+        }
+    }
+
+    zval_ptr_dtor(&output);
+    ctx->errors = errors;
+
+    sf_rule_result_t result = RULE_PASS;
+    if (combinator->type == RULE_ANY_OF && !passed) {
+        merge_errors(errors, &pending);
+        result = RULE_FAIL;
+    } else if (combinator->type == RULE_NONE_OF && passed) {
+        sf_add_error(ctx, "validation.none_of");
+        result = RULE_FAIL;
+    }
+
+    zend_hash_destroy(&pending);
+    return result;
+}
+
+/*
+ * Interpreter loop: run instructions [pc, end) against the context value.
+ *
+ * Rule opcodes (including superinstructions and specialized variants)
+ * dispatch straight through the handler table; branches and jumps
+ * implement compiled 'when' rules, dispatches compiled variants, and
+ * combinators run their branches through run_combinator(). A
+ * RULE_SKIP result stops the whole chain (including from inside a branch),
+ * as does a failure when bail is set. With `profile` set, every rule's
+ * cost and outcome are recorded.
+ *
+ * Specialized variants assume their guard established the value type.
+ * That does not hold once a guard failed, nor for a nullable empty value
+ * (every guard passes it untyped); `generic` selects the generic rule then.
+ *
+ * Returns SF_RUN_* flags.
+ */
+static uint8_t sf_run_program(
+    sf_validation_context_t *ctx,
+    const sf_program_t *prog,
+    uint32_t pc,
+    uint32_t end,
+    sf_insn_profile_t *profile,
+    bool generic
+)
+{
+    const sf_insn_t *code = prog->code;
+    sf_parsed_rule_t *params = prog->params;
+    uint8_t status = 0;
+
+    while (pc < end) {
+        const sf_insn_t *insn = &code[pc];
+
+        if (EXPECTED(SF_OP_IS_RULE(insn->op))) {
+            uint32_t op = insn->op;
+            if (UNEXPECTED(generic) && (insn->flags & SF_INSN_SPECIALIZED)) {
+                op = insn->b;
             }
+
+            sf_rule_result_t result = UNEXPECTED(profile)
+                ? sf_run_profiled(ctx, op, &params[insn->a], &profile[pc])
+                : sf_rule_handlers[op](ctx, &params[insn->a]);
+            if (result == RULE_FAIL) {
+                status |= SF_RUN_FAILED;
+                if (insn->flags & SF_INSN_GUARD) {
+                    generic = 1;
+                }
+                if (ctx->bail) {
+                    return status | SF_RUN_STOPPED;
+                }
+            } else if (result == RULE_SKIP) {
+                return status | SF_RUN_STOPPED;
+            }
+            pc++;
             continue;
         }
 
-        sf_rule_result_t result = sf_execute_rule(&ctx, rule);
-        if (result == RULE_FAIL) {
-            has_error = 1;
-            if (ctx.bail) break;
-        } else if (result == RULE_SKIP) {
-            break;
+        switch (insn->op) {
+            case SF_OP_BRANCH:
+                if (sf_evaluate_condition_memo(
+                        params[insn->a].params.conditional.condition,
+                        ctx->memo,
+                        ctx->value,
+                        &ctx->analysis,
+                        ctx->data,
+                        ctx->frames,
+                        ctx->field_name,
+                        ctx->validator)) {
+                    pc++;
+                } else {
+                    pc = insn->b;
+                }
+                break;
+
+            case SF_OP_JUMP:
+                pc = insn->a;
+                break;
+
+            case SF_OP_DISPATCH: {
+                const sf_parsed_rule_t *variant = &params[insn->a];
+                const uint32_t *starts = variant->params.variant.starts;
+                uint32_t count = variant->params.variant.case_count;
+                zval *subject = variant_subject(variant, ctx);
+                uint32_t k = count;
+                bool scanned = 0;
+
+                if (subject) {
+                    zval *member;
+                    sf_set_result_t found = variant->params.variant.set
+                        ? sf_value_set_find(variant->params.variant.set, subject, &member)
+                        : SF_SET_UNKNOWN;
+
+                    if (found == SF_SET_HIT) {
+                        k = (uint32_t)Z_LVAL_P(member);
+                    } else if (found == SF_SET_UNKNOWN) {
+                        k = variant_scan(variant, subject, 0);
+                        scanned = 1;
+                    }
+                }
+
+                /* A hashed lookup matches at most one case */
+                if (!scanned || k == count || !variant->params.variant.all_matches) {
+                    pc = starts[k];
+                    break;
+                }
+
+                /*
+                 * A lowered 'when' chain runs every case equal to the value;
+                 * a boolean or null can equal several. Each case block ends
+                 * in the jump past the variant, so run them one at a time.
+                 */
+                while (k < count) {
+                    status |= sf_run_program(ctx, prog, starts[k], starts[k + 1] - 1, profile, generic);
+                    if (status & SF_RUN_STOPPED) {
+                        return status;
+                    }
+                    k = variant_scan(variant, subject, k + 1);
+                }
+                pc = variant->params.variant.end;
+                break;
+            }
+
+            case SF_OP_COMBINE: {
+                const sf_parsed_rule_t *combinator = &params[insn->a];
+
+                if (run_combinator(ctx, prog, combinator, profile, generic) == RULE_FAIL) {
+                    status |= SF_RUN_FAILED;
+                    if (ctx->bail) {
+                        return status | SF_RUN_STOPPED;
+                    }
+                }
+                pc = combinator->params.combinator.starts[combinator->params.combinator.branch_count];
+                break;
+            }
+
+            default:
+                pc++;
+                break;
         }
     }
 
-    /* Add to validated if no errors */
-    if (!has_error && value) {
+    return status;
+}
+
+/* A schema validation queued by a 'schema' rule */
+typedef struct {
+    uint32_t schema;        /* Index into the schema table */
+    zval *value;            /* Array to validate, owned by the input data */
+    zend_string *path;      /* Path of the value, prefixed to the schema's field names */
+    uint32_t depth;         /* Schema nesting of the value */
+} sf_schema_item_t;
+
+/*
+ * Explicit traversal stack of schema validations. 'schema' rules push
+ * their value while a program runs; validate() pops and runs them one at
+ * a time afterwards, so nested and recursive schemas cost no C recursion
+ * however deep the data goes.
+ */
+struct sf_schema_stack_s {
+    sf_schema_item_t *items;
+    uint32_t count;
+    uint32_t cap;
+    uint32_t depth;         /* Nesting of the program running now (0: top level) */
+    uint32_t runs;          /* Values queued during this call */
+};
+
+/* Queue a schema validation */
+bool sf_push_schema(sf_schema_stack_t *stack, uint32_t schema, zval *value, const char *name, size_t len)
+{
+    if (stack->depth >= SF_MAX_SCHEMA_DEPTH || stack->runs >= SF_MAX_SCHEMA_RUNS) {
+        return 0;
+    }
+
+    if (stack->count == stack->cap) {
+        stack->cap = stack->cap ? stack->cap * 2 : 8;
+        stack->items = safe_erealloc(stack->items, stack->cap, sizeof(sf_schema_item_t), 0);
+    }
+
+    sf_schema_item_t *item = &stack->items[stack->count++];
+    item->schema = schema;
+    item->value = value;
+    item->path = zend_string_init(name, len, 0);
+    item->depth = stack->depth + 1;
+
+    stack->runs++;
+    return 1;
+}
+
+/* Reverse items [from, count), so they pop in the order they were pushed */
+static void reverse_schemas(sf_schema_stack_t *stack, uint32_t from)
+{
+    uint32_t lo = from;
+    uint32_t hi = stack->count;
+
+    while (hi > lo + 1) {
+        sf_schema_item_t tmp = stack->items[lo];
+        stack->items[lo++] = stack->items[--hi];
+        stack->items[hi] = tmp;
+    }
+}
+
+/* State shared by the fields of one program run */
+typedef struct {
+    signalforge_validator_t *validator;
+    sf_program_t *program;
+    HashTable *data;
+    HashTable *errors;
+    HashTable *validated;
+    uint8_t *memo;
+    const uint64_t *presence;       /* Presence facts of this run */
+    sf_schema_stack_t *schemas;
+    sf_aggregate_t *aggregates;     /* During a walk whose program has collection rules */
+} sf_field_visit_t;
+
+/*
+ * Validate a single field against its compiled rule chain. Returns the
+ * field's SF_FIELD_* state.
+ */
+static uint8_t validate_field(
+    const sf_field_visit_t *run,
+    const sf_field_program_t *field,
+    zval *value,
+    const char *actual_field_name,
+    size_t actual_field_len,
+    zval *const *frames
+)
+{
+    /* 'sometimes': an absent field is not validated */
+    if (field->sometimes && !value) {
+        return SF_FIELD_SKIPPED;
+    }
+
+    sf_validation_context_t ctx;
+    ctx.validator = run->validator;
+    ctx.data = run->data;
+    ctx.field_name = actual_field_name;
+    ctx.field_len = actual_field_len;
+    ctx.value = value;
+    ctx.analysis.known = 0;
+    ctx.errors = run->errors;
+    ctx.has_nullable = field->has_nullable;
+    ctx.is_null_or_empty = sf_is_empty(value);
+    ctx.bail = field->bail;
+    ctx.memo = run->memo;
+    ctx.frames = frames;
+    ctx.schemas = run->schemas;
+    ctx.aggregates = run->aggregates;
+    ZVAL_UNDEF(&ctx.output);
+    ctx.presence = run->presence;
+    ctx.excluded = 0;
+
+    /* Hoisted leading nullable: nothing to run for a null/empty value */
+    bool has_error = 0;
+    if (!(field->skip_empty && ctx.is_null_or_empty)) {
+        const sf_program_t *prog = run->program;
+
+        /* Only bail fields are reordered, so only they are profiled */
+        sf_insn_profile_t *profile = prog->profiling && field->bail ? prog->profile : NULL;
+
+        has_error = sf_run_program(&ctx, prog, field->start, field->end, profile,
+            ctx.has_nullable && ctx.is_null_or_empty) & SF_RUN_FAILED;
+    }
+
+    /* Add to validated if no errors and not dropped by exclude_if */
+    if (!has_error && value && !ctx.excluded) {
         zend_string *key = zend_string_init(actual_field_name, actual_field_len, 0);
         zval copy;
-        ZVAL_COPY(&copy, value);
+        if (Z_ISUNDEF(ctx.output)) {
+            ZVAL_COPY(&copy, value);
+        } else {
+            ZVAL_COPY_VALUE(&copy, &ctx.output);
+            ZVAL_UNDEF(&ctx.output);
+        }
 
         /* On duplicate key (wildcard expansion can produce overlapping paths
          * via reference cycles in input data), zend_hash_add returns NULL
          * and `copy` would leak. (audit #31) */
-        if (zend_hash_add(validated, key, &copy) == NULL) {
+        if (zend_hash_add(run->validated, key, &copy) == NULL) {
             zval_ptr_dtor(&copy);
         }
 
         zend_string_release(key);
     }
+    zval_ptr_dtor(&ctx.output);
+
+    return has_error ? SF_FIELD_FAILED : SF_FIELD_PASSED;
+}
+
+/* Validate one element matched by a wildcard field; descend only if it passed */
+static bool visit_element(void *arg, uint32_t field, zval *value, const sf_path_cursor_t *cursor)
+{
+    sf_field_visit_t *visit = arg;
+
+    return validate_field(
+        visit,
+        &visit->program->fields[field],
+        value,
+        cursor->buf,
+        cursor->len,
+        cursor->frames
+    ) == SF_FIELD_PASSED;
+}
+
+/* Make room for memo slots added by fields compiled during this call */
+static uint8_t *reserve_memo(uint8_t *memo, uint8_t *memo_stack, uint32_t *cap, uint32_t count)
+{
+    if (count <= *cap) {
+        return memo;
+    }
+
+    uint8_t *grown = ecalloc(count, sizeof(uint8_t));
+    memcpy(grown, memo, *cap);
+    if (memo != memo_stack) {
+        efree(memo);
+    }
+
+    *cap = count;
+    return grown;
+}
+
+/*
+ * Compute the presence facts added since the last call (all of them on
+ * the first) and make room for them in the run's bitmap. Each fact is one
+ * lookup of a root-anchored field, however many rules test it.
+ */
+static uint64_t *reserve_facts(
+    const sf_program_t *prog,
+    HashTable *data,
+    uint64_t *bits,
+    uint64_t *bits_stack,
+    uint32_t *cap,
+    uint32_t *done
+)
+{
+    uint32_t words = (prog->fact_count + 63) / 64;
+
+    if (words > *cap) {
+        uint64_t *grown = ecalloc(words, sizeof(uint64_t));
+        memcpy(grown, bits, *cap * sizeof(uint64_t));
+        if (bits != bits_stack) {
+            efree(bits);
+        }
+        bits = grown;
+        *cap = words;
+    }
+
+    for (uint32_t f = *done; f < prog->fact_count; f++) {
+        const sf_presence_fact_t *fact = &prog->facts[f];
+        zval *value = sf_path_resolve(&fact->path, data);
+        bool set;
+
+        if (fact->param) {
+            const sf_parsed_rule_t *rule = &prog->params[fact->param];
+            set = value && sf_value_set_contains(rule->params.presence.set, rule->params.presence.values,
+                SF_SET_LOOSE, value);
+        } else {
+            set = sf_is_filled(value);
+        }
+
+        if (set) {
+            bits[f / 64] |= (uint64_t)1 << (f % 64);
+        }
+    }
+
+    *done = prog->fact_count;
+    return bits;
+}
+
+/*
+ * Check the totals of a walk group's collection rules once the walk is
+ * over, then reset the accumulators. Totals are reported under the
+ * field's pattern ("items.*.qty"), below prefix in a schema program.
+ */
+static void finish_aggregates(
+    sf_field_visit_t *visit,
+    uint32_t group,
+    zend_string *prefix,
+    sf_path_cursor_t *cursor
+)
+{
+    const sf_program_t *prog = visit->program;
+
+    sf_validation_context_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.validator = visit->validator;
+    ctx.data = visit->data;
+    ctx.errors = visit->errors;
+    ctx.aggregates = visit->aggregates;
+
+    for (uint32_t i = 0; i < prog->field_count; i++) {
+        const sf_field_program_t *field = &prog->fields[i];
+
+        if (!field->has_aggregates || field->walk_group != group) {
+            continue;
+        }
+
+        ctx.field_name = field->name;
+        ctx.field_len = field->name_len;
+        if (prefix) {
+            if (!sf_path_cursor_field(cursor, field->name, field->name_len)) {
+                continue;
+            }
+            ctx.field_name = cursor->buf;
+            ctx.field_len = cursor->len;
+        }
+
+        for (uint32_t pc = field->start; pc < field->end; pc++) {
+            const sf_insn_t *insn = &prog->code[pc];
+            if (insn->op == RULE_SUM_MIN || insn->op == RULE_SUM_MAX) {
+                sf_aggregate_finish(&ctx, &prog->params[insn->a]);
+            }
+        }
+    }
+
+    for (uint32_t k = 0; k < prog->aggregate_count; k++) {
+        sf_aggregate_release(&visit->aggregates[k]);
+    }
+}
+
+/* Root slot of a data key, or SF_NO_FIELD if no field starts with it */
+static uint32_t root_slot(const sf_program_t *prog, zend_string *key, zend_ulong index)
+{
+    zval *slot = key ? zend_hash_find(prog->roots, key) : zend_hash_index_find(prog->roots, index);
+    return slot ? (uint32_t)Z_LVAL_P(slot) : SF_NO_FIELD;
+}
+
+static int compare_positions(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void swap_positions(void *a, void *b)
+{
+    uint32_t t = *(uint32_t *)a;
+    *(uint32_t *)a = *(uint32_t *)b;
+    *(uint32_t *)b = t;
+}
+
+/*
+ * Plan a data-driven run: the positions in prog->order to run, in run
+ * order. The data's keys reach the fields below each first segment they
+ * match (marked in present); '*' fields always run, and of the fields
+ * below absent first segments only the absent-reporting list. Returns
+ * the list (run_stack, or allocated if it holds too few) and its length
+ * through *len.
+ */
+static uint32_t *plan_run(const sf_program_t *prog, HashTable *data, uint8_t *present, uint32_t *run_stack, uint32_t *len)
+{
+    zend_string *key;
+    zend_ulong index;
+
+    /* '*' fields and the absent list bound what the roots do not reach */
+    size_t cap = prog->root_start[prog->root_count + 1] - prog->root_start[prog->root_count] + prog->absent_count;
+    ZEND_HASH_FOREACH_KEY(data, index, key) {
+        uint32_t slot = root_slot(prog, key, index);
+        if (slot != SF_NO_FIELD) {
+            present[slot] = 1;
+            cap += prog->root_start[slot + 1] - prog->root_start[slot];
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    uint32_t *run = run_stack;
+    if (cap > SF_RUN_STACK_SLOTS) {
+        run = safe_emalloc(cap, sizeof(uint32_t), 0);
+    }
+
+    uint32_t n = 0;
+    ZEND_HASH_FOREACH_KEY(data, index, key) {
+        uint32_t slot = root_slot(prog, key, index);
+        if (slot != SF_NO_FIELD) {
+            for (uint32_t e = prog->root_start[slot]; e < prog->root_start[slot + 1]; e++) {
+                run[n++] = prog->root_fields[e];
+            }
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    for (uint32_t e = prog->root_start[prog->root_count]; e < prog->root_start[prog->root_count + 1]; e++) {
+        run[n++] = prog->root_fields[e];
+    }
+
+    for (uint32_t a = 0; a < prog->absent_count; a++) {
+        uint32_t o = prog->absent_fields[a];
+        if (!present[prog->fields[prog->order[o]].root]) {
+            run[n++] = o;
+        }
+    }
+
+    /* Parents first and errors in declaration order, as in a rule-driven run */
+    zend_sort(run, n, sizeof(uint32_t), compare_positions, swap_positions);
+
+    *len = n;
+    return run;
+}
+
+/* Lazy mode: compile every pending field of a walk subtree */
+static bool compile_subtree(sf_program_t *prog, const sf_walk_node_t *node)
+{
+    for (uint32_t i = 0; i < node->field_count; i++) {
+        if (!sf_compile_field(prog, node->fields[i])) {
+            return 0;
+        }
+    }
+    for (uint32_t i = 0; i < node->child_count; i++) {
+        if (!compile_subtree(prog, &node->children[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Run every field of a program against data, parents first. For a schema
+ * program, prefix is the path of data within the input: field names are
+ * reported below it. The cursor is shared by all runs of a validate()
+ * call and set up on first use.
+ *
+ * Every scheduled field runs in turn (rule-driven), unless the data has
+ * far fewer keys than the program has fields, as in a sparse PATCH
+ * against a large schema. The run is then data-driven (see plan_run()):
+ * the data's keys reach the fields below the first segments they match,
+ * and of the fields below absent ones only those that can report on an
+ * absent value run, without a lookup. The others ('sometimes', a leading
+ * nullable, or below an absent 'sometimes' field) cost nothing, and in
+ * lazy mode are not compiled.
+ *
+ * Returns 0 with an InvalidRuleException thrown if a lazy field failed to
+ * compile.
+ */
+static bool run_fields(
+    sf_field_visit_t *visit,
+    sf_program_t *prog,
+    HashTable *data,
+    zend_string *prefix,
+    sf_path_cursor_t *cursor,
+    bool *has_cursor
+)
+{
+    sf_prepare_program(prog);
+
+    if (prefix) {
+        if (!*has_cursor) {
+            sf_path_cursor_init(cursor);
+            *has_cursor = 1;
+        }
+
+        /* Paths that would exceed the length limit are skipped, as in sf_walk_trie() */
+        if (!sf_path_cursor_rebase(cursor, ZSTR_VAL(prefix), ZSTR_LEN(prefix))) {
+            return 1;
+        }
+    }
+
+    /* Invariant condition results, valid for this run only */
+    uint8_t memo_stack[SF_MEMO_STACK_SLOTS];
+    uint8_t *memo = memo_stack;
+    uint32_t memo_cap = SF_MEMO_STACK_SLOTS;
+    if (prog->memo_count > SF_MEMO_STACK_SLOTS) {
+        memo = ecalloc(prog->memo_count, sizeof(uint8_t));
+        memo_cap = prog->memo_count;
+    } else {
+        memset(memo_stack, SF_MEMO_UNKNOWN, sizeof(memo_stack));
+    }
+
+    /* Presence facts, computed up front for the fields compiled so far */
+    uint64_t facts_stack[SF_PRESENCE_STACK_WORDS] = {0};
+    uint32_t facts_cap = SF_PRESENCE_STACK_WORDS;
+    uint32_t facts_done = 0;
+    uint64_t *facts = reserve_facts(prog, data, facts_stack, facts_stack, &facts_cap, &facts_done);
+
+    /* Data-driven: first segments the data has a key for, and the fields to run */
+    uint8_t present_stack[SF_ROOT_STACK_SLOTS];
+    uint8_t *present = NULL;
+    uint32_t run_stack[SF_RUN_STACK_SLOTS];
+    uint32_t *run = NULL;
+    uint32_t run_len = prog->order_len;
+    if (prog->root_count > 0
+        && (uint64_t)zend_hash_num_elements(data) * SF_DATA_DRIVEN_RATIO < prog->field_count) {
+        present = present_stack;
+        if (prog->root_count > SF_ROOT_STACK_SLOTS) {
+            present = ecalloc(prog->root_count, sizeof(uint8_t));
+        } else {
+            memset(present_stack, 0, sizeof(present_stack));
+        }
+        run = plan_run(prog, data, present, run_stack, &run_len);
+        prog->data_driven_runs++;
+    } else {
+        prog->rule_driven_runs++;
+    }
+
+    /* Lazy mode: a field failed to compile and threw */
+    bool aborted = 0;
+
+    /* Plain field outcomes, gating the fields below them */
+    uint8_t states_stack[SF_FIELD_STATE_STACK_SLOTS];
+    uint8_t *states = states_stack;
+    if (prog->field_count > SF_FIELD_STATE_STACK_SLOTS) {
+        states = ecalloc(prog->field_count, sizeof(uint8_t));
+    } else {
+        memset(states_stack, SF_FIELD_PASSED, sizeof(states_stack));
+    }
+
+    visit->program = prog;
+    visit->data = data;
+    visit->memo = memo;
+    visit->presence = facts;
+
+    /* Strict: undeclared top-level keys, in one pass over the data's keys */
+    if (prog->strict_keys) {
+        sf_validation_context_t ctx;
+        memset(&ctx, 0, sizeof(ctx));
+        ctx.validator = visit->validator;
+        ctx.data = data;
+        ctx.errors = visit->errors;
+        if (prefix) {
+            ctx.field_name = ZSTR_VAL(prefix);
+            ctx.field_len = ZSTR_LEN(prefix);
+        } else {
+            ctx.field_name = "";
+        }
+        sf_report_undeclared_keys(&ctx, data, prog->strict_keys);
+    }
+
+    /* Run each field's compiled rule chain, parents first */
+    for (uint32_t k = 0; k < run_len; k++) {
+        uint32_t i = prog->order[run ? run[k] : k];
+        const sf_field_program_t *field = &prog->fields[i];
+
+        if (field->has_wildcard) {
+            const sf_walk_node_t *group = &prog->walk.children[field->walk_group];
+
+            /* Lazy: compile the group only if the walk can reach an element */
+            if (prog->options.lazy) {
+                if (group->gate != SF_NO_FIELD && states[group->gate]) {
+                    continue;
+                }
+                zval *top = zend_hash_find(data, group->segment.key);
+                if (!top && group->segment.is_index) {
+                    top = zend_hash_index_find(data, group->segment.index);
+                }
+                if (!top || Z_TYPE_P(top) != IS_ARRAY) {
+                    continue;
+                }
+                if (!compile_subtree(prog, group)) {
+                    aborted = 1;
+                    break;
+                }
+                memo = visit->memo = reserve_memo(memo, memo_stack, &memo_cap, prog->memo_count);
+                facts = reserve_facts(prog, data, facts, facts_stack, &facts_cap, &facts_done);
+                visit->presence = facts;
+            }
+
+            /* The group's leader runs every field of the group */
+            if (!*has_cursor) {
+                sf_path_cursor_init(cursor);
+                *has_cursor = 1;
+            }
+
+            /* Collection rules accumulate over the whole walk */
+            if (prog->aggregate_count > 0) {
+                visit->aggregates = ecalloc(prog->aggregate_count, sizeof(sf_aggregate_t));
+            }
+
+            sf_walk_trie(&prog->walk, field->walk_group, data, states, cursor, visit_element, visit);
+
+            if (visit->aggregates) {
+                finish_aggregates(visit, field->walk_group, prefix, cursor);
+                efree(visit->aggregates);
+                visit->aggregates = NULL;
+            }
+        } else {
+            uint8_t parent = field->parent != SF_NO_FIELD ? states[field->parent] : SF_FIELD_PASSED;
+
+            /* Below an absent 'sometimes' field: the whole subtree is skipped */
+            if (parent == SF_FIELD_SKIPPED) {
+                states[i] = SF_FIELD_SKIPPED;
+                continue;
+            }
+
+            /* Schema fields are named below the schema value's path */
+            const char *name = field->name;
+            size_t name_len = field->name_len;
+            if (prefix) {
+                if (!sf_path_cursor_field(cursor, field->name, field->name_len)) {
+                    states[i] = SF_FIELD_SKIPPED;
+                    continue;
+                }
+                name = cursor->buf;
+                name_len = cursor->len;
+            }
+
+            /* Simple field - get value from data, unless its first segment is known absent */
+            zval *value = NULL;
+            if (!present || field->root == SF_NO_FIELD || present[field->root]) {
+                value = sf_path_resolve(&field->path, data);
+            }
+
+            /* Lazy: compile on first run (an absent 'sometimes' field does not run) */
+            if (SF_FIELD_PENDING(field) && !(field->sometimes && !value)) {
+                if (!sf_compile_field(prog, i)) {
+                    aborted = 1;
+                    break;
+                }
+                memo = visit->memo = reserve_memo(memo, memo_stack, &memo_cap, prog->memo_count);
+                facts = reserve_facts(prog, data, facts, facts_stack, &facts_cap, &facts_done);
+                visit->presence = facts;
+            }
+
+            uint8_t state = validate_field(visit, field, value, name, name_len, NULL);
+
+            /* A failed ancestor still closes the wildcard fields below this one */
+            states[i] = MAX(state, parent);
+        }
+    }
+
+    if (states != states_stack) {
+        efree(states);
+    }
+
+    if (memo != memo_stack) {
+        efree(memo);
+    }
+
+    if (facts != facts_stack) {
+        efree(facts);
+    }
+
+    if (present && present != present_stack) {
+        efree(present);
+    }
+
+    if (run && run != run_stack) {
+        efree(run);
+    }
+
+    return !aborted;
+}
+
+/*
+ * Parse the Validator options array.
+ *
+ * Supported keys:
+ *   'optimize' => bool   Run the rule-chain optimizer (default true)
+ *   'bail'     => bool   Stop every field at its first failure (default false)
+ *   'profile'  => bool   Record rule statistics and periodically reorder
+ *                        bail fields by them (default false)
+ *   'lazy'     => bool   Check field names only; compile each field the
+ *                        first time validate() runs it (default false)
+ *   'strict'   => bool   Report top-level keys no field declares (default false)
+ *   'schemas'  => array  Named sub-schemas, name => field rules, for the
+ *                        'schema' rule (set in *schemas, NULL if absent)
+ *
+ * Returns 0 with an InvalidRuleException thrown on an unknown option.
+ */
+static bool sf_parse_options(HashTable *options_array, sf_compile_options_t *options, HashTable **schemas)
+{
+    options->optimize = 1;
+    options->bail = 0;
+    options->profile = 0;
+    options->lazy = 0;
+    options->strict = 0;
+    *schemas = NULL;
+
+    if (!options_array) {
+        return 1;
+    }
+
+    zend_string *key;
+    zval *value;
+    ZEND_HASH_FOREACH_STR_KEY_VAL(options_array, key, value) {
+        if (!key) {
+            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                "Option names must be strings");
+            return 0;
+        }
+
+        if (zend_string_equals_literal(key, "optimize")) {
+            options->optimize = zend_is_true(value);
+        } else if (zend_string_equals_literal(key, "bail")) {
+            options->bail = zend_is_true(value);
+        } else if (zend_string_equals_literal(key, "profile")) {
+            options->profile = zend_is_true(value);
+        } else if (zend_string_equals_literal(key, "lazy")) {
+            options->lazy = zend_is_true(value);
+        } else if (zend_string_equals_literal(key, "strict")) {
+            options->strict = zend_is_true(value);
+        } else if (zend_string_equals_literal(key, "schemas")) {
+            if (Z_TYPE_P(value) != IS_ARRAY) {
+                zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                    "Option 'schemas' must be an array");
+                return 0;
+            }
+            *schemas = Z_ARRVAL_P(value);
+        } else {
+            zend_throw_exception_ex(signalforge_invalid_rule_exception_ce, 0,
+                "Unknown validator option: %s", ZSTR_VAL(key));
+            return 0;
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    return 1;
 }
 
-/* PHP Method: Validator::__construct(array $rules) */
+/* PHP Method: Validator::__construct(array $rules, array $options = []) */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_validator_construct, 0, 0, 1)
     ZEND_ARG_ARRAY_INFO(0, rules, 0)
+    ZEND_ARG_ARRAY_INFO(0, options, 0)
 ZEND_END_ARG_INFO()
 
 PHP_METHOD(Validator, __construct)
 {
     HashTable *rules_array;
+    HashTable *options_array = NULL;
 
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    ZEND_PARSE_PARAMETERS_START(1, 2)
         Z_PARAM_ARRAY_HT(rules_array)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_ARRAY_HT(options_array)
     ZEND_PARSE_PARAMETERS_END();
 
+    sf_compile_options_t options;
+    HashTable *schemas;
+    if (!sf_parse_options(options_array, &options, &schemas)) {
+        RETURN_THROWS();
+    }
+
     signalforge_validator_t *intern = Z_SIGNALFORGE_VALIDATOR_P(ZEND_THIS);
 
-    /* Free any existing rules — userland can call __construct() twice (or
+    /* Free any existing program — userland can call __construct() twice (or
      * extension-loaded classes get re-constructed via reflection). Without
-     * this, the previously parsed rules HashTable, all field rules, all
-     * parsed_rule structs, and condition trees would leak. */
-    if (intern->rules) {
-        sf_free_parsed_rules_ht(intern->rules);
-        intern->rules = NULL;
+     * this, the previously compiled program and its parameters would leak. */
+    if (intern->program) {
+        sf_free_program(intern->program);
+        intern->program = NULL;
     }
 
     /* Parse rules */
-    intern->rules = sf_parse_rules(rules_array);
-    if (!intern->rules) {
+    HashTable *parsed_rules = options.lazy
+        ? sf_parse_rules_deferred(rules_array)
+        : sf_parse_rules(rules_array);
+    if (!parsed_rules) {
         /* Exception was thrown by sf_parse_rules */
         return;
     }
+
+    /* Compile into a flat program; the parse tree is consumed */
+    intern->program = sf_compile_rules(parsed_rules, schemas, &options);
 }
 
 /* PHP Method: Validator::validate(array $data): ValidationResult */
@@ -302,7 +1216,7 @@ PHP_METHOD(Validator, validate)
 
     signalforge_validator_t *intern = Z_SIGNALFORGE_VALIDATOR_P(ZEND_THIS);
 
-    if (!intern->rules) {
+    if (!intern->program) {
         zend_throw_exception(signalforge_invalid_rule_exception_ce,
             "Validator not properly initialized", 0);
         RETURN_THROWS();
@@ -320,62 +1234,152 @@ PHP_METHOD(Validator, validate)
 
     result->is_valid = 1;
 
-    /* Iterate over each field's rules */
-    sf_field_rules_t *field_rules;
-    ZEND_HASH_FOREACH_PTR(intern->rules, field_rules) {
-        /* Check for wildcards */
-        if (sf_has_wildcard(field_rules->field_name, field_rules->field_len)) {
-            HashTable *expanded = sf_expand_wildcards(
-                field_rules->field_name,
-                field_rules->field_len,
-                data_array
-            );
-
-            sf_expanded_field_t *entry;
-            ZEND_HASH_FOREACH_PTR(expanded, entry) {
-                zval *value = sf_get_nested_value(entry->path, entry->path_len, data_array);
-                validate_field(
-                    intern,
-                    field_rules,
-                    value,
-                    data_array,
-                    result->errors,
-                    result->validated,
-                    entry->path,
-                    entry->path_len
-                );
-            } ZEND_HASH_FOREACH_END();
-
-            sf_free_expanded_fields(expanded);
-        } else {
-            /* Simple field - get value from data */
-            zval *value = sf_get_nested_value(
-                field_rules->field_name,
-                field_rules->field_len,
-                data_array
-            );
-
-            validate_field(
-                intern,
-                field_rules,
-                value,
-                data_array,
-                result->errors,
-                result->validated,
-                field_rules->field_name,
-                field_rules->field_len
-            );
+    sf_program_t *prog = intern->program;
+
+    sf_schema_stack_t schemas;
+    memset(&schemas, 0, sizeof(schemas));
+
+    sf_field_visit_t visit;
+    visit.validator = intern;
+    visit.errors = result->errors;
+    visit.validated = result->validated;
+    visit.schemas = &schemas;
+    visit.aggregates = NULL;
+
+    /* One path cursor serves every wildcard walk and schema prefix */
+    sf_path_cursor_t cursor;
+    bool has_cursor = 0;
+
+    bool ok = run_fields(&visit, prog, data_array, NULL, &cursor, &has_cursor);
+
+    /* Then the values 'schema' rules queued: depth first, in field order */
+    uint32_t mark = 0;
+    while (ok) {
+        reverse_schemas(&schemas, mark);
+        if (schemas.count == 0) {
+            break;
         }
-    } ZEND_HASH_FOREACH_END();
+
+        sf_schema_item_t item = schemas.items[--schemas.count];
+        mark = schemas.count;
+        schemas.depth = item.depth;
+
+        ok = run_fields(&visit, prog->schemas[item.schema].program, Z_ARRVAL_P(item.value),
+            item.path, &cursor, &has_cursor);
+        zend_string_release(item.path);
+    }
+
+    for (uint32_t k = 0; k < schemas.count; k++) {
+        zend_string_release(schemas.items[k].path);
+    }
+    if (schemas.items) {
+        efree(schemas.items);
+    }
+
+    if (has_cursor) {
+        sf_path_cursor_destroy(&cursor);
+    }
+
+    if (!ok) {
+        zval_ptr_dtor(return_value);
+        ZVAL_NULL(return_value);
+        RETURN_THROWS();
+    }
 
     /* Set is_valid based on errors */
     result->is_valid = (zend_hash_num_elements(result->errors) == 0);
+
+    /* Profile-guided reordering */
+    if (prog->profiling && ++prog->validations >= SF_PROFILE_REORDER_INTERVAL) {
+        sf_profile_reorder(prog);
+    }
+}
+
+/* PHP Method: Validator::exportProfile(): array */
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_validator_export_profile, 0, 0, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
+PHP_METHOD(Validator, exportProfile)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    signalforge_validator_t *intern = Z_SIGNALFORGE_VALIDATOR_P(ZEND_THIS);
+
+    if (!intern->program) {
+        zend_throw_exception(signalforge_invalid_rule_exception_ce,
+            "Validator not properly initialized", 0);
+        RETURN_THROWS();
+    }
+
+    sf_profile_export(intern->program, return_value);
+}
+
+/* PHP Method: Validator::importProfile(array $profile): void */
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_validator_import_profile, 0, 1, IS_VOID, 0)
+    ZEND_ARG_ARRAY_INFO(0, profile, 0)
+ZEND_END_ARG_INFO()
+
+PHP_METHOD(Validator, importProfile)
+{
+    HashTable *profile;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_ARRAY_HT(profile)
+    ZEND_PARSE_PARAMETERS_END();
+
+    signalforge_validator_t *intern = Z_SIGNALFORGE_VALIDATOR_P(ZEND_THIS);
+
+    if (!intern->program) {
+        zend_throw_exception(signalforge_invalid_rule_exception_ce,
+            "Validator not properly initialized", 0);
+        RETURN_THROWS();
+    }
+
+    if (!sf_profile_import(intern->program, profile)) {
+        RETURN_THROWS();
+    }
+}
+
+/* PHP Method: Validator::stats(): array */
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_validator_stats, 0, 0, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
+/*
+ * How the program runs of this validator iterated: the top-level data
+ * and every value validated against a sub-schema count as one run each.
+ */
+PHP_METHOD(Validator, stats)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+
+    signalforge_validator_t *intern = Z_SIGNALFORGE_VALIDATOR_P(ZEND_THIS);
+
+    if (!intern->program) {
+        zend_throw_exception(signalforge_invalid_rule_exception_ce,
+            "Validator not properly initialized", 0);
+        RETURN_THROWS();
+    }
+
+    const sf_program_t *prog = intern->program;
+    uint64_t rule_driven = prog->rule_driven_runs;
+    uint64_t data_driven = prog->data_driven_runs;
+    for (uint32_t k = 0; k < prog->schema_count; k++) {
+        rule_driven += prog->schemas[k].program->rule_driven_runs;
+        data_driven += prog->schemas[k].program->data_driven_runs;
+    }
+
+    array_init(return_value);
+    add_assoc_long(return_value, "runs", (zend_long)(rule_driven + data_driven));
+    add_assoc_long(return_value, "rule_driven", (zend_long)rule_driven);
+    add_assoc_long(return_value, "data_driven", (zend_long)data_driven);
+    add_assoc_long(return_value, "fields", (zend_long)prog->field_count);
 }
 
-/* PHP Method: Validator::make(array $data, array $rules): Validator */
+/* PHP Method: Validator::make(array $data, array $rules, array $options = []): Validator */
 ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO_EX(arginfo_validator_make, 0, 2, Signalforge\\Validation\\Validator, 0)
     ZEND_ARG_ARRAY_INFO(0, data, 0)
     ZEND_ARG_ARRAY_INFO(0, rules, 0)
+    ZEND_ARG_ARRAY_INFO(0, options, 0)
 ZEND_END_ARG_INFO()
 
 /*
@@ -391,25 +1395,42 @@ PHP_METHOD(Validator, make)
 {
     HashTable *data_array;
     HashTable *rules_array;
+    HashTable *options_array = NULL;
 
-    ZEND_PARSE_PARAMETERS_START(2, 2)
+    ZEND_PARSE_PARAMETERS_START(2, 3)
         Z_PARAM_ARRAY_HT(data_array)
         Z_PARAM_ARRAY_HT(rules_array)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_ARRAY_HT(options_array)
     ZEND_PARSE_PARAMETERS_END();
 
+    sf_compile_options_t options;
+    HashTable *schemas;
+    if (!sf_parse_options(options_array, &options, &schemas)) {
+        RETURN_THROWS();
+    }
+
     /* Parse rules first - if this fails, we don't create the object */
-    HashTable *parsed_rules = sf_parse_rules(rules_array);
+    HashTable *parsed_rules = options.lazy
+        ? sf_parse_rules_deferred(rules_array)
+        : sf_parse_rules(rules_array);
     if (!parsed_rules) {
         /* Exception was thrown by sf_parse_rules */
         RETURN_THROWS();
     }
 
+    /* Compile before creating the object: unknown schemas throw here too */
+    sf_program_t *program = sf_compile_rules(parsed_rules, schemas, &options);
+    if (!program) {
+        RETURN_THROWS();
+    }
+
     /* Create new Validator instance */
     object_init_ex(return_value, signalforge_validator_ce);
     signalforge_validator_t *intern = Z_SIGNALFORGE_VALIDATOR_P(return_value);
 
-    /* Transfer ownership of parsed rules to the validator */
-    intern->rules = parsed_rules;
+    /* Transfer ownership of the program to the validator */
+    intern->program = program;
 }
 
 /* Method table */
@@ -417,223 +1438,17 @@ static const zend_function_entry validator_methods[] = {
     PHP_ME(Validator, __construct, arginfo_validator_construct, ZEND_ACC_PUBLIC)
     PHP_ME(Validator, validate, arginfo_validator_validate, ZEND_ACC_PUBLIC)
     PHP_ME(Validator, make, arginfo_validator_make, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Validator, exportProfile, arginfo_validator_export_profile, ZEND_ACC_PUBLIC)
+    PHP_ME(Validator, importProfile, arginfo_validator_import_profile, ZEND_ACC_PUBLIC)
+    PHP_ME(Validator, stats, arginfo_validator_stats, ZEND_ACC_PUBLIC)
     PHP_FE_END
 };
 
-/*
- * Deep copy a single parsed rule.
- * Returns NULL on allocation failure.
- */
-static sf_parsed_rule_t *sf_clone_parsed_rule(sf_parsed_rule_t *src);
-
-/*
- * Deep copy a field rules structure.
- * Returns NULL on allocation failure.
- */
-static sf_field_rules_t *sf_clone_field_rules(sf_field_rules_t *src)
-{
-    if (!src) {
-        return NULL;
-    }
-
-    sf_field_rules_t *dst = ecalloc(1, sizeof(sf_field_rules_t));
-
-    if (src->field_name) {
-        dst->field_name = estrndup(src->field_name, src->field_len);
-        dst->field_len = src->field_len;
-    }
-
-    if (src->rules && src->rule_count > 0) {
-        dst->rules = ecalloc(src->rule_count, sizeof(sf_parsed_rule_t *));
-        dst->rule_count = 0;
-
-        for (size_t i = 0; i < src->rule_count; i++) {
-            sf_parsed_rule_t *cloned = sf_clone_parsed_rule(src->rules[i]);
-            if (!cloned) {
-                /* Cleanup on failure */
-                for (size_t j = 0; j < dst->rule_count; j++) {
-                    sf_free_parsed_rule(dst->rules[j]);
-                }
-                efree(dst->rules);
-                if (dst->field_name) {
-                    efree(dst->field_name);
-                }
-                efree(dst);
-                return NULL;
-            }
-            dst->rules[dst->rule_count++] = cloned;
-        }
-    }
-
-    return dst;
-}
-
-/*
- * Deep copy a condition structure.
- * Returns NULL on allocation failure.
- */
-static sf_condition_t *sf_clone_condition(sf_condition_t *src)
-{
-    if (!src) {
-        return NULL;
-    }
-
-    sf_condition_t *dst = ecalloc(1, sizeof(sf_condition_t));
-    dst->kind = src->kind;
-
-    if (src->kind == COND_SIMPLE) {
-        dst->simple.subject = src->simple.subject;
-        dst->simple.op = src->simple.op;
-
-        if (src->simple.field_name) {
-            dst->simple.field_name = estrndup(src->simple.field_name, src->simple.field_len);
-            dst->simple.field_len = src->simple.field_len;
-        }
-
-        ZVAL_COPY(&dst->simple.value, &src->simple.value);
-    } else {
-        /* Compound condition (AND/OR) */
-        if (src->compound.count > 0 && src->compound.conditions) {
-            dst->compound.conditions = ecalloc(src->compound.count, sizeof(sf_condition_t *));
-            dst->compound.count = 0;
-
-            for (size_t i = 0; i < src->compound.count; i++) {
-                sf_condition_t *cloned = sf_clone_condition(src->compound.conditions[i]);
-                if (!cloned) {
-                    /* Cleanup on failure */
-                    for (size_t j = 0; j < dst->compound.count; j++) {
-                        sf_free_condition(dst->compound.conditions[j]);
-                    }
-                    efree(dst->compound.conditions);
-                    efree(dst);
-                    return NULL;
-                }
-                dst->compound.conditions[dst->compound.count++] = cloned;
-            }
-        }
-    }
-
-    return dst;
-}
-
-/*
- * Deep copy a single parsed rule.
- * Returns NULL on allocation failure.
- */
-static sf_parsed_rule_t *sf_clone_parsed_rule(sf_parsed_rule_t *src)
-{
-    if (!src) {
-        return NULL;
-    }
-
-    sf_parsed_rule_t *dst = ecalloc(1, sizeof(sf_parsed_rule_t));
-    dst->type = src->type;
-
-    switch (src->type) {
-        case RULE_MIN:
-        case RULE_MAX:
-        case RULE_GT:
-        case RULE_GTE:
-        case RULE_LT:
-        case RULE_LTE:
-            dst->params.size.value = src->params.size.value;
-            break;
-
-        case RULE_BETWEEN:
-            dst->params.range.min = src->params.range.min;
-            dst->params.range.max = src->params.range.max;
-            break;
-
-        case RULE_REGEX:
-        case RULE_NOT_REGEX:
-            if (src->params.regex.pattern) {
-                dst->params.regex.pattern = estrndup(src->params.regex.pattern, src->params.regex.len);
-                dst->params.regex.len = src->params.regex.len;
-            }
-            break;
-
-        case RULE_STARTS_WITH:
-        case RULE_ENDS_WITH:
-        case RULE_CONTAINS:
-        case RULE_DATE_FORMAT:
-            if (src->params.string.str) {
-                dst->params.string.str = estrndup(src->params.string.str, src->params.string.len);
-                dst->params.string.len = src->params.string.len;
-            }
-            break;
-
-        case RULE_SAME:
-        case RULE_DIFFERENT:
-        case RULE_AFTER:
-        case RULE_BEFORE:
-        case RULE_AFTER_OR_EQUAL:
-        case RULE_BEFORE_OR_EQUAL:
-            if (src->params.field_ref.field) {
-                dst->params.field_ref.field = estrndup(src->params.field_ref.field, src->params.field_ref.len);
-                dst->params.field_ref.len = src->params.field_ref.len;
-            }
-            break;
-
-        case RULE_IN:
-        case RULE_NOT_IN:
-            if (src->params.in_list.values) {
-                ALLOC_HASHTABLE(dst->params.in_list.values);
-                zend_hash_init(dst->params.in_list.values,
-                    zend_hash_num_elements(src->params.in_list.values),
-                    NULL, ZVAL_PTR_DTOR, 0);
-                zend_hash_copy(dst->params.in_list.values, src->params.in_list.values, zval_add_ref);
-            }
-            break;
-
-        case RULE_WHEN:
-            dst->params.conditional.condition = sf_clone_condition(src->params.conditional.condition);
-
-            if (src->params.conditional.then_rules && src->params.conditional.then_count > 0) {
-                dst->params.conditional.then_rules = ecalloc(
-                    src->params.conditional.then_count, sizeof(sf_parsed_rule_t *));
-                dst->params.conditional.then_count = 0;
-
-                for (size_t i = 0; i < src->params.conditional.then_count; i++) {
-                    sf_parsed_rule_t *cloned = sf_clone_parsed_rule(src->params.conditional.then_rules[i]);
-                    if (!cloned) {
-                        goto when_cleanup;
-                    }
-                    dst->params.conditional.then_rules[dst->params.conditional.then_count++] = cloned;
-                }
-            }
-
-            if (src->params.conditional.else_rules && src->params.conditional.else_count > 0) {
-                dst->params.conditional.else_rules = ecalloc(
-                    src->params.conditional.else_count, sizeof(sf_parsed_rule_t *));
-                dst->params.conditional.else_count = 0;
-
-                for (size_t i = 0; i < src->params.conditional.else_count; i++) {
-                    sf_parsed_rule_t *cloned = sf_clone_parsed_rule(src->params.conditional.else_rules[i]);
-                    if (!cloned) {
-                        goto when_cleanup;
-                    }
-                    dst->params.conditional.else_rules[dst->params.conditional.else_count++] = cloned;
-                }
-            }
-            break;
-
-        when_cleanup:
-            sf_free_parsed_rule(dst);
-            return NULL;
-
-        default:
-            /* No parameters to copy */
-            break;
-    }
-
-    return dst;
-}
-
 /*
  * Clone handler for Validator objects.
  *
  * Security fix: Creates a proper deep copy of the validator including its
- * parsed rules. This prevents use-after-free if the original validator is
+ * compiled program. This prevents use-after-free if the original validator is
  * destroyed while the clone is still in use.
  *
  * The regex cache is NOT copied - it will be rebuilt on demand during
@@ -652,22 +1467,12 @@ static zend_object *signalforge_validator_clone(zend_object *old_obj)
     zend_objects_clone_members(&new_intern->std, old_obj);
 
     /*
-     * Deep copy the parsed rules to ensure the clone is fully independent.
+     * Deep copy the compiled program to ensure the clone is fully independent.
      * This prevents use-after-free vulnerabilities if the original validator
      * is destroyed while the clone is still in use.
      */
-    if (old_intern->rules) {
-        ALLOC_HASHTABLE(new_intern->rules);
-        zend_hash_init(new_intern->rules, zend_hash_num_elements(old_intern->rules), NULL, NULL, 0);
-
-        zend_string *key;
-        sf_field_rules_t *fr;
-        ZEND_HASH_FOREACH_STR_KEY_PTR(old_intern->rules, key, fr) {
-            sf_field_rules_t *cloned_fr = sf_clone_field_rules(fr);
-            if (cloned_fr && key) {
-                zend_hash_add_ptr(new_intern->rules, key, cloned_fr);
-            }
-        } ZEND_HASH_FOREACH_END();
+    if (old_intern->program) {
+        new_intern->program = sf_clone_program(old_intern->program);
     }
 
     return &new_intern->std;
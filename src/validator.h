@@ -6,6 +6,7 @@
 #define SIGNALFORGE_VALIDATOR_H
 
 #include "php_signalforge_validation.h"
+#include "rules/rules.h"
 
 /* Register Validator class */
 void signalforge_register_validator_class(void);
@@ -20,4 +21,10 @@ cached_regex_t *sf_get_or_compile_regex(
     size_t pattern_len
 );
 
+/*
+ * Queue a schema validation of value, whose path is name. Returns 0 if
+ * that would exceed SF_MAX_SCHEMA_DEPTH or SF_MAX_SCHEMA_RUNS.
+ */
+bool sf_push_schema(sf_schema_stack_t *stack, uint32_t schema, zval *value, const char *name, size_t len);
+
 #endif /* SIGNALFORGE_VALIDATOR_H */
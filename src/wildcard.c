@@ -2,14 +2,16 @@
  * Wildcard expansion for nested field validation
  *
  * This module handles wildcard patterns like "items.*.name" that allow
- * validation rules to be applied to all elements of an array. The algorithm
- * recursively expands wildcards by iterating over array keys and building
- * concrete paths.
+ * validation rules to be applied to all elements of an array. The walker
+ * descends the data once along the compiled pattern, iterating the arrays
+ * a '*' stands for and handing each matching value to a visitor, with its
+ * concrete path kept in a single reusable cursor buffer.
  *
  * Security considerations:
- * - All path buffers are dynamically allocated to prevent stack overflow
+ * - The path cursor is heap-allocated to prevent stack overflow
  * - Maximum recursion depth is enforced to prevent stack exhaustion
  * - Path length limits prevent unbounded memory allocation
+ * - The number of visited paths per pattern is capped
  */
 
 #include "wildcard.h"
@@ -18,10 +20,11 @@
 /* Maximum path length to prevent unbounded allocations */
 #define SF_MAX_PATH_LENGTH 8192
 
-/* Maximum recursion depth to prevent stack exhaustion */
-#define SF_MAX_WILDCARD_DEPTH 32
 #define SF_MAX_EXPANDED_FIELDS 100000
 
+/* Initial path cursor capacity */
+#define SF_PATH_CURSOR_INITIAL 64
+
 /* Check if a field pattern contains wildcards */
 bool sf_has_wildcard(const char *pattern, size_t len)
 {
@@ -96,248 +99,350 @@ zval *sf_get_nested_value(const char *path, size_t path_len, HashTable *data)
     return current_val;
 }
 
-/*
- * Recursive wildcard expansion helper with depth limiting.
- *
- * This function expands wildcard patterns by recursively traversing the
- * data structure and building concrete paths. Safety measures include:
- * - Depth limiting to prevent stack exhaustion attacks
- * - Dynamic memory allocation for path buffers
- * - Path length validation before allocation
- *
- * Parameters:
- *   pattern     - Remaining pattern to match (after prefix)
- *   pattern_len - Length of remaining pattern
- *   data        - Root data hashtable (for nested value lookups)
- *   prefix      - Current path prefix being built
- *   prefix_len  - Length of current prefix
- *   result      - Output hashtable for expanded fields
- *   depth       - Current recursion depth (for limit checking)
- */
-static void expand_wildcards_recursive(
-    const char *pattern,
-    size_t pattern_len,
-    HashTable *data,
-    const char *prefix,
-    size_t prefix_len,
-    HashTable *result,
-    size_t depth
-)
+/* Set up a path cursor */
+void sf_path_cursor_init(sf_path_cursor_t *cursor)
 {
-    /* Prevent stack exhaustion from deeply nested structures */
-    if (depth > SF_MAX_WILDCARD_DEPTH) {
-        return;
-    }
+    cursor->cap = SF_PATH_CURSOR_INITIAL;
+    cursor->buf = emalloc(cursor->cap);
+    cursor->buf[0] = '\0';
+    cursor->len = 0;
+    cursor->base = 0;
+}
 
-    /* Prevent combinatorial explosion on broad wildcards
-     * (e.g., *.*.*.name with 100-element arrays at each level). */
-    if (zend_hash_num_elements(result) >= SF_MAX_EXPANDED_FIELDS) {
-        return;
+/* Release a path cursor */
+void sf_path_cursor_destroy(sf_path_cursor_t *cursor)
+{
+    efree(cursor->buf);
+    cursor->buf = NULL;
+    cursor->len = cursor->cap = 0;
+}
+
+/* Append a segment (dot-separated). Returns 0 if the path would get too long. */
+static bool cursor_push(sf_path_cursor_t *cursor, const char *segment, size_t seg_len)
+{
+    size_t sep = cursor->len > 0 ? 1 : 0;
+
+    if (seg_len > SF_MAX_PATH_LENGTH || cursor->len + sep + seg_len > SF_MAX_PATH_LENGTH) {
+        return 0;
     }
 
-    if (pattern_len == 0) {
-        /* End of pattern - add the current path */
-        sf_expanded_field_t *entry = emalloc(sizeof(sf_expanded_field_t));
-        entry->path = estrndup(prefix, prefix_len);
-        entry->path_len = prefix_len;
-        entry->value = sf_get_nested_value(prefix, prefix_len, data);
-
-        zend_string *key = zend_string_init(prefix, prefix_len, 0);
-
-        /* On duplicate key (e.g., reference cycles producing the same expanded
-         * path twice), zend_hash_add_ptr returns NULL. Without this check,
-         * `entry` and `entry->path` leak unboundedly. (audit #20) */
-        if (zend_hash_add_ptr(result, key, entry) == NULL) {
-            efree(entry->path);
-            efree(entry);
+    size_t new_len = cursor->len + sep + seg_len;
+    if (new_len + 1 > cursor->cap) {
+        while (cursor->cap < new_len + 1) {
+            cursor->cap *= 2;
         }
+        cursor->buf = erealloc(cursor->buf, cursor->cap);
+    }
 
-        zend_string_release(key);
-        return;
+    if (sep) {
+        cursor->buf[cursor->len] = '.';
     }
+    memcpy(cursor->buf + cursor->len + sep, segment, seg_len);
+    cursor->len = new_len;
+    cursor->buf[new_len] = '\0';
+
+    return 1;
+}
+
+/* Append an integer key */
+static bool cursor_push_index(sf_path_cursor_t *cursor, zend_ulong index)
+{
+    char digits[MAX_LENGTH_OF_LONG + 1];
+    char *end = digits + sizeof(digits) - 1;
+    char *start = zend_print_long_to_buf(end, (zend_long)index);
+
+    return cursor_push(cursor, start, end - start);
+}
+
+/* Drop everything after len */
+static void cursor_pop(sf_path_cursor_t *cursor, size_t len)
+{
+    cursor->len = len;
+    cursor->buf[len] = '\0';
+}
 
-    const char *segment;
-    size_t seg_len;
-    size_t consumed = get_segment(pattern, pattern_len, &segment, &seg_len);
-
-    /* Get current data at prefix */
-    zval *current_data = NULL;
-    zval temp;
-    if (prefix_len > 0) {
-        current_data = sf_get_nested_value(prefix, prefix_len, data);
-    } else {
-        /* Create a temporary zval for the root data */
-        ZVAL_ARR(&temp, data);
-        current_data = &temp;
+/* Replace the fixed prefix */
+bool sf_path_cursor_rebase(sf_path_cursor_t *cursor, const char *prefix, size_t len)
+{
+    cursor->base = 0;
+    cursor_pop(cursor, 0);
+
+    if (len > 0 && !cursor_push(cursor, prefix, len)) {
+        cursor_pop(cursor, 0);
+        return 0;
     }
 
-    if (!current_data && prefix_len > 0) {
-        return;
+    cursor->base = cursor->len;
+    return 1;
+}
+
+/* Point the cursor at a plain field below the prefix */
+bool sf_path_cursor_field(sf_path_cursor_t *cursor, const char *name, size_t len)
+{
+    cursor_pop(cursor, cursor->base);
+    return cursor_push(cursor, name, len);
+}
+
+/*
+ * Traversal trie.
+ *
+ * Wildcard patterns are merged on their common prefixes, so
+ * "items.*.name", "items.*.price" and "items.*.tags.*" share the nodes for
+ * "items" and "items.*": the items array is iterated once, and for each
+ * element the rule chains of all three fields run back to back.
+ */
+
+/* Find or append the child of node reached through segment */
+static uint32_t trie_child(sf_walk_node_t *node, const sf_path_segment_t *segment, bool *created)
+{
+    for (uint32_t i = 0; i < node->child_count; i++) {
+        const sf_path_segment_t *existing = &node->children[i].segment;
+        if (existing->is_wildcard == segment->is_wildcard
+            && (segment->is_wildcard || zend_string_equals(existing->key, segment->key))) {
+            *created = 0;
+            return i;
+        }
     }
 
-    HashTable *current_ht = (prefix_len > 0 && current_data) ?
-        (Z_TYPE_P(current_data) == IS_ARRAY ? Z_ARRVAL_P(current_data) : NULL) : data;
+    node->children = safe_erealloc(node->children, node->child_count + 1, sizeof(sf_walk_node_t), 0);
 
-    if (!current_ht) {
-        return;
+    sf_walk_node_t *child = &node->children[node->child_count];
+    memset(child, 0, sizeof(*child));
+    child->segment = *segment;
+    child->segment.key = zend_string_copy(segment->key);
+    child->gate = SF_NO_FIELD;
+
+    *created = 1;
+    return node->child_count++;
+}
+
+/* Add a field's wildcard pattern to the trie */
+uint32_t sf_walk_trie_add(sf_walk_node_t *root, const sf_path_t *pattern, uint32_t field, bool *leader)
+{
+    *leader = 0;
+    if (pattern->count == 0) {
+        return 0;
     }
 
-    if (seg_len == 1 && segment[0] == '*') {
-        /* Wildcard - iterate over all keys */
-        zend_string *key;
-        zend_ulong idx;
-
-        ZEND_HASH_FOREACH_KEY(current_ht, idx, key) {
-            size_t key_len;
-            size_t new_prefix_len;
-            char *new_prefix;
-
-            /* Calculate required buffer size safely */
-            if (key) {
-                key_len = ZSTR_LEN(key);
-            } else {
-                /* Maximum digits for zend_ulong (20 for 64-bit) */
-                key_len = 21;
-            }
+    bool created;
+    uint32_t group = trie_child(root, &pattern->segments[0], &created);
+    *leader = created;
 
-            /* Check for potential overflow: prefix_len + 1 (dot) + key_len + 1 (null) */
-            if (prefix_len > SF_MAX_PATH_LENGTH - key_len - 2) {
-                continue; /* Skip paths that would exceed maximum length */
-            }
+    sf_walk_node_t *node = &root->children[group];
+    for (uint32_t i = 1; i < pattern->count; i++) {
+        uint32_t child = trie_child(node, &pattern->segments[i], &created);
+        node = &node->children[child];
+    }
 
-            new_prefix_len = prefix_len + (prefix_len > 0 ? 1 : 0) + key_len;
-            if (new_prefix_len > SF_MAX_PATH_LENGTH) {
-                continue;
-            }
+    node->fields = safe_erealloc(node->fields, node->field_count + 1, sizeof(uint32_t), 0);
+    node->fields[node->field_count++] = field;
 
-            /* Allocate buffer dynamically */
-            new_prefix = emalloc(new_prefix_len + 1);
+    return group;
+}
 
-            if (key) {
-                if (prefix_len > 0) {
-                    new_prefix_len = snprintf(new_prefix, new_prefix_len + 1, "%.*s.%s",
-                        (int)prefix_len, prefix, ZSTR_VAL(key));
-                } else {
-                    new_prefix_len = snprintf(new_prefix, new_prefix_len + 1, "%s", ZSTR_VAL(key));
-                }
-            } else {
-                if (prefix_len > 0) {
-                    new_prefix_len = snprintf(new_prefix, new_prefix_len + 1, "%.*s.%lu",
-                        (int)prefix_len, prefix, idx);
-                } else {
-                    new_prefix_len = snprintf(new_prefix, new_prefix_len + 1, "%lu", idx);
-                }
-            }
+/* Make a plain field the gate of the node at its path */
+void sf_walk_trie_gate(sf_walk_node_t *root, const sf_path_t *path, uint32_t field)
+{
+    sf_walk_node_t *node = root;
 
-            const char *remaining = pattern + consumed;
-            size_t remaining_len = pattern_len - consumed;
-
-            if (remaining_len > 0) {
-                expand_wildcards_recursive(remaining, remaining_len, data,
-                    new_prefix, new_prefix_len, result, depth + 1);
-                efree(new_prefix);
-            } else {
-                /* End of pattern - transfer ownership of new_prefix to entry */
-                sf_expanded_field_t *entry = emalloc(sizeof(sf_expanded_field_t));
-                entry->path = new_prefix; /* Transfer ownership */
-                entry->path_len = new_prefix_len;
-                entry->value = sf_get_nested_value(new_prefix, new_prefix_len, data);
-
-                zend_string *result_key = zend_string_init(new_prefix, new_prefix_len, 0);
-
-                /* Check for duplicate-key collision (audit #20) */
-                if (zend_hash_add_ptr(result, result_key, entry) == NULL) {
-                    efree(entry->path);
-                    efree(entry);
-                }
+    for (uint32_t i = 0; i < path->count; i++) {
+        const sf_path_segment_t *segment = &path->segments[i];
+        sf_walk_node_t *next = NULL;
 
-                zend_string_release(result_key);
+        for (uint32_t c = 0; c < node->child_count; c++) {
+            const sf_path_segment_t *existing = &node->children[c].segment;
+            if (!existing->is_wildcard && zend_string_equals(existing->key, segment->key)) {
+                next = &node->children[c];
+                break;
             }
-        } ZEND_HASH_FOREACH_END();
-    } else {
-        /* Regular segment - just append and continue */
-        size_t new_prefix_len;
-        char *new_prefix;
-
-        /* Check for potential overflow */
-        if (prefix_len > SF_MAX_PATH_LENGTH - seg_len - 2) {
-            return;
         }
 
-        new_prefix_len = prefix_len + (prefix_len > 0 ? 1 : 0) + seg_len;
-        if (new_prefix_len > SF_MAX_PATH_LENGTH) {
+        if (!next) {
             return;
         }
+        node = next;
+    }
 
-        new_prefix = emalloc(new_prefix_len + 1);
-
-        if (prefix_len > 0) {
-            new_prefix_len = snprintf(new_prefix, new_prefix_len + 1, "%.*s.%.*s",
-                (int)prefix_len, prefix, (int)seg_len, segment);
-        } else {
-            new_prefix_len = snprintf(new_prefix, new_prefix_len + 1, "%.*s", (int)seg_len, segment);
-        }
+    if (node != root) {
+        node->gate = field;
+    }
+}
 
-        const char *remaining = pattern + consumed;
-        size_t remaining_len = pattern_len - consumed;
+/* Release a trie's nodes (not the root itself) */
+void sf_walk_trie_free(sf_walk_node_t *root)
+{
+    for (uint32_t i = 0; i < root->child_count; i++) {
+        sf_walk_node_t *child = &root->children[i];
+        sf_walk_trie_free(child);
+        zend_string_release(child->segment.key);
+    }
 
-        expand_wildcards_recursive(remaining, remaining_len, data,
-            new_prefix, new_prefix_len, result, depth + 1);
-        efree(new_prefix);
+    if (root->children) {
+        efree(root->children);
+    }
+    if (root->fields) {
+        efree(root->fields);
     }
+
+    root->children = NULL;
+    root->child_count = 0;
+    root->fields = NULL;
+    root->field_count = 0;
 }
 
-/* Expand wildcards in a field pattern against data */
-HashTable *sf_expand_wildcards(const char *pattern, size_t pattern_len, HashTable *data)
+/* Walk state shared across the recursion */
+typedef struct {
+    const uint8_t *states;
+    sf_path_cursor_t *cursor;
+    sf_wildcard_visitor_t visit;
+    void *arg;
+    uint32_t visited;
+    uint32_t max_visits;
+} sf_walk_t;
+
+static void walk_child(sf_walk_t *w, const sf_walk_node_t *child, zval *parent, uint32_t depth);
+
+/*
+ * Visit the fields ending at node, then descend into its children unless
+ * one of them closed the element, with value the data at node's path
+ * (NULL once a non-wildcard segment was missing). Recursion is bounded by
+ * SF_MAX_WILDCARD_DEPTH.
+ */
+static void walk_node(sf_walk_t *w, const sf_walk_node_t *node, zval *value, uint32_t depth)
 {
-    HashTable *result;
-    ALLOC_HASHTABLE(result);
-    zend_hash_init(result, 8, NULL, NULL, 0);
-
-    if (!sf_has_wildcard(pattern, pattern_len)) {
-        /* No wildcards - just add the pattern as-is */
-        sf_expanded_field_t *entry = emalloc(sizeof(sf_expanded_field_t));
-        entry->path = estrndup(pattern, pattern_len);
-        entry->path_len = pattern_len;
-        entry->value = sf_get_nested_value(pattern, pattern_len, data);
-
-        zend_string *key = zend_string_init(pattern, pattern_len, 0);
-
-        /* Defensive: fresh hashtable, dup impossible — but keep consistent (audit #20) */
-        if (zend_hash_add_ptr(result, key, entry) == NULL) {
-            efree(entry->path);
-            efree(entry);
+    if (depth > SF_MAX_WILDCARD_DEPTH || w->visited >= w->max_visits) {
+        return;
+    }
+
+    w->cursor->frames[depth + 1] = value;
+
+    bool open = 1;
+    for (uint32_t i = 0; i < node->field_count; i++) {
+        w->visited++;
+        if (!w->visit(w->arg, node->fields[i], value, w->cursor)) {
+            open = 0;
         }
+    }
 
-        zend_string_release(key);
-    } else {
-        expand_wildcards_recursive(pattern, pattern_len, data, "", 0, result, 0);
+    if (!open) {
+        return;
     }
 
-    return result;
+    for (uint32_t i = 0; i < node->child_count; i++) {
+        walk_child(w, &node->children[i], value, depth + 1);
+    }
 }
 
-/* Free expanded field entry */
-static void free_expanded_field(sf_expanded_field_t *entry)
+/* Visit one element of a wildcard's array */
+static zend_always_inline void walk_element(
+    sf_walk_t *w,
+    const sf_walk_node_t *node,
+    zval *value,
+    zend_ulong index,
+    zend_string *key,
+    uint32_t depth
+)
 {
-    if (entry) {
-        if (entry->path) {
-            efree(entry->path);
-        }
-        efree(entry);
+    size_t mark = w->cursor->len;
+    bool fits = key
+        ? cursor_push(w->cursor, ZSTR_VAL(key), ZSTR_LEN(key))
+        : cursor_push_index(w->cursor, index);
+
+    /* Paths that would exceed SF_MAX_PATH_LENGTH are skipped */
+    if (fits) {
+        walk_node(w, node, value, depth);
     }
+    cursor_pop(w->cursor, mark);
 }
 
-/* Free expanded fields hashtable */
-void sf_free_expanded_fields(HashTable *expanded)
+/* Step from a parent value into child's segment */
+static void walk_child(sf_walk_t *w, const sf_walk_node_t *child, zval *parent, uint32_t depth)
 {
-    if (!expanded) return;
+    const sf_path_segment_t *segment = &child->segment;
 
-    sf_expanded_field_t *entry;
-    ZEND_HASH_FOREACH_PTR(expanded, entry) {
-        free_expanded_field(entry);
-    } ZEND_HASH_FOREACH_END();
+    if (segment->is_wildcard) {
+        /* Nothing to iterate below a missing or scalar value */
+        if (!parent || Z_TYPE_P(parent) != IS_ARRAY) {
+            return;
+        }
+
+        HashTable *ht = Z_ARRVAL_P(parent);
+        zend_ulong index;
+        zend_string *key;
+        zval *value;
+
+        if (HT_IS_PACKED(ht)) {
+            ZEND_HASH_PACKED_FOREACH_KEY_VAL(ht, index, value) {
+                walk_element(w, child, value, index, NULL, depth);
+                if (w->visited >= w->max_visits) {
+                    break;
+                }
+            } ZEND_HASH_FOREACH_END();
+        } else {
+            ZEND_HASH_MAP_FOREACH_KEY_VAL(ht, index, key, value) {
+                walk_element(w, child, value, index, key, depth);
+                if (w->visited >= w->max_visits) {
+                    break;
+                }
+            } ZEND_HASH_FOREACH_END();
+        }
+        return;
+    }
+
+    /* A plain field at this path did not pass: leave its subtree alone */
+    if (child->gate != SF_NO_FIELD && w->states[child->gate]) {
+        return;
+    }
 
-    zend_hash_destroy(expanded);
-    FREE_HASHTABLE(expanded);
+    /* Regular segment: same lookup rules as sf_get_nested_value() */
+    zval *value = NULL;
+    if (parent && Z_TYPE_P(parent) == IS_ARRAY) {
+        value = zend_hash_find(Z_ARRVAL_P(parent), segment->key);
+        if (!value && segment->is_index) {
+            value = zend_hash_index_find(Z_ARRVAL_P(parent), segment->index);
+        }
+    }
+
+    size_t mark = w->cursor->len;
+    if (cursor_push(w->cursor, ZSTR_VAL(segment->key), ZSTR_LEN(segment->key))) {
+        walk_node(w, child, value, depth);
+    }
+    cursor_pop(w->cursor, mark);
+}
+
+/* Walk one top-level group of the trie */
+void sf_walk_trie(
+    const sf_walk_node_t *root,
+    uint32_t group,
+    HashTable *data,
+    const uint8_t *states,
+    sf_path_cursor_t *cursor,
+    sf_wildcard_visitor_t visit,
+    void *arg
+)
+{
+    sf_walk_t w;
+    w.states = states;
+    w.cursor = cursor;
+    w.visit = visit;
+    w.arg = arg;
+    w.visited = 0;
+    w.max_visits = SF_MAX_EXPANDED_FIELDS * sf_walk_trie_fields(&root->children[group]);
+
+    zval top;
+    ZVAL_ARR(&top, data);
+
+    cursor_pop(cursor, cursor->base);
+    cursor->frames[0] = &top;
+    walk_child(&w, &root->children[group], &top, 0);
+}
+
+/* Number of fields in a subtree */
+uint32_t sf_walk_trie_fields(const sf_walk_node_t *node)
+{
+    uint32_t count = node->field_count;
+    for (uint32_t i = 0; i < node->child_count; i++) {
+        count += sf_walk_trie_fields(&node->children[i]);
+    }
+    return count;
 }
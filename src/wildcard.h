@@ -6,29 +6,109 @@
 #define SIGNALFORGE_WILDCARD_H
 
 #include "php_signalforge_validation.h"
+#include "path.h"
 
-/* Expanded field entry */
+/* Maximum recursion depth to prevent stack exhaustion */
+#define SF_MAX_WILDCARD_DEPTH 32
+
+/*
+ * Path cursor: the concrete path of the element being visited, built in
+ * place while walking ("items" -> "items.0" -> "items.0.name"). Always
+ * NUL-terminated. frames holds the values along that path, for references
+ * bound to the current element (see sf_path_resolve_at).
+ *
+ * The first base bytes are a fixed prefix every path starts with: the
+ * path of the value a schema program runs against ("billing" for
+ * "billing.street"). frames start below it.
+ */
 typedef struct {
-    char *path;          /* Full path like "items.0.name" */
-    size_t path_len;
-    zval *value;         /* Pointer to the value in original data */
-} sf_expanded_field_t;
+    char *buf;
+    size_t len;
+    size_t cap;
+    size_t base;
+    zval *frames[SF_MAX_WILDCARD_DEPTH + 2];
+} sf_path_cursor_t;
+
+/* No field (trie gates, field parents) */
+#define SF_NO_FIELD UINT32_MAX
+
+/*
+ * Called for every concrete path of a wildcard field. Returning false
+ * closes the element: nothing below this path is visited.
+ */
+typedef bool (*sf_wildcard_visitor_t)(void *arg, uint32_t field, zval *value, const sf_path_cursor_t *cursor);
+
+/*
+ * Traversal trie of wildcard field patterns, merged on common prefixes.
+ * The root's children are the top-level groups: one per first segment.
+ */
+typedef struct sf_walk_node_s {
+    sf_path_segment_t segment;          /* Step from the parent node */
+    struct sf_walk_node_s *children;
+    uint32_t child_count;
+    uint32_t *fields;                   /* Fields whose pattern ends here */
+    uint32_t field_count;
+    uint32_t gate;                      /* Plain field at this path, or SF_NO_FIELD */
+} sf_walk_node_t;
 
 /* Check if a field pattern contains wildcards */
 bool sf_has_wildcard(const char *pattern, size_t len);
 
-/* Expand wildcards in a field pattern against data
- * Returns a HashTable of sf_expanded_field_t pointers
- * Pattern like "items.*.name" becomes "items.0.name", "items.1.name", etc.
+/*
+ * Add a field's compiled pattern (see sf_path_init) to the trie. Returns
+ * its top-level group; *leader is set if the field is the group's first.
  */
-HashTable *sf_expand_wildcards(const char *pattern, size_t pattern_len, HashTable *data);
+uint32_t sf_walk_trie_add(sf_walk_node_t *root, const sf_path_t *pattern, uint32_t field, bool *leader);
+
+/*
+ * Make a plain (wildcard-free) field the gate of the node at its path, if
+ * the trie has one.
+ */
+void sf_walk_trie_gate(sf_walk_node_t *root, const sf_path_t *path, uint32_t field);
+
+/* Release a trie's nodes (not the root itself) */
+void sf_walk_trie_free(sf_walk_node_t *root);
+
+/* Number of fields in a subtree */
+uint32_t sf_walk_trie_fields(const sf_walk_node_t *node);
+
+/*
+ * Walk data along one top-level group of the trie, calling visit for every
+ * concrete path of every field in the group. Each array a '*' stands for
+ * is iterated once, and for each element all fields below it are visited
+ * before the next element: a field ending at a node before the fields
+ * below it, sibling fields in declaration order. Elements are reached
+ * directly from their parent, and the cursor holds the current path; no
+ * per-element allocation is made. value is NULL for paths whose trailing
+ * non-wildcard segments are missing, e.g. "items.0.name" when item 0 has
+ * no name.
+ *
+ * A node whose gate has a nonzero entry in states is not entered at all,
+ * so a failed parent field keeps its collection from being iterated.
+ */
+void sf_walk_trie(
+    const sf_walk_node_t *root,
+    uint32_t group,
+    HashTable *data,
+    const uint8_t *states,
+    sf_path_cursor_t *cursor,
+    sf_wildcard_visitor_t visit,
+    void *arg
+);
+
+/* Set up and release a path cursor */
+void sf_path_cursor_init(sf_path_cursor_t *cursor);
+void sf_path_cursor_destroy(sf_path_cursor_t *cursor);
+
+/* Replace the cursor's fixed prefix (empty for none). Returns 0 if too long. */
+bool sf_path_cursor_rebase(sf_path_cursor_t *cursor, const char *prefix, size_t len);
+
+/* Set the cursor to a plain field's name below the prefix. Returns 0 if too long. */
+bool sf_path_cursor_field(sf_path_cursor_t *cursor, const char *name, size_t len);
 
 /* Get a nested value from data using dot notation
  * e.g., "user.address.city" from {'user': {'address': {'city': 'Zagreb'}}}
  */
 zval *sf_get_nested_value(const char *path, size_t path_len, HashTable *data);
 
-/* Free expanded fields hashtable */
-void sf_free_expanded_fields(HashTable *expanded);
-
 #endif /* SIGNALFORGE_WILDCARD_H */
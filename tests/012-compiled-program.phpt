@@ -0,0 +1,72 @@
+--TEST--
+Compiled rule programs: when/else branches, skip propagation, clone independence
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+$v = new Validator([
+    'kind' => ['required', ['in', ['a', 'b']]],
+    'code' => [
+        'required',
+        ['when', ['kind', '=', 'a'],
+            [['regex', '/^A\d+$/']],
+            [['regex', '/^B\d+$/'], ['max', 4]]
+        ],
+        ['min', 2],
+    ],
+    // nullable inside a branch must stop the rest of the chain
+    'note' => [
+        ['when', ['kind', '=', 'b'], ['nullable']],
+        'string',
+    ],
+]);
+
+// then-branch
+var_dump($v->validate(['kind' => 'a', 'code' => 'A12'])->valid());
+var_dump($v->validate(['kind' => 'a', 'code' => 'B12'])->hasError('code'));
+
+// else-branch, and the rule after the when still runs
+var_dump($v->validate(['kind' => 'b', 'code' => 'B12'])->valid());
+$r = $v->validate(['kind' => 'b', 'code' => 'B12345']);
+var_dump(array_column($r->errorsFor('code'), 'key'));
+$r = $v->validate(['kind' => 'b', 'code' => 'B']);
+var_dump(array_column($r->errorsFor('code'), 'key'));
+
+// skip from inside a branch
+var_dump($v->validate(['kind' => 'b', 'code' => 'B1', 'note' => null])->hasError('note'));
+var_dump($v->validate(['kind' => 'a', 'code' => 'A1', 'note' => null])->hasError('note'));
+
+// clones run their own copy of the program
+$c = clone $v;
+unset($v);
+var_dump($c->validate(['kind' => 'a', 'code' => 'A12'])->valid());
+
+// re-running the constructor replaces the program
+$c->__construct(['x' => ['required']]);
+var_dump($c->validate([])->hasError('x'));
+var_dump($c->validate(['x' => 1])->valid());
+
+echo "OK\n";
+?>
+--EXPECT--
+bool(true)
+bool(true)
+bool(true)
+array(1) {
+  [0]=>
+  string(14) "validation.max"
+}
+array(2) {
+  [0]=>
+  string(16) "validation.regex"
+  [1]=>
+  string(14) "validation.min"
+}
+bool(false)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+OK
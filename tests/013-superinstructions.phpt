@@ -0,0 +1,76 @@
+--TEST--
+Fused and type-specialized rule sequences report the same errors as the rules written out
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+function keys($r, $f) { return implode(',', array_column($r->errorsFor($f), 'key')); }
+
+// string + min + max (fused), followed by a string-specialized regex
+$v = new Validator([
+    'name' => ['required', 'string', ['min', 2], ['max', 5], ['regex', '/^[a-z]+$/']],
+    'code' => ['string', ['max', 3], ['min', 5]],
+    'tags' => ['array', ['min', 1], ['max', 2]],
+]);
+echo keys($v->validate(['name' => 'abc']), 'name'), "|\n";
+echo keys($v->validate(['name' => 'a']), 'name'), "\n";
+echo keys($v->validate(['name' => 'abcdefg']), 'name'), "\n";
+echo keys($v->validate(['name' => 'ABC']), 'name'), "\n";
+// UTF-8 length, not bytes
+echo keys($v->validate(['name' => 'čćž']), 'name'), "\n";
+// non-string: min/max still judge the integer as they would unfused
+echo keys($v->validate(['name' => 1]), 'name'), "\n";
+echo keys($v->validate(['name' => 9]), 'name'), "\n";
+// max declared before min keeps its order
+echo keys($v->validate(['code' => 'abcd']), 'code'), "\n";
+// array guard + specialized count checks
+echo keys($v->validate(['tags' => []]), 'tags'), "\n";
+echo keys($v->validate(['tags' => [1, 2, 3]]), 'tags'), "\n";
+echo keys($v->validate(['tags' => 'x']), 'tags'), "\n";
+
+// nullable + integer + gt
+$v = new Validator(['age' => ['nullable', 'integer', ['gt', 17]]]);
+var_dump($v->validate(['age' => 18])->valid());
+var_dump($v->validate(['age' => null])->valid());
+var_dump($v->validate(['age' => '18'])->valid());
+echo keys($v->validate(['age' => 17]), 'age'), "\n";
+echo keys($v->validate(['age' => 'x']), 'age'), "\n";
+
+// required + email
+$v = new Validator(['email' => ['required', 'email']]);
+var_dump($v->validate(['email' => 'a@b.co'])->valid());
+echo keys($v->validate(['email' => 'nope']), 'email'), "\n";
+echo keys($v->validate(['email' => '']), 'email'), "\n";
+echo keys($v->validate([]), 'email'), "\n";
+
+// nullable empty value passes specialized rules through the generic path
+$v = new Validator(['nick' => ['string', ['regex', '/^x$/'], 'nullable']]);
+var_dump($v->validate(['nick' => ''])->valid());
+
+echo "OK\n";
+?>
+--EXPECT--
+|
+validation.min
+validation.max
+validation.regex
+validation.regex
+validation.string,validation.min,validation.regex
+validation.string,validation.max,validation.regex
+validation.max,validation.min
+validation.min
+validation.max
+validation.array
+bool(true)
+bool(true)
+bool(true)
+validation.gt
+validation.integer,validation.gt
+bool(true)
+validation.email
+validation.required,validation.email
+validation.required,validation.email
+bool(true)
+OK
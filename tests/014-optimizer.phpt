@@ -0,0 +1,87 @@
+--TEST--
+Rule-chain optimizer, bail rule and validator options
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+use Signalforge\Validation\InvalidRuleException;
+
+function keys($r, $f) { return implode(',', array_column($r->errorsFor($f), 'key')); }
+
+// Merged min/max keeps both errors in declared order
+$v = new Validator([
+    'qty' => ['numeric', ['min', 3], ['max', 5]],
+    'code' => [['max', 2], ['min', 5]],
+]);
+echo keys($v->validate(['qty' => 7]), 'qty'), "\n";
+echo keys($v->validate(['qty' => 1]), 'qty'), "\n";
+echo keys($v->validate(['code' => 'abcd']), 'code'), "\n";
+
+// Hoisted nullable: null/empty skip the chain but stay in validated()
+$v = new Validator(['mail' => ['nullable', 'email']]);
+var_dump($v->validate(['mail' => ''])->validated());
+var_dump($v->validate([])->valid());
+echo keys($v->validate(['mail' => 'x']), 'mail'), "\n";
+
+// Redundant string guard before email
+$rules = ['mail' => ['string', 'email']];
+echo keys((new Validator($rules))->validate(['mail' => 5]), 'mail'), "\n";
+echo keys((new Validator($rules, ['optimize' => false]))->validate(['mail' => 5]), 'mail'), "\n";
+
+// Without bail every rule runs in declared order
+$v = new Validator(['slug' => [['regex', '/^[a-z]+$/'], ['max', 3]]]);
+echo keys($v->validate(['slug' => 'ABCDE']), 'slug'), "\n";
+
+// With bail, cheap rules run first
+$rules = ['slug' => ['bail', ['regex', '/^[a-z]+$/'], ['max', 3]]];
+echo keys((new Validator($rules))->validate(['slug' => 'ABCDE']), 'slug'), "\n";
+echo keys((new Validator($rules, ['optimize' => false]))->validate(['slug' => 'ABCDE']), 'slug'), "\n";
+var_dump((new Validator($rules))->validate(['slug' => 'abc'])->valid());
+
+// Validator-wide bail option, also through make()
+$rules = ['slug' => [['regex', '/^[a-z]+$/'], ['max', 3]]];
+echo keys((new Validator($rules, ['bail' => true]))->validate(['slug' => 'ABCDE']), 'slug'), "\n";
+echo keys(Validator::make([], $rules, ['bail' => true, 'optimize' => false])->validate(['slug' => 'ABCDE']), 'slug'), "\n";
+
+// nullable stays a barrier when reordering
+$v = new Validator(['n' => ['bail', 'required', ['regex', '/^\d+$/'], 'nullable', ['max', 2]]]);
+echo keys($v->validate(['n' => 'abc']), 'n'), "\n";
+
+// Clones keep the compiled options
+$v = new Validator(['slug' => ['bail', ['regex', '/^[a-z]+$/'], ['max', 3]]]);
+$c = clone $v;
+unset($v);
+echo keys($c->validate(['slug' => 'ABCDE']), 'slug'), "\n";
+
+// Unknown options are rejected
+try {
+    new Validator([], ['fast' => true]);
+} catch (InvalidRuleException $e) {
+    echo $e->getMessage(), "\n";
+}
+
+echo "OK\n";
+?>
+--EXPECT--
+validation.max
+validation.min
+validation.max,validation.min
+array(1) {
+  ["mail"]=>
+  string(0) ""
+}
+bool(true)
+validation.email
+validation.email
+validation.string,validation.email
+validation.regex,validation.max
+validation.max
+validation.regex
+bool(true)
+validation.max
+validation.regex
+validation.regex
+validation.max
+Unknown validator option: fast
+OK
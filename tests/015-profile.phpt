@@ -0,0 +1,115 @@
+--TEST--
+Profile-guided rule ordering, export and import
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+use Signalforge\Validation\InvalidRuleException;
+
+function keys($r, $f) { return implode(',', array_column($r->errorsFor($f), 'key')); }
+function summary($profile) {
+    foreach ($profile as $field => $entries) {
+        foreach ($entries as $e) {
+            echo "$field: {$e['rule']}#{$e['slot']} runs={$e['runs']} fails={$e['fails']}",
+                is_int($e['time']) && $e['time'] >= 0 ? '' : ' bad-time', "\n";
+        }
+    }
+}
+
+$rules = [
+    'slug' => ['bail', ['regex', '/^[a-z]+$/'], ['max', 3]],
+    'name' => ['string'],
+];
+$options = ['optimize' => false, 'profile' => true];
+
+// Statistics are recorded for bail fields only
+$v = new Validator($rules, $options);
+echo keys($v->validate(['slug' => 'ABCDE']), 'slug'), "\n";
+$v->validate(['slug' => 'abcde']);
+$v->validate(['slug' => 'abc']);
+summary($v->exportProfile());
+
+// Without the option nothing is recorded
+var_dump((new Validator($rules))->exportProfile());
+
+// An imported profile reorders immediately: max rejects most input cheaply
+$profile = ['slug' => [
+    ['rule' => 'regex', 'slot' => 0, 'runs' => 1000, 'fails' => 10, 'time' => 500000],
+    ['rule' => 'max', 'slot' => 1, 'runs' => 990, 'fails' => 400, 'time' => 20000],
+]];
+$v = new Validator($rules, ['optimize' => false]);
+$v->importProfile($profile);
+echo keys($v->validate(['slug' => 'ABCDE']), 'slug'), "\n";
+var_dump($v->validate(['slug' => 'abc'])->valid());
+summary($v->exportProfile());
+
+// Round trip into a fresh worker, and through clone
+$w = new Validator($rules, $options);
+$w->importProfile($v->exportProfile());
+echo keys($w->validate(['slug' => 'ABCDE']), 'slug'), "\n";
+$c = clone $w;
+unset($w);
+echo keys($c->validate(['slug' => 'ABCDE']), 'slug'), "\n";
+
+// Stale entries (rule changed, unknown slot or field) are ignored
+$v = new Validator($rules, ['optimize' => false]);
+$v->importProfile([
+    'slug' => [
+        ['rule' => 'email', 'slot' => 1, 'runs' => 990, 'fails' => 400, 'time' => 20000],
+        ['rule' => 'max', 'slot' => 7, 'runs' => 990, 'fails' => 400, 'time' => 20000],
+    ],
+    'gone' => [['rule' => 'max', 'slot' => 0, 'runs' => 1, 'fails' => 1, 'time' => 1]],
+]);
+echo keys($v->validate(['slug' => 'ABCDE']), 'slug'), "\n";
+
+// Numeric field names export as integer keys and import back through JSON or var_export()
+$numeric = [7 => $rules['slug']];
+$v = new Validator($numeric, ['optimize' => false]);
+$v->importProfile([7 => $profile['slug']]);
+$exported = $v->exportProfile();
+var_dump(array_keys($exported));
+foreach ([json_decode(json_encode($exported), true), eval('return ' . var_export($exported, true) . ';')] as $copy) {
+    $w = new Validator($numeric, ['optimize' => false]);
+    $w->importProfile($copy);
+    echo $w->validate([7 => 'ABCDE'])->errors()[7][0]['key'], "\n";
+}
+
+// Malformed profiles are rejected
+foreach ([
+    ['slug' => 'x'],
+    ['slug' => [['rule' => 'max', 'slot' => 1, 'runs' => 1, 'fails' => 2, 'time' => 0]]],
+    ['slug' => [['rule' => 'max', 'slot' => 1]]],
+] as $bad) {
+    try {
+        $v->importProfile($bad);
+    } catch (InvalidRuleException $e) {
+        echo $e->getMessage(), "\n";
+    }
+}
+
+echo "OK\n";
+?>
+--EXPECT--
+validation.regex
+slug: regex#0 runs=3 fails=1
+slug: max#1 runs=2 fails=1
+array(0) {
+}
+validation.max
+bool(true)
+slug: max#1 runs=990 fails=400
+slug: regex#0 runs=1000 fails=10
+validation.max
+validation.max
+validation.regex
+array(1) {
+  [0]=>
+  int(7)
+}
+validation.max
+validation.max
+Invalid profile: expected a list of rule entries per field
+Invalid profile entry for field 'slug'
+Invalid profile entry for field 'slug'
+OK
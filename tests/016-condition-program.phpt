@@ -0,0 +1,89 @@
+--TEST--
+Compiled and/or conditions short-circuit like the nested trees they replace
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+function applies($cond, $data) {
+    $v = new Validator(['x' => [['when', $cond, ['required']]]]);
+    return $v->validate($data)->failed();
+}
+
+// or(and(a = 1, b = 2), c filled)
+$cond = ['or', ['and', ['a', '=', 1], ['b', '=', 2]], ['c', 'filled']];
+var_dump(applies($cond, ['a' => 1, 'b' => 2]));
+var_dump(applies($cond, ['a' => 1, 'b' => 3]));
+var_dump(applies($cond, ['a' => 2, 'b' => 2, 'c' => 'y']));
+var_dump(applies($cond, []));
+
+// Empty compounds: 'and' always holds, 'or' never does
+var_dump(applies(['and'], []));
+var_dump(applies(['or'], []));
+var_dump(applies(['and', ['or'], ['a', '=', 1]], ['a' => 1]));
+var_dump(applies(['or', ['and'], ['a', '=', 1]], []));
+
+// Random nested trees agree with a reference evaluator on every input
+mt_srand(42);
+function tree($depth) {
+    if ($depth === 0 || mt_rand(0, 3) === 0) {
+        return [chr(ord('a') + mt_rand(0, 3)), mt_rand(0, 1) ? '=' : '!=', 1];
+    }
+    $node = [mt_rand(0, 1) ? 'and' : 'or'];
+    for ($i = mt_rand(1, 3); $i > 0; $i--) {
+        $node[] = tree($depth - 1);
+    }
+    return $node;
+}
+function reference($c, $data) {
+    if ($c[0] === 'and' || $c[0] === 'or') {
+        foreach (array_slice($c, 1) as $child) {
+            $r = reference($child, $data);
+            if ($c[0] === 'and' && !$r) return false;
+            if ($c[0] === 'or' && $r) return true;
+        }
+        return $c[0] === 'and';
+    }
+    $eq = ($data[$c[0]] ?? null) == $c[2];
+    return $c[1] === '=' ? $eq : !$eq;
+}
+
+$mismatches = 0;
+for ($t = 0; $t < 50; $t++) {
+    $cond = tree(6);
+    for ($bits = 0; $bits < 16; $bits++) {
+        $data = [];
+        foreach (['a', 'b', 'c', 'd'] as $i => $k) {
+            $data[$k] = ($bits >> $i) & 1;
+        }
+        if (applies($cond, $data) !== reference($cond, $data)) {
+            $mismatches++;
+        }
+    }
+}
+echo "mismatches: $mismatches\n";
+
+// Deep nesting within the parse limit
+$cond = ['a', '=', 1];
+for ($i = 0; $i < 30; $i++) {
+    $cond = [$i % 2 ? 'and' : 'or', $cond, ['b', '=', 1]];
+}
+var_dump(applies($cond, ['a' => 1, 'b' => 1]));
+var_dump(applies($cond, ['a' => 0, 'b' => 0]));
+
+echo "OK\n";
+?>
+--EXPECT--
+bool(true)
+bool(false)
+bool(true)
+bool(false)
+bool(true)
+bool(false)
+bool(false)
+bool(true)
+mismatches: 0
+bool(true)
+bool(false)
+OK
@@ -0,0 +1,78 @@
+--TEST--
+Typed condition operands, nested field subjects and in/not_in sets
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+function applies($cond, $data, $field = 'x') {
+    $v = new Validator([$field => [['when', $cond, ['required']]]]);
+    return $v->validate($data)->failed();
+}
+
+// Nested field subjects, with a literal dotted key as fallback
+$cond = ['address.country', '=', 'HR'];
+var_dump(applies($cond, ['address' => ['country' => 'HR']]));
+var_dump(applies($cond, ['address' => ['country' => 'SI']]));
+var_dump(applies($cond, ['address' => 'HR']));
+var_dump(applies($cond, ['address.country' => 'HR']));
+var_dump(applies(['items.1', 'filled'], ['items' => ['a', 'b']]));
+var_dump(applies(['items.2', 'filled'], ['items' => ['a', 'b']]));
+
+// @type names
+var_dump(applies(['@type', '=', 'integer'], ['x' => 5]));
+var_dump(applies(['@type', 'in', ['string', 'array']], ['x' => [1]]));
+var_dump(applies(['@type', '=', 'null'], []));
+
+// Typed and hashed operands agree with PHP's own comparisons
+$values = [0, 1, -1, 2, 10, 1.0, 1.5, -0.0, INF, -INF, '', '0', '1', '01', '1.0', ' 1', '1 ',
+    '1e0', '10', '1abc', 'abc', 'ABC', 'abd', null, true, false, [], [1], 9007199254740993];
+$ops = ['=' => fn($a, $b) => $a == $b, '!=' => fn($a, $b) => $a != $b,
+    '>' => fn($a, $b) => $a > $b, '>=' => fn($a, $b) => $a >= $b,
+    '<' => fn($a, $b) => $a < $b, '<=' => fn($a, $b) => $a <= $b];
+$lists = [[1, 2, 10], ['abc', 'x y', '', 'INF'], [1, 'abc'], ['1', 'abc'], [1.5, 2], [true], [],
+    [9007199254740992]];
+
+$mismatches = 0;
+foreach ($values as $subject) {
+    foreach ($values as $constant) {
+        foreach ($ops as $op => $fn) {
+            if (applies(['f', $op, $constant], ['f' => $subject]) !== $fn($subject, $constant)) {
+                $mismatches++;
+            }
+        }
+    }
+    foreach ($lists as $list) {
+        $in = in_array($subject, $list);
+        if (applies(['f', 'in', $list], ['f' => $subject]) !== $in
+            || applies(['f', 'not_in', $list], ['f' => $subject]) !== !$in) {
+            $mismatches++;
+        }
+    }
+}
+echo "mismatches: $mismatches\n";
+
+// Compiled operands survive clone
+$v = new Validator(['x' => [['when', ['a.b', 'in', ['p', 'q']], ['required']]]]);
+$c = clone $v;
+unset($v);
+var_dump($c->validate(['a' => ['b' => 'q']])->failed());
+var_dump($c->validate(['a' => ['b' => 'r']])->failed());
+
+echo "OK\n";
+?>
+--EXPECT--
+bool(true)
+bool(false)
+bool(false)
+bool(true)
+bool(true)
+bool(false)
+bool(true)
+bool(true)
+bool(true)
+mismatches: 0
+bool(true)
+bool(false)
+OK
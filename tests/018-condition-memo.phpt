@@ -0,0 +1,66 @@
+--TEST--
+Invariant when-conditions are evaluated once per validate() call
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$business = ['type', '=', 'business'];
+$v = new Validator([
+    'items.*.vat' => [['when', $business, ['required'], ['nullable', 'integer']]],
+    'items.*.note' => [['when', ['@filled'], ['string', ['max', 3]]]],
+    'company' => [['when', $business, ['required']]],
+    'vat_id' => [['when', ['and', ['type', '=', 'business'], ['country', 'in', ['HR', 'SI']]], ['required']]],
+]);
+
+$items = [['vat' => 25, 'note' => 'ok'], ['note' => 'too long'], ['vat' => 'x']];
+
+// The memo is reset between calls: each sees its own data
+echo keys($v->validate(['type' => 'business', 'items' => $items])), "\n";
+echo keys($v->validate(['type' => 'personal', 'items' => $items])), "\n";
+echo keys($v->validate(['type' => 'business', 'country' => 'HR', 'company' => 'Acme', 'items' => []])), "\n";
+echo keys($v->validate(['type' => 'business', 'country' => 'AT'])), "\n";
+
+// Clones keep their memo slots
+$c = clone $v;
+unset($v);
+echo keys($c->validate(['type' => 'business', 'items' => [[]]])), "\n";
+
+// Lazy clones compile further conditions against the memo slots they copied
+$v = new Validator([
+    'x' => ['sometimes', 'array'],
+    'x.a' => [['when', $business, ['required']]],
+    'y' => ['sometimes', 'array'],
+    'y.b' => [['when', ['type', '=', 'business'], ['required']]],
+    'y.c' => [['when', ['type', '=', 'personal'], ['required']]],
+], ['lazy' => true]);
+$v->validate(['x' => []]);
+$c = clone $v;
+echo keys($c->validate(['type' => 'business', 'x' => [], 'y' => []])), "\n";
+echo keys($c->validate(['type' => 'personal', 'x' => [], 'y' => []])), "\n";
+
+// More distinct conditions than fit on the stack
+$rules = [];
+for ($i = 0; $i < 100; $i++) {
+    $rules["f$i"] = [['when', ['k', '=', $i], ['required']]];
+}
+$v = new Validator($rules);
+echo keys($v->validate(['k' => 42])), "\n";
+echo keys($v->validate(['k' => 99, 'f99' => 1])), "\n";
+
+echo "OK\n";
+?>
+--EXPECT--
+items.1.vat:validation.required items.1.note:validation.max company:validation.required
+items.1.note:validation.max items.2.vat:validation.integer
+vat_id:validation.required
+company:validation.required
+items.0.vat:validation.required company:validation.required
+x.a:validation.required y.b:validation.required
+y.c:validation.required
+f42:validation.required
+valid
+OK
@@ -0,0 +1,85 @@
+--TEST--
+Compiled field paths and field references
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$v = new Validator([
+    'user.address.city' => ['required', 'string'],
+    'lines.1' => ['required', 'integer'],
+    'user.email' => ['required', ['different', 'user.backup.email']],
+    'user.password' => ['required', 'confirmed'],
+    'trip.end' => ['required', ['after', 'trip.start']],
+    'repeat' => [['same', 'user.address.city']],
+]);
+
+$data = [
+    'user' => [
+        'address' => ['city' => 'Zagreb'],
+        'email' => 'a@example.com',
+        'backup' => ['email' => 'b@example.com'],
+        'password' => 'secret',
+        'password_confirmation' => 'secret',
+    ],
+    'lines' => [5, 7],
+    'trip' => ['start' => '2024-01-01', 'end' => '2024-02-01'],
+    'repeat' => 'Zagreb',
+];
+var_dump($v->validate($data)->valid());
+var_dump(array_keys($v->validate($data)->validated()));
+
+$bad = $data;
+$bad['user']['address'] = 'Zagreb';
+$bad['lines'] = ['x', 'y'];
+$bad['user']['backup']['email'] = 'a@example.com';
+$bad['user']['password_confirmation'] = 'other';
+$bad['trip']['end'] = '2023-12-31';
+echo keys($v->validate($bad)), "\n";
+
+// String keys win over integer keys, as before
+$v = new Validator(['m.1' => ['required', ['same', 'm.01']]]);
+var_dump($v->validate(['m' => [1 => 'a', '01' => 'a']])->valid());
+var_dump($v->validate(['m' => [1 => 'a', '01' => 'b']])->valid());
+
+// confirmed on wildcard fields still resolves per element
+$v = new Validator(['pins.*.code' => ['confirmed']]);
+echo keys($v->validate(['pins' => [['code' => '1234', 'code_confirmation' => '1234']]])), "|\n";
+echo keys($v->validate(['pins' => [['code' => '1234', 'code_confirmation' => '9']]])), "|\n";
+
+// Clones own their paths
+$v = new Validator(['a.b' => [['same', 'c.d'], 'confirmed']]);
+$c = clone $v;
+unset($v);
+var_dump($c->validate(['a' => ['b' => 1, 'b_confirmation' => 1], 'c' => ['d' => 1]])->valid());
+echo keys($c->validate(['a' => ['b' => 1], 'c' => ['d' => 2]])), "\n";
+
+echo "OK\n";
+?>
+--EXPECT--
+bool(true)
+array(6) {
+  [0]=>
+  string(17) "user.address.city"
+  [1]=>
+  string(7) "lines.1"
+  [2]=>
+  string(10) "user.email"
+  [3]=>
+  string(13) "user.password"
+  [4]=>
+  string(8) "trip.end"
+  [5]=>
+  string(6) "repeat"
+}
+user.address.city:validation.required,validation.string lines.1:validation.integer user.email:validation.different user.password:validation.confirmed trip.end:validation.after repeat:validation.same
+bool(true)
+bool(false)
+valid|
+pins.0.code:validation.confirmed|
+bool(true)
+a.b:validation.same,validation.confirmed
+OK
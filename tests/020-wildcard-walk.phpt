@@ -0,0 +1,76 @@
+--TEST--
+Wildcard fields are walked in data order with concrete element paths
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$v = new Validator([
+    'items.*.name' => ['required', 'string'],
+    'matrix.*.*' => ['integer'],
+    'tags.*' => ['string'],
+]);
+
+$data = [
+    'items' => [['name' => 'a'], ['price' => 1], 'scalar', ['name' => 5]],
+    'matrix' => [[1, 2], ['x' => 3, 'y' => 'z'], 7],
+    'tags' => [5 => 'a', -2 => 'b', 'k' => 3],
+];
+echo keys($v->validate($data)), "\n";
+var_dump(array_keys($v->validate($data)->validated()));
+
+// Holes in packed arrays, empty and missing collections
+$v = new Validator(['list.*' => ['integer']]);
+$list = [1, 2, 3];
+unset($list[1]);
+var_dump(array_keys($v->validate(['list' => $list])->validated()));
+var_dump($v->validate(['list' => []])->valid());
+var_dump($v->validate([])->valid());
+var_dump($v->validate(['list' => 'nope'])->valid());
+
+// Rules that read the element path
+$v = new Validator(['users.*.pin' => ['confirmed']]);
+echo keys($v->validate(['users' => [
+    ['pin' => '1', 'pin_confirmation' => '1'],
+    ['pin' => '2', 'pin_confirmation' => '3'],
+]])), "\n";
+
+// Long keys: the path stays correct as the cursor grows
+$long = str_repeat('k', 300);
+$v = new Validator(['deep.*.*' => ['integer']]);
+echo keys($v->validate(['deep' => [$long => [$long => 'x', 'b' => 1]]])) === "deep.$long.$long:validation.integer"
+    ? "long ok\n" : "long broken\n";
+
+echo "OK\n";
+?>
+--EXPECT--
+items.1.name:validation.required,validation.string items.2.name:validation.required,validation.string items.3.name:validation.string matrix.1.y:validation.integer tags.k:validation.string
+array(6) {
+  [0]=>
+  string(12) "items.0.name"
+  [1]=>
+  string(10) "matrix.0.0"
+  [2]=>
+  string(10) "matrix.0.1"
+  [3]=>
+  string(10) "matrix.1.x"
+  [4]=>
+  string(6) "tags.5"
+  [5]=>
+  string(7) "tags.-2"
+}
+array(2) {
+  [0]=>
+  string(6) "list.0"
+  [1]=>
+  string(6) "list.2"
+}
+bool(true)
+bool(true)
+bool(true)
+users.1.pin:validation.confirmed
+long ok
+OK
@@ -0,0 +1,59 @@
+--TEST--
+Wildcard fields over the same collection share one traversal
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$rules = [
+    'items.*.name' => ['required', 'string'],
+    'total' => ['required', 'numeric'],
+    'items.*' => ['array'],
+    'items.*.price' => ['required', 'numeric'],
+    'items.*.tags.*' => ['string'],
+    'notes.*' => ['string'],
+];
+$v = new Validator($rules);
+
+$data = [
+    'items' => [
+        ['name' => 'a', 'price' => 'x', 'tags' => ['t', 1]],
+        'oops',
+        ['name' => 7, 'price' => 2, 'tags' => [2 => 'ok', 'k' => []]],
+    ],
+    'notes' => [1],
+];
+
+// All items fields run per element (parents first), at the position of the first one;
+// a failed items.* closes its element
+echo keys($v->validate($data)), "\n";
+var_dump(array_keys($v->validate($data)->validated()));
+
+// Clones rebuild the trie
+$c = clone $v;
+unset($v);
+echo keys($c->validate(['total' => 1, 'items' => [['name' => 'n', 'price' => 1, 'tags' => [3]]]])), "\n";
+
+echo "OK\n";
+?>
+--EXPECT--
+items.0.price:validation.numeric items.0.tags.1:validation.string items.1:validation.array items.2.name:validation.string items.2.tags.k:validation.string total:validation.required,validation.numeric notes.0:validation.string
+array(6) {
+  [0]=>
+  string(7) "items.0"
+  [1]=>
+  string(12) "items.0.name"
+  [2]=>
+  string(14) "items.0.tags.0"
+  [3]=>
+  string(7) "items.2"
+  [4]=>
+  string(13) "items.2.price"
+  [5]=>
+  string(14) "items.2.tags.2"
+}
+items.0.tags.0:validation.string
+OK
@@ -0,0 +1,75 @@
+--TEST--
+Parent fields run first and gate the wildcard fields below them; sometimes skips absent subtrees
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+// The parent runs first even when declared after its wildcard fields
+$v = new Validator([
+    'items.*.name' => ['required', 'string'],
+    'items' => ['required', 'array', ['max', 3]],
+]);
+echo keys($v->validate(['items' => array_fill(0, 100000, [])])), "\n";
+echo keys($v->validate(['items' => 'no'])), "\n";
+echo keys($v->validate([])), "\n";
+echo keys($v->validate(['items' => [['name' => 'a'], []]])), "\n";
+
+// A failed ancestor closes wildcard fields below a passing plain child
+$v = new Validator([
+    'groups' => [['max', 1]],
+    'groups.list' => ['array'],
+    'groups.list.*' => ['integer'],
+]);
+echo keys($v->validate(['groups' => ['list' => ['a'], 'x' => 1]])), "\n";
+echo keys($v->validate(['groups' => ['list' => ['a']]])), "\n";
+
+// A failed wildcard parent closes its element only
+$v = new Validator([
+    'rows.*' => ['array'],
+    'rows.*.id' => ['required'],
+]);
+echo keys($v->validate(['rows' => [['id' => 1], 5, []]])), "\n";
+
+// sometimes: absent fields and everything below them are not validated
+$v = new Validator([
+    'profile' => ['sometimes', 'array'],
+    'profile.name' => ['required', 'string'],
+    'profile.tags.*' => ['string'],
+    'nick' => ['sometimes', 'string', ['min', 3]],
+    'lines.*.qty' => ['sometimes', 'integer'],
+]);
+var_dump($v->validate([])->valid());
+echo keys($v->validate(['profile' => ['tags' => [1]], 'nick' => 'ab'])), "\n";
+echo keys($v->validate(['lines' => [['qty' => 'x'], []]])), "\n";
+var_dump(array_keys($v->validate(['nick' => 'abcd', 'lines' => [['qty' => 1], []]])->validated()));
+
+// Clones keep the run order
+$c = clone $v;
+unset($v);
+var_dump($c->validate(['lines' => [[]]])->valid());
+
+echo "OK\n";
+?>
+--EXPECT--
+items:validation.max
+items:validation.array
+items:validation.required,validation.array
+items.1.name:validation.required,validation.string
+groups:validation.max
+groups.list.0:validation.integer
+rows.1:validation.array rows.2.id:validation.required
+bool(true)
+profile.name:validation.required,validation.string profile.tags.0:validation.string nick:validation.min
+lines.0.qty:validation.integer
+array(2) {
+  [0]=>
+  string(4) "nick"
+  [1]=>
+  string(11) "lines.0.qty"
+}
+bool(true)
+OK
@@ -0,0 +1,71 @@
+--TEST--
+Field references and condition subjects bound to the current wildcard element
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$v = new Validator([
+    'items.*.start' => ['required', 'date'],
+    'items.*.end' => ['required', ['after', 'items.*.start']],
+    'items.*.check' => ['nullable', ['before_or_equal', '^.end']],
+    'items.*.vat' => [['when', ['^.type', '=', 'business'], ['required']]],
+]);
+echo keys($v->validate(['items' => [
+    ['start' => '2024-01-01', 'end' => '2024-02-01', 'type' => 'business', 'vat' => 'HR1', 'check' => '2024-02-01'],
+    ['start' => '2024-03-01', 'end' => '2024-02-01', 'type' => 'business'],
+    ['start' => '2024-01-01', 'end' => '2024-01-05', 'type' => 'private', 'check' => '2024-01-06'],
+]])), "\n";
+
+// Nested wildcards: either form reaches the outer element
+$v = new Validator([
+    'orders.*.lines.*.qty' => [['when', ['orders.*.status', '=', 'open'], ['required']]],
+    'orders.*.lines.*.note' => [['when', ['^.^.^.status', '=', 'open'], ['required']]],
+]);
+echo keys($v->validate(['orders' => [
+    ['status' => 'open', 'lines' => [['note' => 'x'], ['qty' => 1]]],
+    ['status' => 'closed', 'lines' => [[]]],
+]])), "\n";
+
+// On plain fields a relative reference is an ordinary path
+$v = new Validator(['trip.end' => [['after', '^.start']]]);
+var_dump($v->validate(['trip' => ['start' => '2024-01-01', 'end' => '2024-02-01']])->valid());
+var_dump($v->validate(['trip' => ['start' => '2024-03-01', 'end' => '2024-02-01']])->valid());
+
+// Clones keep bound references
+$v = new Validator(['rows.*.b' => [['same', '^.a']]]);
+$c = clone $v;
+unset($v);
+echo keys($c->validate(['rows' => [['a' => 1, 'b' => 1], ['a' => 1, 'b' => 2]]])), "\n";
+
+// References that do not fit the field
+foreach ([
+    ['a.*.b' => [['same', 'c.*.d']]],
+    ['x' => [['same', '^.^.y']]],
+    ['a.*.b' => [['same', 'a.^.c']]],
+    ['a.*.b' => [['when', ['b.*.c', 'filled'], ['required']]]],
+] as $rules) {
+    try {
+        new Validator($rules);
+        echo "no exception\n";
+    } catch (Signalforge\Validation\InvalidRuleException $e) {
+        echo $e->getMessage(), "\n";
+    }
+}
+
+echo "OK\n";
+?>
+--EXPECT--
+items.1.end:validation.after items.1.vat:validation.required items.2.check:validation.before_or_equal
+orders.0.lines.0.qty:validation.required orders.0.lines.1.note:validation.required
+bool(true)
+bool(false)
+rows.1.b:validation.same
+Field reference 'c.*.d' does not fit field 'a.*.b'
+Field reference '^.^.y' does not fit field 'x'
+Field reference 'a.^.c' does not fit field 'a.*.b'
+Condition field reference does not fit field 'a.*.b'
+OK
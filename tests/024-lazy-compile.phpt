@@ -0,0 +1,98 @@
+--TEST--
+Lazy mode compiles each field the first time validate() runs it
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$rules = [
+    'email' => ['required', 'email'],
+    'items' => ['required', 'array'],
+    'items.*.qty' => ['required', 'integer', ['min', 1]],
+    'items.*.end' => ['nullable', ['after', '^.start']],
+    'ship' => ['sometimes', 'array'],
+    'ship.zip' => [['when', ['country', '=', 'US'], ['required', ['regex', '/^\d{5}$/']]]],
+];
+$data = [
+    'email' => 'nope',
+    'country' => 'US',
+    'items' => [['qty' => 0], ['qty' => 2, 'start' => '2024-02-01', 'end' => '2024-01-01']],
+    'ship' => ['zip' => '1234'],
+];
+
+// Same results as the eager validator, on every call
+$eager = new Validator($rules);
+$lazy = new Validator($rules, ['lazy' => true]);
+echo keys($eager->validate($data)), "\n";
+echo keys($lazy->validate($data)), "\n";
+echo keys($lazy->validate($data)), "\n";
+var_dump($lazy->validate(['email' => 'a@b.co', 'items' => [['qty' => 1]]])->valid());
+
+// Invalid rules throw from validate() once the field runs
+$v = new Validator([
+    'name' => ['required'],
+    'extra' => ['sometimes', 'bogus_rule'],
+    'rows.*.x' => [['min']],
+], ['lazy' => true]);
+var_dump($v->validate(['name' => 'a'])->valid());
+foreach ([['name' => 'a', 'extra' => 1], ['name' => 'a', 'rows' => [[]]]] as $input) {
+    try {
+        $v->validate($input);
+        echo "no exception\n";
+    } catch (Signalforge\Validation\InvalidRuleException $e) {
+        echo $e->getMessage(), "\n";
+    }
+}
+
+// Field names are still checked at construction
+try {
+    new Validator(['1bad' => ['required']], ['lazy' => true]);
+} catch (Signalforge\Validation\InvalidRuleException $e) {
+    echo $e->getMessage(), "\n";
+}
+
+// Clones share nothing: each compiles its own fields
+$v = new Validator($rules, ['lazy' => true]);
+$c = clone $v;
+echo keys($v->validate($data)), "\n";
+unset($v);
+echo keys($c->validate($data)), "\n";
+
+// Integer top-level keys reach wildcard groups as in eager mode
+$rules = ['7.*.code' => ['integer'], '0.*.x' => ['required']];
+$input = [7 => [['code' => 'a']], 0 => [['y' => 1]]];
+echo keys((new Validator($rules))->validate($input)), "\n";
+echo keys((new Validator($rules, ['lazy' => true]))->validate($input)), "\n";
+
+// Profiling extends its statistics to fields compiled later
+$v = new Validator(['a' => ['required', 'integer'], 'b' => ['sometimes', 'string']],
+    ['lazy' => true, 'bail' => true, 'profile' => true]);
+$v->validate(['a' => 'x']);
+$v->validate(['a' => 1, 'b' => 2]);
+var_dump(array_keys($v->exportProfile()));
+
+echo "OK\n";
+?>
+--EXPECT--
+email:validation.email items.0.qty:validation.min items.1.end:validation.after ship.zip:validation.regex
+email:validation.email items.0.qty:validation.min items.1.end:validation.after ship.zip:validation.regex
+email:validation.email items.0.qty:validation.min items.1.end:validation.after ship.zip:validation.regex
+bool(true)
+bool(true)
+Unknown validation rule: bogus_rule
+Rule 'min' requires a parameter
+Invalid field name: 1bad
+email:validation.email items.0.qty:validation.min items.1.end:validation.after ship.zip:validation.regex
+email:validation.email items.0.qty:validation.min items.1.end:validation.after ship.zip:validation.regex
+7.0.code:validation.integer 0.0.x:validation.required
+7.0.code:validation.integer 0.0.x:validation.required
+array(2) {
+  [0]=>
+  string(1) "a"
+  [1]=>
+  string(1) "b"
+}
+OK
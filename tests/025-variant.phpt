@@ -0,0 +1,94 @@
+--TEST--
+Variant rules and same-field when chains dispatch through a case table
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$v = new Validator([
+    'details' => [['variant', 'method', [
+        'card' => ['required', 'array'],
+        'bank' => ['required', ['min', 5]],
+        7 => ['integer'],
+    ], ['nullable', 'string']]],
+]);
+foreach ([
+    ['method' => 'card', 'details' => 'x'],
+    ['method' => 'bank', 'details' => 'abc'],
+    ['method' => '7', 'details' => 'x'],
+    ['method' => 7.0, 'details' => 3],
+    ['details' => 5],
+    ['method' => 'other', 'details' => null],
+    ['method' => true, 'details' => 'x'],
+] as $data) {
+    echo keys($v->validate($data)), "\n";
+}
+
+// Clones keep the case table
+$c = clone $v;
+unset($v);
+echo keys($c->validate(['method' => 'bank', 'details' => 'abcdef'])), "\n";
+
+// Relative discriminator inside a wildcard field
+$v = new Validator([
+    'pay.*.ref' => [['variant', '^.kind', ['iban' => ['integer'], 'oib' => ['string']]]],
+]);
+echo keys($v->validate(['pay' => [
+    ['kind' => 'iban', 'ref' => 'a'],
+    ['kind' => 'oib', 'ref' => 5],
+    ['kind' => 'x', 'ref' => []],
+]])), "\n";
+
+// A when chain on one field: same results as before, including a boolean
+// subject that equals every constant
+$v = new Validator(['x' => [
+    ['when', ['t', '=', 'a'], ['integer']],
+    ['when', ['t', '=', 'b'], [['min', 3]]],
+    ['when', ['t', '=', 'c'], ['email']],
+]]);
+foreach (['a', 'b', 'c', 'd', true, null] as $t) {
+    echo keys($v->validate(['t' => $t, 'x' => 'zz'])), "\n";
+}
+
+foreach ([
+    ['x' => [['variant']]],
+    ['x' => [['variant', 't']]],
+    ['x' => [['variant', 't', ['a' => 'required']]]],
+    ['x' => [['variant', 't', ['a' => ['bogus']]]]],
+    ['x' => [['variant', '^.^.t', ['a' => []]]]],
+] as $rules) {
+    try {
+        new Validator($rules);
+        echo "no exception\n";
+    } catch (Signalforge\Validation\InvalidRuleException $e) {
+        echo $e->getMessage(), "\n";
+    }
+}
+
+echo "OK\n";
+?>
+--EXPECT--
+details:validation.array
+details:validation.min
+details:validation.integer
+valid
+details:validation.string
+valid
+details:validation.array
+valid
+pay.0.ref:validation.integer pay.1.ref:validation.string
+x:validation.integer
+x:validation.min
+x:validation.email
+valid
+x:validation.integer,validation.min,validation.email
+valid
+Rule 'variant' requires a discriminator field name
+Rule 'variant' requires an array of cases
+Rule 'variant' case rules must be an array
+Unknown validation rule: bogus
+Field reference '^.^.t' does not fit field 'x'
+OK
@@ -0,0 +1,124 @@
+--TEST--
+Named sub-schemas shared between fields and applied recursively
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$rules = [
+    'billing' => ['required', ['schema', 'address']],
+    'shipping' => ['sometimes', ['schema', 'address']],
+    'contacts.*.address' => [['schema', 'address']],
+];
+$options = ['schemas' => [
+    'address' => [
+        'street' => ['required', 'string'],
+        'zip' => ['required', ['regex', '/^\d{5}$/']],
+    ],
+]];
+$data = [
+    'billing' => ['street' => 'Main 1', 'zip' => '123'],
+    'contacts' => [['address' => ['zip' => '12345']], ['address' => 'x']],
+];
+
+// One schema for three fields; errors are reported under each value's path
+$v = new Validator($rules, $options);
+echo keys($v->validate($data)), "\n";
+$r = $v->validate(['billing' => ['street' => 'Main 1', 'zip' => '12345']]);
+echo keys($r), ' ', implode(',', array_keys($r->validated())), "\n";
+
+// Clones and lazy validators give the same results
+$c = clone $v;
+unset($v);
+echo keys($c->validate($data)), "\n";
+$lazy = new Validator($rules, $options + ['lazy' => true]);
+echo keys($lazy->validate($data)), "\n";
+
+// Field references inside a schema are relative to its value
+$v = new Validator([
+    'a' => [['schema', 'range']],
+    'b' => [['schema', 'range']],
+], ['schemas' => ['range' => [
+    'start' => ['required', 'date'],
+    'end' => ['required', ['after', 'start']],
+]]]);
+echo keys($v->validate([
+    'start' => '2030-01-01',
+    'a' => ['start' => '2024-01-01', 'end' => '2024-02-01'],
+    'b' => ['start' => '2024-03-01', 'end' => '2024-02-01'],
+])), "\n";
+
+// A recursive schema, depth first in field order
+$v = new Validator(['thread' => ['required', ['schema', 'comment']]], ['schemas' => [
+    'comment' => [
+        'body' => ['required', 'string'],
+        'replies' => ['sometimes', 'array', ['max', 2]],
+        'replies.*' => [['schema', 'comment']],
+    ],
+]]);
+echo keys($v->validate(['thread' => [
+    'body' => 'a',
+    'replies' => [
+        ['body' => 'b', 'replies' => [['body' => 1]]],
+        ['replies' => [['body' => 'c'], ['body' => 'd'], ['body' => 'e']]],
+    ],
+]])), "\n";
+
+// Nesting deeper than the limit fails at the limit
+$deep = ['body' => 'x'];
+for ($i = 0; $i < 70; $i++) {
+    $deep = ['body' => 'x', 'replies' => [$deep]];
+}
+$errors = $v->validate(['thread' => $deep])->errors();
+$field = array_key_first($errors);
+echo count($errors), ' ', substr_count($field, 'replies'), ' ', $errors[$field][0]['key'], "\n";
+
+foreach ([
+    [['x' => [['schema', 'nope']]], []],
+    [['x' => [['schema']]], []],
+    [['x' => ['schema']], []],
+    [['x' => ['required']], ['schemas' => 'a']],
+    [['x' => ['required']], ['schemas' => ['a' => 'b']]],
+    [['x' => ['required']], ['schemas' => [['y' => ['required']]]]],
+    [['x' => [['schema', 'a']]], ['schemas' => ['a' => ['y' => [['schema', 'b']]]]]],
+] as [$rules, $options]) {
+    try {
+        new Validator($rules, $options);
+        echo "no exception\n";
+    } catch (Signalforge\Validation\InvalidRuleException $e) {
+        echo $e->getMessage(), "\n";
+    }
+}
+
+// Lazy: an unknown schema throws once the field runs
+$v = new Validator(['x' => ['sometimes', ['schema', 'nope']]], ['lazy' => true]);
+var_dump($v->validate([])->valid());
+try {
+    $v->validate(['x' => []]);
+} catch (Signalforge\Validation\InvalidRuleException $e) {
+    echo $e->getMessage(), "\n";
+}
+
+echo "OK\n";
+?>
+--EXPECT--
+contacts.1.address:validation.schema billing.zip:validation.regex contacts.0.address.street:validation.required,validation.string
+valid billing,billing.street,billing.zip
+contacts.1.address:validation.schema billing.zip:validation.regex contacts.0.address.street:validation.required,validation.string
+contacts.1.address:validation.schema billing.zip:validation.regex contacts.0.address.street:validation.required,validation.string
+b.end:validation.after
+thread.replies.0.replies.0.body:validation.string thread.replies.1.body:validation.required,validation.string thread.replies.1.replies:validation.max
+1 64 validation.schema_limit
+Unknown schema 'nope'
+Rule 'schema' requires a schema name
+Rule 'schema' requires a schema name
+Option 'schemas' must be an array
+Schema 'a' must be an array of field rules
+Schema names must be non-empty strings
+Unknown schema 'b'
+bool(true)
+Unknown schema 'nope'
+OK
@@ -0,0 +1,88 @@
+--TEST--
+any_of, all_of and none_of combine rule branches with short-circuiting
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+// any_of: errors only when no branch passes, then every branch's
+$v = new Validator([
+    'contact' => ['required', ['any_of', 'email', [['regex', '/^\+\d{8,15}$/']]]],
+]);
+foreach (['a@b.co', '+385911234567', 'nope', 5] as $contact) {
+    echo keys($v->validate(['contact' => $contact])), "\n";
+}
+$c = clone $v;
+unset($v);
+echo keys($c->validate(['contact' => 'nope'])), "\n";
+
+// all_of: stops at the first failing branch
+$v = new Validator(['code' => [['all_of', ['string', ['min', 3]], [['regex', '/^[A-Z]+$/']]]]]);
+foreach (['AB', 'abc', 'ABC'] as $code) {
+    echo keys($v->validate(['code' => $code])), "\n";
+}
+
+// none_of: fails as soon as a branch passes
+$v = new Validator([
+    'username' => ['required', 'string', ['none_of', [['in', ['admin', 'root']]], [['starts_with', 'sys_']]]],
+]);
+foreach (['admin', 'sys_x', 'bob'] as $name) {
+    echo keys($v->validate(['username' => $name])), "\n";
+}
+
+// nullable ends its own branch only
+$v = new Validator(['alt' => [['any_of', ['nullable', 'integer'], ['email']]]]);
+echo keys($v->validate(['alt' => null])), "\n";
+echo keys($v->validate(['alt' => 'x'])), "\n";
+
+// Relative references inside wildcard fields, and bail
+$v = new Validator([
+    'rows.*.b' => [['any_of', [['same', '^.a']], [['same', '^.c']]]],
+    'x' => ['bail', ['any_of', 'integer', 'boolean'], ['min', 100]],
+]);
+echo keys($v->validate([
+    'rows' => [['a' => 1, 'b' => 1], ['a' => 1, 'c' => 2, 'b' => 2], ['a' => 1, 'c' => 1, 'b' => 3]],
+    'x' => 'str',
+])), "\n";
+
+foreach ([
+    ['x' => [['any_of']]],
+    ['x' => ['any_of']],
+    ['x' => [['none_of', 5]]],
+    ['x' => [['all_of', ['bogus']]]],
+    ['x.*.y' => [['any_of', [['same', '^.^.^.^.z']]]]],
+] as $rules) {
+    try {
+        new Validator($rules);
+        echo "no exception\n";
+    } catch (Signalforge\Validation\InvalidRuleException $e) {
+        echo $e->getMessage(), "\n";
+    }
+}
+
+echo "OK\n";
+?>
+--EXPECT--
+valid
+valid
+contact:validation.email,validation.regex
+contact:validation.email,validation.regex
+contact:validation.email,validation.regex
+code:validation.min
+code:validation.regex
+valid
+username:validation.none_of
+username:validation.none_of
+valid
+valid
+alt:validation.integer,validation.email
+rows.2.b:validation.same,validation.same x:validation.integer,validation.boolean
+Rule 'any_of' requires at least one branch
+Rule 'any_of' requires at least one branch
+Rule 'none_of' branches must be rule arrays
+Unknown validation rule: bogus
+Field reference '^.^.^.^.z' does not fit field 'x.*.y'
+OK
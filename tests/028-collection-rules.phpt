@@ -0,0 +1,107 @@
+--TEST--
+Collection rules accumulate across the elements of a wildcard field in one walk
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$rules = [
+    'items.*.sku' => ['required', 'string', 'unique'],
+    'items.*.qty' => ['required', 'integer', ['sum_max', 10]],
+    'slots.*' => ['sorted'],
+    'addresses.*.primary' => [['count_where', true, 1]],
+];
+$data = [
+    'items' => [
+        ['sku' => 'A', 'qty' => 4],
+        ['sku' => 'B', 'qty' => 5],
+        ['sku' => 'A', 'qty' => 3],
+    ],
+    'slots' => [1, 3, 2, 5],
+    'addresses' => [['primary' => true], ['primary' => false], ['primary' => true]],
+];
+
+$v = new Validator($rules);
+$r = $v->validate($data);
+echo keys($r), "\n";
+$e = $r->errors()['items.*.qty'][0]['params'];
+echo $e['sum'], ' ', $e['max'], "\n";
+
+// Accumulators start over on every call, for clones and lazy validators too
+echo keys($v->validate(['items' => [['sku' => 'A', 'qty' => 10]], 'slots' => [1, 1, 2]])), "\n";
+$c = clone $v;
+unset($v);
+echo keys($c->validate($data)), "\n";
+echo keys((new Validator($rules, ['lazy' => true]))->validate($data)), "\n";
+
+// Loose keys for unique, numeric strings summed, a descending order
+$v = new Validator([
+    'ids.*' => ['unique'],
+    'w.*' => [['sum_min', 1.5], ['sorted', 'desc']],
+    'big.*' => [['sum_max', PHP_INT_MAX]],
+]);
+echo keys($v->validate([
+    'ids' => [1, '1', 2.0, '2', 2.5, '2.50', true, 'x', 'x', null, null],
+    'w' => ['0.5', 0.25, 'abc', 0.5],
+    'big' => [PHP_INT_MAX, PHP_INT_MAX],
+])), "\n";
+
+// Nested patterns cover every parent; elements below a failed parent are left out
+$v = new Validator([
+    'orders.*.lines' => ['array', ['max', 2]],
+    'orders.*.lines.*.qty' => [['sum_max', 5]],
+]);
+echo keys($v->validate(['orders' => [
+    ['lines' => [['qty' => 2], ['qty' => 2]]],
+    ['lines' => [['qty' => 1], ['qty' => 1], ['qty' => 9]]],
+    ['lines' => [['qty' => 2]]],
+]])), "\n";
+
+// Inside a schema, each value is its own collection
+$v = new Validator(['a' => [['schema', 'cart']], 'b' => [['schema', 'cart']]], ['schemas' => [
+    'cart' => ['items.*.qty' => [['sum_max', 3]]],
+]]);
+echo keys($v->validate([
+    'a' => ['items' => [['qty' => 2], ['qty' => 2]]],
+    'b' => ['items' => [['qty' => 3]]],
+])), "\n";
+
+foreach ([
+    ['x' => ['unique']],
+    ['x' => [['when', ['y', '=', 1], ['sorted']]]],
+    ['x.*' => ['sum_max']],
+    ['x.*' => [['sum_min', '5']]],
+    ['x.*' => [['sorted', 'up']]],
+    ['x.*' => [['count_where', true]]],
+    ['x.*' => [['count_where', [1], 1]]],
+] as $rules) {
+    try {
+        new Validator($rules);
+        echo "no exception\n";
+    } catch (Signalforge\Validation\InvalidRuleException $e) {
+        echo $e->getMessage(), "\n";
+    }
+}
+
+echo "OK\n";
+?>
+--EXPECT--
+items.2.sku:validation.unique items.*.qty:validation.sum_max slots.2:validation.sorted addresses.2.primary:validation.count_where
+12 10
+valid
+items.2.sku:validation.unique items.*.qty:validation.sum_max slots.2:validation.sorted addresses.2.primary:validation.count_where
+items.2.sku:validation.unique items.*.qty:validation.sum_max slots.2:validation.sorted addresses.2.primary:validation.count_where
+ids.1:validation.unique ids.3:validation.unique ids.5:validation.unique ids.6:validation.unique ids.8:validation.unique w.2:validation.sum_min,validation.sorted w.*:validation.sum_min big.*:validation.sum_max
+orders.1.lines:validation.max orders.*.lines.*.qty:validation.sum_max
+a.items.*.qty:validation.sum_max
+Rule 'unique' requires a wildcard field, not 'x'
+Rule 'sorted' requires a wildcard field, not 'x'
+Rule 'sum_max' requires a numeric parameter
+Rule 'sum_min' requires a numeric parameter
+Rule 'sorted' direction must be 'asc' or 'desc'
+Rule 'count_where' requires a scalar value and a maximum count
+Rule 'count_where' requires a scalar value and a maximum count
+OK
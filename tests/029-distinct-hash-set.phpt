@@ -0,0 +1,57 @@
+--TEST--
+distinct and unique share a typed hash set comparing values by their string form
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$v = new Validator(['x' => ['distinct']]);
+foreach ([
+    [1.0000001, 1.0000002],
+    [PHP_INT_MAX, PHP_INT_MAX - 1],
+    ['abcdefghijk', 'abcdefghijl'],
+    ['a', 'A', [1], [1]],
+    [NAN, NAN],
+    [1, '1'],
+    [1.5, '1.50'],
+    [2.0, 2],
+    [true, 1],
+    [null, ''],
+    ['abcdefghijk', 'abcdefghijk'],
+] as $x) {
+    echo keys($v->validate(['x' => $x])), "\n";
+}
+
+// Large arrays grow past the inline slots
+$ids = range(1, 50000);
+echo keys($v->validate(['x' => $ids])), "\n";
+$ids[] = '25000';
+echo keys($v->validate(['x' => $ids])), "\n";
+
+// Across the elements of a wildcard field
+$rows = array_map(fn($i) => ['id' => $i], range(0, 999));
+$rows[] = ['id' => '500'];
+$v = new Validator(['rows.*.id' => ['unique']]);
+echo keys($v->validate(['rows' => $rows])), "\n";
+
+echo "OK\n";
+?>
+--EXPECT--
+valid
+valid
+valid
+valid
+x:validation.distinct
+x:validation.distinct
+valid
+x:validation.distinct
+x:validation.distinct
+x:validation.distinct
+x:validation.distinct
+valid
+x:validation.distinct
+rows.1000.id:validation.unique
+OK
@@ -0,0 +1,78 @@
+--TEST--
+in and not_in answer from keyed sets as in_array() would, with strict and ci modes
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$lists = [
+    'small ints' => [1, 2, 3, 40, 41],
+    'sparse ints' => [-5, 100000, PHP_INT_MAX],
+    'numbers' => [1.5, '2.50', '7', 0.0, '1e3'],
+    'strings' => ['HR', 'SI', 'abc', '', '0x1A', ' 12'],
+    'mixed' => [null, 'x', 3],
+    'booleans' => [true, 'y'],
+    'falsy' => [false, 9],
+    'scan' => [[1], INF, 'z'],
+];
+$values = [0, 1, 3, 41, 42, -5, PHP_INT_MAX, 1.5, 2.5, 7.0, -0.0, 1000, 'HR', 'hr', 'abc', '',
+    '0', '1', '1.50', '2.5', '07', ' 7', '1e3', '1000.0', '0x1A', '12', ' 12', 'x', 'y', 'z',
+    null, true, false, [1], INF, NAN, 9.0, 3.0];
+
+$mismatches = 0;
+foreach ($lists as $name => $list) {
+    foreach ([null, 'strict'] as $mode) {
+        $rule = $mode ? ['in', $list, $mode] : ['in', $list];
+        $not = $mode ? ['not_in', $list, $mode] : ['not_in', $list];
+        $v = new Validator(['f' => [$rule], 'g' => [$not]]);
+        foreach ($values as $value) {
+            $expected = in_array($value, $list, $mode === 'strict');
+            $r = $v->validate(['f' => $value, 'g' => $value]);
+            $errors = $r->errors();
+            if (isset($errors['f']) === $expected || isset($errors['g']) !== $expected) {
+                echo "$name ", $mode ?? 'loose', ': ', var_export($value, true), "\n";
+                $mismatches++;
+            }
+        }
+    }
+}
+echo "mismatches: $mismatches\n";
+
+// Case-insensitive strings; numbers compare as before
+$v = new Validator(['country' => [['in', ['HR', 'si', 'Ab1'], 'ci']], 'n' => [['in', ['1E3', 'X'], 'ci']]]);
+foreach (['hr', 'SI', 'aB1', 'de'] as $country) {
+    echo keys($v->validate(['country' => $country, 'n' => 1000])), "\n";
+}
+echo keys((clone $v)->validate(['country' => 'Hr', 'n' => 'x'])), "\n";
+
+// Large lists
+$codes = [];
+for ($i = 0; $i < 3000; $i++) {
+    $codes[] = sprintf('C%04d', $i);
+}
+$v = new Validator(['code' => [['in', $codes]], 'id' => [['not_in', range(0, 2999)]]]);
+echo keys($v->validate(['code' => 'C2999', 'id' => 3000])), "\n";
+echo keys($v->validate(['code' => 'C3000', 'id' => '2999'])), "\n";
+
+try {
+    new Validator(['x' => [['in', ['a'], 'fuzzy']]]);
+    echo "no exception\n";
+} catch (Signalforge\Validation\InvalidRuleException $e) {
+    echo $e->getMessage(), "\n";
+}
+
+echo "OK\n";
+?>
+--EXPECT--
+mismatches: 0
+valid
+valid
+valid
+country:validation.in
+valid
+code:validation.in id:validation.not_in
+Rule 'in' mode must be 'strict' or 'ci'
+OK
@@ -0,0 +1,93 @@
+--TEST--
+enum checks backing values of a backed enum and can put the case in validated output
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+enum Status: string {
+    case Active = 'active';
+    case Closed = 'closed';
+    case Numbered = '7';
+}
+
+enum Priority: int {
+    const DEFAULT = self::Low;
+    case Low = 1;
+    case High = 10 * 2;
+}
+
+enum Suit {
+    case Hearts;
+}
+
+$v = new Validator([
+    'status' => ['required', ['enum', Status::class]],
+    'priority' => ['nullable', ['enum', Priority::class, 'cast']],
+]);
+
+foreach ([
+    ['status' => 'active', 'priority' => 20],
+    ['status' => 'Active', 'priority' => '1'],
+    ['status' => 7, 'priority' => 1.0],
+    ['status' => Status::Closed, 'priority' => Priority::High],
+    ['status' => 'closed', 'priority' => 3],
+    ['status' => ['active'], 'priority' => '1.5'],
+    ['status' => 'active', 'priority' => null],
+    ['priority' => 1],
+] as $data) {
+    $r = $v->validate($data);
+    echo keys($r);
+    if ($r->valid()) {
+        echo ' ', var_export($r->validated()['priority'], true);
+    }
+    echo "\n";
+}
+
+// Clones and other validators share the case table
+$c = clone $v;
+unset($v);
+var_dump($c->validate(['status' => 'closed', 'priority' => 20])->validated()['priority'] === Priority::High);
+$w = new Validator(['p.*' => [['enum', Priority::class, 'cast']]]);
+$r = $w->validate(['p' => [1, '20', 2]]);
+echo keys($r), "\n";
+var_dump($r->validated()['p.0'] === Priority::Low);
+
+foreach ([
+    ['x' => ['enum']],
+    ['x' => [['enum', Suit::class]]],
+    ['x' => [['enum', 'NoSuchEnum']]],
+    ['x' => [['enum', stdClass::class]]],
+    ['x' => [['enum', Status::class, 'tryFrom']]],
+] as $rules) {
+    try {
+        new Validator($rules);
+        echo "no exception\n";
+    } catch (Signalforge\Validation\InvalidRuleException $e) {
+        echo $e->getMessage(), "\n";
+    }
+}
+
+echo "OK\n";
+?>
+--EXPECT--
+valid \Priority::High
+status:validation.enum
+valid \Priority::Low
+valid \Priority::High
+priority:validation.enum
+status:validation.enum priority:validation.enum
+valid NULL
+status:validation.required,validation.enum
+bool(true)
+p.2:validation.enum
+bool(true)
+Rule 'enum' requires a backed enum class
+Rule 'enum' requires a backed enum class
+Rule 'enum' requires a backed enum class
+Rule 'enum' requires a backed enum class
+Rule 'enum' option must be 'cast'
+OK
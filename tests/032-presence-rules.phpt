@@ -0,0 +1,105 @@
+--TEST--
+required_if, required_with and related rules test other fields through the presence bitmap
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$v = new Validator([
+    'type' => ['string'],
+    'vat_id' => [['required_if', 'type', 'business', 'ngo'], 'string'],
+    'note' => [['required_unless', 'type', ['personal']], 'string'],
+    'discount' => [['prohibited_if', 'type', 'personal']],
+    'coupon' => [['exclude_if', 'type', 'partner'], 'string'],
+]);
+echo keys($v->validate(['type' => 'business', 'coupon' => 'C'])), "\n";
+echo keys($v->validate(['type' => 'ngo', 'vat_id' => 'HR1', 'note' => 'x', 'coupon' => 'C'])), "\n";
+echo keys($v->validate(['type' => 'personal', 'discount' => 10, 'coupon' => 'C'])), "\n";
+echo keys($v->validate(['type' => 'personal', 'discount' => '', 'coupon' => 'C'])), "\n";
+$r = $v->validate(['type' => 'partner', 'coupon' => 42, 'note' => 'x']);
+echo keys($r), ' ', json_encode($r->validated()), "\n";
+$r = $v->validate(['type' => 'other', 'coupon' => 'C1', 'note' => 'x']);
+echo keys($r), ' ', json_encode($r->validated()), "\n";
+
+// Values compare loosely, as with 'in'
+$v = new Validator(['b' => [['required_if', 'a', 1]]]);
+foreach (['1', 1.0, true, '1.0', '01', 'x', null] as $a) {
+    echo var_export($a, true), ' ', keys($v->validate(['a' => $a])), "\n";
+}
+echo 'absent ', keys($v->validate([])), "\n";
+
+$v = new Validator([
+    'street' => [['required_with', 'city', 'zip']],
+    'all' => [['required_with_all', ['city', 'zip']]],
+    'phone' => [['required_without', 'email', 'fax']],
+    'contact' => [['required_without_all', 'email', 'fax']],
+]);
+echo keys($v->validate([])), "\n";
+echo keys($v->validate(['city' => 'Split'])), "\n";
+echo keys($v->validate(['city' => 'Split', 'zip' => '21000', 'email' => 'a@b.c', 'fax' => ''])), "\n";
+echo keys($v->validate(['email' => 'a@b.c', 'fax' => '1'])), "\n";
+
+// Params name the other fields
+$r = $v->validate(['city' => 'Split', 'zip' => '21000']);
+echo json_encode($r->errors()['all'][0]['params']), "\n";
+$r = (new Validator(['b' => [['required_if', 'a', 'x']]]))->validate(['a' => 'x']);
+echo json_encode($r->errors()['b'][0]['params']), "\n";
+
+// Relative names are resolved per element
+$v = new Validator(['items.*.price' => [['required_unless', '^.free', true], 'integer']]);
+echo keys($v->validate(['items' => [['free' => true], ['free' => false], ['price' => 3]]])), "\n";
+
+// Facts shared between rules, lazy compilation and clones
+$rules = [];
+for ($i = 0; $i < 300; $i++) {
+    $rules["f$i"] = [['required_with', 'k' . ($i % 7)], ['required_if', 'mode', "m$i"]];
+}
+foreach ([[], ['lazy' => true]] as $options) {
+    $v = new Validator($rules, $options);
+    $data = ['k3' => 'x', 'mode' => 'm299'];
+    echo count($v->validate($data)->errors()), ' ', count((clone $v)->validate($data)->errors()), "\n";
+}
+
+foreach ([['required_if', 'a'], ['required_if', 'a', []], ['required_with'], ['required_with', 5]] as $rule) {
+    try {
+        new Validator(['x' => [$rule]]);
+        echo "no exception\n";
+    } catch (Signalforge\Validation\InvalidRuleException $e) {
+        echo $e->getMessage(), "\n";
+    }
+}
+
+echo "OK\n";
+?>
+--EXPECT--
+vat_id:validation.required_if,validation.string note:validation.required_unless,validation.string
+valid
+discount:validation.prohibited_if
+valid
+valid {"type":"partner","note":"x"}
+valid {"type":"other","note":"x","coupon":"C1"}
+'1' b:validation.required_if
+1.0 b:validation.required_if
+true b:validation.required_if
+'1.0' b:validation.required_if
+'01' b:validation.required_if
+'x' valid
+NULL valid
+absent valid
+phone:validation.required_without contact:validation.required_without_all
+street:validation.required_with phone:validation.required_without contact:validation.required_without_all
+street:validation.required_with all:validation.required_with_all phone:validation.required_without
+valid
+{"field":"all","values":"city, zip"}
+{"field":"b","other":"a"}
+items.1.price:validation.required_unless,validation.integer
+44 44
+44 44
+Rule 'required_if' requires a field name and at least one value
+Rule 'required_if' requires a field name and at least one value
+Rule 'required_with' requires at least one field name
+Rule 'required_with' requires at least one field name
+OK
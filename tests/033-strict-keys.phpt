@@ -0,0 +1,92 @@
+--TEST--
+strict option and rule report undeclared keys; keys rule limits a map's keys
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$rules = [
+    'user' => ['array', 'strict'],
+    'user.name' => ['required', 'string'],
+    'user.email' => ['email'],
+    'items.*' => ['strict'],
+    'items.*.sku' => ['required', 'string'],
+    'tags' => ['array'],
+    '7' => ['integer'],
+];
+
+foreach ([[], ['lazy' => true]] as $options) {
+    $v = new Validator($rules, $options + ['strict' => true]);
+    $data = [
+        'user' => ['name' => 'Ana', 'email' => 'a@b.hr'],
+        'items' => [['sku' => 'A1'], ['sku' => 'A2']],
+        'tags' => ['x' => 1],
+        7 => 1,
+    ];
+    echo keys($v->validate($data)), "\n";
+    echo keys((clone $v)->validate($data + ['extra' => 1])), "\n";
+
+    $data['user']['role'] = 'admin';
+    $data['items'][1]['price'] = 0;
+    $data['items'][1][0] = 'x';
+    $data['debug'] = true;
+    $data[8] = 1;
+    $r = $v->validate($data);
+    echo keys($r), "\n";
+    echo implode(',', array_keys($r->validated())), "\n";
+}
+
+// Without the option only 'strict' rules check keys
+$v = new Validator(['user' => ['strict'], 'user.name' => ['string']]);
+echo keys($v->validate(['user' => ['name' => 'Ana', 'x' => 1], 'debug' => 1])), "\n";
+
+// A wildcard field declares every key at its level
+$v = new Validator(['map' => ['strict'], 'map.*' => ['integer'], 'other.*.id' => ['integer']], ['strict' => true]);
+echo keys($v->validate(['map' => ['a' => 1, 'b' => 2], 'other' => [], 'x' => 1])), "\n";
+
+// Schemas check the value they validate
+$v = new Validator(['billing' => [['schema', 'address']]], [
+    'strict' => true,
+    'schemas' => ['address' => ['street' => ['string'], 'city' => ['nullable', 'string']]],
+]);
+echo keys($v->validate(['billing' => ['street' => 'Ilica 1', 'zip' => '10000']])), "\n";
+
+// keys
+$v = new Validator(['meta' => [['keys', ['source', 'campaign', 3]]], 'opt' => ['nullable', ['keys', ['a']]]]);
+echo keys($v->validate(['meta' => ['source' => 'web', 3 => 'x'], 'opt' => null])), "\n";
+echo keys($v->validate(['meta' => ['source' => 'web', 'ref' => 'x'], 'opt' => 'a'])), "\n";
+echo keys($v->validate(['meta' => ['3' => 1], 'opt' => ['a' => 1]])), "\n";
+
+foreach ([['keys'], 'keys', ['keys', [1.5]]] as $rule) {
+    try {
+        new Validator(['x' => [$rule]]);
+        echo "no exception\n";
+    } catch (Signalforge\Validation\InvalidRuleException $e) {
+        echo $e->getMessage(), "\n";
+    }
+}
+
+echo "OK\n";
+?>
+--EXPECT--
+valid
+extra:validation.strict
+debug:validation.strict 8:validation.strict user.role:validation.strict items.1.price:validation.strict items.1.0:validation.strict
+user.name,user.email,items.0,items.0.sku,tags,7
+valid
+extra:validation.strict
+debug:validation.strict 8:validation.strict user.role:validation.strict items.1.price:validation.strict items.1.0:validation.strict
+user.name,user.email,items.0,items.0.sku,tags,7
+user.x:validation.strict
+x:validation.strict
+billing.zip:validation.strict
+valid
+meta:validation.keys opt:validation.keys
+valid
+Rule 'keys' requires an array of keys
+Rule 'keys' requires an array of keys
+Rule 'keys' keys must be strings or integers
+OK
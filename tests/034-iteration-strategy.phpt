@@ -0,0 +1,57 @@
+--TEST--
+Sparse input runs data-driven, dense input rule-driven, with the same results; stats() reports which
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$rules = ['id' => ['required', 'integer']];
+for ($i = 0; $i < 40; $i++) {
+    $rules["f$i"] = ['sometimes', 'string'];
+    $rules["nested.n$i"] = ['sometimes', 'integer'];
+}
+$rules['7.code'] = ['sometimes', 'integer'];
+$rules['profile.name'] = ['required', 'string'];
+
+$sparse = ['id' => 1, 'f3' => 'x', 'nested' => ['n1' => 'y'], 7 => ['code' => 'z']];
+$dense = [];
+for ($i = 0; $i < 100; $i++) {
+    $dense["f$i"] = 's';
+}
+
+foreach ([[], ['lazy' => true]] as $options) {
+    $v = new Validator($rules, $options);
+
+    $r = $v->validate($sparse);
+    echo keys($r), "\n";
+    echo implode(',', array_keys($r->validated())), "\n";
+    echo keys($v->validate($dense)), "\n";
+    echo keys((clone $v)->validate($sparse)), "\n";
+
+    echo json_encode($v->stats()), "\n";
+}
+
+// Sub-schema values are runs of their own
+$v = new Validator(['a' => [['schema', 's']]], ['schemas' => ['s' => ['x' => ['integer']]]]);
+echo keys($v->validate(['a' => ['x' => 'no']])), "\n";
+echo json_encode($v->stats()), "\n";
+
+echo "OK\n";
+?>
+--EXPECT--
+nested.n1:validation.integer 7.code:validation.integer profile.name:validation.required,validation.string
+id,f3
+id:validation.required,validation.integer profile.name:validation.required,validation.string
+nested.n1:validation.integer 7.code:validation.integer profile.name:validation.required,validation.string
+{"runs":2,"rule_driven":1,"data_driven":1,"fields":83}
+nested.n1:validation.integer 7.code:validation.integer profile.name:validation.required,validation.string
+id,f3
+id:validation.required,validation.integer profile.name:validation.required,validation.string
+nested.n1:validation.integer 7.code:validation.integer profile.name:validation.required,validation.string
+{"runs":2,"rule_driven":1,"data_driven":1,"fields":83}
+a.x:validation.integer
+{"runs":2,"rule_driven":2,"data_driven":0,"fields":1}
+OK
@@ -0,0 +1,58 @@
+--TEST--
+A field's rules share one analysis of its value: lengths, UTF-8 validity and numbers agree across rules
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+// Length, alpha and regex on multibyte, long and malformed strings
+$v = new Validator(['name' => ['string', ['min', 2], ['max', 5], 'alpha', ['regex', '/^\p{L}+$/u']]]);
+$long = str_repeat('ž', 300);
+foreach (['Žžćčš', 'Žžćčšđ', 'abcdefghijklmnop', "abcdefghé", "ab\xC3", "\xC0\xAF", "abcdefgh\xFF", $long, $long] as $name) {
+    echo keys($v->validate(['name' => $name])), "\n";
+}
+
+// @length and @matches conditions read the same analysis
+$v = new Validator([
+    'bio' => [['when', ['@length', '>', 3], [['regex', '/^\w+$/']], [['max', 1]]]],
+    'tag' => ['alpha_num', ['when', ['@matches', '/^\p{Lu}/u'], [['min', 3]]]],
+]);
+foreach ([['čćžš', 'Ćx'], ['ččč', 'ćx'], ['abcd', "\xFF"]] as [$bio, $tag]) {
+    echo keys($v->validate(['bio' => $bio, 'tag' => $tag])), "\n";
+}
+
+// numeric, gt and lt parse the string once
+$v = new Validator(['qty' => ['numeric', ['gt', 10], ['lt', 100]]]);
+foreach (['50', ' 5', 'x', '1e2', '42.5'] as $qty) {
+    echo var_export($qty, true), ' ', keys($v->validate(['qty' => $qty])), "\n";
+}
+
+// The value is untouched for PHP's own functions
+preg_match('/^\p{L}+$/u', $long, $m);
+echo strlen($m[0]), "\n";
+
+echo "OK\n";
+?>
+--EXPECT--
+valid
+name:validation.max
+name:validation.max
+name:validation.max
+name:validation.alpha,validation.regex
+name:validation.min,validation.alpha,validation.regex
+name:validation.max,validation.alpha,validation.regex
+name:validation.max
+name:validation.max
+bio:validation.regex tag:validation.min
+bio:validation.max
+tag:validation.alpha_num
+'50' valid
+' 5' qty:validation.gt
+'x' qty:validation.numeric,validation.gt,validation.lt
+'1e2' qty:validation.lt
+'42.5' valid
+600
+OK
@@ -0,0 +1,63 @@
+--TEST--
+Length rules and @length conditions count only as far as their bounds, with unchanged results
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+function check(array $rules, array $values) {
+    $v = new Validator(['f' => $rules]);
+    $out = [];
+    foreach ($values as $value) {
+        $out[] = keys($v->validate(['f' => $value]));
+    }
+    echo implode(' | ', $out), "\n";
+}
+
+$huge = str_repeat('a', 5 * 1024 * 1024);
+$continuations = str_repeat("\x80", 12);
+
+// max: bytes alone or a count up to max + 1
+check(['string', ['max', 255]], [str_repeat('𝄞', 255), str_repeat('𝄞', 256), str_repeat('a', 255), $huge]);
+check([['max', 3]], ['abc', 'abcd', '𝄞𝄞𝄞', "ab\xFF\xFF"]);
+
+// min: malformed bytes do not count as four-byte characters
+check([['min', 3]], ['ab', '𝄞𝄞𝄞', str_repeat('𝄞', 2), $continuations, "\xF0\x9D\x84"]);
+
+// A string PHP already knows to be valid UTF-8
+$known = str_repeat('𝄞', 2);
+preg_match('/./u', $known);
+check([['min', 3]], [$known]);
+$known = str_repeat('𝄞', 3);
+preg_match('/./u', $known);
+check([['min', 3]], [$known]);
+
+// between and fused min/max
+check([['between', 2, 4]], ['a', 'ab', 'éééé', 'ééééé', str_repeat('é', 1000000)]);
+check(['string', ['min', 2], ['max', 4]], ['a', 'ab', 'éééé', 'ééééé', $huge]);
+check(['string', ['max', 4], ['min', 2]], ['a', $huge]);
+
+// @length against an integer, and against a numeric string (counted in full)
+foreach ([['=', 3], ['>', 3], ['<=', 3], ['>', '3']] as [$op, $n]) {
+    check([['when', ['@length', $op, $n], [['max', 0]]]], ['𝄞𝄞𝄞', '𝄞𝄞𝄞𝄞', 'ab', $huge]);
+}
+
+echo "OK\n";
+?>
+--EXPECT--
+valid | f:validation.max | valid | f:validation.max
+valid | f:validation.max | valid | f:validation.max
+f:validation.min | valid | f:validation.min | f:validation.min | f:validation.min
+f:validation.min
+valid
+f:validation.between | valid | valid | f:validation.between | f:validation.between
+f:validation.min | valid | valid | f:validation.max | f:validation.max
+f:validation.min | f:validation.max
+f:validation.max | valid | valid | valid
+valid | f:validation.max | valid | f:validation.max
+f:validation.max | valid | f:validation.max | valid
+valid | f:validation.max | valid | f:validation.max
+OK
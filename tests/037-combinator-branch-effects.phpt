@@ -0,0 +1,61 @@
+--TEST--
+any_of and none_of drop the effects of branches they do not take; deferred rules are rejected in them
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+enum Status: string {
+    case Active = 'active';
+}
+
+// An enum cast in a failed branch is undone; the taken branch keeps its own
+$v = new Validator(['s' => [['any_of', [['enum', Status::class, 'cast'], ['max', 3]], ['string']]]]);
+$r = $v->validate(['s' => 'active']);
+echo keys($r), ' ', get_debug_type($r->validated()['s']), "\n";
+
+$v = new Validator(['s' => [['any_of', [['enum', Status::class, 'cast']], ['string']]]]);
+$r = $v->validate(['s' => 'active']);
+echo keys($r), ' ', get_debug_type($r->validated()['s']), "\n";
+
+$v = new Validator(['s' => [['none_of', [['enum', Status::class, 'cast'], ['max', 3]]]]]);
+$r = $v->validate(['s' => 'active']);
+echo keys($r), ' ', get_debug_type($r->validated()['s']), "\n";
+
+// Schema branches: all_of queues the value, any_of and none_of cannot
+$schemas = ['card' => ['pan' => ['required', 'string']], 'bank' => ['iban' => ['required', 'string']]];
+$v = new Validator(['pay' => [['all_of', ['array'], [['schema', 'card']]]]], ['schemas' => $schemas]);
+echo keys($v->validate(['pay' => ['iban' => 'HR12']])), "\n";
+
+$rules = [
+    ['pay' => [['any_of', [['schema', 'card']], [['schema', 'bank']]]]],
+    ['pay' => [['none_of', [['schema', 'card']]]]],
+    ['pay' => [['any_of', ['string'], [['when', ['@type', '=', 'array'], [['schema', 'bank']]]]]]],
+    ['pay' => [['any_of', ['string'], [['all_of', [['schema', 'bank']]]]]]],
+    ['items.*' => [['any_of', ['integer'], ['string', 'unique']]]],
+];
+foreach ($rules as $r) {
+    try {
+        new Validator($r, ['schemas' => $schemas]);
+        echo "no exception\n";
+    } catch (Signalforge\Validation\InvalidRuleException $e) {
+        echo $e->getMessage(), "\n";
+    }
+}
+
+echo "OK\n";
+?>
+--EXPECT--
+valid string
+valid Status
+valid string
+pay.pan:validation.required,validation.string
+Rule 'schema' cannot be used inside 'any_of'
+Rule 'schema' cannot be used inside 'none_of'
+Rule 'schema' cannot be used inside 'any_of'
+Rule 'schema' cannot be used inside 'any_of'
+Rule 'unique' cannot be used inside 'any_of'
+OK
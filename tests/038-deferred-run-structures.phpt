@@ -0,0 +1,46 @@
+--TEST--
+Run order, parent gating and strict keys are built on first validate(), also for clones
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+// Children declared before their parent; 'a.b' is not a field, so 'a' gates 'a.b.c'
+$rules = [
+    'a.b.c' => ['required'],
+    'items.*.id' => ['required'],
+    'a' => ['sometimes', 'array', 'strict'],
+    'items' => ['sometimes', 'array'],
+    'x.y' => ['required'],
+];
+
+foreach ([[], ['lazy' => true]] as $options) {
+    $v = new Validator($rules, $options + ['strict' => true]);
+    $c = clone $v;
+    echo keys($c->validate(['z' => 1])), "\n";
+    echo keys($v->validate(['a' => [], 'items' => [[]], 'x' => ['y' => 1]])), "\n";
+    echo keys($c->validate(['a' => ['b' => ['c' => 1], 'q' => 2], 'x' => ['y' => 1]])), "\n";
+}
+
+// Many fields, few used
+$rules = [];
+for ($i = 0; $i < 5000; $i++) {
+    $rules["group$i.field$i"] = ['sometimes', 'integer'];
+}
+$v = new Validator($rules, ['lazy' => true]);
+echo keys($v->validate(['group7' => ['field7' => 'x']])), "\n";
+
+echo "OK\n";
+?>
+--EXPECT--
+z:validation.strict x.y:validation.required
+a.b.c:validation.required items.0.id:validation.required
+a.q:validation.strict
+z:validation.strict x.y:validation.required
+a.b.c:validation.required items.0.id:validation.required
+a.q:validation.strict
+group7.field7:validation.integer
+OK
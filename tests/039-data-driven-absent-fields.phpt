@@ -0,0 +1,51 @@
+--TEST--
+Data-driven runs pass over absent fields that cannot report anything, and still run the rest
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$rules = [];
+for ($i = 0; $i < 40; $i++) {
+    $rules["f$i"] = ['nullable', 'string'];
+}
+$rules['meta'] = ['bail', 'nullable', 'array'];
+$rules['meta.owner'] = ['required', 'integer'];
+$rules['extra'] = ['sometimes', 'array'];
+$rules['extra.tag'] = ['required', 'string'];
+$rules['note'] = ['string'];
+$rules['broken'] = ['nullable', 'no_such_rule'];
+
+$sparse = ['f1' => 5];
+
+foreach ([[], ['lazy' => true]] as $options) {
+    $v = new Validator($options ? $rules : array_diff_key($rules, ['broken' => 1]), $options);
+    $r = $v->validate($sparse);
+    echo keys($r), "\n";
+    echo json_encode($r->validated()), "\n";
+    echo json_encode($v->stats()['data_driven']), "\n";
+}
+
+// Lazy: a field passed over is not compiled, one that runs is
+$v = new Validator($rules, ['lazy' => true]);
+try {
+    $v->validate(['broken' => 1]);
+    echo "no exception\n";
+} catch (Signalforge\Validation\InvalidRuleException $e) {
+    echo "compiled when present\n";
+}
+
+echo "OK\n";
+?>
+--EXPECT--
+f1:validation.string meta.owner:validation.required,validation.integer note:validation.string
+[]
+1
+f1:validation.string meta.owner:validation.required,validation.integer note:validation.string
+[]
+1
+compiled when present
+OK
@@ -0,0 +1,57 @@
+--TEST--
+Condition in/not_in lists and variant cases are keyed like rule lists, numeric strings included
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$subjects = [1.5, '1.50', 10, '10.0', 'abc', 'ABC', 0, null];
+
+// Conditions: 'note' is required when kind is in the list
+foreach (['in', 'not_in'] as $op) {
+    $v = new Validator(['note' => [['when', ['kind', $op, ['1.5', '1e1', 'abc']], ['required']]]]);
+    $line = [];
+    foreach ($subjects as $kind) {
+        $line[] = $v->validate(['kind' => $kind])->valid() ? '-' : 'R';
+    }
+    echo $op, ' ', implode('', $line), "\n";
+}
+
+// Variant cases with numeric string keys
+$v = new Validator([
+    'details' => [['variant', 'kind', [
+        '1.5' => ['integer'],
+        '1e1' => ['array'],
+        'abc' => ['email'],
+    ], ['nullable', 'string']]],
+]);
+foreach ($subjects as $kind) {
+    echo keys($v->validate(['kind' => $kind, 'details' => 'zz'])), "\n";
+}
+
+// Case values equal under == fall back to the first matching case
+$v = new Validator([
+    'details' => [['variant', 'kind', ['1.5' => ['integer'], '1.50' => ['array']]]],
+]);
+echo keys($v->validate(['kind' => 1.5, 'details' => 'zz'])), "\n";
+echo keys((clone $v)->validate(['kind' => '1.50', 'details' => 'zz'])), "\n";
+
+echo "OK\n";
+?>
+--EXPECT--
+in RRRRR---
+not_in -----RRR
+details:validation.integer
+details:validation.integer
+details:validation.array
+details:validation.array
+details:validation.email
+valid
+valid
+valid
+details:validation.integer
+details:validation.integer
+OK
@@ -0,0 +1,56 @@
+--TEST--
+distinct and unique treat values as equal when their string forms are
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$v = new Validator(['x' => ['distinct']]);
+foreach ([
+    ['01', '1'],
+    ['1e3', 1000],
+    ['abc', 'ABC'],
+    ['1e20', 1e20],
+    [1000.0, '1000'],
+    [1.5, '1.5'],
+    [0.1 + 0.2, 0.3],
+    [-0.0, '-0'],
+    [0.0, '0'],
+    [INF, 'INF'],
+    [1e20, '1.0E+20'],
+    [false, '0'],
+] as $x) {
+    echo keys($v->validate(['x' => $x])), "\n";
+}
+
+// Floats take the form (string) gives them at the current precision
+ini_set('precision', '17');
+echo keys($v->validate(['x' => [0.1 + 0.2, 0.3]])), "\n";
+ini_restore('precision');
+
+$v = new Validator(['rows.*.id' => ['unique']]);
+echo keys($v->validate(['rows' => [['id' => '07'], ['id' => 7]]])), "\n";
+echo keys($v->validate(['rows' => [['id' => '7'], ['id' => 7.0]]])), "\n";
+
+echo "OK\n";
+?>
+--EXPECT--
+valid
+valid
+valid
+valid
+x:validation.distinct
+x:validation.distinct
+x:validation.distinct
+x:validation.distinct
+x:validation.distinct
+x:validation.distinct
+x:validation.distinct
+x:validation.distinct
+valid
+valid
+rows.1.id:validation.unique
+OK
@@ -0,0 +1,35 @@
+--TEST--
+Parent gating and strict keys match fields whose segment names are built at runtime
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+// Names not present as literals anywhere, so not interned at compile time
+$list = str_repeat('it', 3);
+$obj = str_repeat('ob', 2);
+
+$rules = [
+    $list => ['sometimes', 'array', ['max', 1]],
+    $list . '.*.name' => ['required'],
+    $obj => ['required', 'array', 'strict'],
+    $obj . '.' . str_repeat('k', 2) => ['integer'],
+];
+
+foreach ([[], ['lazy' => true]] as $options) {
+    $v = new Validator($rules, $options);
+    echo keys($v->validate([$list => [[], []], $obj => ['kk' => 1]])), "\n";
+    echo keys($v->validate([$list => [[]], $obj => ['kk' => 1, 'zz' => 2]])), "\n";
+}
+
+echo "OK\n";
+?>
+--EXPECT--
+ititit:validation.max
+ititit.0.name:validation.required obob.zz:validation.strict
+ititit:validation.max
+ititit.0.name:validation.required obob.zz:validation.strict
+OK
@@ -0,0 +1,56 @@
+--TEST--
+Data-driven runs reach fields through the data's keys and run only the absent-reporting fields elsewhere
+--SKIPIF--
+<?php if (!extension_loaded('signalforge_validation')) die('skip'); ?>
+--FILE--
+<?php
+use Signalforge\Validation\Validator;
+
+require __DIR__ . '/_keys.inc';
+
+$rules = [];
+for ($i = 0; $i < 40; $i++) {
+    $rules["f$i"] = ['nullable', 'string'];
+}
+$rules['id'] = ['required', 'integer'];
+$rules['profile'] = ['sometimes', 'array'];
+$rules['profile.name'] = ['required', 'string'];
+$rules['profile.bad'] = ['required', 'no_such_rule'];
+$rules['tags.*'] = ['integer'];
+$rules[7] = ['required', 'integer'];
+
+// Keys in another order than the rules: errors still follow the rules
+$sparse = ['tags' => [1, 'a'], 7 => 'x', 'f3' => 5];
+$dense = $sparse;
+for ($i = 0; $i < 40; $i++) {
+    $dense += ["f$i" => 'text'];
+}
+
+foreach ([[], ['lazy' => true]] as $options) {
+    $v = new Validator($options ? $rules : array_diff_key($rules, ['profile.bad' => 1]), $options);
+    echo keys($v->validate($sparse)), "\n";
+    echo keys($v->validate($dense)), "\n";
+    $stats = $v->stats();
+    echo $stats['data_driven'], ' ', $stats['rule_driven'], "\n";
+}
+
+// Lazy: fields under a present root compile once reached
+$v = new Validator($rules, ['lazy' => true]);
+try {
+    $v->validate(['profile' => []]);
+    echo "no exception\n";
+} catch (Signalforge\Validation\InvalidRuleException $e) {
+    echo "compiled when present\n";
+}
+
+echo "OK\n";
+?>
+--EXPECT--
+f3:validation.string id:validation.required,validation.integer tags.1:validation.integer 7:validation.integer
+f3:validation.string id:validation.required,validation.integer tags.1:validation.integer 7:validation.integer
+1 1
+f3:validation.string id:validation.required,validation.integer tags.1:validation.integer 7:validation.integer
+f3:validation.string id:validation.required,validation.integer tags.1:validation.integer 7:validation.integer
+1 1
+compiled when present
+OK